@@ -0,0 +1,90 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#ifndef _BINARY_DATASET_H_
+#define _BINARY_DATASET_H_
+
+#include <string>
+
+#include "global.h"
+#include "object.h"
+
+namespace similarity {
+
+using std::string;
+
+/*
+ * A binary data set is a sequence of object buffers, exactly as they are
+ * stored in memory: | 4-byte id | 4-byte label | 8-byte datasize | data ........ |
+ * Each record is padded to an 8-byte boundary. The file starts with a header:
+ *
+ * | 8-byte signature | 8-byte # of objects | 8-byte length of the space description | space description |
+ *
+ * (the space description is padded to an 8-byte boundary as well).
+ *
+ * Because records keep object data exactly as it is produced by the space
+ * (e.g., some spaces store precomputed logarithms along with vector elements),
+ * the file must be read using the same space that was used to create it.
+ */
+
+#define BINARY_DATASET_SIGNATURE "NMSLIBDS"
+
+/*
+ * Saves a data set created by the space with the given description (see Space::ToString()).
+ */
+void WriteBinaryDataset(const string& SpaceDesc, const ObjectVector& dataset, const string& FileName);
+
+/*
+ * Returns true if the file starts with the binary data set signature.
+ */
+bool IsBinaryDataset(const string& FileName);
+
+/*
+ * The file is memory mapped: objects are NOT copied, they are
+ * created using the non-owning constructor Object(char* buffer).
+ * The mapped data set must be alive as long as these objects are used.
+ */
+class MappedDataset {
+public:
+  explicit MappedDataset(const string& FileName);
+  ~MappedDataset();
+
+  const string& GetSpaceDesc() const { return SpaceDesc_; }
+  size_t GetObjectQty() const { return ObjQty_; }
+  /*
+   * Creates at most MaxNumObjects (if non-zero) objects. The caller
+   * is responsible for deleting Object pointers (but not the memory they point to).
+   */
+  void CreateObjects(ObjectVector& dataset, size_t MaxNumObjects) const;
+private:
+  void Unmap();
+
+  string  FileName_;
+  string  SpaceDesc_;
+  char*   pMapped_;
+  size_t  MappedSize_;
+  size_t  DataOffset_;
+  size_t  ObjQty_;
+#ifdef _MSC_VER
+  void*   hFile_;
+  void*   hMapping_;
+#endif
+
+  DISABLE_COPY_AND_ASSIGN(MappedDataset);
+};
+
+}  // namespace similarity
+
+#endif     // _BINARY_DATASET_H_
@@ -0,0 +1,247 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#ifndef _DIST_KERNEL_H_
+#define _DIST_KERNEL_H_
+
+#include <cmath>
+#include <type_traits>
+
+#include "object.h"
+#include "distcomp.h"
+#include "distcomp_dispatch.h"
+
+namespace similarity {
+
+template <typename dist_t> class Space;
+
+/*
+ * Distance kernels let hot loops of search methods (e.g., bucket scanning)
+ * compute distances without virtual calls. A space of dense vectors
+ * describes its distance by a kernel type and the number of vector elements
+ * (see Space::GetDistKernel). If all data objects have the same length,
+ * a method keeps this description (see GetDataDistKernel). At search time,
+ * DispatchDistKernel passes a kernel functor to a visitor, whose templated
+ * operator() runs the search loop specialized for this functor.
+ *
+ * A kernel has the function:
+ *
+ *   template <typename QueryType>
+ *   dist_t DistanceObjLeft(QueryType* query, const Object* obj) const;
+ *
+ * which computes the same distance as query->DistanceObjLeft(obj)
+ * and updates the query distance counter in the same way.
+ * The virtual kernel simply calls query->DistanceObjLeft(obj):
+ * it is used for spaces without kernels and for queries that don't fit the kernel.
+ */
+enum DistKernelType {
+  kDistKernelVirtual        = 0,
+  kDistKernelL1             = 1,
+  kDistKernelL2             = 2,
+  kDistKernelLInf           = 3,
+  // Cosine and angular distances with precomputed inverse norms (see distcomp.h)
+  kDistKernelCosinePrecomp  = 4,
+  kDistKernelAngularPrecomp = 5
+};
+
+struct DistKernelDesc {
+  DistKernelDesc() : Type_(kDistKernelVirtual), ElemQty_(0), DataLength_(0) {}
+  DistKernelDesc(DistKernelType type, size_t ElemQty, size_t DataLength) :
+                Type_(type), ElemQty_(ElemQty), DataLength_(DataLength) {}
+
+  // Can the kernel compute distances between data objects and this query object?
+  bool Fits(const Object* obj) const {
+    return Type_ != kDistKernelVirtual && obj->datalength() == DataLength_;
+  }
+
+  DistKernelType  Type_;
+  size_t          ElemQty_;    // the number of vector elements used to compute the distance
+  size_t          DataLength_; // the length of object data in bytes
+};
+
+template <typename dist_t>
+class VirtualDistKernel {
+ public:
+  template <typename QueryType>
+  dist_t DistanceObjLeft(QueryType* query, const Object* obj) const {
+    return query->DistanceObjLeft(obj);
+  }
+};
+
+/*
+ * DistFunc is a functor that computes the distance between
+ * two arrays of ElemQty elements.
+ */
+template <typename dist_t, typename DistFunc>
+class DenseDistKernel {
+ public:
+  explicit DenseDistKernel(size_t ElemQty) : ElemQty_(ElemQty) {}
+
+  template <typename QueryType>
+  dist_t DistanceObjLeft(QueryType* query, const Object* obj) const {
+    query->AddDistanceComputations(1);
+    return func_(reinterpret_cast<const dist_t*>(obj->data()),
+                 reinterpret_cast<const dist_t*>(query->QueryObject()->data()), ElemQty_);
+  }
+ private:
+  DistFunc  func_;
+  size_t    ElemQty_;
+};
+
+/*
+ * Lp functors are instantiated for each SIMD tier (see distcomp_dispatch.h)
+ * and call the kernels of this tier directly. Thus, they compute exactly
+ * the same values as *SIMD functions.
+ */
+template <SIMDTier tier> struct LpKernels;
+
+template <> struct LpKernels<kSIMDTierSSE> {
+  template <typename T> static T LInfNorm(const T* x, const T* y, size_t qty) { return LInfNormSSE(x, y, qty); }
+  template <typename T> static T L1Norm(const T* x, const T* y, size_t qty)   { return L1NormSSE(x, y, qty); }
+  template <typename T> static T L2Sqr(const T* x, const T* y, size_t qty)    { return L2SqrSSE(x, y, qty); }
+};
+
+template <> struct LpKernels<kSIMDTierAVX2> {
+  template <typename T> static T LInfNorm(const T* x, const T* y, size_t qty) { return LInfNormAVX2(x, y, qty); }
+  template <typename T> static T L1Norm(const T* x, const T* y, size_t qty)   { return L1NormAVX2(x, y, qty); }
+  template <typename T> static T L2Sqr(const T* x, const T* y, size_t qty)    { return L2SqrAVX2(x, y, qty); }
+};
+
+template <> struct LpKernels<kSIMDTierAVX512> {
+  template <typename T> static T LInfNorm(const T* x, const T* y, size_t qty) { return LInfNormAVX512(x, y, qty); }
+  template <typename T> static T L1Norm(const T* x, const T* y, size_t qty)   { return L1NormAVX512(x, y, qty); }
+  template <typename T> static T L2Sqr(const T* x, const T* y, size_t qty)    { return L2SqrAVX512(x, y, qty); }
+};
+
+template <typename dist_t, SIMDTier tier>
+struct L1DistFunc {
+  dist_t operator()(const dist_t* x, const dist_t* y, size_t qty) const {
+    return LpKernels<tier>::L1Norm(x, y, qty);
+  }
+};
+
+template <typename dist_t, SIMDTier tier>
+struct L2DistFunc {
+  dist_t operator()(const dist_t* x, const dist_t* y, size_t qty) const {
+    return std::sqrt(LpKernels<tier>::L2Sqr(x, y, qty));
+  }
+};
+
+template <typename dist_t, SIMDTier tier>
+struct LInfDistFunc {
+  dist_t operator()(const dist_t* x, const dist_t* y, size_t qty) const {
+    return LpKernels<tier>::LInfNorm(x, y, qty);
+  }
+};
+
+template <typename dist_t>
+struct CosinePrecompDistFunc {
+  dist_t operator()(const dist_t* x, const dist_t* y, size_t qty) const {
+    return CosineSimilarityPrecompSIMD(x, y, qty);
+  }
+};
+
+template <typename dist_t>
+struct AngularPrecompDistFunc {
+  dist_t operator()(const dist_t* x, const dist_t* y, size_t qty) const {
+    return AngularDistancePrecompSIMD(x, y, qty);
+  }
+};
+
+/*
+ * Dense kernels exist only for float and double distances,
+ * other distance types always use the virtual kernel.
+ */
+template <typename dist_t, bool bDense = std::is_floating_point<dist_t>::value>
+struct DistKernelDispatcher {
+  template <typename Visitor>
+  static void Dispatch(const DistKernelDesc& desc, Visitor& visitor) {
+    switch (desc.Type_) {
+      case kDistKernelL1:
+        DispatchSIMDTier<L1DistFunc>(desc.ElemQty_, visitor);
+        return;
+      case kDistKernelL2:
+        DispatchSIMDTier<L2DistFunc>(desc.ElemQty_, visitor);
+        return;
+      case kDistKernelLInf:
+        DispatchSIMDTier<LInfDistFunc>(desc.ElemQty_, visitor);
+        return;
+      case kDistKernelCosinePrecomp:
+        visitor(DenseDistKernel<dist_t, CosinePrecompDistFunc<dist_t>>(desc.ElemQty_));
+        return;
+      case kDistKernelAngularPrecomp:
+        visitor(DenseDistKernel<dist_t, AngularPrecompDistFunc<dist_t>>(desc.ElemQty_));
+        return;
+      default:
+        visitor(VirtualDistKernel<dist_t>());
+    }
+  }
+
+  /*
+   * The SIMD tier is resolved once per dispatch, so that the search loop
+   * is specialized for the kernels of the current tier.
+   */
+  template <template <typename, SIMDTier> class DistFunc, typename Visitor>
+  static void DispatchSIMDTier(size_t ElemQty, Visitor& visitor) {
+    switch (GetSIMDTier()) {
+      case kSIMDTierAVX512:
+        visitor(DenseDistKernel<dist_t, DistFunc<dist_t, kSIMDTierAVX512>>(ElemQty));
+        return;
+      case kSIMDTierAVX2:
+        visitor(DenseDistKernel<dist_t, DistFunc<dist_t, kSIMDTierAVX2>>(ElemQty));
+        return;
+      default:
+        visitor(DenseDistKernel<dist_t, DistFunc<dist_t, kSIMDTierSSE>>(ElemQty));
+    }
+  }
+};
+
+template <typename dist_t>
+struct DistKernelDispatcher<dist_t, false> {
+  template <typename Visitor>
+  static void Dispatch(const DistKernelDesc&, Visitor& visitor) {
+    visitor(VirtualDistKernel<dist_t>());
+  }
+};
+
+/*
+ * Calls visitor(kernel), where kernel is a functor (see above)
+ * of the type specified by desc. The visitor should have the function:
+ *
+ *   template <typename Kernel> void operator()(const Kernel& kernel);
+ */
+template <typename dist_t, typename Visitor>
+inline void DispatchDistKernel(const DistKernelDesc& desc, Visitor& visitor) {
+  DistKernelDispatcher<dist_t>::Dispatch(desc, visitor);
+}
+
+/*
+ * Returns the kernel of the space if all data objects have the same length.
+ * Otherwise, the virtual kernel is used.
+ */
+template <typename dist_t>
+DistKernelDesc GetDataDistKernel(const Space<dist_t>* space, const ObjectVector& data) {
+  if (data.empty()) return DistKernelDesc();
+  const DistKernelDesc desc = space->GetDistKernel(data[0]);
+  if (desc.DataLength_ == 0) return DistKernelDesc();
+  for (const Object* obj : data) {
+    if (obj->datalength() != desc.DataLength_) return DistKernelDesc();
+  }
+  return desc;
+}
+
+}  // namespace similarity
+
+#endif     // _DIST_KERNEL_H_
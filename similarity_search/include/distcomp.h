@@ -64,7 +64,65 @@ template <class T> T AngularDistance(const T *p1, const T *p2, size_t qty);
 template <class T> T CosineSimilarity(const T *p1, const T *p2, size_t qty);
 template <class T> T NormScalarProduct(const T *p1, const T *p2, size_t qty);
 
+template <class T> T ScalarProduct(const T *p1, const T *p2, size_t qty);
+template <class T> T ScalarProductSIMD(const T *p1, const T *p2, size_t qty);
+
+/*
+ * Precomp means that the inverse of the vector norm is precomputed
+ * and stored right after qty original vector values.
+ * That's the layout is:
+ * x1 ... x_qty 1/||x||
+ * The inverse norm of the zero vector is zero.
+ */
+template <class T> T NormScalarProductPrecompSIMD(const T *p1, const T *p2, size_t qty);
+template <class T> T AngularDistancePrecompSIMD(const T *p1, const T *p2, size_t qty);
+template <class T> T CosineSimilarityPrecompSIMD(const T *p1, const T *p2, size_t qty);
+
+/*
+ * Computes the inverse norm and stores it after qty values of pVect.
+ * NOTE: pVect should have qty + 1 elements!!!
+ */
+template <class T> void PrecompInvNorm(T* pVect, size_t qty) {
+    T norm = 0;
+    for (size_t i = 0; i < qty; i++) {
+      norm += pVect[i] * pVect[i];
+    }
+    // See the comment in NormScalarProduct
+    pVect[qty] = norm < std::numeric_limits<T>::min() * 2 ? T(0) : T(1) / sqrt(norm);
+}
+
+/*
+ * The normalized scalar product of two sparse vectors packed by PackSparseElements
+ * (see space/space_sparse_vector_inter.h).
+ */
 float ScalarProjectFast(const char* pData1, size_t len1, const char* pData2, size_t len2);
+/*
+ * The scalar product of two blocks of packed sparse vectors: 
+ * ids are sorted, non-zero, and are unique within a block.
+ */
+float SparseBlockScalarProductSIMD(const uint16_t* pBlockIds1, const float* pBlockVals1, size_t qty1,
+                                   const uint16_t* pBlockIds2, const float* pBlockVals2, size_t qty2);
+
+/*
+ * Scalar quantization (see space/space_quant.h).
+ *
+ * SQ8 codes are bytes: the respective vector element is min + scale * code.
+ * FP16 codes are IEEE 754 half-precision numbers.
+ *
+ * Distance functions are asymmetric: the first argument is an uncompressed
+ * vector, the second argument is an array of codes.
+ */
+uint16_t FloatToHalf(float x);
+float    HalfToFloat(uint16_t h);
+
+void DecodeSQ8(const uint8_t* pCodes, float min, float scale, float* pVect, size_t qty);
+void DecodeFP16(const uint16_t* pCodes, float* pVect, size_t qty);
+
+// The square of the L2 distance
+float L2SqrSQ8SIMD(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty);
+float ScalarProductSQ8SIMD(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty);
+float L2SqrFP16SIMD(const float* pVect, const uint16_t* pCodes, size_t qty);
+float ScalarProductFP16SIMD(const float* pVect, const uint16_t* pCodes, size_t qty);
 
 /*
  *  Itakura-Saito distance
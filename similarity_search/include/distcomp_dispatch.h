@@ -0,0 +1,138 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#ifndef _DISTCOMP_DISPATCH_H_
+#define _DISTCOMP_DISPATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace similarity {
+
+/*
+ * The most frequently used SIMD distance functions (L*NormSIMD, KLPrecompSIMD,
+ * ItakuraSaitoPrecompSIMD, JSPrecompSIMDApproxLog, the scalar quantization
+ * functions, and SparseBlockScalarProductSIMD) have 128-bit (SSE), 256-bit (AVX2+FMA+F16C), and 512-bit (AVX-512F) versions. The AVX2 and AVX-512
+ * versions reside in separate files (distcomp_avx2.cc and distcomp_avx512.cc),
+ * which are compiled with their own instruction-set flags, while the rest of
+ * the code may be compiled for a generic x86-64 CPU. The best version
+ * supported by the CPU (and the OS) is selected once at startup.
+ *
+ * IMPORTANT NOTE: the AVX files should never call inline functions
+ * that are defined in other translation units as well (e.g., std::max).
+ * Otherwise, the linker may pick up a copy compiled with AVX instructions
+ * for the whole program, which would crash on older CPUs.
+ */
+enum SIMDTier { kSIMDTierSSE = 0, kSIMDTierAVX2 = 1, kSIMDTierAVX512 = 2 };
+
+const SIMDTier kSIMDTierMax = kSIMDTierAVX512;
+
+template <class T>
+struct SIMDKernels {
+  T (*LInfNorm)(const T* pVect1, const T* pVect2, size_t qty);
+  T (*L1Norm)(const T* pVect1, const T* pVect2, size_t qty);
+  // The square of the L2 norm
+  T (*L2Sqr)(const T* pVect1, const T* pVect2, size_t qty);
+  T (*KLPrecomp)(const T* pVect1, const T* pVect2, size_t qty);
+  T (*ItakuraSaitoPrecomp)(const T* pVect1, const T* pVect2, size_t qty);
+  T (*JSPrecompApproxLog)(const T* pVect1, const T* pVect2, size_t qty);
+};
+
+// Scalar quantization kernels (see distcomp.h)
+struct SQKernels {
+  float (*L2SqrSQ8)(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty);
+  float (*ScalarProductSQ8)(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty);
+  float (*L2SqrFP16)(const float* pVect, const uint16_t* pCodes, size_t qty);
+  float (*ScalarProductFP16)(const float* pVect, const uint16_t* pCodes, size_t qty);
+};
+
+// Sparse vector kernels (see distcomp.h)
+struct SparseKernels {
+  float (*BlockScalarProduct)(const uint16_t* pBlockIds1, const float* pBlockVals1, size_t qty1,
+                              const uint16_t* pBlockIds2, const float* pBlockVals2, size_t qty2);
+};
+
+const char* SIMDTierName(SIMDTier tier);
+// Checks if the tier is supported by both the CPU and the binary
+bool IsSIMDTierSupported(SIMDTier tier);
+SIMDTier GetBestSIMDTier();
+// The tier of currently used kernels
+SIMDTier GetSIMDTier();
+/*
+ * Makes *SIMD functions use kernels of a given tier (e.g., to compare
+ * their efficiency). If the tier is not supported, an exception is thrown.
+ * This function is not thread-safe: don't call it while other threads
+ * compute distances.
+ */
+void SetSIMDTier(SIMDTier tier);
+
+/*
+ * If a file is compiled without support for the respective instruction set,
+ * these functions return false. There is no AVX-512 version of sparse
+ * kernels: the AVX-512 tier uses AVX2 ones.
+ */
+bool GetAVX2Kernels(SIMDKernels<float>& FloatKernels, SIMDKernels<double>& DoubleKernels,
+                    SQKernels& QuantKernels, SparseKernels& SparseVectKernels);
+bool GetAVX512Kernels(SIMDKernels<float>& FloatKernels, SIMDKernels<double>& DoubleKernels,
+                      SQKernels& QuantKernels);
+
+/*
+ * SSE versions of *SIMD functions.
+ */
+template <class T> T LInfNormSSE(const T* pVect1, const T* pVect2, size_t qty);
+template <class T> T L1NormSSE(const T* pVect1, const T* pVect2, size_t qty);
+template <class T> T L2SqrSSE(const T* pVect1, const T* pVect2, size_t qty);
+template <class T> T KLPrecompSSE(const T* pVect1, const T* pVect2, size_t qty);
+template <class T> T ItakuraSaitoPrecompSSE(const T* pVect1, const T* pVect2, size_t qty);
+template <class T> T JSPrecompSSEApproxLog(const T* pVect1, const T* pVect2, size_t qty);
+
+/*
+ * AVX2 and AVX-512 versions of Lp-norm functions. They are called directly
+ * by tier-specific functors (see dist_kernel.h). If the tier is not supported,
+ * they must not be called.
+ */
+float  LInfNormAVX2(const float* pVect1, const float* pVect2, size_t qty);
+double LInfNormAVX2(const double* pVect1, const double* pVect2, size_t qty);
+float  L1NormAVX2(const float* pVect1, const float* pVect2, size_t qty);
+double L1NormAVX2(const double* pVect1, const double* pVect2, size_t qty);
+float  L2SqrAVX2(const float* pVect1, const float* pVect2, size_t qty);
+double L2SqrAVX2(const double* pVect1, const double* pVect2, size_t qty);
+
+float  LInfNormAVX512(const float* pVect1, const float* pVect2, size_t qty);
+double LInfNormAVX512(const double* pVect1, const double* pVect2, size_t qty);
+float  L1NormAVX512(const float* pVect1, const float* pVect2, size_t qty);
+double L1NormAVX512(const double* pVect1, const double* pVect2, size_t qty);
+float  L2SqrAVX512(const float* pVect1, const float* pVect2, size_t qty);
+double L2SqrAVX512(const double* pVect1, const double* pVect2, size_t qty);
+
+float L2SqrSQ8SSE(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty);
+float ScalarProductSQ8SSE(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty);
+float L2SqrFP16SSE(const float* pVect, const uint16_t* pCodes, size_t qty);
+float ScalarProductFP16SSE(const float* pVect, const uint16_t* pCodes, size_t qty);
+
+float SparseBlockScalarProductSSE(const uint16_t* pBlockIds1, const float* pBlockVals1, size_t qty1,
+                                  const uint16_t* pBlockIds2, const float* pBlockVals2, size_t qty2);
+
+/*
+ * The table of approximate logarithms used by JSPrecomp*ApproxLog:
+ * the element with the index floor(LogQty * x) is log(1 + x), 0 <= x <= 1.
+ */
+const unsigned LogQty = 65536;
+
+template <class T> const T* GetApproxLogTable();
+
+}
+
+#endif
@@ -18,6 +18,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <limits>
 #include <vector>
 #include <unordered_set>
 #include <memory>
@@ -29,6 +30,7 @@
 #include "index.h"
 #include "knnqueue.h"
 #include "eval_metrics.h"
+#include "ztimer.h"
 
 namespace similarity {
 
@@ -49,49 +51,203 @@ public:
   GoldStandard(const typename similarity::Space<dist_t>* space,
               const ObjectVector& datapoints, 
               const typename similarity::KNNQuery<dist_t>* query 
-              ) {
-    DoSeqSearch(space, datapoints, query->QueryObject());
+              ) : space_(space), datapoints_(&datapoints), queryObj_(query->QueryObject()) {
+    DoSeqSearch();
+    SortClosest(query->GetK());
   }
   GoldStandard(const typename similarity::Space<dist_t>* space,
               const ObjectVector& datapoints, 
               const typename similarity::RangeQuery<dist_t>* query 
-              ) {
-    DoSeqSearch(space, datapoints, query->QueryObject());
+              ) : space_(space), datapoints_(&datapoints), queryObj_(query->QueryObject()) {
+    DoSeqSearch();
+    ExtendSorted(query->Radius());
+  }
+  /*
+   * These constructors use the closest entries precomputed by GoldStandardManager
+   * (see gold_standard.h). The entries are sorted by distance and all other
+   * data points are farther from the query than any of these entries.
+   * If the closest entries are not enough to evaluate an answer (which happens
+   * only if a method returns rather distant points), distances to all the data
+   * points are computed again.
+   */
+  GoldStandard(const typename similarity::Space<dist_t>* space,
+              const ObjectVector& datapoints, 
+              const vector<ResultEntry<dist_t>>& closest,
+              bool complete,
+              uint64_t SeqSearchTime,
+              const typename similarity::KNNQuery<dist_t>* query 
+              ) : space_(space), datapoints_(&datapoints), queryObj_(query->QueryObject()),
+                  SeqSearchTime_(SeqSearchTime), 
+                  SortedAllEntries_(closest), SortedQty_(closest.size()), Complete_(complete) {
+    SortClosest(query->GetK());
+  }
+  GoldStandard(const typename similarity::Space<dist_t>* space,
+              const ObjectVector& datapoints, 
+              const vector<ResultEntry<dist_t>>& closest,
+              bool complete,
+              uint64_t SeqSearchTime,
+              const typename similarity::RangeQuery<dist_t>* query 
+              ) : space_(space), datapoints_(&datapoints), queryObj_(query->QueryObject()),
+                  SeqSearchTime_(SeqSearchTime), 
+                  SortedAllEntries_(closest), SortedQty_(closest.size()), Complete_(complete) {
+    ExtendSorted(query->Radius());
+  }
+  /*
+   * This constructor is used by GoldStandardManager: 
+   * dists are distances from the query to data points, nothing is sorted yet.
+   */
+  GoldStandard(const ObjectVector& datapoints, const vector<dist_t>& dists) 
+              : space_(NULL), datapoints_(&datapoints), queryObj_(NULL), SeqSearchTime_(0) {
+    SetEntries(dists);
   }
   uint64_t GetSeqSearchTime()     const { return SeqSearchTime_; }
 
   /* 
-   * SortedAllEntries_ include all database entries sorted in the order
-   * of increasing distance from the query.
+   * SortedAllEntries_ include all database entries (or only the closest ones,
+   * see Complete_), but only the first SortedQty_ entries are sorted in the 
+   * order of increasing distance from the query. The remaining entries are 
+   * farther from the query than any of the sorted ones.
+   * The sorted part always includes the exact answer. To evaluate an approximate
+   * answer, it may need to be extended (see ExtendSorted). Sorting only what is
+   * needed is much cheaper than sorting all entries for every query.
    */
   const vector<ResultEntry<dist_t>>&   GetSortedEntries() const { return  SortedAllEntries_;}
+  size_t GetSortedQty() const { return SortedQty_; }
+
+  /*
+   * Makes sure that all entries with distances up to MaxDist are sorted, as
+   * well as the next (farther) entry (unless all entries are sorted already).
+   */
+  void ExtendSorted(dist_t MaxDist) {
+    while (HasMore() &&
+           (!SortedQty_ || 
+            SortedAllEntries_[SortedQty_ - 1].mDist <= MaxDist ||
+            ApproxEqual(SortedAllEntries_[SortedQty_ - 1].mDist, MaxDist))) {
+      // The size of the sorted part at least doubles on every iteration
+      SortMore(std::max(SortedQty_, static_cast<size_t>(MIN_SORT_QTY)));
+    }
+  }
+  // Makes sure that all entries needed to evaluate the answer are sorted
+  void ExtendSorted(const KNNQuery<dist_t>* query) {
+    // The queue top is the farthest answer
+    if (!query->Result()->Empty()) ExtendSorted(query->Result()->TopDistance());
+  }
+  void ExtendSorted(const RangeQuery<dist_t>* query) {
+    const std::vector<dist_t>& ResQDists = *query->ResultDists();
+    if (!ResQDists.empty()) ExtendSorted(*std::max_element(ResQDists.begin(), ResQDists.end()));
+  }
+
+  /*
+   * Sorts (at least) Qty closest entries as well as entries 
+   * that have the same distance as the Qty-th entry.
+   * The exact k-NN answer includes such entries (see EvalResults).
+   */
+  void SortClosest(size_t Qty) {
+    if (!Qty) return;
+    while (SortedQty_ < Qty && HasMore()) SortMore(Qty - SortedQty_);
+    if (SortedQty_) ExtendSorted(SortedAllEntries_[SortedQty_ - 1].mDist);
+  }
+
+  /*
+   * Retrieves sorted entries such that all other entries are 
+   * (definitely) farther from the query. complete is set to true
+   * if there are no other entries.
+   */
+  void GetClosestEntries(vector<ResultEntry<dist_t>>& closest, bool& complete) const {
+    size_t qty = SortedQty_;
+    complete = Complete_ && qty == SortedAllEntries_.size();
+    if (!complete) {
+      dist_t MinRest = std::numeric_limits<dist_t>::max();
+      for (size_t i = SortedQty_; i < SortedAllEntries_.size(); ++i) {
+        MinRest = std::min(MinRest, SortedAllEntries_[i].mDist);
+      }
+      // Entries that can be tied with remaining ones are excluded
+      while (qty && (SortedAllEntries_[qty - 1].mDist >= MinRest || 
+                     ApproxEqual(SortedAllEntries_[qty - 1].mDist, MinRest))) {
+        --qty;
+      }
+    }
+    closest.assign(SortedAllEntries_.begin(), SortedAllEntries_.begin() + qty);
+  }
 private:
-  void DoSeqSearch(const similarity::Space<dist_t>* space,
-                   const ObjectVector&              datapoints,
-                   const Object*                    query) {
+  static const size_t MIN_SORT_QTY = 32;
+
+  bool HasMore() const { return SortedQty_ < SortedAllEntries_.size() || !Complete_; }
+
+  // Computes distances to all the data points
+  void DoSeqSearch() {
     WallClockTimer  wtm;
 
     wtm.reset();
 
-    SortedAllEntries_.resize(datapoints.size());
+    vector<dist_t> dists(datapoints_->size());
 
-    for (size_t i = 0; i < datapoints.size(); ++i) {
+    for (size_t i = 0; i < datapoints_->size(); ++i) {
       // Distance can be asymmetric, but the query is always on the right side
-      SortedAllEntries_[i] = ResultEntry<dist_t>(datapoints[i]->id(), datapoints[i]->label(), space->IndexTimeDistance(datapoints[i], query));
+      dists[i] = space_->IndexTimeDistance((*datapoints_)[i], queryObj_);
     }
 
     wtm.split();
 
     SeqSearchTime_ = wtm.elapsed();
 
-    std::sort(SortedAllEntries_.begin(), SortedAllEntries_.end());
+    SetEntries(dists);
   }
 
+  void SetEntries(const vector<dist_t>& dists) {
+    const ObjectVector& datapoints = *datapoints_;
+    CHECK(datapoints.size() == dists.size());
+
+    SortedAllEntries_.resize(datapoints.size());
+
+    for (size_t i = 0; i < datapoints.size(); ++i) {
+      SortedAllEntries_[i] = ResultEntry<dist_t>(datapoints[i]->id(), datapoints[i]->label(), dists[i]);
+    }
+    SortedQty_ = 0;
+    Complete_  = true;
+  }
+
+  // Moves (at most) Qty closest unsorted entries to the sorted part
+  void SortMore(size_t Qty) {
+    if (SortedQty_ == SortedAllEntries_.size() && !Complete_) {
+      /* 
+       * We need entries that were not kept by GoldStandardManager. 
+       * The sequential search time is not changed.
+       */
+      const uint64_t SeqSearchTime = SeqSearchTime_;
+      const size_t   SortedQty     = SortedQty_;
+      DoSeqSearch();
+      SeqSearchTime_ = SeqSearchTime;
+      // The previously sorted entries need to be sorted again
+      Qty += SortedQty;
+    }
+    auto start = SortedAllEntries_.begin() + SortedQty_;
+    auto end   = SortedAllEntries_.begin() + std::min(SortedAllEntries_.size(), SortedQty_ + Qty);
+
+    if (end != SortedAllEntries_.end()) {
+      std::nth_element(start, end, SortedAllEntries_.end());
+    }
+    std::sort(start, end);
+
+    SortedQty_ = end - SortedAllEntries_.begin();
+  }
+
+  const Space<dist_t>*                space_;
+  const ObjectVector*                 datapoints_;
+  const Object*                       queryObj_;
+
   uint64_t                            SeqSearchTime_;
 
   vector<ResultEntry<dist_t>>         SortedAllEntries_;
+  size_t                              SortedQty_;
+  // False if SortedAllEntries_ include only the closest entries
+  bool                                Complete_;
 };
 
+/*
+ * The gold standard should be prepared for the evaluation 
+ * by calling GoldStandard::ExtendSorted(query).
+ */
 template <class dist_t>
 class EvalResults {
 public:
@@ -173,10 +329,12 @@ private:
       else break; // SortedAllEntries_ are sorted by distance
     }
 
-    unique_ptr<KNNQueue<dist_t>> ResQ(query->Result()->Clone());
+    vector<typename KNNQueue<dist_t>::QueueElement> ResQ;
+    query->Result()->GetSortedElements(ResQ);
 
-    while (!ResQ->Empty()) {
-      const Object* ResObject = reinterpret_cast<const Object*>(ResQ->TopObject());
+    // Farther elements go first
+    for (auto it = ResQ.rbegin(); it != ResQ.rend(); ++it) {
+      const Object* ResObject = it->second;
       CHECK(ResObject);
       /*
        * A search method can potentially return duplicate records.
@@ -184,12 +342,11 @@ private:
        */
       if (ApproxResultIds_.find(ResObject->id()) == ApproxResultIds_.end()) {
         ApproxResultIds_.insert(ResObject->id());
-        ApproxEntries_.insert(ApproxEntries_.begin(), 
-                              ResultEntry<dist_t>(ResObject->id(), ResObject->label(), ResQ->TopDistance()));
+        ApproxEntries_.push_back(ResultEntry<dist_t>(ResObject->id(), ResObject->label(), it->first));
       }
-      ResQ->Pop();
     }
     // ApproxEntries_ should be sorted
+    std::reverse(ApproxEntries_.begin(), ApproxEntries_.end());
   }
 
   void GetRangeData(const RangeQuery<dist_t>* query) {
@@ -265,8 +422,9 @@ private:
 
 
   /* 
-   * SortedAllEntries_ include all database entries sorted in the order
-   * of increasing distance from the query.
+   * SortedAllEntries_ include all database entries, the entries
+   * that are necessary to evaluate the answer are sorted in the order
+   * of increasing distance from the query (see GoldStandard).
    */
   const std::vector<ResultEntry<dist_t>>& SortedAllEntries_;
 };
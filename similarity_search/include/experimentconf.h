@@ -19,10 +19,13 @@
 
 #include <string.h>
 #include <string>
+#include <memory>
 #include "global.h"
 #include "object.h"
 #include "utils.h"
 #include "space.h"
+#include "binary_dataset.h"
+#include "object_arena.h"
 
 namespace similarity {
 
@@ -42,6 +45,7 @@ public:
                    float eps,
                    const typename std::vector<dist_t>& range)
       : space(reinterpret_cast<Space<dist_t>*>(space)),
+        DataArena(new ObjectArena()),
         datafile(datafile),
         queryfile(queryfile),
         NoQueryFile(queryfile.empty()),
@@ -61,6 +65,10 @@ public:
     }
   }
 
+  /*
+   * Objects are deleted before the member destructors
+   * unmap binary data sets (or release arenas) that objects point to.
+   */
   ~ExperimentConfig() {
     delete space;
     for (auto it = OrigData.begin(); it != OrigData.end(); ++it) {
@@ -81,13 +89,27 @@ public:
   const Space<dist_t>*  GetSpace() const { return space; }
   const ObjectVector& GetDataObjects() const { return dataobjects; }
   const ObjectVector& GetQueryObjects() const { return queryobjects; }
+  const string& GetDataFile() const { return datafile; }
+  const string& GetQueryFile() const { return queryfile; }
   const typename std::vector<unsigned>& GetKNN() const { return knn; }
   float GetEPS() const { return eps; }
   const typename std::vector<dist_t>& GetRange() const { return range; }
   int   GetDimension() const { return dimension; }
+  // Objects read from text files are placed into this arena
+  ObjectArena* GetObjectArena() const { return DataArena.get(); }
   int   GetQueryQty() const { return NoQueryFile ? MaxNumQuery : static_cast<unsigned>(OrigQuery.size()); }
 private:
+  /*
+   * Reads either a binary data set (see binary_dataset.h)
+   * or a regular data file (using the space).
+   */
+  void ReadObjects(ObjectVector& dataset, const string& FileName, unsigned MaxNumObjects,
+                   std::unique_ptr<MappedDataset>& mapped, bool bQueries);
+
   Space<dist_t>*    space;
+  std::unique_ptr<MappedDataset>  MappedData;
+  std::unique_ptr<MappedDataset>  MappedQuery;
+  std::unique_ptr<ObjectArena>    DataArena;
   ObjectVector      dataobjects;
   ObjectVector      queryobjects;
   ObjectVector      OrigData;
@@ -29,6 +29,7 @@
 #include <thread>
 #include <mutex>
 #include <memory>
+#include <atomic>
 
 #include "global.h"
 #include "object.h"
@@ -43,6 +44,7 @@
 #include "logging.h"
 #include "methodfactory.h"
 #include "eval_results.h"
+#include "gold_standard.h"
 #include "meta_analysis.h"
 
 namespace similarity {
@@ -100,6 +102,7 @@ public:
                      vector<vector<MetaAnalysis*>>&   ExpResRange,
                      vector<vector<MetaAnalysis*>>&   ExpResKNN,
                      const ExperimentConfig<dist_t>&  config,
+                     const GoldStandardManager<dist_t>& GSManager,
                      const  std::vector<shared_ptr<IndexType>>& IndexPtrs,
                      const vector<shared_ptr<MethodWithParams>>& MethodsDesc) {
 
@@ -112,7 +115,7 @@ public:
         const dist_t radius = config.GetRange()[i];
         RangeCreator  cr(radius);
         Execute<RangeQuery<dist_t>, RangeCreator>(LogInfo, ThreadTestQty, TestSetId, 
-                                                  ExpResRange[i], config, cr, 
+                                                  ExpResRange[i], config, GSManager, cr, 
                                                   IndexPtrs, MethodsDesc);
       }
     }
@@ -122,7 +125,7 @@ public:
         const size_t K = config.GetKNN()[i];
         KNNCreator  cr(K, config.GetEPS());
         Execute<KNNQuery<dist_t>, KNNCreator>(LogInfo, ThreadTestQty, TestSetId, 
-                                              ExpResKNN[i], config, cr, 
+                                              ExpResKNN[i], config, GSManager, cr, 
                                               IndexPtrs, MethodsDesc);
       }
     }
@@ -134,8 +137,7 @@ public:
   struct  BenchmarkThreadParams {
     BenchmarkThreadParams(
               mutex&                          UpdateStat,
-              unsigned                        ThreadQty,
-              unsigned                        QueryPart,
+              std::atomic<size_t>&            NextQuery,
               size_t                          TestSetId, 
               std::vector<MetaAnalysis*>&     ExpRes,
               const ExperimentConfig<dist_t>& config,
@@ -148,8 +150,7 @@ public:
               vector<double>&                 avg_result_size,
               vector<uint64_t>&               DistCompQty) :
     UpdateStat_(UpdateStat),
-    ThreadQty_(ThreadQty),
-    QueryPart_(QueryPart),
+    NextQuery_(NextQuery),
     TestSetId_(TestSetId),
     ExpRes_(ExpRes),
     config_(config),
@@ -165,8 +166,8 @@ public:
     {}
 
     mutex&                          UpdateStat_;
-    unsigned                        ThreadQty_;
-    unsigned                        QueryPart_;
+    // Queries are handed out dynamically: a thread takes the next unanswered one
+    std::atomic<size_t>&            NextQuery_;
     size_t                          TestSetId_;
     std::vector<MetaAnalysis*>&     ExpRes_;
     const ExperimentConfig<dist_t>& config_;
@@ -184,37 +185,36 @@ public:
   template <typename QueryType, typename QueryCreatorType> 
   struct BenchmarkThread {
     void operator ()(BenchmarkThreadParams<QueryType, QueryCreatorType>& prm) {
-      int numquery = prm.config_.GetQueryObjects().size();
+      size_t numquery = prm.config_.GetQueryObjects().size();
 
       WallClockTimer wtm;
 
       wtm.reset();
 
       unsigned MethNum = prm.MethNum_;
-      unsigned QueryPart = prm.QueryPart_;
-      unsigned ThreadQty = prm.ThreadQty_;
 
-      for (int q = 0; q < numquery; ++q) {
-        if ((q % ThreadQty) == QueryPart) {
-          unique_ptr<QueryType> query(prm.QueryCreator_(prm.config_.GetSpace(), 
-                                      prm.config_.GetQueryObjects()[q]));
-          uint64_t  t1 = wtm.split();
-          prm.Method_.Search(query.get());
-          uint64_t  t2 = wtm.split();
+      for (size_t q = prm.NextQuery_++; q < numquery; q = prm.NextQuery_++) {
+        unique_ptr<QueryType> query(prm.QueryCreator_(prm.config_.GetSpace(), 
+                                    prm.config_.GetQueryObjects()[q]));
+        uint64_t  t1 = wtm.split();
+        prm.Method_.Search(query.get());
+        // The query time includes the time to re-rank k-NN candidates (if the space re-ranks them)
+        query->Rerank();
+        unsigned  ResultSize = query->ResultSize();
+        uint64_t  t2 = wtm.split();
 
-          {
-            lock_guard<mutex> g(prm.UpdateStat_);
+        {
+          lock_guard<mutex> g(prm.UpdateStat_);
 
-            prm.ExpRes_[MethNum]->AddDistComp(prm.TestSetId_, query->DistanceComputations());
-            prm.ExpRes_[MethNum]->AddQueryTime(prm.TestSetId_, (1.0*t2 - t1)/1e3);
+          prm.ExpRes_[MethNum]->AddDistComp(prm.TestSetId_, query->DistanceComputations());
+          prm.ExpRes_[MethNum]->AddQueryTime(prm.TestSetId_, (1.0*t2 - t1)/1e3);
 
 
-            prm.DistCompQty_[MethNum] += query->DistanceComputations();
-            prm.avg_result_size_[MethNum] += query->ResultSize();
+          prm.DistCompQty_[MethNum] += query->DistanceComputations();
+          prm.avg_result_size_[MethNum] += ResultSize;
 
-            if (query->ResultSize() > prm.max_result_size_[MethNum]) {
-              prm.max_result_size_[MethNum] = query->ResultSize();
-            }
+          if (ResultSize > prm.max_result_size_[MethNum]) {
+            prm.max_result_size_[MethNum] = ResultSize;
           }
         }
       }
@@ -225,11 +225,14 @@ public:
   static void Execute(bool LogInfo, unsigned ThreadTestQty, size_t TestSetId, 
                      std::vector<MetaAnalysis*>&                  ExpRes,
                      const ExperimentConfig<dist_t>&              config,
+                     const GoldStandardManager<dist_t>&           GSManager,
                      const QueryCreatorType&                      QueryCreator,
                      const vector<shared_ptr<IndexType>>&         IndexPtrs,
                      const vector<shared_ptr<MethodWithParams>>&  MethodsDesc) {
     int numquery = config.GetQueryObjects().size();
 
+    CHECK(GSManager.GetQueryQty() == config.GetQueryObjects().size());
+
       /*
        *  We make 2 passes:
        *    1) Only measure CPU time & # of distance computations
@@ -259,6 +262,8 @@ public:
     vector<unsigned>  max_result_size(MethQty);
     vector<double>    avg_result_size(MethQty);
     vector<uint64_t>  DistCompQty(MethQty);
+    // Statistics reported by methods, see Index::GetSearchStats
+    vector<vector<pair<string, double>>>  SearchStats(MethQty);
 
     mutex             UpdateStat;
 
@@ -285,13 +290,12 @@ public:
       vector<BenchmarkThreadParams<QueryType, QueryCreatorType>*>       ThreadParams(ThreadTestQty);
       vector<thread>                                                    Threads(ThreadTestQty);
       AutoVectDel<BenchmarkThreadParams<QueryType, QueryCreatorType>>   DelThreadParams(ThreadParams);
-
+      std::atomic<size_t>                                               NextQuery(0);
 
       for (unsigned QueryPart = 0; QueryPart < ThreadTestQty; ++QueryPart) {
         ThreadParams[QueryPart] =  new BenchmarkThreadParams<QueryType, QueryCreatorType>(
                                               UpdateStat,
-                                              ThreadTestQty,
-                                              QueryPart,
+                                              NextQuery,
                                               TestSetId, 
                                               ExpRes,
                                               config,
@@ -328,6 +332,11 @@ public:
       ExpRes[MethNum]->SetImprDistComp(TestSetId, ImprDistComp[MethNum]);
 
       avg_result_size[MethNum] /= static_cast<double>(numquery);
+      /*
+       * Query-time parameters are reset in the 2d pass,
+       * so the statistics is obtained right after the 1st pass.
+       */
+      SearchStats[MethNum] = Method.GetSearchStats();
     }
 
     config.GetSpace()->SetIndexPhase();
@@ -341,12 +350,11 @@ public:
     for (int q = 0; q < numquery; ++q) {
       unique_ptr<QueryType> queryGS(QueryCreator(config.GetSpace(), config.GetQueryObjects()[q]));
 
-      /* 
-       * We compute gold stanard once for each query.
-       * Note that GS uses a lot of space, b/c we need to compute the distance
-       * from the query to every data point.
-       */
-      GoldStandard<dist_t>  QueryGS(config.GetSpace(), config.GetDataObjects(), queryGS.get());
+      // The closest data points are precomputed (see gold_standard.h)
+      GoldStandard<dist_t>  QueryGS(config.GetSpace(), config.GetDataObjects(), 
+                                    GSManager.GetClosestEntries(q), GSManager.IsComplete(q),
+                                    GSManager.GetSeqSearchTime(q),
+                                    queryGS.get());
 
       SeqSearchTime     += QueryGS.GetSeqSearchTime();
 
@@ -365,7 +373,9 @@ public:
         unique_ptr<QueryType> query(QueryCreator(config.GetSpace(), config.GetQueryObjects()[q]));
         
         Method.Search(query.get());
+        query->Rerank();
 
+        QueryGS.ExtendSorted(query.get());
         EvalResults<dist_t>     Eval(config.GetSpace(), query.get(), QueryGS);
 
         NumCloser[MethNum]    += Eval.GetNumCloser();
@@ -398,6 +408,9 @@ public:
         LOG(LIB_INFO) << ">>>> Time elapsed:           " << (SearchTime[MethNum]/double(1e6)) << " sec";
         LOG(LIB_INFO) << ">>>> Avg time per query:     " << (SearchTime[MethNum]/double(1e3)/numquery) << " msec";
         LOG(LIB_INFO) << ">>>> System time elapsed:    " << (SystemTimeElapsed[MethNum]/double(1e6)) << " sec";
+        for (const auto& stat : SearchStats[MethNum]) {
+          LOG(LIB_INFO) << ">>>> " << stat.first << " = " << stat.second;
+        }
         LOG(LIB_INFO) << "=========================================";
       }
 
@@ -27,6 +27,7 @@
 #include "factory/method/dummy.h"
 #include "factory/method/bbtree.h"
 #include "factory/method/ghtree.h"
+#include "factory/method/hnsw.h"
 #include "factory/method/list_clusters.h"
 #include "factory/method/multi_index.h"
 #include "factory/method/multi_vantage_point_tree.h"
@@ -38,10 +39,12 @@
 #include "factory/method/permutation_prefix_index.h"
 #include "factory/method/permutation_vptree.h"
 #include "factory/method/pivot_neighb_invindx.h"
+#include "factory/method/product_quantization.h"
 #include "factory/method/proj_vptree.h"
 #include "factory/method/seqsearch.h"
 #include "factory/method/small_world_rand.h"
 #include "factory/method/spatial_approx_tree.h"
+#include "factory/method/sparse_inv_index.h"
 #include "factory/method/vptree.h"
 
 namespace similarity {
@@ -123,6 +126,9 @@ inline void initMethods() {
   REGISTER_METHOD_CREATOR(double, METH_PIVOT_NEIGHB_INVINDEX, CreatePivotNeighbInvertedIndex)
   REGISTER_METHOD_CREATOR(int,    METH_PIVOT_NEIGHB_INVINDEX, CreatePivotNeighbInvertedIndex)
 
+  // Product quantization with asymmetric distance computation (dense L2 only)
+  REGISTER_METHOD_CREATOR(float,  METH_PQ, CreateProductQuantization)
+
   // VP-tree built over projections
   REGISTER_METHOD_CREATOR(float,  METH_PROJ_VPTREE, CreateProjVPTree)
   REGISTER_METHOD_CREATOR(double, METH_PROJ_VPTREE, CreateProjVPTree)
@@ -132,11 +138,20 @@ inline void initMethods() {
   REGISTER_METHOD_CREATOR(double, METH_SEQ_SEARCH, CreateSeqSearch)
   REGISTER_METHOD_CREATOR(int,    METH_SEQ_SEARCH, CreateSeqSearch)
 
+  // Exact search in sparse cosine similarity and angular distance spaces using an inverted index
+  REGISTER_METHOD_CREATOR(float,  METH_SPARSE_INV_INDEX, CreateSparseInvIndex)
+  REGISTER_METHOD_CREATOR(double, METH_SPARSE_INV_INDEX, CreateSparseInvIndex)
+
   // Small-word with randomly generated neighborhood-networks
   REGISTER_METHOD_CREATOR(float,  METH_SMALL_WORLD_RAND, CreateSmallWorldRand)
   REGISTER_METHOD_CREATOR(double, METH_SMALL_WORLD_RAND, CreateSmallWorldRand)
   REGISTER_METHOD_CREATOR(int,    METH_SMALL_WORLD_RAND, CreateSmallWorldRand)
 
+  // Hierarchical small-world graph
+  REGISTER_METHOD_CREATOR(float,  METH_HNSW, CreateHnsw)
+  REGISTER_METHOD_CREATOR(double, METH_HNSW, CreateHnsw)
+  REGISTER_METHOD_CREATOR(int,    METH_HNSW, CreateHnsw)
+
   // SA-tree
   REGISTER_METHOD_CREATOR(float,  METH_SATREE, CreateSATree)
   REGISTER_METHOD_CREATOR(double, METH_SATREE, CreateSATree)
@@ -157,6 +172,38 @@ inline void initMethods() {
   REGISTER_METHOD_CREATOR(double, METH_MULT_INDEX, CreateMultiIndex)
   REGISTER_METHOD_CREATOR(int,    METH_MULT_INDEX, CreateMultiIndex)
 
+  /*
+   * Methods that can load a previously saved index.
+   */
+  REGISTER_METHOD_LOADER(float,  METH_PERMUTATION, LoadPermutationIndex)
+  REGISTER_METHOD_LOADER(double, METH_PERMUTATION, LoadPermutationIndex)
+  REGISTER_METHOD_LOADER(int,    METH_PERMUTATION, LoadPermutationIndex)
+
+  REGISTER_METHOD_LOADER(float,  METH_PIVOT_NEIGHB_INVINDEX, LoadPivotNeighbInvertedIndex)
+  REGISTER_METHOD_LOADER(double, METH_PIVOT_NEIGHB_INVINDEX, LoadPivotNeighbInvertedIndex)
+  REGISTER_METHOD_LOADER(int,    METH_PIVOT_NEIGHB_INVINDEX, LoadPivotNeighbInvertedIndex)
+
+  REGISTER_METHOD_LOADER(float,  METH_PQ, LoadProductQuantization)
+
+  REGISTER_METHOD_LOADER(float,  METH_SPARSE_INV_INDEX, LoadSparseInvIndex)
+  REGISTER_METHOD_LOADER(double, METH_SPARSE_INV_INDEX, LoadSparseInvIndex)
+
+  REGISTER_METHOD_LOADER(float,  METH_SMALL_WORLD_RAND, LoadSmallWorldRand)
+  REGISTER_METHOD_LOADER(double, METH_SMALL_WORLD_RAND, LoadSmallWorldRand)
+  REGISTER_METHOD_LOADER(int,    METH_SMALL_WORLD_RAND, LoadSmallWorldRand)
+
+  REGISTER_METHOD_LOADER(float,  METH_HNSW, LoadHnsw)
+  REGISTER_METHOD_LOADER(double, METH_HNSW, LoadHnsw)
+  REGISTER_METHOD_LOADER(int,    METH_HNSW, LoadHnsw)
+
+  REGISTER_METHOD_LOADER(int,    METH_VPTREE, LoadVPTreeTriang)
+  REGISTER_METHOD_LOADER(float,  METH_VPTREE, LoadVPTreeTriang)
+  REGISTER_METHOD_LOADER(double, METH_VPTREE, LoadVPTreeTriang)
+
+  REGISTER_METHOD_LOADER(int,    METH_GHTREE, LoadGHTree)
+  REGISTER_METHOD_LOADER(float,  METH_GHTREE, LoadGHTree)
+  REGISTER_METHOD_LOADER(double, METH_GHTREE, LoadGHTree)
+
 }
 
 
@@ -23,6 +23,7 @@
 #include "factory/space/space_dummy.h"
 #include "factory/space/space_js.h"
 #include "factory/space/space_lp.h"
+#include "factory/space/space_quant.h"
 #include "factory/space/space_scalar.h"
 #include "factory/space/space_sparse_lp.h"
 #include "factory/space/space_sparse_scalar.h"
@@ -86,6 +87,14 @@ inline void initSpaces() {
   REGISTER_SPACE_CREATOR(double, SPACE_COSINE_SIMILARITY, CreateCosineSimilarity)
   REGISTER_SPACE_CREATOR(float,  SPACE_ANGULAR_DISTANCE, CreateAngularDistance)
   REGISTER_SPACE_CREATOR(double, SPACE_ANGULAR_DISTANCE, CreateAngularDistance)
+  REGISTER_SPACE_CREATOR(float,  SPACE_COSINE_SIMILARITY_FAST, CreateCosineSimilarityFast)
+  REGISTER_SPACE_CREATOR(double, SPACE_COSINE_SIMILARITY_FAST, CreateCosineSimilarityFast)
+  REGISTER_SPACE_CREATOR(float,  SPACE_ANGULAR_DISTANCE_FAST, CreateAngularDistanceFast)
+  REGISTER_SPACE_CREATOR(double, SPACE_ANGULAR_DISTANCE_FAST, CreateAngularDistanceFast)
+
+  // Scalar-quantized dense vectors
+  REGISTER_SPACE_CREATOR(float,  SPACE_L2_SQ, CreateL2SQ)
+  REGISTER_SPACE_CREATOR(float,  SPACE_COSINE_SIMILARITY_SQ, CreateCosineSimilaritySQ)
 
   // Sparse
   REGISTER_SPACE_CREATOR(float,  SPACE_SPARSE_L, CreateSparseL)
@@ -35,6 +35,19 @@ Index<dist_t>* CreateGHTree(bool PrintProgress,
     return new GHTree<dist_t>(space, DataObjects, AllParams);
 }
 
+template <typename dist_t>
+Index<dist_t>* LoadGHTree(const string& Location,
+                           const string& SpaceType,
+                           const Space<dist_t>* space,
+                           const ObjectVector& DataObjects,
+                           const AnyParams& AllParams) {
+    unique_ptr<GHTree<dist_t>> index(new GHTree<dist_t>(space, DataObjects, AllParams,
+                                                       true  /* use random center */,
+                                                       false /* don't build the index */));
+    index->LoadIndex(Location);
+    return index.release();
+}
+
 /*
  * End of creating functions.
  */
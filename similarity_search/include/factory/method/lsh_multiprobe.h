@@ -49,6 +49,13 @@ Index<dist_t>* CreateLSHMultiprobe(bool PrintProgress,
     pmgr.GetParamOptional("tuneK",  LSH_TuneK);
     pmgr.GetParamOptional("desiredRecall",  DesiredRecall);
 
+    // For the range search
+    unsigned  RangeT = LSH_T;
+    float     RangeRecall = 0;
+
+    pmgr.GetParamOptional("rangeT",  RangeT);
+    pmgr.GetParamOptional("rangeRecall",  RangeRecall);
+
     if (SpaceType != "l2") LOG(LIB_FATAL) << "Multiprobe LSH works only with L2";
 
     // For FitData():
@@ -81,7 +88,9 @@ Index<dist_t>* CreateLSHMultiprobe(bool PrintProgress,
                   LSH_T,
                   LSH_H,
                   LSH_M,
-                  LSH_W
+                  LSH_W,
+                  RangeT,
+                  RangeRecall
                   );
 }
 
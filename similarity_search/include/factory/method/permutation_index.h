@@ -25,12 +25,15 @@ namespace similarity {
  * Creating functions.
  */
 
+/*
+ * Both creating and loading functions parse parameters here,
+ * so that a loaded index has the same defaults as a new one.
+ */
 template <typename dist_t>
-Index<dist_t>* CreatePermutationIndex(bool PrintProgress,
-                           const string& SpaceType,
-                           const Space<dist_t>* space,
+PermutationIndex<dist_t>* NewPermutationIndex(const Space<dist_t>* space,
                            const ObjectVector& DataObjects,
-                           const AnyParams& AllParams) {
+                           const AnyParams& AllParams,
+                           bool BuildIndex) {
   AnyParamManager pmgr(AllParams);
 
   double    DbScanFrac = 0.05;
@@ -47,9 +50,31 @@ Index<dist_t>* CreatePermutationIndex(bool PrintProgress,
                                       DataObjects,
                                       NumPivot,
                                       DbScanFrac,
-                                      SpearmanRhoSIMD
+                                      SpearmanRhoSIMD,
+                                      BuildIndex
                                      );
+}
+
+template <typename dist_t>
+Index<dist_t>* CreatePermutationIndex(bool PrintProgress,
+                           const string& SpaceType,
+                           const Space<dist_t>* space,
+                           const ObjectVector& DataObjects,
+                           const AnyParams& AllParams) {
+  return NewPermutationIndex(space, DataObjects, AllParams, true);
+}
 
+template <typename dist_t>
+Index<dist_t>* LoadPermutationIndex(const string& Location,
+                           const string& SpaceType,
+                           const Space<dist_t>* space,
+                           const ObjectVector& DataObjects,
+                           const AnyParams& AllParams) {
+  unique_ptr<PermutationIndex<dist_t>> index(
+                          NewPermutationIndex(space, DataObjects, AllParams,
+                                              false /* don't build the index */));
+  index->LoadIndex(Location);
+  return index.release();
 }
 
 /*
@@ -40,6 +40,25 @@ Index<dist_t>* CreatePivotNeighbInvertedIndex(
   );
 }
 
+template <typename dist_t>
+Index<dist_t>* LoadPivotNeighbInvertedIndex(
+    const string& Location,
+    const string& SpaceType,
+    const Space<dist_t>* space,
+    const ObjectVector& DataObjects,
+    const AnyParams& AllParams) {
+
+  unique_ptr<PivotNeighbInvertedIndex<dist_t>> index(
+    new PivotNeighbInvertedIndex<dist_t>(
+      space,
+      DataObjects,
+      AllParams,
+      false /* don't build the index */
+  ));
+  index->LoadIndex(Location);
+  return index.release();
+}
+
 /*
  * End of creating functions.
  */
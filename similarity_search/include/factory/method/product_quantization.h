@@ -0,0 +1,59 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#ifndef _FACTORY_PRODUCT_QUANTIZATION_H_
+#define _FACTORY_PRODUCT_QUANTIZATION_H_
+
+#include <method/product_quantization.h>
+
+namespace similarity {
+
+/*
+ * Creating functions.
+ */
+
+template <typename dist_t>
+Index<dist_t>* CreateProductQuantization(bool PrintProgress,
+                                         const string& SpaceType,
+                                         const Space<dist_t>* space,
+                                         const ObjectVector& DataObjects,
+                                         const AnyParams& AllParams) {
+  return new ProductQuantization<dist_t>(space, DataObjects, AllParams);
+}
+
+template <typename dist_t>
+Index<dist_t>* LoadProductQuantization(const string& Location,
+                                       const string& SpaceType,
+                                       const Space<dist_t>* space,
+                                       const ObjectVector& DataObjects,
+                                       const AnyParams& AllParams) {
+  unique_ptr<ProductQuantization<dist_t>> index(
+                          new ProductQuantization<dist_t>(space,
+                                                          DataObjects,
+                                                          AllParams,
+                                                          false /* don't build the index */
+                                                         ));
+  index->LoadIndex(Location);
+  return index.release();
+}
+
+/*
+ * End of creating functions.
+ */
+
+}
+
+#endif
@@ -35,6 +35,20 @@ Index<dist_t>* CreateSmallWorldRand(bool PrintProgress,
     return new SmallWorldRand<dist_t>(space, DataObjects, AllParams);
 }
 
+template <typename dist_t>
+Index<dist_t>* LoadSmallWorldRand(const string& Location,
+                                        const string& SpaceType,
+                                        const Space<dist_t>* space,
+                                        const ObjectVector& DataObjects,
+                                        const AnyParams& AllParams) {
+
+    unique_ptr<SmallWorldRand<dist_t>> index(
+                new SmallWorldRand<dist_t>(space, DataObjects, AllParams, 
+                                           false /* don't build the index */));
+    index->LoadIndex(Location);
+    return index.release();
+}
+
 /*
  * End of creating functions.
  */
@@ -25,13 +25,17 @@ namespace similarity {
 /* 
  * We have two different creating functions, 
  * b/c there can be two different oracle types.
+ * Creating and loading functions for the triangle-inequality
+ * oracle share parameter parsing, so that a loaded index has
+ * the same defaults as a new one.
  */
 template <typename dist_t>
-Index<dist_t>* CreateVPTreeTriang(bool PrintProgress,
-                           const string& SpaceType,
+VPTree<dist_t, TriangIneq<dist_t>, TriangIneqCreator<dist_t> >* NewVPTreeTriang(
+                           bool PrintProgress,
                            const Space<dist_t>* space,
                            const ObjectVector& DataObjects,
-                           const AnyParams& AllParams) {
+                           const AnyParams& AllParams,
+                           bool BuildIndex) {
     AnyParamManager pmgr(AllParams);
 
     double AlphaLeft = 1.0, AlphaRight = 1.0;
@@ -48,10 +52,34 @@ Index<dist_t>* CreateVPTreeTriang(bool PrintProgress,
                                                 OracleCreator,
                                                 space,
                                                 DataObjects,
-                                                RemainParams
+                                                RemainParams,
+                                                true /* use random center */,
+                                                BuildIndex
                                                 );
 }
 
+template <typename dist_t>
+Index<dist_t>* CreateVPTreeTriang(bool PrintProgress,
+                           const string& SpaceType,
+                           const Space<dist_t>* space,
+                           const ObjectVector& DataObjects,
+                           const AnyParams& AllParams) {
+    return NewVPTreeTriang(PrintProgress, space, DataObjects, AllParams, true);
+}
+
+template <typename dist_t>
+Index<dist_t>* LoadVPTreeTriang(const string& Location,
+                           const string& SpaceType,
+                           const Space<dist_t>* space,
+                           const ObjectVector& DataObjects,
+                           const AnyParams& AllParams) {
+    unique_ptr<VPTree<dist_t, TriangIneq<dist_t>, TriangIneqCreator<dist_t> >> index(
+                 NewVPTreeTriang(false /* print progress */, space, DataObjects, AllParams,
+                                 false /* don't build the index */));
+    index->LoadIndex(Location);
+    return index.release();
+}
+
 template <typename dist_t>
 Index<dist_t>* CreateVPTreeSample(bool PrintProgress,
                            const string& SpaceType,
@@ -0,0 +1,63 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#ifndef FACTORY_SPACE_QUANT_H
+#define FACTORY_SPACE_QUANT_H
+
+#include <space/space_quant.h>
+
+namespace similarity {
+
+/*
+ * Creating functions.
+ */
+
+inline Space<float>* CreateQuantized(SQDistType distType, const char* spaceName, const AnyParams& AllParams) {
+  AnyParamManager pmgr(AllParams);
+
+  string    codeType = "int8";
+  unsigned  rerankFactor = 0;
+
+  // Space parameters are converted to lower case
+  pmgr.GetParamOptional("code", codeType);
+  pmgr.GetParamOptional("rerank", rerankFactor);
+
+  SQCodeType type = kSQCodeInt8;
+
+  if (codeType == "fp16") {
+    type = kSQCodeFP16;
+  } else if (codeType != "int8") {
+    LOG(LIB_FATAL) << spaceName << " requires that the code parameter is either int8 or fp16";
+  }
+
+  return new SpaceQuantized(distType, type, rerankFactor);
+}
+
+inline Space<float>* CreateL2SQ(const AnyParams& AllParams) {
+  return CreateQuantized(kSQDistL2, SPACE_L2_SQ, AllParams);
+}
+
+inline Space<float>* CreateCosineSimilaritySQ(const AnyParams& AllParams) {
+  return CreateQuantized(kSQDistCosine, SPACE_COSINE_SIMILARITY_SQ, AllParams);
+}
+
+/*
+ * End of creating functions.
+ */
+
+}
+
+#endif
@@ -38,6 +38,18 @@ Space<dist_t>* CreateAngularDistance(const AnyParams& /* ignoring params */) {
   return new SpaceAngularDistance<dist_t>();
 }
 
+template <typename dist_t>
+Space<dist_t>* CreateCosineSimilarityFast(const AnyParams& /* ignoring params */) {
+  // Cosine Similarity with precomputed norms
+  return new SpaceCosineSimilarityFast<dist_t>();
+}
+
+template <typename dist_t>
+Space<dist_t>* CreateAngularDistanceFast(const AnyParams& /* ignoring params */) {
+  // Angular distance with precomputed norms
+  return new SpaceAngularDistanceFast<dist_t>();
+}
+
 /*
  * End of creating functions.
  */
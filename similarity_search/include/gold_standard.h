@@ -0,0 +1,346 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#ifndef _GOLD_STANDARD_H_
+#define _GOLD_STANDARD_H_
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+
+#include "global.h"
+#include "object.h"
+#include "space.h"
+#include "ztimer.h"
+#include "utils.h"
+#include "logging.h"
+#include "experimentconf.h"
+#include "eval_results.h"
+
+#define GOLD_STANDARD_CACHE_SIGNATURE "NMSLIBG2"
+
+namespace similarity {
+
+using std::string;
+using std::vector;
+using std::thread;
+
+// Each test set has its own cache file
+inline string GetGSCacheFileName(const string& CachePrefix, size_t TestSetId) {
+  std::stringstream str;
+  str << CachePrefix << "_" << TestSetId;
+  return str.str();
+}
+
+/*
+ * Keeps data points closest to every query, which are used to compute 
+ * the gold standard (see GoldStandard in eval_results.h). 
+ * The closest points don't depend on the method being tested. 
+ * Thus, they are computed only once for every test set 
+ * (i.e., after ExperimentConfig::SelectTestSet is called) using
+ * multiple threads: each thread processes its own subset of queries.
+ *
+ * For each query, we keep all the points within the maximum range 
+ * (of all range queries) and KNN_KEEP_FACTOR times as many points 
+ * as the maximum K (of all k-NN queries), but at least MIN_KEEP_QTY points. 
+ * If an approximate answer contains a point that is farther than all 
+ * the kept points, GoldStandard computes distances to all data points again.
+ *
+ * The closest points can also be cached in a file. The cached data is reused
+ * only if the space, the data and the query files (including their sizes and
+ * modification times), the numbers of data/query points, and the maximum K
+ * and range are the same. The object contents are not compared: if a file
+ * is modified, its modification time changes. When queries are randomly
+ * selected from the data set, the key also includes the query ids.
+ * Sequential search times are not cached: they depend on the machine.
+ */
+template <class dist_t>
+class GoldStandardManager {
+public:
+  explicit GoldStandardManager(const ExperimentConfig<dist_t>& config) : config_(config), KeepQty_(0), MaxRange_(0) {}
+
+  /*
+   * If ThreadQty is zero, the number of threads is equal to the number of cores.
+   * The sequential search time (which is used as a baseline in efficiency tests)
+   * is measured by a single thread, so that it is not affected by other threads 
+   * competing for the memory bandwidth. If the gold standard data is computed 
+   * by several threads or loaded from the cache, only a sample of queries is timed
+   * (see MeasureSeqSearchTime).
+   */
+  void Compute(unsigned ThreadQty, const string& CacheFile = "") {
+    KeepQty_  = 0;
+    MaxRange_ = 0;
+    for (unsigned K: config_.GetKNN()) {
+      KeepQty_ = std::max(KeepQty_, std::max(MIN_KEEP_QTY, KNN_KEEP_FACTOR * K));
+    }
+    for (dist_t range: config_.GetRange()) MaxRange_ = std::max(MaxRange_, range);
+
+    const string Key = GetCacheKey();
+
+    if (!CacheFile.empty() && LoadCache(CacheFile, Key)) {
+      LOG(LIB_INFO) << "Gold standard data is loaded from the cache: " << CacheFile;
+      MeasureSeqSearchTime();
+      return;
+    }
+
+    const ObjectVector& QueryObjects = config_.GetQueryObjects();
+    const size_t        QueryQty     = QueryObjects.size();
+
+    if (!ThreadQty) ThreadQty = std::max(1U, thread::hardware_concurrency());
+
+    LOG(LIB_INFO) << "Computing gold standard data using " << ThreadQty << " threads";
+
+    Closest_.assign(QueryQty, vector<ResultEntry<dist_t>>());
+    Complete_.assign(QueryQty, 0);
+    SeqSearchTime_.assign(QueryQty, 0);
+
+    if (ThreadQty == 1) {
+      ComputeThread(0, 1, true /* measure sequential search time */);
+    } else {
+      vector<thread> Threads(ThreadQty);
+
+      for (unsigned QueryPart = 0; QueryPart < ThreadQty; ++QueryPart) {
+        Threads[QueryPart] = thread(&GoldStandardManager<dist_t>::ComputeThread,
+                                    this, QueryPart, ThreadQty, false);
+      }
+      for (unsigned QueryPart = 0; QueryPart < ThreadQty; ++QueryPart) {
+        Threads[QueryPart].join();
+      }
+      MeasureSeqSearchTime();
+    }
+
+    if (!CacheFile.empty()) {
+      LOG(LIB_INFO) << "Saving gold standard data to the cache: " << CacheFile;
+      SaveCache(CacheFile, Key);
+    }
+  }
+
+  size_t GetQueryQty() const { return Closest_.size(); }
+  /*
+   * The closest data points sorted by the distance from the query.
+   * All other data points are farther from the query.
+   */
+  const vector<ResultEntry<dist_t>>& GetClosestEntries(size_t QueryId) const { return Closest_[QueryId]; }
+  // True if the closest points include all the data points
+  bool IsComplete(size_t QueryId) const { return Complete_[QueryId] != 0; }
+  uint64_t GetSeqSearchTime(size_t QueryId) const { return SeqSearchTime_[QueryId]; }
+
+private:
+  static const unsigned KNN_KEEP_FACTOR = 4;
+  static const unsigned MIN_KEEP_QTY    = 32;
+  static const size_t   SEQ_TIME_SAMPLE_QTY = 32;
+
+  void ComputeDists(const Object* query, vector<dist_t>& dists) const {
+    const Space<dist_t>*  space        = config_.GetSpace();
+    const ObjectVector&   DataObjects  = config_.GetDataObjects();
+
+    dists.resize(DataObjects.size());
+
+    for (size_t i = 0; i < DataObjects.size(); ++i) {
+      // Distance can be asymmetric, but the query is always on the right side
+      dists[i] = space->IndexTimeDistance(DataObjects[i], query);
+    }
+  }
+
+  void ComputeThread(unsigned QueryPart, unsigned ThreadQty, bool MeasureTime) {
+    const ObjectVector&   QueryObjects = config_.GetQueryObjects();
+
+    WallClockTimer  wtm;
+    vector<dist_t>  dists;
+
+    for (size_t q = QueryPart; q < QueryObjects.size(); q += ThreadQty) {
+      wtm.reset();
+      ComputeDists(QueryObjects[q], dists);
+      wtm.split();
+
+      if (MeasureTime) SeqSearchTime_[q] = wtm.elapsed();
+
+      GoldStandard<dist_t> gs(config_.GetDataObjects(), dists);
+
+      gs.SortClosest(KeepQty_);
+      if (!config_.GetRange().empty()) gs.ExtendSorted(MaxRange_);
+
+      bool complete = false;
+      gs.GetClosestEntries(Closest_[q], complete);
+      Complete_[q] = complete;
+    }
+  }
+
+  /*
+   * At most SEQ_TIME_SAMPLE_QTY evenly spaced queries are timed.
+   * Each remaining query is assigned the average time of sampled queries:
+   * only the total sequential search time is used in efficiency tests.
+   */
+  void MeasureSeqSearchTime() {
+    const ObjectVector&   QueryObjects = config_.GetQueryObjects();
+    const size_t          QueryQty     = QueryObjects.size();
+    const size_t          SampleQty    = std::min(QueryQty, SEQ_TIME_SAMPLE_QTY);
+
+    WallClockTimer  wtm;
+    vector<dist_t>  dists;
+    vector<char>    sampled(QueryQty, 0);
+    uint64_t        SampleTime = 0;
+
+    SeqSearchTime_.assign(QueryQty, 0);
+
+    for (size_t i = 0; i < SampleQty; ++i) {
+      const size_t q = i * QueryQty / SampleQty;
+
+      wtm.reset();
+      ComputeDists(QueryObjects[q], dists);
+      wtm.split();
+
+      SeqSearchTime_[q] = wtm.elapsed();
+      SampleTime += SeqSearchTime_[q];
+      sampled[q] = 1;
+    }
+    if (!SampleQty) return;
+
+    const uint64_t AvgTime = SampleTime / SampleQty;
+    for (size_t q = 0; q < QueryQty; ++q) {
+      if (!sampled[q]) SeqSearchTime_[q] = AvgTime;
+    }
+  }
+
+  static void AddFileToKey(std::stringstream& str, const string& FileName) {
+    uint64_t size  = 0;
+    int64_t  mtime = 0;
+
+    str << " file=" << FileName;
+    if (!FileName.empty() && GetFileSizeAndTime(FileName, size, mtime)) {
+      str << " size=" << size << " mtime=" << mtime;
+    }
+  }
+
+  string GetCacheKey() const {
+    const ObjectVector& QueryObjects = config_.GetQueryObjects();
+
+    std::stringstream str;
+    str << "distType="  << DistTypeName<dist_t>()
+        << " space="    << config_.GetSpace()->ToString();
+    AddFileToKey(str, config_.GetDataFile());
+    AddFileToKey(str, config_.GetQueryFile());
+    str << " dataQty="  << config_.GetDataObjects().size()
+        << " queryQty=" << QueryObjects.size()
+        << " keepQty="  << KeepQty_
+        << " maxRange=" << MaxRange_;
+
+    if (config_.GetQueryFile().empty()) {
+      // Queries are selected randomly from the data set: they are identified by their ids
+      uint64_t hash = 14695981039346656037ULL;
+      for (const Object* obj: QueryObjects) {
+        hash ^= static_cast<uint64_t>(obj->id());
+        hash *= 1099511628211ULL;
+      }
+      str << " queryIds=" << hash;
+    }
+    return str.str();
+  }
+
+  bool LoadCache(const string& CacheFile, const string& Key) {
+    std::ifstream in(CacheFile.c_str(), std::ios::binary | std::ios::in);
+    if (!in) return false;
+
+    const size_t SigSize = strlen(GOLD_STANDARD_CACHE_SIGNATURE);
+    string   sig(SigSize, 0), key;
+    uint64_t keyLen = 0;
+
+    if (!in.read(&sig[0], SigSize) || sig != GOLD_STANDARD_CACHE_SIGNATURE ||
+        !in.read(reinterpret_cast<char*>(&keyLen), sizeof keyLen) || keyLen > 16 * 1024) {
+      LOG(LIB_INFO) << "Ignoring the gold standard cache: " << CacheFile << " (wrong format)";
+      return false;
+    }
+    key.resize(keyLen);
+    if (!in.read(&key[0], keyLen) || key != Key) {
+      LOG(LIB_INFO) << "Ignoring the gold standard cache: " << CacheFile
+                    << " it was created for a different data set, query set, or space";
+      return false;
+    }
+
+    const size_t QueryQty = config_.GetQueryObjects().size();
+    const size_t DataQty  = config_.GetDataObjects().size();
+
+    Closest_.assign(QueryQty, vector<ResultEntry<dist_t>>());
+    Complete_.assign(QueryQty, 0);
+
+    for (size_t q = 0; q < QueryQty; ++q) {
+      uint64_t qty = 0;
+      if (!in.read(&Complete_[q], sizeof Complete_[q]) ||
+          !in.read(reinterpret_cast<char*>(&qty), sizeof qty) || qty > DataQty) {
+        LOG(LIB_INFO) << "Ignoring the gold standard cache: " << CacheFile << " (the file is truncated)";
+        Closest_.clear();
+        Complete_.clear();
+        return false;
+      }
+      Closest_[q].resize(qty);
+      for (ResultEntry<dist_t>& e: Closest_[q]) {
+        if (!in.read(reinterpret_cast<char*>(&e.mId), sizeof e.mId) ||
+            !in.read(reinterpret_cast<char*>(&e.mLabel), sizeof e.mLabel) ||
+            !in.read(reinterpret_cast<char*>(&e.mDist), sizeof e.mDist)) {
+          LOG(LIB_INFO) << "Ignoring the gold standard cache: " << CacheFile << " (the file is truncated)";
+          Closest_.clear();
+          Complete_.clear();
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void SaveCache(const string& CacheFile, const string& Key) const {
+    std::ofstream out(CacheFile.c_str(), std::ios::binary | std::ios::trunc | std::ios::out);
+
+    if (!out) {
+      LOG(LIB_FATAL) << "Cannot open: '" << CacheFile << "' for writing!";
+    }
+    out.exceptions(std::ios::badbit | std::ios::failbit);
+
+    uint64_t keyLen = Key.size();
+
+    out.write(GOLD_STANDARD_CACHE_SIGNATURE, strlen(GOLD_STANDARD_CACHE_SIGNATURE));
+    out.write(reinterpret_cast<const char*>(&keyLen), sizeof keyLen);
+    out.write(Key.data(), keyLen);
+
+    for (size_t q = 0; q < Closest_.size(); ++q) {
+      uint64_t qty = Closest_[q].size();
+      out.write(&Complete_[q], sizeof Complete_[q]);
+      out.write(reinterpret_cast<const char*>(&qty), sizeof qty);
+      for (const ResultEntry<dist_t>& e: Closest_[q]) {
+        out.write(reinterpret_cast<const char*>(&e.mId), sizeof e.mId);
+        out.write(reinterpret_cast<const char*>(&e.mLabel), sizeof e.mLabel);
+        out.write(reinterpret_cast<const char*>(&e.mDist), sizeof e.mDist);
+      }
+    }
+    out.close();
+  }
+
+  const ExperimentConfig<dist_t>&       config_;
+  unsigned                              KeepQty_;
+  dist_t                                MaxRange_;
+  vector<vector<ResultEntry<dist_t>>>   Closest_;
+  // Not vector<bool>: it is filled by several threads
+  vector<char>                          Complete_;
+  vector<uint64_t>                      SeqSearchTime_;
+
+  DISABLE_COPY_AND_ASSIGN(GoldStandardManager);
+};
+
+}  // namespace similarity
+
+#endif     // _GOLD_STANDARD_H_
@@ -19,6 +19,8 @@
 #include <stdio.h>
 #include <string>
 #include <vector>
+#include <utility>
+#include <stdexcept>
 
 #include "params.h"
 
@@ -26,6 +28,8 @@ namespace similarity {
 
 using std::string;
 using std::vector;
+using std::pair;
+using std::runtime_error;
 
 template <typename dist_t>
 class RangeQuery;
@@ -42,6 +46,18 @@ class Index {
   virtual ~Index() {}
   virtual void Search(RangeQuery<dist_t>* query) = 0;
   virtual void Search(KNNQuery<dist_t>* query) = 0;
+  /*
+   * Answers a batch of queries. Methods can override these functions
+   * to compare several queries against the same data (e.g., a bucket) while
+   * it is still in cache. This improves throughput, but not the latency.
+   * The default implementation answers queries one by one.
+   */
+  virtual void SearchBatch(vector<RangeQuery<dist_t>*>& queries) {
+    for (RangeQuery<dist_t>* query: queries) Search(query);
+  }
+  virtual void SearchBatch(vector<KNNQuery<dist_t>*>& queries) {
+    for (KNNQuery<dist_t>* query: queries) Search(query);
+  }
   virtual const string ToString() const = 0;
   /*
    * If a method has query time parameters that
@@ -58,6 +74,26 @@ class Index {
     AnyParams       tmpParams = tmpParamMngr.ExtractParametersExcept(GetQueryTimeParamNames());
     SetQueryTimeParamsInternal(tmpParamMngr);
   }
+  /*
+   * Statistics (name and value) collected while answering queries since
+   * query-time parameters were set (e.g., the recall predicted by a model).
+   * The experiment prints them along with efficiency metrics.
+   */
+  virtual vector<pair<string, double>> GetSearchStats() const {
+    return vector<pair<string, double>>();
+  }
+  /*
+   * Methods that can store the index on disk override SaveIndex() and
+   * LoadIndex(). The index can be loaded only for the same data set
+   * that was used to create it (see index_io.h). A method that supports
+   * loading should also register a loader in the method factory.
+   */
+  virtual void SaveIndex(const string& location) {
+    throw runtime_error("Saving of the index is not supported by the method: " + ToString());
+  }
+  virtual void LoadIndex(const string& location) {
+    throw runtime_error("Loading of the index is not supported by the method: " + ToString());
+  }
 protected:
   virtual void SetQueryTimeParamsInternal(AnyParamManager& ) {}
 };
@@ -0,0 +1,184 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#ifndef _INDEX_IO_H_
+#define _INDEX_IO_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#include "object.h"
+
+namespace similarity {
+
+using std::string;
+using std::vector;
+using std::runtime_error;
+
+/*
+ * Helpers to store indices in a simple binary format.
+ * The format is NOT portable across platforms with different endianness
+ * and/or different sizes of basic types.
+ *
+ * Indices never store objects themselves. Instead, they store
+ * positions of objects in the data set that was used to create the index.
+ * Hence, an index can be loaded only for exactly the same data set
+ * (with objects stored in the same order).
+ */
+
+#define INDEX_FILE_SIGNATURE "NMSLIB_INDEX_V1"
+
+template <typename T>
+inline void WriteBinaryPOD(std::ostream& out, const T& val) {
+  static_assert(std::is_pod<T>::value, "WriteBinaryPOD expects a POD type");
+  out.write(reinterpret_cast<const char*>(&val), sizeof(T));
+  if (!out) throw runtime_error("Error writing index data");
+}
+
+template <typename T>
+inline void ReadBinaryPOD(std::istream& in, T& val) {
+  static_assert(std::is_pod<T>::value, "ReadBinaryPOD expects a POD type");
+  in.read(reinterpret_cast<char*>(&val), sizeof(T));
+  if (!in) throw runtime_error("Error reading index data (truncated file?)");
+}
+
+inline void WriteBinaryString(std::ostream& out, const string& s) {
+  WriteBinaryPOD(out, static_cast<uint64_t>(s.size()));
+  out.write(s.data(), s.size());
+  if (!out) throw runtime_error("Error writing index data");
+}
+
+inline void ReadBinaryString(std::istream& in, string& s) {
+  uint64_t qty;
+  ReadBinaryPOD(in, qty);
+  s.resize(qty);
+  if (qty) in.read(&s[0], qty);
+  if (!in) throw runtime_error("Error reading index data (truncated file?)");
+}
+
+template <typename T>
+inline void WriteBinaryVector(std::ostream& out, const vector<T>& v) {
+  static_assert(std::is_pod<T>::value, "WriteBinaryVector expects a vector of POD elements");
+  WriteBinaryPOD(out, static_cast<uint64_t>(v.size()));
+  if (!v.empty()) out.write(reinterpret_cast<const char*>(&v[0]), v.size() * sizeof(T));
+  if (!out) throw runtime_error("Error writing index data");
+}
+
+template <typename T>
+inline void ReadBinaryVector(std::istream& in, vector<T>& v) {
+  static_assert(std::is_pod<T>::value, "ReadBinaryVector expects a vector of POD elements");
+  uint64_t qty;
+  ReadBinaryPOD(in, qty);
+  v.resize(qty);
+  if (qty) in.read(reinterpret_cast<char*>(&v[0]), qty * sizeof(T));
+  if (!in) throw runtime_error("Error reading index data (truncated file?)");
+}
+
+inline void OpenIndexFileForWriting(const string& location, std::ofstream& out) {
+  out.open(location.c_str(), std::ios::binary | std::ios::trunc | std::ios::out);
+  if (!out) throw runtime_error("Cannot open file: '" + location + "' for writing");
+}
+
+inline void OpenIndexFileForReading(const string& location, std::ifstream& in) {
+  in.open(location.c_str(), std::ios::binary | std::ios::in);
+  if (!in) throw runtime_error("Cannot open file: '" + location + "' for reading");
+}
+
+/*
+ * The header contains the method name and the number
+ * of data points: both are verified during loading.
+ */
+inline void WriteIndexHeader(std::ostream& out, const string& MethName, size_t DataQty) {
+  WriteBinaryString(out, INDEX_FILE_SIGNATURE);
+  WriteBinaryString(out, MethName);
+  WriteBinaryPOD(out, static_cast<uint64_t>(DataQty));
+}
+
+inline void ReadIndexHeader(std::istream& in, const string& MethName, size_t DataQty) {
+  string sig, name;
+  uint64_t qty;
+  ReadBinaryString(in, sig);
+  if (sig != INDEX_FILE_SIGNATURE) {
+    throw runtime_error("Not an index file or an unsupported index format version");
+  }
+  ReadBinaryString(in, name);
+  if (name != MethName) {
+    throw runtime_error("The index was created by the method '" + name +
+                        "', but we are loading it using the method '" + MethName + "'");
+  }
+  ReadBinaryPOD(in, qty);
+  if (qty != DataQty) {
+    std::stringstream err;
+    err << "The index was created for " << qty << " data points, "
+        << "but the current data set has " << DataQty << " data points";
+    throw runtime_error(err.str());
+  }
+}
+
+/*
+ * Maps objects to their positions in the data set. Objects are identified
+ * by their ids rather than by pointers, because some methods store copies
+ * of data set objects (see CreateCacheOptimizedBucket). Thus, to be saved,
+ * the data set must have unique object ids.
+ */
+class ObjectPositionMap {
+public:
+  explicit ObjectPositionMap(const ObjectVector& data) {
+    for (size_t i = 0; i < data.size(); ++i) {
+      if (!pos_.insert(std::make_pair(data[i]->id(), i)).second) {
+        std::stringstream err;
+        err << "Cannot save the index, because the data set has a duplicate object id: " << data[i]->id();
+        throw runtime_error(err.str());
+      }
+    }
+  }
+  uint64_t GetPos(const Object* obj) const {
+    auto it = pos_.find(obj->id());
+    if (it == pos_.end()) throw runtime_error("Bug: the object isn't found in the data set");
+    return it->second;
+  }
+private:
+  std::unordered_map<IdType, uint64_t> pos_;
+};
+
+inline const Object* GetObjectByPos(const ObjectVector& data, uint64_t pos) {
+  if (pos >= data.size()) throw runtime_error("Corrupt index file: an object position is out of range");
+  return data[pos];
+}
+
+/*
+ * Saves/loads a list of data set objects (e.g., pivots) as a list of positions.
+ */
+inline void WriteObjectPositions(std::ostream& out, const ObjectPositionMap& objPos, const ObjectVector& objs) {
+  vector<uint64_t> pos;
+  for (const Object* obj: objs) pos.push_back(objPos.GetPos(obj));
+  WriteBinaryVector(out, pos);
+}
+
+inline void ReadObjectPositions(std::istream& in, const ObjectVector& data, ObjectVector& objs) {
+  vector<uint64_t> pos;
+  ReadBinaryVector(in, pos);
+  objs.clear();
+  for (uint64_t p: pos) objs.push_back(GetObjectByPos(data, p));
+}
+
+}  // namespace similarity
+
+#endif     // _INDEX_IO_H_
@@ -17,6 +17,9 @@
 #ifndef _KNNQUERY_H_
 #define _KNNQUERY_H_
 
+#include <vector>
+#include <utility>
+
 #include "object.h"
 #include "query.h"
 
@@ -44,9 +47,31 @@ class KNNQuery : public Query<dist_t> {
   float GetEPS() const { return eps_; }
 
   void Reset();
+  /*
+   * If the space re-ranks k-NN candidates (see Space::GetRerankQty),
+   * all distances computed by the query are approximate (see Space::ProxyDistance),
+   * and the search collects more than K candidates. This function re-computes 
+   * their distances using the real distance and keeps K closest candidates.
+   * Result() and ResultSize() call it, so they never return unranked candidates.
+   * Before that, Radius() is computed using the candidates, which is what
+   * search methods need. Calling this function explicitly lets one 
+   * include the re-ranking time into the search time.
+   * If there is no re-ranking, or candidates are already re-ranked, it does nothing.
+   */
+  void Rerank() const;
+  /*
+   * If the space re-ranks k-NN candidates, the distance should be computed
+   * by the query (e.g., using DistanceObjLeft), so that it is approximate as well.
+   */
   bool CheckAndAddToResult(const dist_t distance, const Object* object);
   bool CheckAndAddToResult(const Object* object);
   size_t CheckAndAddToResult(const ObjectVector& bucket);
+  size_t CheckAndAddToResult(const Object* const* objs, size_t qty);
+  /*
+   * Adds candidates (and distance computations) of another query with the same
+   * query object, e.g., of a query that searched a part of the data in another thread.
+   */
+  void Merge(const KNNQuery<dist_t>& other);
 
   bool Equals(const KNNQuery<dist_t>* query) const;
   void Print() const;
@@ -55,7 +80,16 @@ class KNNQuery : public Query<dist_t> {
  protected:
   unsigned K_;
   float eps_;
+  // The number of candidates to be re-ranked, it is equal to K_, if there is no re-ranking
+  unsigned RerankQty_;
+  // Candidates are re-ranked lazily, when the result is requested (see Rerank)
+  mutable bool reranked_;
   KNNQueue<dist_t>* result_;
+  // Distances to bucket objects (the buffer is reused by all buckets)
+  std::vector<std::pair<dist_t, const Object*>> batch_;
+  std::vector<dist_t>                            batchDists_;
+
+  bool AddToResult(const dist_t distance, const Object* object);
 
   // disable copy and assign
   DISABLE_COPY_AND_ASSIGN(KNNQuery);
@@ -17,65 +17,119 @@
 #ifndef _KNN_QUEUE_H_
 #define _KNN_QUEUE_H_
 
-#include <queue>
 #include <vector>
 #include <utility>
 #include <limits>
+#include <algorithm>
 
 #include "global.h"
 #include "object.h"
 
 namespace similarity {
 
+/*
+ * A max-heap of (at most) K closest objects: the farthest one is on top.
+ * Unlike std::priority_queue, the heap is kept in a single preallocated
+ * array, so that pushing an element never allocates memory and replacing
+ * the farthest element requires only one sift-down. The elements
+ * can also be accessed without popping them (or cloning the queue).
+ */
 template <typename dist_t>
 class KNNQueue {
  public:
-  KNNQueue(unsigned K) : K_(K) {}
+  typedef std::pair<dist_t, const Object*> QueueElement;
+
+  KNNQueue(unsigned K) : K_(K) { heap_.reserve(K); }
 
   ~KNNQueue() {}
 
-  void Reset() { QueueType empty; std::swap(empty, queue_); }
+  void Reset() { heap_.clear(); }
 
-  bool Empty() const { return queue_.empty(); }
+  bool Empty() const { return heap_.empty(); }
 
-  size_t Size() const { return queue_.size(); }
+  size_t Size() const { return heap_.size(); }
 
   dist_t TopDistance() const {
-    return queue_.empty()
+    return heap_.empty()
         ? std::numeric_limits<dist_t>::max()
-        : queue_.top().first;
+        : heap_.front().first;
   }
 
-  const Object* TopObject() const { return queue_.top().second; }
+  const Object* TopObject() const { return heap_.front().second; }
 
   const Object* Pop() {
     const Object* top_object = TopObject();
-    queue_.pop();
+    std::pop_heap(heap_.begin(), heap_.end());
+    heap_.pop_back();
     return top_object;
   }
 
   void Push(const dist_t distance, const Object* object) {
     if (Size() < K_) {
-      queue_.push(QueueElement(distance, object));
+      heap_.push_back(QueueElement(distance, object));
+      std::push_heap(heap_.begin(), heap_.end());
     } else {
-      if (TopDistance() > distance) {
-        Pop();
-        queue_.push(QueueElement(distance, object));
+      // The heap is empty only if K is zero
+      if (!heap_.empty() && TopDistance() > distance) {
+        ReplaceTop(QueueElement(distance, object));
       }
     }
   }
 
+  /*
+   * Is equivalent to calling Push for every element,
+   * returns the number of elements that were added.
+   */
+  size_t PushBatch(const QueueElement* elems, size_t qty) {
+    size_t i = 0;
+
+    for (; i < qty && Size() < K_; ++i) {
+      heap_.push_back(elems[i]);
+      std::push_heap(heap_.begin(), heap_.end());
+    }
+    size_t res = i;
+    for (; i < qty && !heap_.empty(); ++i) {
+      if (TopDistance() > elems[i].first) {
+        ReplaceTop(elems[i]);
+        ++res;
+      }
+    }
+    return res;
+  }
+
+  // The elements are in the heap order
+  const std::vector<QueueElement>& GetElements() const { return heap_; }
+
+  // Copies elements sorted in the order of increasing distances
+  void GetSortedElements(std::vector<QueueElement>& res) const {
+    res = heap_;
+    std::sort_heap(res.begin(), res.end());
+  }
+
   KNNQueue* Clone() const {
     KNNQueue* clone = new KNNQueue(K_);
-    clone->queue_ = queue_;
+    clone->heap_ = heap_;
     return clone;
   }
 
  private:
-  typedef std::pair<dist_t, const Object*> QueueElement;
-  typedef std::priority_queue<QueueElement> QueueType;
+  // Replaces the farthest element and sifts the new one down
+  void ReplaceTop(const QueueElement& elem) {
+    const size_t qty = heap_.size();
+    size_t       curr = 0;
+
+    while (true) {
+      size_t child = 2 * curr + 1;
+      if (child >= qty) break;
+      if (child + 1 < qty && heap_[child] < heap_[child + 1]) ++child;
+      if (!(elem < heap_[child])) break;
+      heap_[curr] = heap_[child];
+      curr = child;
+    }
+    heap_[curr] = elem;
+  }
 
-  QueueType queue_;
+  std::vector<QueueElement> heap_;
   unsigned K_;
 
   // disable copy and assign
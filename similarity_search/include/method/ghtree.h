@@ -17,8 +17,11 @@
 #ifndef _METRIC_GHTREE_H_
 #define _METRIC_GHTREE_H_
 
+#include <iostream>
+
 #include "index.h"
 #include "params.h"
+#include "index_io.h"
 
 #define METH_GHTREE                 "ghtree"
 
@@ -30,6 +33,7 @@ namespace similarity {
 
 template <typename dist_t>
 class Space;
+class ParallelTreeBuilder;
 
 template <typename dist_t>
 class GHTree : public Index<dist_t> {
@@ -37,25 +41,42 @@ class GHTree : public Index<dist_t> {
   GHTree(const Space<dist_t>* space,
          const ObjectVector& data,
          const AnyParams& MethParams,
-         bool use_random_center = true);
+         bool use_random_center = true,
+         bool BuildIndex = true);
   ~GHTree();
 
   const std::string ToString() const;
   void Search(RangeQuery<dist_t>* query);
   void Search(KNNQuery<dist_t>* query);
 
+  virtual void SaveIndex(const string& location);
+  virtual void LoadIndex(const string& location);
+
+  // maxLeavesToVisit can be changed without rebuilding the tree
+  virtual vector<string> GetQueryTimeParamNames() const;
+
  private:
+  virtual void SetQueryTimeParamsInternal(AnyParamManager& );
+
   class GHNode {
    public:
+    /*
+     * If builder isn't NULL, pivot distances are computed in parallel
+     * and small subtrees are created later by the builder's threads.
+     */
     GHNode(const Space<dist_t>* space, ObjectVector& data,
            size_t bucket_size, bool chunk_bucket,
-           const bool use_random_center, bool is_root);
+           const bool use_random_center, bool is_root,
+           ParallelTreeBuilder* builder);
     ~GHNode();
 
     template <typename QueryType>
     void GenericSearch(QueryType* query, int& MaxLeavesToVisit);
 
    private:
+    // Used only to load the index
+    GHNode() : pivot1_(NULL), pivot2_(NULL), left_child_(NULL), right_child_(NULL),
+               bucket_(NULL), CacheOptimizedBucket_(NULL) {}
 
     const Object* pivot1_;
     const Object* pivot2_;
@@ -66,11 +87,17 @@ class GHTree : public Index<dist_t> {
     friend class GHTree;
   };
 
+  void    SaveNode(std::ostream& out, const ObjectPositionMap& objPos, const GHNode* node) const;
+  GHNode* LoadNode(std::istream& in) const;
+
+  const ObjectVector&  data_;
+
   GHNode* root_;
 
   size_t                    BucketSize_;
   int                       MaxLeavesToVisit_;
   bool                      ChunkBucket_;
+  size_t                    IndexThreadQty_;
 
   // disable copy and assign
   DISABLE_COPY_AND_ASSIGN(GHTree);
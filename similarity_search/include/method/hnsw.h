@@ -0,0 +1,154 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#ifndef _HNSW_H_
+#define _HNSW_H_
+
+#include "index.h"
+#include "params.h"
+#include "method/visited_list_pool.h"
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#define METH_HNSW                 "hnsw"
+
+namespace similarity {
+
+using std::string;
+using std::vector;
+using std::mutex;
+using std::unique_lock;
+using std::priority_queue;
+
+template <typename dist_t>
+class Space;
+
+/*
+ * A hierarchical version of the small world graph (see small_world_rand.h).
+ * Each point gets a random level l (the probability to get the level l
+ * decays exponentially) and it is inserted into graphs of levels 0, 1, ..., l.
+ * The search starts from the top level and greedily descends level by level,
+ * so that only the bottom level is searched exhaustively (using the
+ * beam search). Thus, unlike SmallWorldRand, there is no need for
+ * multiple random restarts. In addition, neighbors are selected using
+ * a heuristic that drops a candidate, if it is closer to an already
+ * selected neighbor than to the inserted point (such edges are mostly redundant).
+ *
+ * This work is described in a paper:
+ *
+ * Malkov, Yu. A., and D. A. Yashunin. "Efficient and robust approximate nearest
+ * neighbor search using Hierarchical Navigable Small World graphs." arXiv:1603.09320 (2016).
+ */
+template <typename dist_t>
+class Hnsw : public Index<dist_t> {
+public:
+  /*
+   * If BuildIndex is false, the index is not created:
+   * it is expected to be loaded using LoadIndex().
+   */
+  Hnsw(const Space<dist_t>* space,
+       const ObjectVector& data,
+       const AnyParams& MethParams,
+       bool BuildIndex = true);
+  ~Hnsw();
+
+  const std::string ToString() const;
+  void Search(RangeQuery<dist_t>* query);
+  void Search(KNNQuery<dist_t>* query);
+
+  virtual void SaveIndex(const string& location);
+  virtual void LoadIndex(const string& location);
+
+  virtual vector<string> GetQueryTimeParamNames() const;
+
+  // Is used by indexing threads
+  void AddNode(const Space<dist_t>* space, size_t id);
+
+private:
+  virtual void SetQueryTimeParamsInternal(AnyParamManager& );
+
+  typedef std::pair<dist_t, unsigned> DistNodePair;
+  // The farthest element is on top
+  typedef priority_queue<DistNodePair> FarthestQueue;
+  // The closest element is on top
+  typedef priority_queue<DistNodePair, vector<DistNodePair>, std::greater<DistNodePair>> ClosestQueue;
+
+  class HnswNode {
+  public:
+    HnswNode(int level) : friends_(level + 1) {}
+    int GetLevel() const { return static_cast<int>(friends_.size()) - 1; }
+
+    /*
+     * During indexing, friends can be accessed only
+     * after locking the mutex. When the index is created,
+     * the graph is read-only and the search doesn't need locking.
+     */
+    vector<vector<unsigned>>  friends_;
+    mutex                     accessGuard_;
+  };
+
+  /*
+   * Greedily moves to the closest neighbor on a given level
+   * until there's no neighbor closer than the current node.
+   */
+  template <typename DistFunc>
+  void GreedySearchLevel(const DistFunc& distFunc, int level, bool lockNodes,
+                         unsigned& curr, dist_t& currDist) const;
+  /*
+   * The beam search on a given level: it returns (at most) ef closest nodes.
+   */
+  template <typename DistFunc>
+  void SearchLevel(const DistFunc& distFunc, int level, bool lockNodes,
+                   unsigned entry, dist_t entryDist, size_t ef,
+                   VisitedList& visited, FarthestQueue& result) const;
+  /*
+   * The heuristic selects at most MaxQty neighbors (in the order
+   * of increasing distances) and drops a candidate, if it is closer to
+   * an already selected neighbor than to the base point.
+   */
+  void SelectNeighbors(const Space<dist_t>* space,
+                       vector<DistNodePair>& candidates, size_t MaxQty,
+                       vector<unsigned>& selected) const;
+
+  size_t MaxFriendQty(int level) const { return level ? M_ : 2 * M_; }
+
+  size_t  M_;
+  size_t  efConstruction_;
+  size_t  efSearch_;
+  size_t  indexThreadQty_;
+  double  mult_;
+
+  const ObjectVector&   data_;
+  vector<HnswNode*>     nodes_;
+
+  // The entry point is the (first) node of the highest level
+  mutable mutex   EntryGuard_;
+  unsigned        EnterPoint_;
+  int             MaxLevel_;
+
+  std::unique_ptr<VisitedListPool> VisitedListPool_;
+
+  DISABLE_COPY_AND_ASSIGN(Hnsw);
+};
+
+}
+
+#endif
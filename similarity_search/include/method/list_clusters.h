@@ -46,6 +46,9 @@ class ListClusters : public Index<dist_t> {
   void Search(RangeQuery<dist_t>* query);
   void Search(KNNQuery<dist_t>* query);
 
+  void SearchBatch(vector<RangeQuery<dist_t>*>& queries);
+  void SearchBatch(vector<KNNQuery<dist_t>*>& queries);
+
   virtual vector<string> GetQueryTimeParamNames() const;
 
   static const Object* SelectNextCenter(
@@ -57,6 +60,8 @@ class ListClusters : public Index<dist_t> {
 
   template <typename QueryType>
   void GenSearch(QueryType* query);
+  template <typename QueryType>
+  void GenSearchBatch(vector<QueryType*>& queries);
 
   class Cluster {
    public:
@@ -73,6 +78,8 @@ class ListClusters : public Index<dist_t> {
 
     template <typename QueryType>
     void Search(QueryType* query) const;
+    template <typename QueryType>
+    void SearchBatch(const vector<QueryType*>& queries) const;
 
    private:
     const Object* center_;
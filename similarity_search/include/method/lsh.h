@@ -20,6 +20,7 @@
 #include "index.h"
 #include "space.h"
 #include "lshkit.h"
+#include "method/lsh_space.h"
 
 #define METH_LSH_THRESHOLD          "lsh_threshold"
 #define METH_LSH_CAUCHY             "lsh_cauchy"
@@ -44,7 +45,7 @@ template <typename lsh_t>
 class ParameterCreator {
  public:
   static typename lsh_t::Parameter GetParameter(
-    const lshkit::FloatMatrix& matrix,
+    const LSHObjectMatrix& matrix,
     unsigned H, unsigned M, float W) {
     LOG(LIB_FATAL) << "not allowed dummy parameter creator";
     return lsh_t::Parameter();
@@ -59,7 +60,7 @@ template <>
 class ParameterCreator<TailRepeatHashThreshold> {
  public:
   static TailRepeatHashThreshold::Parameter GetParameter(
-    const lshkit::FloatMatrix& matrix,
+    const LSHObjectMatrix& matrix,
     unsigned H, unsigned M, float W) {
     TailRepeatHashThreshold::Parameter param;
     param.range = H;
@@ -86,7 +87,7 @@ template <>
 class ParameterCreator<TailRepeatHashCauchy> {
  public:
   static TailRepeatHashCauchy::Parameter GetParameter(
-    const lshkit::FloatMatrix& matrix,
+    const LSHObjectMatrix& matrix,
     unsigned H, unsigned M, float W) {
     TailRepeatHashCauchy::Parameter param;
     param.range = H;
@@ -105,7 +106,7 @@ template <>
 class ParameterCreator<TailRepeatHashGaussian> {
  public:
   static TailRepeatHashGaussian::Parameter GetParameter(
-    const lshkit::FloatMatrix& matrix,
+    const LSHObjectMatrix& matrix,
     unsigned H, unsigned M, float W) {
     TailRepeatHashGaussian::Parameter param;
     param.range = H;
@@ -143,7 +144,8 @@ class LSH : public Index<dist_t> {
 
   const ObjectVector& data_;
   int p_;
-  lshkit::FloatMatrix* matrix_;
+  // Vectors are read directly from data_
+  LSHObjectMatrix matrix_;
   LshIndexType* index_;
 
   // disable copy and assign
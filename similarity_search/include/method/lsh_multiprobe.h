@@ -17,9 +17,12 @@
 #ifndef _LSH_MULTI_PROBE_H_
 #define _LSH_MULTI_PROBE_H_
 
+#include <atomic>
+
 #include "index.h"
 #include "space.h"
 #include "lshkit.h"
+#include "method/lsh_space.h"
 
 #define METH_LSH_MULTIPROBE         "lsh_multiprobe"
 
@@ -50,7 +53,10 @@ class MultiProbeLSH : public Index<dist_t> {
                 unsigned T,           // # of bins probed in each hash table
                 unsigned H,           // hash table size
                 int      M,           // # of hash functions
-                float  W              // width
+                float  W,             // width
+                // for range search
+                unsigned RangeT,      // max # of bins probed in each hash table
+                float    RangeRecall  // desired recall (0 means always probe RangeT bins)
                 );
   ~MultiProbeLSH();
 
@@ -58,15 +64,41 @@ class MultiProbeLSH : public Index<dist_t> {
   void Search(RangeQuery<dist_t>* query);
   void Search(KNNQuery<dist_t>* query);
 
+  /*
+   * rangeT and rangeRecall (parameters of the range search)
+   * can be changed without rebuilding the index.
+   */
+  virtual vector<string> GetQueryTimeParamNames() const;
+
+  /*
+   * Reports the average recall of range queries predicted by the recall model
+   * (the statistics is reset when query-time parameters are set).
+   */
+  virtual vector<pair<string, double>> GetSearchStats() const;
+
  private:
+  virtual void SetQueryTimeParamsInternal(AnyParamManager& );
+
   typedef lshkit::MultiProbeLshIndex<unsigned> LshIndexType;
 
   const ObjectVector& data_;
   int dim_;
-  lshkit::FloatMatrix* matrix_;
+  // Vectors are read directly from data_
+  LSHObjectMatrix matrix_;
   LshIndexType* index_;
   unsigned T_;
   float R_;
+  unsigned RangeT_;
+  float RangeRecall_;
+
+  /*
+   * Statistics are updated by concurrent range queries, so they are atomic.
+   * The sum of predicted recall values is kept in fixed point 
+   * (see RANGE_RECALL_SCALE), because there's no atomic addition for doubles.
+   */
+  static const uint64_t RANGE_RECALL_SCALE = 1000000;
+  std::atomic<uint64_t> RangeQueryQty_;
+  std::atomic<uint64_t> RangeRecallSum_;
 
   // disable copy and assign
   DISABLE_COPY_AND_ASSIGN(MultiProbeLSH);
@@ -18,10 +18,65 @@
 #define _LSH_SPACE_H_
 
 #include <cmath>
+#include <boost/dynamic_bitset.hpp>
+
+#include "object.h"
 #include "knnquery.h"
 
 namespace similarity {
 
+/*
+ * A read-only replacement of lshkit::FloatMatrix: the i-th vector is read
+ * directly from the buffer of the i-th data object, so the data isn't copied.
+ * All objects must be dense float vectors of the same dimensionality.
+ */
+class LSHObjectMatrix {
+ public:
+  explicit LSHObjectMatrix(const ObjectVector& data) : data_(data), dim_(0) {
+    CHECK(!data.empty());
+    const size_t datalength = data[0]->datalength();
+    for (const Object* obj : data) {
+      CHECK(datalength == obj->datalength());
+    }
+    dim_ = static_cast<int>(datalength / sizeof(float));
+  }
+
+  const float* operator[](int i) const {
+    return reinterpret_cast<const float*>(data_[i]->data());
+  }
+
+  int getDim() const { return dim_; }
+  int getSize() const { return static_cast<int>(data_.size()); }
+
+  // The same interface as lshkit::FloatMatrix::Accessor
+  class Accessor {
+   public:
+    typedef unsigned Key;
+    typedef const float* Value;
+
+    explicit Accessor(const LSHObjectMatrix& matrix)
+        : matrix_(matrix), flags_(matrix.getSize()) {}
+
+    void reset() { flags_.reset(); }
+
+    bool mark(unsigned key) {
+      if (flags_[key]) return false;
+      flags_.set(key);
+      return true;
+    }
+
+    const float* operator()(unsigned key) const { return matrix_[key]; }
+
+   private:
+    const LSHObjectMatrix&   matrix_;
+    boost::dynamic_bitset<>  flags_;
+  };
+
+ private:
+  const ObjectVector& data_;
+  int                 dim_;
+};
+
 float LSHLp(const float* x, const float* y, const int dim, const int p);
 
 template <typename dist_t>
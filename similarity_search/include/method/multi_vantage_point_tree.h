@@ -32,6 +32,7 @@ namespace similarity {
 
 template <typename dist_t>
 class Space;
+class ParallelTreeBuilder;
 
 template <typename dist_t>
 class MultiVantagePointTree : public Index<dist_t> {
@@ -45,7 +46,12 @@ class MultiVantagePointTree : public Index<dist_t> {
   void Search(RangeQuery<dist_t>* query);
   void Search(KNNQuery<dist_t>* query);
 
+  // maxLeavesToVisit can be changed without rebuilding the tree
+  virtual vector<string> GetQueryTimeParamNames() const;
+
  private:
+  virtual void SetQueryTimeParamsInternal(AnyParamManager& );
+
   struct Entry;
 
   typedef std::vector<dist_t> Dists;
@@ -150,7 +156,11 @@ class MultiVantagePointTree : public Index<dist_t> {
     friend class MultiVantagePointTree;
   };
 
-  Node* BuildTree(const Space<dist_t>* space, Entries& entries);
+  /*
+   * If builder isn't NULL, pivot distances are computed in parallel
+   * and small subtrees are created later by the builder's threads.
+   */
+  Node* BuildTree(const Space<dist_t>* space, Entries& entries, ParallelTreeBuilder* builder);
 
   template <typename QueryType>
   void GenericSearch(Node* node, QueryType* query, Dists& path, size_t query_path_len, int& MaxLeavesToVisit);
@@ -162,6 +172,7 @@ class MultiVantagePointTree : public Index<dist_t> {
   size_t BucketSize_;     // the maximum fanout for the leaf nodes (K)
   bool   ChunkBucket_;
   int    MaxLeavesToVisit_;
+  size_t IndexThreadQty_;
 
 
   // disable copy and assign
@@ -0,0 +1,114 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#ifndef _PARALLEL_TREE_BUILDER_H_
+#define _PARALLEL_TREE_BUILDER_H_
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+#include "global.h"
+#include "work_stealing_pool.h"
+
+namespace similarity {
+
+using std::vector;
+using std::function;
+using std::unique_ptr;
+
+/*
+ * Helps trees (VP-tree, GH-tree, MVP-tree) to create their nodes in parallel.
+ *
+ * 1. Nodes with many data points are created by the thread that builds the index,
+ *    but distances to pivots are computed in parallel (see ParallelFor).
+ * 2. Subtrees with at most GetSubtreeQty() data points are not created immediately.
+ *    Instead, they are queued as tasks (see AddSubtreeTask), which are 
+ *    carried out by the work stealing pool in Finish(). There are about 
+ *    kTasksPerThread tasks per thread, so threads rarely stay idle.
+ *    Such subtrees are created sequentially, i.e., tasks don't submit other tasks.
+ *
+ * Because nested tasks are never waited for, pool threads don't block.
+ * If a task throws an exception, ParallelFor() or Finish() rethrows 
+ * it (after all the tasks are finished), so the index constructor fails 
+ * the same way as it would fail without threads.
+ */
+class ParallelTreeBuilder {
+public:
+  ParallelTreeBuilder(unsigned ThreadQty, size_t TotalQty) :
+                      pool_(new WorkStealingPool(ThreadQty)),
+                      SubtreeQty_(TotalQty / (kTasksPerThread * pool_->GetThreadQty())) {}
+
+  size_t GetSubtreeQty() const { return SubtreeQty_; }
+
+  /*
+   * Calls f(i) for each i in [0, qty). Large ranges are split
+   * into chunks processed by pool threads. It should be called only
+   * by the thread that builds the index, before calling Finish().
+   */
+  template <typename Func>
+  void ParallelFor(size_t qty, const Func& f) {
+    size_t ChunkQty = qty / (kChunksPerThread * pool_->GetThreadQty());
+    if (ChunkQty < kMinChunkQty) ChunkQty = kMinChunkQty;
+
+    if (qty <= ChunkQty) {
+      for (size_t i = 0; i < qty; ++i) f(i);
+      return;
+    }
+    for (size_t start = 0; start < qty; start += ChunkQty) {
+      const size_t end = std::min(qty, start + ChunkQty);
+      pool_->Submit([&f, start, end]() {
+        for (size_t i = start; i < end; ++i) f(i);
+      });
+    }
+    pool_->WaitAll();
+  }
+
+  void AddSubtreeTask(const function<void()>& task) { tasks_.push_back(task); }
+
+  // Creates queued subtrees and waits until they are finished
+  void Finish() {
+    for (const function<void()>& task: tasks_) pool_->Submit(task);
+    tasks_.clear();
+    pool_->WaitAll();
+  }
+
+private:
+  static const size_t kTasksPerThread  = 8;
+  static const size_t kChunksPerThread = 4;
+  static const size_t kMinChunkQty     = 1024;
+
+  unique_ptr<WorkStealingPool>  pool_;
+  size_t                        SubtreeQty_;
+  vector<function<void()>>      tasks_;
+
+  DISABLE_COPY_AND_ASSIGN(ParallelTreeBuilder);
+};
+
+// Calls f(i) for each i in [0, qty) in parallel, if builder isn't NULL
+template <typename Func>
+inline void BuildParallelFor(ParallelTreeBuilder* builder, size_t qty, const Func& f) {
+  if (builder) {
+    builder->ParallelFor(qty, f);
+  } else {
+    for (size_t i = 0; i < qty; ++i) f(i);
+  }
+}
+
+}  // namespace similarity
+
+#endif     // _PARALLEL_TREE_BUILDER_H_
@@ -54,15 +54,25 @@ class PermBinVPTree : public Index<dist_t> {
   void Search(RangeQuery<dist_t>* query);
   void Search(KNNQuery<dist_t>* query);
 
+  vector<string> GetQueryTimeParamNames() const;
+
  private:
+  void SetQueryTimeParamsInternal(AnyParamManager& );
+
   const Space<dist_t>*      space_;
   const ObjectVector&       data_;
   size_t                    bin_threshold_;
   size_t                    bin_perm_word_qty_;
+  float                     db_scan_frac_;
   size_t                    db_scan_qty_;
   ObjectVector              pivots_;
   ObjectVector              BinPermData_;
 
+  void ComputeDbScanQty(float DbScanFrac) {
+    // db_can_qty_ should always be > 0
+    db_scan_qty_ = max(size_t(1), static_cast<size_t>(DbScanFrac * data_.size()));
+  }
+
   VPTree<int, TriangIneq<int>, TriangIneqCreator<int> >*   VPTreeIndex_;
   const SpaceBitHamming*                                   VPTreeSpace_;
 
@@ -38,21 +38,37 @@ class PermutationIndex : public Index<dist_t> {
                    const ObjectVector& data,
                    const size_t num_pivot,
                    const double db_scan_percentage,
-                   const IntDistFuncPtr perm_func);
+                   const IntDistFuncPtr perm_func,
+                   bool BuildIndex = true);
   ~PermutationIndex();
 
   const std::string ToString() const;
   void Search(RangeQuery<dist_t>* query);
   void Search(KNNQuery<dist_t>* query);
 
+  virtual void SaveIndex(const string& location);
+  virtual void LoadIndex(const string& location);
+
+  virtual vector<string> GetQueryTimeParamNames() const;
+
  private:
+  virtual void SetQueryTimeParamsInternal(AnyParamManager& );
+
   const ObjectVector& data_;
-  const size_t db_scan_;
+  double db_scan_frac_;
+  size_t db_scan_;
   const IntDistFuncPtr permfunc_;
   ObjectVector pivot_;
   std::vector<Permutation> permtable_;
 
   template <typename QueryType> void GenSearch(QueryType* query);
+  void ComputeDbScan(double db_scan_fraction) {
+    CHECK(db_scan_fraction > 0.0);
+    CHECK(db_scan_fraction <= 1.0);
+    db_scan_frac_ = db_scan_fraction;
+    // db_scan_ should always be > 0
+    db_scan_ = std::max(size_t(1), static_cast<size_t>(db_scan_fraction * data_.size()));
+  }
 
   // disable copy and assign
   DISABLE_COPY_AND_ASSIGN(PermutationIndex);
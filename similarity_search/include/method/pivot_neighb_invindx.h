@@ -63,7 +63,8 @@ class PivotNeighbInvertedIndex : public Index<dist_t> {
  public:
   PivotNeighbInvertedIndex(const Space<dist_t>* space,
                            const ObjectVector& data,
-                           const AnyParams& AllParams);
+                           const AnyParams& AllParams,
+                           bool BuildIndex = true);
 
   ~PivotNeighbInvertedIndex();
 
@@ -73,6 +74,9 @@ class PivotNeighbInvertedIndex : public Index<dist_t> {
   
   virtual vector<string> GetQueryTimeParamNames() const;
 
+  virtual void SaveIndex(const string& location);
+  virtual void LoadIndex(const string& location);
+
   void IndexChunk(size_t chunkId);
  private:
   virtual void SetQueryTimeParamsInternal(AnyParamManager& );
@@ -0,0 +1,113 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#ifndef _PRODUCT_QUANTIZATION_H_
+#define _PRODUCT_QUANTIZATION_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "index.h"
+#include "params.h"
+
+#define METH_PQ                 "pq"
+
+namespace similarity {
+
+using std::string;
+using std::vector;
+
+template <typename dist_t>
+class Space;
+
+/*
+ * Product quantization with asymmetric distance computation (ADC).
+ * A vector is split into subVectQty sub-vectors and each sub-vector is
+ * replaced by the id of the closest centroid (one byte). Centroids are obtained
+ * separately for each sub-vector by running k-means on a sample of data points.
+ *
+ * The query is not quantized: for each query, we compute a table of squared
+ * L2 distances from query sub-vectors to all centroids. Then, the distance
+ * to a data point is approximated by summing up subVectQty table entries.
+ * The shortListQty (or K, whichever is larger) data points with
+ * the smallest approximate distances are re-ranked using the real distance.
+ * The range search verifies all data points whose approximate distances
+ * don't exceed the radius, as well as shortListQty data points with
+ * the smallest approximate distances.
+ *
+ * Because candidates are always verified using original vectors, data points
+ * are not moved to the index: codes are kept in addition to them. Thus,
+ * the index doesn't save memory, it only reduces the amount of memory read
+ * per data point (subVectQty bytes instead of the whole vector).
+ *
+ * H. Jegou, M. Douze, and C. Schmid, "Product quantization for nearest neighbor search",
+ * IEEE Trans. Pattern Anal. Mach. Intell. (2011)
+ */
+template <typename dist_t>
+class ProductQuantization : public Index<dist_t> {
+ public:
+  ProductQuantization(const Space<dist_t>* space,
+                      const ObjectVector& data,
+                      const AnyParams& MethParams,
+                      bool BuildIndex = true);
+  ~ProductQuantization();
+
+  const std::string ToString() const;
+  void Search(RangeQuery<dist_t>* query);
+  void Search(KNNQuery<dist_t>* query);
+
+  virtual vector<string> GetQueryTimeParamNames() const;
+
+  virtual void SaveIndex(const string& location);
+  virtual void LoadIndex(const string& location);
+
+ private:
+  virtual void SetQueryTimeParamsInternal(AnyParamManager& );
+
+  // The first dimension of the sub-vector (the last one is SubVectStart(m + 1) - 1)
+  size_t SubVectStart(size_t m) const { return m * dim_ / subVectQty_; }
+  // Centroids of the m-th sub-vector are stored in centroids_ starting from this position
+  const dist_t* SubVectCentroids(size_t m) const { return &centroids_[centroidQty_ * SubVectStart(m)]; }
+
+  const dist_t* GetVector(const Object* obj) const;
+
+  void TrainSubVect(size_t m, const vector<size_t>& sample, unsigned seed);
+  void EncodeRange(size_t start, size_t end);
+  void ComputeDistTable(const Object* query, vector<dist_t>& table) const;
+
+  template <typename QueryType> void GenSearch(QueryType* query, size_t ShortListQty, dist_t MaxADCDist) const;
+
+  const ObjectVector&   data_;
+
+  size_t  dim_;
+  size_t  subVectQty_;
+  size_t  centroidQty_;
+  size_t  trainSampleQty_;
+  size_t  iterQty_;
+  size_t  shortListQty_;
+  size_t  indexThreadQty_;
+
+  vector<dist_t>    centroids_;
+  // subVectQty_ codes for each data point
+  vector<uint8_t>   codes_;
+
+  DISABLE_COPY_AND_ASSIGN(ProductQuantization);
+};
+
+}
+
+#endif
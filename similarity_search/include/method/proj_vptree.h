@@ -50,13 +50,23 @@ class ProjectionVPTree : public Index<dist_t> {
   void Search(RangeQuery<dist_t>* query);
   void Search(KNNQuery<dist_t>* query);
 
+  vector<string> GetQueryTimeParamNames() const;
+
  private:
+  void SetQueryTimeParamsInternal(AnyParamManager& );
+
   const SpaceSparseVector<dist_t>*  space_;
   const ObjectVector&               data_;
+  float                             db_scan_frac_;
   size_t                            db_scan_qty_;
   ObjectVector                      randProjPivots_;
   ObjectVector                      projData_;
 
+  void ComputeDbScanQty(float DbScanFrac) {
+    // db_can_qty_ should always be > 0
+    db_scan_qty_ = max(size_t(1), static_cast<size_t>(DbScanFrac * data_.size()));
+  }
+
   // Convert a sparse vector into a dense one
   Object*                           ProjectOneVect(size_t id, const Object* sparseVect) const;
 
@@ -17,21 +17,34 @@
 #define _SEQSEARCH_H_
 
 #include <string>
+#include <vector>
+#include <memory>
 
 #include "index.h"
+#include "params.h"
+#include "work_stealing_pool.h"
 
 #define METH_SEQ_SEARCH             "seq_search"
 
 namespace similarity {
 
 using std::string;
+using std::vector;
 
 // Sequential search
 
+template <typename dist_t> class Space;
+
 template <typename dist_t>
 class SeqSearch : public Index<dist_t> {
  public:
-  SeqSearch(const ObjectVector& data) : data_(data) {}
+  /*
+   * If threadQty > 1, the data is split into up to threadQty parts
+   * that are scanned in parallel: the calling thread scans the first part
+   * and remaining parts are scanned by a pool of threadQty - 1 threads.
+   * Each part has its own copies of queries, which are merged at the end.
+   */
+  SeqSearch(const Space<dist_t>* space, const ObjectVector& data, const AnyParams& MethParams);
   ~SeqSearch(){};
 
   const std::string ToString() const { return "Sequential search"; }
@@ -39,8 +52,32 @@ class SeqSearch : public Index<dist_t> {
   void Search(RangeQuery<dist_t>* query);
   void Search(KNNQuery<dist_t>* query);
 
+  void SearchBatch(vector<RangeQuery<dist_t>*>& queries);
+  void SearchBatch(vector<KNNQuery<dist_t>*>& queries);
+
  private:
+  /*
+   * The data is split into blocks of roughly BATCH_BLOCK_SIZE bytes
+   * (that should fit into the L2 cache). All queries are compared
+   * against a block before we move on to the next block.
+   */
+  static const size_t BATCH_BLOCK_SIZE = 256 * 1024;
+  // Smaller data sets are not split into parts
+  static const size_t MIN_PART_QTY = 4096;
+
+  template <typename QueryType>
+  void GenSearchBatch(vector<QueryType*>& queries);
+  // Compares queries with data points data_[start], ..., data_[end-1]
+  template <typename QueryType>
+  void ScanPart(const vector<QueryType*>& queries, size_t start, size_t end) const;
+
+  KNNQuery<dist_t>*   CreatePartQuery(const KNNQuery<dist_t>* query) const;
+  RangeQuery<dist_t>* CreatePartQuery(const RangeQuery<dist_t>* query) const;
+
+  const Space<dist_t>*    space_;
   const ObjectVector&     data_;
+  size_t                  threadQty_;
+  unique_ptr<WorkStealingPool>  pool_;
   // disable copy and assign
   DISABLE_COPY_AND_ASSIGN(SeqSearch);
 };
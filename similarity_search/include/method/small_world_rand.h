@@ -19,6 +19,8 @@
 
 #include "index.h"
 #include "params.h"
+#include "method/visited_list_pool.h"
+#include "dist_kernel.h"
 #include <set>
 #include <limits>
 #include <iostream>
@@ -59,9 +61,8 @@ class Space;
 //----------------------------------
 class MSWNode{
 public:
-  MSWNode(const Object *Obj){
-    data_ = Obj;
-  }
+  // id is the position of the object in the data set
+  MSWNode(const Object *Obj, size_t id) : data_(Obj), id_(id) {}
   ~MSWNode(){};
   void removeAllFriends(){
     friends.clear();
@@ -81,6 +82,9 @@ public:
   const Object* getData() const {
     return data_;
   }
+  size_t getId() const {
+    return id_;
+  }
   /* 
    * THIS NOTE APPLIES ONLY TO THE INDEXING PHASE:
    *
@@ -98,6 +102,7 @@ public:
 
 private:
   const Object*       data_;
+  size_t              id_;
   vector<MSWNode*>    friends;
 };
 //----------------------------------
@@ -157,9 +162,14 @@ struct SearchThreadParams {
 template <typename dist_t>
 class SmallWorldRand : public Index<dist_t> {
 public:
+  /*
+   * If BuildIndex is false, the index is not created:
+   * it is expected to be loaded using LoadIndex().
+   */
   SmallWorldRand(const Space<dist_t>* space,
                         const ObjectVector& data,
-                        const AnyParams& MethParams);
+                        const AnyParams& MethParams,
+                        bool BuildIndex = true);
   ~SmallWorldRand();
 
   typedef std::vector<MSWNode*> ElementList;
@@ -183,18 +193,53 @@ public:
 
   virtual vector<string> GetQueryTimeParamNames() const;
 
+  virtual void SaveIndex(const string& location);
+  virtual void LoadIndex(const string& location);
+
 private:
   virtual void SetQueryTimeParamsInternal(AnyParamManager& );
 
+  /*
+   * When the index is created (or loaded), the graph is frozen into a compact
+   * adjacency array: neighbors of the node representing the i-th data point
+   * are FrozenNeighbors_[FrozenOffsets_[i]], ..., FrozenNeighbors_[FrozenOffsets_[i+1]-1].
+   * The search uses only the frozen graph, which is read-only
+   * and, hence, can be accessed without locking. Indexing-time
+   * nodes (ElList_) are deleted afterwards.
+   */
+  void FreezeGraph();
+
+  // The k-NN search that computes distances using the kernel (see dist_kernel.h)
+  template <typename Kernel>
+  void SearchKernel(KNNQuery<dist_t>* query, const Kernel& kernel);
+
+  struct SearchVisitor {
+    SearchVisitor(SmallWorldRand& index, KNNQuery<dist_t>* query) : index_(index), query_(query) {}
+    template <typename Kernel>
+    void operator()(const Kernel& kernel) { index_.SearchKernel(query_, kernel); }
+    SmallWorldRand&     index_;
+    KNNQuery<dist_t>*   query_;
+  };
+
   size_t NN_;
   size_t initIndexAttempts_;
   size_t initSearchAttempts_;
   size_t size_;
   size_t indexThreadQty_;
 
+  const ObjectVector& data_;
+  // The kernel is used only for queries that fit it
+  DistKernelDesc      distKernel_;
+
   mutable mutex   ElListGuard_;
   ElementList     ElList_;
 
+  vector<size_t>    FrozenOffsets_;
+  vector<unsigned>  FrozenNeighbors_;
+
+  // Visited nodes are tracked using node ids (both during indexing and search)
+  std::unique_ptr<VisitedListPool> VisitedListPool_;
+
 protected:
 
   DISABLE_COPY_AND_ASSIGN(SmallWorldRand);
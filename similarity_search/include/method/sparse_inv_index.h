@@ -0,0 +1,143 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#ifndef _SPARSE_INV_INDEX_H_
+#define _SPARSE_INV_INDEX_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <limits>
+
+#include "index.h"
+#include "params.h"
+#include "space/space_sparse_vector.h"
+
+#define METH_SPARSE_INV_INDEX        "sparse_inv_index"
+
+namespace similarity {
+
+using std::string;
+using std::vector;
+
+/*
+ * An exact search method for sparse cosine similarity and angular distance spaces,
+ * which employs an inverted index. Short queries are evaluated document-at-a-time
+ * using the MaxScore algorithm:
+ *
+ * H. Turtle and J. Flood, "Query evaluation: strategies and optimizations",
+ * Information Processing & Management, 31(6) (1995).
+ *
+ * Postings keep normalized element values, i.e., values divided by the vector norm.
+ * Thus, the scalar product of normalized vectors is the sum of posting values multiplied
+ * by respective query element values. Given the maximum posting value of each
+ * query element, MaxScore doesn't visit data points that occur only in posting lists
+ * whose total contribution can't exceed the score of the k-th best data point found so far.
+ *
+ * Both distances decrease monotonically with the score. Scores are used only
+ * to select candidates: to obtain the answer, we compute real distances
+ * to candidates whose scores are close to (or larger than) the threshold. 
+ * If fewer than K data points have positive scores, the k-NN search
+ * also checks all remaining data points (their distances aren't smaller than
+ * the distance to any data point with a positive score).
+ *
+ * MaxScore may compare each posting with the current postings of all other lists,
+ * so its cost grows with the total length of posting lists multiplied by their number.
+ * Term-at-a-time evaluation, which accumulates scores of all data points in an array,
+ * costs roughly the number of data points plus the total length of posting lists.
+ * Thus, a query is evaluated term-at-a-time if the former product is at least
+ * taatRatio times the number of data points (see UseTAAT).
+ */
+template <typename dist_t>
+class SparseInvIndex : public Index<dist_t> {
+ public:
+  SparseInvIndex(const Space<dist_t>* space,
+                 const ObjectVector& data,
+                 const AnyParams& MethParams,
+                 bool BuildIndex = true);
+  ~SparseInvIndex();
+
+  const std::string ToString() const;
+  void Search(RangeQuery<dist_t>* query);
+  void Search(KNNQuery<dist_t>* query);
+
+  virtual vector<string> GetQueryTimeParamNames() const;
+
+  virtual void SaveIndex(const string& location);
+  virtual void LoadIndex(const string& location);
+
+ private:
+  virtual void SetQueryTimeParamsInternal(AnyParamManager& );
+
+  typedef SparseVectElem<dist_t> ElemType;
+
+  // A position in the posting list of one query element
+  struct PostCursor {
+    const uint32_t* pObjIds_;
+    const dist_t*   pVals_;
+    size_t          pos_;
+    size_t          qty_;
+    // The normalized query element value
+    dist_t          queryVal_;
+    // The maximum contribution of this element to the score
+    dist_t          maxScore_;
+
+    // Finished cursors return the maximum id
+    uint32_t ObjId() const { return pos_ < qty_ ? pObjIds_[pos_] : std::numeric_limits<uint32_t>::max(); }
+    dist_t   Score() const { return queryVal_ * pVals_[pos_]; }
+    void     SkipTo(uint32_t objId) {
+      pos_ = GallopLowerBound(pObjIds_ + pos_, pObjIds_ + qty_, objId) - pObjIds_;
+    }
+  };
+
+  // Creates cursors for query elements present in the index
+  void CreateCursors(const Object* query, vector<PostCursor>& cursors) const;
+  /*
+   * Calls Check(score, objId) for each data point whose score is larger 
+   * than (approximately) the value returned by Thresh().
+   */
+  template <typename CheckFunc, typename ThreshFunc>
+  void MaxScoreSearch(vector<PostCursor>& cursors, const CheckFunc& Check, const ThreshFunc& Thresh) const;
+  // Computes scores of all data points (term-at-a-time)
+  void TAATScores(const vector<PostCursor>& cursors, vector<dist_t>& scores) const;
+  // Should the query be evaluated term-at-a-time?
+  bool UseTAAT(const vector<PostCursor>& cursors) const;
+
+  // Converts a maximum distance to a minimum score
+  dist_t MinScore(dist_t dist) const;
+
+  const SpaceSparseVector<dist_t>*  space_;
+  const ObjectVector&               data_;
+  bool                              bAngular_;
+  double                            taatRatio_;
+
+  // Sorted element ids
+  vector<uint32_t>  termIds_;
+  // Postings of the i-th element are in the range [postOffsets_[i], postOffsets_[i+1]) 
+  vector<uint64_t>  postOffsets_;
+  // Positions of data points in the data set
+  vector<uint32_t>  postObjIds_;
+  vector<dist_t>    postVals_;
+  // The maximum and the minimum posting values of each element
+  vector<dist_t>    maxVals_;
+  vector<dist_t>    minVals_;
+
+  DISABLE_COPY_AND_ASSIGN(SparseInvIndex);
+};
+
+}
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#ifndef _VISITED_LIST_POOL_H_
+#define _VISITED_LIST_POOL_H_
+
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <cstdint>
+
+#include "global.h"
+
+namespace similarity {
+
+using std::vector;
+using std::mutex;
+using std::unique_lock;
+
+/*
+ * Keeps track of visited graph nodes, which are identified by
+ * numbers from 0 to qty-1. Instead of clearing the list, we
+ * increase the epoch: a node is visited if its tag is equal to the
+ * current epoch. Thus, the reset takes O(1) time (except for the
+ * rare case when the epoch counter wraps around).
+ */
+class VisitedList {
+public:
+  explicit VisitedList(size_t qty) : epoch_(0), tags_(qty) {}
+
+  void Reset() {
+    if (++epoch_ == 0) {
+      std::fill(tags_.begin(), tags_.end(), 0);
+      epoch_ = 1;
+    }
+  }
+  bool IsVisited(size_t id) const { return tags_[id] == epoch_; }
+  void MarkVisited(size_t id) { tags_[id] = epoch_; }
+  size_t GetSize() const { return tags_.size(); }
+
+private:
+  uint16_t          epoch_;
+  vector<uint16_t>  tags_;
+
+  DISABLE_COPY_AND_ASSIGN(VisitedList);
+};
+
+/*
+ * Visited lists are expensive to allocate, so they are reused.
+ * A search thread takes a list from the pool and returns it when
+ * it is done. Hence, the pool eventually has one list per concurrently
+ * running thread and the mutex is held only to get/return a list.
+ */
+class VisitedListPool {
+public:
+  VisitedListPool(size_t initListQty, size_t qty) : qty_(qty) {
+    for (size_t i = 0; i < initListQty; ++i) {
+      pool_.push_back(new VisitedList(qty_));
+    }
+  }
+  ~VisitedListPool() {
+    for (VisitedList* list: pool_) delete list;
+  }
+
+  // The returned list is already reset
+  VisitedList* GetFreeList() {
+    VisitedList* res = NULL;
+    {
+      unique_lock<mutex> lock(poolGuard_);
+      if (!pool_.empty()) {
+        res = pool_.back();
+        pool_.pop_back();
+      }
+    }
+    if (res == NULL) res = new VisitedList(qty_);
+    res->Reset();
+    return res;
+  }
+  void ReleaseList(VisitedList* list) {
+    unique_lock<mutex> lock(poolGuard_);
+    pool_.push_back(list);
+  }
+
+private:
+  size_t                qty_;
+  mutex                 poolGuard_;
+  vector<VisitedList*>  pool_;
+
+  DISABLE_COPY_AND_ASSIGN(VisitedListPool);
+};
+
+/*
+ * Takes a list from the pool and returns it back when goes out of scope.
+ */
+class VisitedListHolder {
+public:
+  explicit VisitedListHolder(VisitedListPool& pool) : pool_(pool), list_(pool.GetFreeList()) {}
+  ~VisitedListHolder() { pool_.ReleaseList(list_); }
+
+  VisitedList& GetList() { return *list_; }
+
+private:
+  VisitedListPool&  pool_;
+  VisitedList*      list_;
+
+  DISABLE_COPY_AND_ASSIGN(VisitedListHolder);
+};
+
+}  // namespace similarity
+
+#endif     // _VISITED_LIST_POOL_H_
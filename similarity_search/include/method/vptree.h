@@ -17,9 +17,13 @@
 #define _VPTREE_H_
 
 #include <string>
+#include <atomic>
+#include <vector>
 
 #include "index.h"
 #include "params.h"
+#include "index_io.h"
+#include "dist_kernel.h"
 
 #define METH_VPTREE          "vptree"
 #define METH_VPTREE_SAMPLE   "vptree_sample"
@@ -31,6 +35,7 @@ using std::string;
 // Vantage point tree
 
 template <typename dist_t> class Space;
+class ParallelTreeBuilder;
 
 template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
 class VPTree : public Index<dist_t> {
@@ -40,7 +45,8 @@ class VPTree : public Index<dist_t> {
          const Space<dist_t>* space,
          const ObjectVector& data,
          const AnyParams& MethParams,
-         bool use_random_center = true);
+         bool use_random_center = true,
+         bool BuildIndex = true);
   ~VPTree();
 
   const std::string ToString() const;
@@ -48,30 +54,58 @@ class VPTree : public Index<dist_t> {
   void Search(RangeQuery<dist_t>* query);
   void Search(KNNQuery<dist_t>* query);
 
+  void SearchBatch(vector<RangeQuery<dist_t>*>& queries);
+  void SearchBatch(vector<KNNQuery<dist_t>*>& queries);
+
+  /*
+   * Oracles are not saved: they are re-created using the oracle creator,
+   * which is possible only for data-independent oracles.
+   * A flattened tree is saved as its breadth-first node table
+   * and it is flattened again when loaded.
+   */
+  virtual void SaveIndex(const string& location);
+  virtual void LoadIndex(const string& location);
+
+  /*
+   * maxLeavesToVisit and parameters of the search oracle
+   * (e.g., alphaLeft and alphaRight) can be changed
+   * without rebuilding the tree.
+   */
+  virtual vector<string> GetQueryTimeParamNames() const;
+
  private:
+  virtual void SetQueryTimeParamsInternal(AnyParamManager& );
+
   class VPNode {
    public:
     // We want trees to be balanced
     const size_t BalanceConst = 4; 
 
+    /*
+     * If builder isn't NULL, pivot distances are computed in parallel
+     * and small subtrees are created later by the builder's threads.
+     */
     VPNode(bool     PrintProgress,
            unsigned level,
            size_t   TotalQty,
-           size_t&  IndexedQty,
+           std::atomic<size_t>&  IndexedQty,
            const SearchOracleCreator& OracleCreator,
            const Space<dist_t>* space, const ObjectVector& data,
            size_t BucketSize, bool ChunkBucket,
            const string& SaveHistFileName,
-           bool use_random_center, bool is_root);
+           bool use_random_center, bool is_root,
+           ParallelTreeBuilder* builder);
     ~VPNode();
 
-    template <typename QueryType>
-    void GenericSearch(QueryType* query, int& MaxLeavesToVisit);
-
    private:
     void CreateBucket(bool ChunkBucket, const ObjectVector& data, 
                       bool PrintProgress,
-                      size_t&  IndexedQty, size_t   TotalQty);
+                      std::atomic<size_t>&  IndexedQty, size_t   TotalQty);
+    // Used only to load the index
+    VPNode() : pivot_(NULL), mediandist_(0),
+               left_child_(NULL), right_child_(NULL), oracle_(NULL),
+               bucket_(NULL), CacheOptimizedBucket_(NULL) {}
+
     const Object* pivot_;
     /* 
      * Even if dist_t is double, or long double
@@ -88,11 +122,163 @@ class VPTree : public Index<dist_t> {
     friend class VPTree;
   };
 
+  /*
+   * A flattened tree occupies a single contiguous memory block (flatTree_).
+   * Nodes are stored in the breadth-first order. Each node is followed
+   * by copies of its objects: the pivot of an inner node or the objects
+   * of a bucket. Each object copy is an Object immediately followed
+   * by the object's buffer. Children are referenced by offsets.
+   * All node and object records are aligned to kFlatAlign bytes.
+   */
+  struct FlatNode {
+    uint64_t  leftChild_;     // the offset of the left child, 0 if there's no child
+    uint64_t  rightChild_;    // the offset of the right child, 0 if there's no child
+    float     mediandist_;
+    uint32_t  oracleId_;      // the index in flatOracles_
+    uint32_t  objQty_;
+    uint32_t  isBucket_;
+  };
+  static const size_t kFlatAlign = 16;
+
+  static size_t FlatObjectSize(const Object* obj) {
+    return (sizeof(Object) + obj->bufferlength() + kFlatAlign - 1) / kFlatAlign * kFlatAlign;
+  }
+
+  /*
+   * The breadth-first node table: it is used to create
+   * the flattened tree and to save/load it.
+   */
+  struct FlatNodeTable {
+    vector<uint8_t>        isBucket_;
+    vector<float>          mediandist_;
+    vector<uint32_t>       leftChild_;  // the node index, 0 if there's no child
+    vector<uint32_t>       rightChild_; // the node index, 0 if there's no child
+    vector<uint64_t>       objStart_;   // objects of the i-th node are objs_[objStart_[i]], ..., objs_[objStart_[i+1]-1]
+    ObjectVector           objs_;
+    vector<SearchOracle*>  oracles_;    // NULL for buckets
+  };
+
+  /*
+   * Search functions access nodes of both layouts
+   * via "node references" with the same interface.
+   */
+  class PtrNodeRef {
+   public:
+    explicit PtrNodeRef(const VPNode* node) : node_(node) {}
+    bool IsBucket() const { return node_->bucket_ != NULL; }
+    template <typename F>
+    void ForEachObject(const F& f) const {
+      for (const Object* obj : *node_->bucket_) f(obj);
+    }
+    const Object* Pivot() const { return node_->pivot_; }
+    float         Median() const { return node_->mediandist_; }
+    SearchOracle& Oracle() const { return *node_->oracle_; }
+    bool          HasLeft() const { return node_->left_child_ != NULL; }
+    bool          HasRight() const { return node_->right_child_ != NULL; }
+    PtrNodeRef    Left() const { return PtrNodeRef(node_->left_child_); }
+    PtrNodeRef    Right() const { return PtrNodeRef(node_->right_child_); }
+   private:
+    const VPNode* node_;
+  };
+
+  class FlatNodeRef {
+   public:
+    FlatNodeRef(VPTree& tree, uint64_t offset) : 
+      tree_(tree), node_(reinterpret_cast<const FlatNode*>(tree.flatTree_ + offset)) {}
+    bool IsBucket() const { return node_->isBucket_ != 0; }
+    template <typename F>
+    void ForEachObject(const F& f) const {
+      const char* p = reinterpret_cast<const char*>(node_ + 1);
+      for (uint32_t i = 0; i < node_->objQty_; ++i) {
+        const Object* obj = reinterpret_cast<const Object*>(p);
+        f(obj);
+        p += FlatObjectSize(obj);
+      }
+    }
+    const Object* Pivot() const { return reinterpret_cast<const Object*>(node_ + 1); }
+    float         Median() const { return node_->mediandist_; }
+    SearchOracle& Oracle() const { return tree_.flatOracles_[node_->oracleId_]; }
+    bool          HasLeft() const { return node_->leftChild_ != 0; }
+    bool          HasRight() const { return node_->rightChild_ != 0; }
+    FlatNodeRef   Left() const { return FlatNodeRef(tree_, node_->leftChild_); }
+    FlatNodeRef   Right() const { return FlatNodeRef(tree_, node_->rightChild_); }
+   private:
+    VPTree&          tree_;
+    const FlatNode*  node_;
+  };
+
+  // Distances are computed using the kernel (see dist_kernel.h)
+  template <typename NodeRef, typename QueryType, typename Kernel>
+  void GenericSearch(NodeRef node, QueryType* query, const Kernel& kernel, int& MaxLeavesToVisit);
+  /*
+   * The batch version traverses the tree once for a group of queries:
+   * qids are indices of queries (and of their leaf counters)
+   * that need to visit this node.
+   */
+  template <typename NodeRef, typename QueryType, typename Kernel>
+  void GenericSearchBatch(NodeRef node,
+                          const vector<QueryType*>& queries, 
+                          const Kernel& kernel,
+                          vector<int>& MaxLeavesToVisit,
+                          const vector<size_t>& qids);
+
+  template <typename QueryType>
+  void GenSearch(QueryType* query);
+  template <typename QueryType>
+  void GenSearchBatch(vector<QueryType*>& queries);
+  template <typename QueryType, typename Kernel>
+  void GenSearchKernel(QueryType* query, const Kernel& kernel);
+  template <typename QueryType, typename Kernel>
+  void GenSearchBatchKernel(vector<QueryType*>& queries, const Kernel& kernel);
+
+  // Visitors passed to DispatchDistKernel
+  template <typename QueryType>
+  struct SearchVisitor {
+    SearchVisitor(VPTree& tree, QueryType* query) : tree_(tree), query_(query) {}
+    template <typename Kernel>
+    void operator()(const Kernel& kernel) { tree_.GenSearchKernel(query_, kernel); }
+    VPTree&     tree_;
+    QueryType*  query_;
+  };
+  template <typename QueryType>
+  struct SearchBatchVisitor {
+    SearchBatchVisitor(VPTree& tree, vector<QueryType*>& queries) : tree_(tree), queries_(queries) {}
+    template <typename Kernel>
+    void operator()(const Kernel& kernel) { tree_.GenSearchBatchKernel(queries_, kernel); }
+    VPTree&              tree_;
+    vector<QueryType*>&  queries_;
+  };
+
+  void    SaveNode(std::ostream& out, const ObjectPositionMap& objPos, const VPNode* node) const;
+  VPNode* LoadNode(std::istream& in, unsigned level) const;
+
+  // Applies query-time parameters of the oracle creator to all oracles
+  void    UpdateOracles(VPNode* node);
+
+  // Converts the pointer-based tree into the flattened one
+  void    Flatten();
+  void    CreateFlatTree(FlatNodeTable& table);
+  // Retrieves the node table of the flattened tree (without oracles)
+  void    GetFlatNodeTable(FlatNodeTable& table) const;
+  size_t  FlatNodeSize(uint64_t offset) const;
+
+  const ObjectVector&  data_;
+  SearchOracleCreator  OracleCreator_;
+
   VPNode* root_;
+  // The flattened tree replaces root_ if flatten is set
+  char*                 flatTree_;
+  size_t                flatTreeSize_;
+  vector<SearchOracle>  flatOracles_;
+
   size_t  BucketSize_;
   int     MaxLeavesToVisit_;
   bool    ChunkBucket_;
   string  SaveHistFileName_;
+  size_t  IndexThreadQty_;
+  bool    Flatten_;
+  // The kernel is used only for queries that fit it
+  DistKernelDesc  distKernel_;
   // disable copy and assign
   DISABLE_COPY_AND_ASSIGN(VPTree);
 };
@@ -30,6 +30,13 @@ using std::string;
 
 #define REGISTER_METHOD_CREATOR(type, name, func)\
       MethodFactoryRegistry<type>::Instance().Register(name, func); 
+
+/*
+ * A loader creates an index object without building the index
+ * and reads the index from the disk.
+ */
+#define REGISTER_METHOD_LOADER(type, name, func)\
+      MethodFactoryRegistry<type>::Instance().RegisterLoader(name, func); 
  
 
 template <typename dist_t>
@@ -41,6 +48,12 @@ public:
                            const ObjectVector& DataObjects,
                            const AnyParams& MethPars);
 
+  typedef Index<dist_t>* (*LoadFuncPtr)(const string& Location,
+                           const string& SpaceType,
+                           const Space<dist_t>* space,
+                           const ObjectVector& DataObjects,
+                           const AnyParams& MethPars);
+
   static MethodFactoryRegistry& Instance() {
     static MethodFactoryRegistry elem;
 
@@ -52,6 +65,15 @@ public:
     Creators_[MethodName] = func;
   }
 
+  void RegisterLoader(const string& MethodName, LoadFuncPtr func) {
+    LOG(LIB_INFO) << "Registering a loader at the factory, method: " << MethodName << " distance type: " << DistTypeName<dist_t>();
+    Loaders_[MethodName] = func;
+  }
+
+  bool IsLoadSupported(const string& MethName) const {
+    return Loaders_.count(MethName) != 0;
+  }
+
   Index<dist_t>* CreateMethod(bool PrintProgress,
                             const string& MethName,
                             const string& SpaceType,
@@ -66,8 +88,24 @@ public:
     }
     return NULL;
   }
+
+  Index<dist_t>* LoadMethod(const string& Location,
+                            const string& MethName,
+                            const string& SpaceType,
+                            const Space<dist_t>* space,
+                            const ObjectVector& DataObjects,
+                            const AnyParams& MethPars) {
+    if (Loaders_.count(MethName)) {
+      return Loaders_[MethName](Location, SpaceType, space, DataObjects, MethPars);
+    } else {
+      LOG(LIB_FATAL) << "It looks like the method " << MethName << 
+                    " doesn't support loading of the index for the distance type : " << DistTypeName<dist_t>();
+    }
+    return NULL;
+  }
 private:
   map<string, CreateFuncPtr>  Creators_;
+  map<string, LoadFuncPtr>    Loaders_;
 };
 
 }
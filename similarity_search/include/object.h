@@ -63,18 +63,17 @@ class Object {
     buffer_ = new char[ID_SIZE + LABEL_SIZE + DATALENGTH_SIZE + datalength];
     CHECK(buffer_ != NULL);
     memory_allocated_ = true;
-    char* ptr = buffer_;
-    memcpy(ptr, &id, ID_SIZE);
-    ptr += ID_SIZE;
-    memcpy(ptr, &label, LABEL_SIZE); 
-    ptr += LABEL_SIZE;
-    memcpy(ptr, &datalength, DATALENGTH_SIZE);
-    ptr += DATALENGTH_SIZE;
-    if (data != NULL) {
-      memcpy(ptr, data, datalength);
-    } else {
-      memset(ptr, 0, datalength);
-    }
+    InitBuffer(id, label, datalength, data);
+  }
+
+  /*
+   * Creates an object in the memory allocated by the caller (e.g., by an ObjectArena):
+   * the buffer should have at least ID_SIZE + LABEL_SIZE + DATALENGTH_SIZE + datalength bytes
+   * and it is NOT released by the object.
+   */
+  Object(char* buffer, IdType id, LabelType label, size_t datalength, const void* data)
+        : buffer_(buffer), memory_allocated_(false) {
+    InitBuffer(id, label, datalength, data);
   }
 
   ~Object() {
@@ -158,6 +157,21 @@ class Object {
     fileLine.insert(0, str.str()); 
   }
  private:
+  void InitBuffer(IdType id, LabelType label, size_t datalength, const void* data) {
+    char* ptr = buffer_;
+    memcpy(ptr, &id, ID_SIZE);
+    ptr += ID_SIZE;
+    memcpy(ptr, &label, LABEL_SIZE); 
+    ptr += LABEL_SIZE;
+    memcpy(ptr, &datalength, DATALENGTH_SIZE);
+    ptr += DATALENGTH_SIZE;
+    if (data != NULL) {
+      memcpy(ptr, data, datalength);
+    } else {
+      memset(ptr, 0, datalength);
+    }
+  }
+
   char* buffer_;
   bool  memory_allocated_;
 
@@ -0,0 +1,99 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#ifndef _OBJECT_ARENA_H_
+#define _OBJECT_ARENA_H_
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "global.h"
+#include "object.h"
+#include "logging.h"
+
+namespace similarity {
+
+/*
+ * An arena keeps buffers of data set objects in large contiguous slabs:
+ * objects are placed one after another in the order of creation.
+ * Compared to allocating every object separately, this reduces
+ * the allocator overhead and makes sequential scans cache (and prefetcher) friendly.
+ *
+ * Objects created by the arena do not own their buffers.
+ * Deleting such an object is fine, but all the memory
+ * is released only when the arena is destroyed. Thus,
+ * the arena must be alive as long as its objects are used.
+ */
+class ObjectArena {
+public:
+  // Slabs are aligned on the cache line boundary
+  static const size_t SLAB_ALIGN   = 64;
+  // Object buffers are aligned on a 16-byte boundary (data then is 16-byte aligned too)
+  static const size_t OBJECT_ALIGN = 16;
+  static const size_t DEFAULT_SLAB_SIZE = 16 * 1024 * 1024;
+
+  explicit ObjectArena(size_t SlabSize = DEFAULT_SLAB_SIZE)
+                      : SlabSize_(SlabSize), pCurr_(NULL), pEnd_(NULL), TotalSize_(0) {}
+  ~ObjectArena() {
+    for (char* p: slabs_) delete [] p;
+  }
+
+  /*
+   * The caller is responsible for deleting the Object pointer
+   * (but not the memory it points to).
+   */
+  Object* CreateObject(IdType id, LabelType label, size_t datalength, const void* data) {
+    return new Object(Allocate(ID_SIZE + LABEL_SIZE + DATALENGTH_SIZE + datalength),
+                      id, label, datalength, data);
+  }
+
+  // The total amount of memory allocated for slabs
+  size_t GetTotalSize() const { return TotalSize_; }
+private:
+  char* Allocate(size_t len) {
+    len = AlignUp(len, OBJECT_ALIGN);
+    if (static_cast<size_t>(pEnd_ - pCurr_) < len) {
+      // A very large object gets its own slab
+      size_t qty = std::max(SlabSize_, len);
+      char* p = new char[qty + SLAB_ALIGN];
+      CHECK(p != NULL);
+      slabs_.push_back(p);
+      TotalSize_ += qty + SLAB_ALIGN;
+      pCurr_ = reinterpret_cast<char*>(AlignUp(reinterpret_cast<uintptr_t>(p), SLAB_ALIGN));
+      pEnd_  = pCurr_ + qty;
+    }
+    char* res = pCurr_;
+    pCurr_ += len;
+    return res;
+  }
+
+  template <typename T>
+  static T AlignUp(T val, size_t align) {
+    return (val + align - 1) / align * align;
+  }
+
+  size_t              SlabSize_;
+  std::vector<char*>  slabs_;
+  char*               pCurr_;
+  char*               pEnd_;
+  size_t              TotalSize_;
+
+  DISABLE_COPY_AND_ASSIGN(ObjectArena);
+};
+
+}  // namespace similarity
+
+#endif     // _OBJECT_ARENA_H_
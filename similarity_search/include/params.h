@@ -273,6 +273,10 @@ void ParseCommandLine(int argc, char *av[],
                       vector<unsigned>&       knn,
                       float&                  eps,
                       string&                 RangeArg,
+                      string&                 SaveIndexPrefix,
+                      string&                 LoadIndexPrefix,
+                      unsigned&               ThreadGSQty,
+                      string&                 CachePrefixGS,
                       vector<shared_ptr<MethodWithParams>>& Methods);
 };
 
@@ -39,6 +39,8 @@ class Query {
   // Distance can be assymetric!
   virtual dist_t DistanceObjLeft(const Object* object);
   virtual dist_t DistanceObjRight(const Object* object);
+  // Computes distances from objects objs[0], ..., objs[qty-1] (on the left side) to the query
+  void DistanceObjLeftBlock(const Object* const* objs, size_t qty, dist_t* dists);
 
   virtual void Reset() = 0;
   virtual dist_t Radius() const = 0;
@@ -48,7 +50,10 @@ class Query {
  protected:
   const Space<dist_t>* space_;
   const Object* query_object_;
-  uint64_t distance_computations_;
+  // It is mutable, because k-NN queries re-rank candidates lazily (see KNNQuery::Rerank)
+  mutable uint64_t distance_computations_;
+  // If true, distances are computed using Space::ProxyDistance (see KNNQuery)
+  bool use_proxy_distance_;
 
   // disable copy and assign
   DISABLE_COPY_AND_ASSIGN(Query);
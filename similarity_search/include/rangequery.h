@@ -35,9 +35,17 @@ class RangeQuery : public Query<dist_t> {
   unsigned ResultSize() const;
 
   void Reset();
+  // Range queries use only the real distance: there is nothing to re-rank (see KNNQuery::Rerank)
+  void Rerank() {}
   bool CheckAndAddToResult(const dist_t distance, const Object* object);
   bool CheckAndAddToResult(const Object* object);
   size_t CheckAndAddToResult(const ObjectVector& bucket);
+  size_t CheckAndAddToResult(const Object* const* objs, size_t qty);
+  /*
+   * Adds results (and distance computations) of another query with the same
+   * query object, e.g., of a query that searched a part of the data in another thread.
+   */
+  void Merge(const RangeQuery<dist_t>& other);
   bool Equals(const RangeQuery<dist_t>* query) const;
   void Print() const;
   static std::string Type() { return "RANGE"; }
@@ -46,6 +54,8 @@ class RangeQuery : public Query<dist_t> {
   dist_t               radius_;
   ObjectVector         result_;
   std::vector<dist_t>  resultDists_;
+  // Distances to bucket objects (the buffer is reused by all buckets)
+  std::vector<dist_t>  batchDists_;
 
   // disable copy and assign
   DISABLE_COPY_AND_ASSIGN(RangeQuery);
@@ -18,16 +18,19 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include "object.h"
 #include "space.h"
 #include "experimentconf.h"
+#include "params.h"
 #include "logging.h"
 
 namespace similarity {
 
 using std::string; 
 using std::stringstream;
+using std::vector;
 
 enum VPTreeVisitDecision { kVisitLeft = 1, kVisitRight = 2, kVisitBoth = 3 };
 
@@ -36,7 +39,16 @@ template <typename dist_t>
 class TriangIneq {
 public:
   static std::string GetName() { return "triangle inequality"; }
+  /*
+   * Is it possible to create the oracle without computing distances to the pivot?
+   * If so, the oracle can be re-created when a VP-tree is loaded from disk.
+   */
+  static bool IsDataIndependent() { return true; }
   TriangIneq(double alpha_left, double alpha_right) : alpha_left_(alpha_left), alpha_right_(alpha_right){}
+  void SetAlphas(double alpha_left, double alpha_right) {
+    alpha_left_ = alpha_left;
+    alpha_right_ = alpha_right;
+  }
 
   inline VPTreeVisitDecision Classify(dist_t dist, dist_t MaxDist, dist_t MedianDist) {
 /*
@@ -81,6 +93,21 @@ public:
   TriangIneq<dist_t>* Create(unsigned level, const Object* /*pivot_*/, const DistObjectPairVector<dist_t>& /*dists*/) const {
     return new TriangIneq<dist_t>(alpha_left_, alpha_right_);
   }
+  /*
+   * Stretching coefficients affect only the search, not the tree.
+   * Thus, they can be changed without rebuilding the VP-tree:
+   * the tree calls SetQueryTimeParams() and then UpdateOracle()
+   * for each of its oracles. Missing parameters are reset to defaults.
+   */
+  static vector<string> GetQueryTimeParamNames() { return {"alphaLeft", "alphaRight"}; }
+  void SetQueryTimeParams(AnyParamManager& pmgr) {
+    alpha_left_ = alpha_right_ = 1.0;
+    pmgr.GetParamOptional("alphaLeft",  alpha_left_);
+    pmgr.GetParamOptional("alphaRight", alpha_right_);
+  }
+  void UpdateOracle(TriangIneq<dist_t>& oracle) const {
+    oracle.SetAlphas(alpha_left_, alpha_right_);
+  }
 private:
   double alpha_left_;
   double alpha_right_;
@@ -101,6 +128,7 @@ public:
                    float  DistLearnThreshold
                    );
     static std::string GetName() { return "sampling"; }
+    static bool IsDataIndependent() { return false; }
 
     inline VPTreeVisitDecision Classify(dist_t dist, dist_t MaxDist, dist_t MedianDist) {
         if (NotEnoughData_ || dist == MedianDist) return kVisitBoth;
@@ -169,6 +197,10 @@ public:
       } 
       return NULL;
     }
+    // Sampling oracles are learned from data and have no query-time parameters
+    static vector<string> GetQueryTimeParamNames() { return vector<string>(); }
+    void SetQueryTimeParams(AnyParamManager& ) {}
+    void UpdateOracle(SamplingOracle<dist_t>& ) const {}
     SamplingOracleCreator(const typename similarity::Space<dist_t>* space,
                    const ObjectVector& AllVectors,
                    bool   DoRandSample,
@@ -26,8 +26,10 @@
 #include <string.h>
 #include "global.h"
 #include "object.h"
+#include "object_arena.h"
 #include "utils.h"
 #include "permutation_type.h"
+#include "dist_kernel.h"
 
 #define LABEL_PREFIX "label:"
 
@@ -78,10 +80,82 @@ class Space {
                       const ExperimentConfig<dist_t>* config, // NULL pointers are allowed
                       const char* inputfile,
                       const int MaxNumObjects) const = 0;
+  /*
+   * Read queries from the external file. Spaces that keep data in
+   * a compressed form may keep queries uncompressed (see space_quant.h).
+   */
+  virtual void ReadQuerySet(ObjectVector& queryset,
+                      const ExperimentConfig<dist_t>* config, // NULL pointers are allowed
+                      const char* inputfile,
+                      const int MaxNumObjects) const {
+    ReadDataset(queryset, config, inputfile, MaxNumObjects);
+  }
+  /*
+   * Creates an object from a string in the data file format (without
+   * the trailing newline). This is used to parse queries one by one
+   * (see query_server.cc). The function throws an exception
+   * if the string cannot be parsed.
+   */
+  virtual Object* CreateObjFromStr(IdType id, const std::string& s) const {
+    throw runtime_error("Creating objects from strings is not supported by the space: " + ToString());
+  }
   virtual std::string ToString() const = 0;
   virtual void PrintInfo() const { LOG(LIB_INFO) << ToString(); }
+  /*
+   * Spaces that keep data in a lossy form (e.g., quantized vectors) may
+   * compute a cheaper approximate distance (see ProxyDistance). In this case,
+   * a k-NN query collects GetRerankQty(K) candidates using the approximate
+   * distance and re-ranks them using the real one (see KNNQuery).
+   * If GetRerankQty(K) == K (default), there is no re-ranking.
+   */
+  virtual unsigned GetRerankQty(unsigned K) const { return K; }
+  /*
+   * Describes a distance kernel that computes the same distance as
+   * HiddenDistance between obj and objects of the same length without
+   * virtual calls (see dist_kernel.h). By default, the virtual kernel is used.
+   * A sub-class overriding HiddenDistance of a space with a kernel
+   * should override this function as well.
+   */
+  virtual DistKernelDesc GetDistKernel(const Object* obj) const { return DistKernelDesc(); }
+
+ private:
+  // The arena used by the current thread and the space it is bound to (see ArenaScope)
+  struct ArenaBinding {
+    const Space*  space_;
+    ObjectArena*  arena_;
+  };
+  static ArenaBinding& CurrArena() {
+    static thread_local ArenaBinding binding = {NULL, NULL};
+    return binding;
+  }
 
  protected:
+  /*
+   * While an object of this class is alive, objects created by the
+   * space (see CreateObject) in the same thread are placed into the arena.
+   * This is used to read data sets into contiguous memory (see ReadDataset
+   * in sub-classes). The arena is bound to the thread, because other
+   * threads may create objects using the same (const) space at the same time.
+   * If the arena is NULL, every object is allocated separately.
+   */
+  class ArenaScope {
+   public:
+    ArenaScope(const Space& space, ObjectArena* arena) : prev_(CurrArena()) {
+      CurrArena().space_ = &space;
+      CurrArena().arena_ = arena;
+    }
+    ~ArenaScope() { CurrArena() = prev_; }
+   private:
+    const ArenaBinding prev_;
+  };
+
+  Object* CreateObject(IdType id, LabelType label, size_t datalength, const void* data) const {
+    const ArenaBinding& binding = CurrArena();
+    return binding.space_ == this && binding.arena_ != NULL ?
+                            binding.arena_->CreateObject(id, label, datalength, data) :
+                            new Object(id, label, datalength, data);
+  }
+
   void SetIndexPhase() const { bIndexPhase = true; }
   void SetQueryPhase() const { bIndexPhase = false; }
 
@@ -94,6 +168,19 @@ class Space {
    * IndexTimeDistance access can be disable/enabled only by function friends 
    */
   virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const = 0;
+  /*
+   * Computes distances between objects objs[0], ..., objs[qty-1] (on the left side)
+   * and obj2. Spaces of dense vectors override this function to compute
+   * all distances in a loop without virtual calls (see VectorSpace).
+   */
+  virtual void HiddenDistanceBlock(const Object* const* objs, size_t qty,
+                                   const Object* obj2, dist_t* dists) const {
+    for (size_t i = 0; i < qty; ++i) dists[i] = HiddenDistance(objs[i], obj2);
+  }
+  // An approximate distance to select k-NN candidates for re-ranking (see GetRerankQty)
+  virtual dist_t ProxyDistance(const Object* obj1, const Object* obj2) const {
+    return HiddenDistance(obj1, obj2);
+  }
  private:
   bool mutable bIndexPhase = true;
 };
@@ -48,6 +48,10 @@ class SpaceJSBase : public VectorSpace<dist_t> {
 
   virtual std::string ToString() const = 0;
   virtual Object* CreateObjFromVect(IdType id, LabelType label, const std::vector<dist_t>& InpVect) const;
+  // Fast versions keep logarithms after vector elements
+  virtual size_t GetElemQty(const Object* object) const {
+    return object->datalength() / sizeof(dist_t) / (type_ == kJSSlow ? 1 : 2);
+  }
 
  protected:
   dist_t JensenShannonFunc(const Object* obj1, const Object* obj2) const;
@@ -82,9 +82,16 @@ class SpaceLp : public VectorSpace<dist_t> {
   virtual ~SpaceLp() {}
 
   virtual std::string ToString() const;
+  dist_t getP() const { return distObj_.getP(); }
+  virtual DistKernelDesc GetDistKernel(const Object* obj) const;
 
  protected:
   virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const;
+  virtual void HiddenDistanceBlock(const Object* const* objs, size_t qty,
+                                   const Object* obj2, dist_t* dists) const {
+    CHECK(obj2->datalength() > 0);
+    this->ComputeDistanceBlock(distObj_, obj2->datalength() / sizeof(dist_t), objs, qty, obj2, dists);
+  }
  private:
   SpaceLpDist<dist_t> distObj_;
 };
@@ -0,0 +1,169 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#ifndef _SPACE_QUANT_H_
+#define _SPACE_QUANT_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#include "global.h"
+#include "object.h"
+#include "logging.h"
+#include "utils.h"
+#include "space.h"
+#include "space_vector.h"
+
+#define SPACE_L2_SQ                 "l2_sq"
+#define SPACE_COSINE_SIMILARITY_SQ  "cosinesimil_sq"
+
+namespace similarity {
+
+enum SQDistType { kSQDistL2, kSQDistCosine };
+enum SQCodeType { kSQCodeInt8, kSQCodeFP16 };
+
+/*
+ * Keeps original vectors of data objects outside of objects (see SpaceQuantized).
+ * Vectors are appended to a temporary file, which is memory mapped in large chunks.
+ * Chunks are never re-mapped, so pointers to vectors stay valid. Because the file
+ * is written without touching the mapping, only vectors that are actually read
+ * (e.g., during re-ranking) are loaded into memory, and the OS may evict them.
+ * The temporary file is placed into the directory TMPDIR (or /tmp) and
+ * deleted automatically.
+ */
+class OrigVectorStore {
+ public:
+  OrigVectorStore();
+  ~OrigVectorStore();
+
+  // Returns the position of the first element, it can be called by several threads
+  uint64_t Add(const float* pVect, size_t qty);
+  const float* Get(uint64_t pos, size_t qty) const {
+    // Vectors never span chunks
+    CHECK(pos + qty <= size_);
+    return chunks_[pos / CHUNK_ELEM_QTY] + pos % CHUNK_ELEM_QTY;
+  }
+ private:
+  static const size_t CHUNK_ELEM_QTY = 16 * 1024 * 1024;
+  // The maximum number of chunks: 1 TB of original vectors
+  static const size_t MAX_CHUNK_QTY  = 16 * 1024;
+
+  void AddChunk();
+
+  std::mutex            mutex_;
+  // Its size never changes, so readers don't need to lock the mutex
+  std::vector<float*>   chunks_;
+  size_t                chunkQty_;
+  std::atomic<uint64_t> size_;
+#ifdef _MSC_VER
+  void*                 hFile_;
+  std::vector<void*>    hMappings_;
+#else
+  int                   fd_;
+#endif
+
+  DISABLE_COPY_AND_ASSIGN(OrigVectorStore);
+};
+
+/*
+ * Dense vectors compressed using scalar quantization: every element is
+ * represented by either an 8-bit integer code, or by a half-precision number.
+ * For 8-bit codes, the range of vector elements is split into 255 equal intervals
+ * (the minimum and the interval length are stored with the vector).
+ * This reduces memory requirements (and memory bandwidth) 4 or 2 times.
+ *
+ * Queries are not compressed (see CreateQueryObjFromVect). Thus, the distance
+ * between a data object and a query is asymmetric: codes are decoded on the fly
+ * and compared with the original query values.
+ *
+ * If the re-ranking factor (the space parameter rerank) is positive, original
+ * vectors of data objects are kept as well. In this case, the distance (HiddenDistance)
+ * is computed using original vectors, but a k-NN query computes distances
+ * using codes (ProxyDistance), collects K * <re-ranking factor> candidates,
+ * and re-ranks them (see KNNQuery). Original vectors are not stored in objects,
+ * but in a memory-mapped file (see OrigVectorStore): data objects keep only
+ * their positions. Thus, objects are still 4 (or 2) times smaller, and only 
+ * original vectors of re-ranked candidates need to be in memory.
+ * Because positions are valid only in the process that created objects,
+ * such objects cannot be saved to binary data sets (see convert_dataset.cc).
+ */
+class SpaceQuantized : public VectorSpace<float> {
+ public:
+  SpaceQuantized(SQDistType distType, SQCodeType codeType, unsigned rerankFactor);
+  virtual ~SpaceQuantized() {}
+
+  virtual std::string ToString() const;
+  virtual void WriteDataset(const ObjectVector& dataset,
+                            const char* outputfile) const;
+  virtual Object* CreateObjFromVect(IdType id, LabelType label, const std::vector<float>& InpVect) const;
+  virtual unsigned GetRerankQty(unsigned K) const { return RerankFactor_ ? K * RerankFactor_ : K; }
+
+  /*
+   * Retrieves original vector elements (if they are kept),
+   * or decodes them.
+   */
+  void GetVector(const Object* obj, std::vector<float>& v) const;
+  // The number of vector elements
+  virtual size_t GetElemQty(const Object* obj) const;
+ protected:
+  virtual Object* CreateQueryObjFromVect(IdType id, LabelType label, const std::vector<float>& InpVect) const;
+  virtual float HiddenDistance(const Object* obj1, const Object* obj2) const;
+  virtual float ProxyDistance(const Object* obj1, const Object* obj2) const;
+ private:
+  /*
+   * Every object starts with this header.
+   * It is followed by either query vector elements, or by codes.
+   * The number of code bytes is padded to be a multiple of four.
+   */
+  struct Header {
+    uint32_t  bQuery_;
+    uint32_t  dim_;
+    // The position of original vector elements in the store (if RerankFactor_ > 0)
+    uint64_t  origPos_;
+    // Parameters of 8-bit codes: the element value is min_ + scale_ * code
+    float     min_;
+    float     scale_;
+    // Inverse norms of vectors (zero for zero vectors), the first one is for the decoded vector
+    float     invNorm_;
+    float     origInvNorm_;
+  };
+
+  static const Header* GetHeader(const Object* obj) {
+    return reinterpret_cast<const Header*>(obj->data());
+  }
+  size_t GetCodeSize(size_t dim) const;
+  // Returns query elements, or original data vector elements (if they are kept)
+  const float* GetOrigVector(const Object* obj) const;
+  void Decode(const Object* obj, size_t start, size_t qty, float* pVect) const;
+  // The square of the L2 distance or the scalar product between vector elements and codes
+  float CodeSum(const float* pVect, const Object* obj, size_t start, size_t qty) const;
+  float FloatSum(const float* pVect1, const float* pVect2, size_t qty) const;
+  float Finalize(float sum, float invNorm1, float invNorm2) const;
+
+  SQDistType  DistType_;
+  SQCodeType  CodeType_;
+  unsigned    RerankFactor_;
+  // Original vectors of data objects, it is NULL if RerankFactor_ == 0
+  std::unique_ptr<OrigVectorStore>  origStore_;
+};
+
+}  // namespace similarity
+
+#endif
@@ -33,6 +33,8 @@
 
 #define SPACE_COSINE_SIMILARITY  "cosinesimil"
 #define SPACE_ANGULAR_DISTANCE   "angulardist"
+#define SPACE_COSINE_SIMILARITY_FAST  "cosinesimil_fast"
+#define SPACE_ANGULAR_DISTANCE_FAST   "angulardist_fast"
 
 namespace similarity {
 
@@ -44,6 +46,8 @@ public:
   }
 protected:
   virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const;
+  virtual void HiddenDistanceBlock(const Object* const* objs, size_t qty,
+                                   const Object* obj2, dist_t* dists) const;
 };
 
 template <typename dist_t>
@@ -54,6 +58,47 @@ public:
   }
 protected:
   virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const;
+  virtual void HiddenDistanceBlock(const Object* const* objs, size_t qty,
+                                   const Object* obj2, dist_t* dists) const;
+};
+
+/*
+ * The fast versions store the inverse of the vector norm after vector
+ * elements (see PrecompInvNorm in distcomp.h). Thus, computing the distance
+ * requires only one scalar product rather than three.
+ */
+template <typename dist_t>
+class SpaceCosineSimilarityFast : public VectorSpace<dist_t> {
+public:
+  virtual std::string ToString() const {
+    return "CosineSimilarity (precomputed norms)";
+  }
+  virtual Object* CreateObjFromVect(IdType id, LabelType label, const std::vector<dist_t>& InpVect) const;
+  virtual size_t GetElemQty(const Object* object) const { return object->datalength()/ sizeof(dist_t) - 1; }
+  virtual DistKernelDesc GetDistKernel(const Object* obj) const {
+    return DistKernelDesc(kDistKernelCosinePrecomp, GetElemQty(obj), obj->datalength());
+  }
+protected:
+  virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const;
+  virtual void HiddenDistanceBlock(const Object* const* objs, size_t qty,
+                                   const Object* obj2, dist_t* dists) const;
+};
+
+template <typename dist_t>
+class SpaceAngularDistanceFast : public VectorSpace<dist_t> {
+public:
+  virtual std::string ToString() const {
+    return "AngularDistance (precomputed norms)";
+  }
+  virtual Object* CreateObjFromVect(IdType id, LabelType label, const std::vector<dist_t>& InpVect) const;
+  virtual size_t GetElemQty(const Object* object) const { return object->datalength()/ sizeof(dist_t) - 1; }
+  virtual DistKernelDesc GetDistKernel(const Object* obj) const {
+    return DistKernelDesc(kDistKernelAngularPrecomp, GetElemQty(obj), obj->datalength());
+  }
+protected:
+  virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const;
+  virtual void HiddenDistanceBlock(const Object* const* objs, size_t qty,
+                                   const Object* obj2, dist_t* dists) const;
 };
 
 
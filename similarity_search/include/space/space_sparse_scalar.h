@@ -21,6 +21,7 @@
 #include <map>
 #include <cmath>
 #include <stdexcept>
+#include <algorithm>
 
 #include <string.h>
 #include "global.h"
@@ -35,8 +36,37 @@
 
 namespace similarity {
 
+/*
+ * A helper base class for sparse spaces that rely on the normalized
+ * scalar product. The inverse norm of a vector is computed when
+ * the object is created and is stored in the header of the object,
+ * i.e., in the value of the first sparse element (the remaining elements
+ * follow the header). Thus, the distance computation boils down
+ * to computing the scalar product of non-zero elements with common ids.
+ */
+template <typename dist_t>
+class SpaceSparseVectorNorm : public SpaceSparseVector<dist_t> {
+ public:
+  typedef SparseVectElem<dist_t> ElemType;
+
+  virtual ~SpaceSparseVectorNorm() {}
+
+  /*
+   * Need to override the function from the base class
+   */
+  virtual dist_t ScalarProduct(const Object* obj1, const Object* obj2) const;
+  virtual Object* CreateObjFromVect(IdType id, LabelType label, const vector<ElemType>& InpVect) const;
+  virtual void GetVector(const Object* obj, vector<ElemType>& v) const {
+    const ElemType* beg = reinterpret_cast<const ElemType*>(obj->data());
+    // Skipping the header
+    v.assign(beg + 1, beg + obj->datalength() / sizeof(ElemType));
+  }
+ protected:
+  virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const = 0;
+};
+
 template <typename dist_t>
-class SpaceSparseAngularDistance : public SpaceSparseVector<dist_t> {
+class SpaceSparseAngularDistance : public SpaceSparseVectorNorm<dist_t> {
  public:
   explicit SpaceSparseAngularDistance() {}
   virtual ~SpaceSparseAngularDistance() {}
@@ -47,22 +77,12 @@ class SpaceSparseAngularDistance : public SpaceSparseVector<dist_t> {
 
  protected:
   virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const {
-    return SpaceSparseVector<dist_t>::ComputeDistanceHelper(obj1, obj2, distObjAngular_);
+    return acos(this->ScalarProduct(obj1, obj2));
   }
- private:
-  struct SpaceAngularDist {
-    dist_t operator()(const dist_t* x, const dist_t* y, size_t length) const {
-      dist_t val = AngularDistance(x, y, length);
-      // TODO: @leo shouldn't happen any more, but let's keep this check here for a while
-      if (std::isnan(val)) LOG(LIB_FATAL) << "Bug: NAN dist!!!!";
-      return val;
-    }
-  };
-  SpaceAngularDist        distObjAngular_;
 };
 
 template <typename dist_t>
-class SpaceSparseCosineSimilarity : public SpaceSparseVector<dist_t> {
+class SpaceSparseCosineSimilarity : public SpaceSparseVectorNorm<dist_t> {
  public:
   explicit SpaceSparseCosineSimilarity() {}
   virtual ~SpaceSparseCosineSimilarity() {}
@@ -73,18 +93,8 @@ class SpaceSparseCosineSimilarity : public SpaceSparseVector<dist_t> {
 
  protected:
   virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const {
-    return SpaceSparseVector<dist_t>::ComputeDistanceHelper(obj1, obj2, distObjCosineSimilarity_);
+    return std::max(dist_t(0), 1 - this->ScalarProduct(obj1, obj2));
   }
- private:
-  struct SpaceCosineSimilarityDist {
-    dist_t operator()(const dist_t* x, const dist_t* y, size_t length) const {
-      dist_t val = CosineSimilarity(x, y, length);
-      // TODO: @leo shouldn't happen any more, but let's keep this check here for a while
-      if (std::isnan(val)) LOG(LIB_FATAL) << "Bug: NAN dist!!!!";
-      return val;
-    }
-  };
-  SpaceCosineSimilarityDist        distObjCosineSimilarity_;
 };
 
 
@@ -65,6 +65,32 @@ ostream& operator<<(ostream& out, SparseVectElem<dist_t> e) {
  */
 #define MAX_BUFFER_QTY  8192
 
+/*
+ * If one list of sparse elements is at least this many times longer
+ * than the other one, intersection functions switch to galloping search,
+ * i.e., each element of the shorter list is looked up in the longer list.
+ * This is typical for short queries and long documents.
+ */
+#define SPARSE_GALLOP_RATIO 32
+
+/*
+ * Finds the first element in the sorted range [beg, end) that isn't less than key.
+ * Unlike std::lower_bound, it first brackets the answer by doubling
+ * the step, which is faster when the answer is close to beg.
+ */
+template <class T>
+inline const T* GallopLowerBound(const T* beg, const T* end, const T& key) {
+  if (beg >= end || !(*beg < key)) return beg;
+  // Invariant: *beg < key
+  size_t step = 1;
+  while (step < size_t(end - beg) && beg[step] < key) {
+    beg += step;
+    step *= 2;
+  }
+  const T* hi = step < size_t(end - beg) ? beg + step : end;
+  return std::lower_bound(beg + 1, hi, key);
+}
+
 template <typename dist_t>
 class SpaceSparseVector : public Space<dist_t> {
  public:
@@ -85,6 +111,12 @@ class SpaceSparseVector : public Space<dist_t> {
   }
 
   virtual Object* CreateObjFromVect(IdType id, LabelType label, const vector<ElemType>& InpVect) const;
+  virtual Object* CreateObjFromStr(IdType id, const std::string& s) const;
+  // Extracts sparse elements from the object created by CreateObjFromVect
+  virtual void GetVector(const Object* obj, vector<ElemType>& v) const {
+    const ElemType* beg = reinterpret_cast<const ElemType*>(obj->data());
+    v.assign(beg, beg + obj->datalength() / sizeof(ElemType));
+  }
  protected:
 
   struct SpaceNormScalarProduct {
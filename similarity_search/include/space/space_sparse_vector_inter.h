@@ -23,6 +23,7 @@
 #include <stdexcept>
 #include <algorithm>
 #include <limits>
+#include <cmath>
 
 #include <string.h>
 #include "global.h"
@@ -64,6 +65,7 @@ class SpaceSparseVectorInter : public SpaceSparseVector<dist_t> {
                              obj2->data(), obj2->datalength());
   }
   virtual Object* CreateObjFromVect(IdType id, LabelType label, const vector<ElemType>& InpVect) const;
+  virtual void GetVector(const Object* obj, vector<ElemType>& v) const;
  protected:
   virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const = 0;
 };
@@ -93,15 +95,15 @@ inline size_t addBlockZeros(size_t id) {
 template <typename dist_t>
 inline  void ParseSparseElementHeader(const char*     pBuff, 
                                       size_t&         rBlockQty,
-                                      dist_t&         rSqSum,
+                                      dist_t&         rInvNorm,
                                       const size_t*&  rpBlockQtys,
                                       const size_t*&  rpBlockOffs, 
                                       const char*&    rpBlockBegin) {
   const size_t*   pQty = reinterpret_cast<const size_t*>(pBuff);
   rBlockQty = *pQty;
-  const dist_t*   pSqSum = reinterpret_cast<const dist_t*>(pQty + 1);
-  rSqSum = *pSqSum;
-  rpBlockQtys = reinterpret_cast<const size_t*>(pSqSum + 1);
+  const dist_t*   pInvNorm = reinterpret_cast<const dist_t*>(pQty + 1);
+  rInvNorm = *pInvNorm;
+  rpBlockQtys = reinterpret_cast<const size_t*>(pInvNorm + 1);
   rpBlockOffs = rpBlockQtys + rBlockQty;
 
   rpBlockBegin = reinterpret_cast<const char*>(rpBlockOffs + rBlockQty);
@@ -114,13 +116,13 @@ inline  void UnpackSparseElements(const char* pBuff, size_t dataLen,
   typedef SparseVectElem<dist_t> ElemType;
 
   size_t            blockQty = 0;
-  dist_t            SqSum = 0;
+  dist_t            InvNorm = 0;
   const size_t*     pBlockQty = NULL;
   const size_t*     pBlockOff = NULL;
 
   const char* pBlockBegin = NULL;
 
-  ParseSparseElementHeader(pBuff, blockQty, SqSum, 
+  ParseSparseElementHeader(pBuff, blockQty, InvNorm, 
                            pBlockQty, 
                            pBlockOff, 
                            pBlockBegin);
@@ -190,13 +192,13 @@ inline  void PackSparseElements(const vector<SparseVectElem<dist_t>>& InpVect,
    *
    * i)   A header will store the number of blocks. 
    * ii)  For each block we keep the # of elements
-   * iii) The sum of squared element values.
+   * iii) The inverse norm of the vector (zero for a zero vector).
    * iv)  Each element has a 2-byte id and a sizeof(dist_t) value
    *
    */
   size_t elemSize = 2 + sizeof(dist_t);
   dataSize = sizeof(size_t) + // number of blocks
-              sizeof(dist_t) + // sum of squared elements
+              sizeof(dist_t) + // inverse norm
               2 * sizeof(size_t) * (blocks.size()) + // block qtys & offsets
               elemSize * InpVect.size();  
 
@@ -209,9 +211,10 @@ inline  void PackSparseElements(const vector<SparseVectElem<dist_t>>& InpVect,
    */
   *pQty = blocks.size(); 
 
-  dist_t*   pSqSum = reinterpret_cast<dist_t*>(pQty + 1);
-  *pSqSum = sqSum;
-  size_t*   pBlockQtyOff = reinterpret_cast<size_t*>(pSqSum + 1);
+  dist_t*   pInvNorm = reinterpret_cast<dist_t*>(pQty + 1);
+  // See the comment in NormScalarProduct
+  *pInvNorm = sqSum < numeric_limits<dist_t>::min() * 2 ? dist_t(0) : dist_t(1) / sqrt(sqSum);
+  size_t*   pBlockQtyOff = reinterpret_cast<size_t*>(pInvNorm + 1);
 
   for (size_t i = 0; i < blocks.size(); ++i) {
     *pBlockQtyOff++ = blocks[i].size(); // qty
@@ -38,12 +38,47 @@ class VectorSpace : public Space<dist_t> {
                       const ExperimentConfig<dist_t>* config,
                       const char* inputfile,
                       const int MaxNumObjects) const;
+  virtual void ReadQuerySet(ObjectVector& queryset,
+                      const ExperimentConfig<dist_t>* config,
+                      const char* inputfile,
+                      const int MaxNumObjects) const;
   virtual void WriteDataset(const ObjectVector& dataset,
                             const char* outputfile) const;
   virtual Object* CreateObjFromVect(IdType id, LabelType label, const std::vector<dist_t>& InpVect) const;
+  virtual Object* CreateObjFromStr(IdType id, const std::string& s) const;
+  /*
+   * The number of vector elements. Spaces that keep precomputed values
+   * after vector elements (e.g., logarithms) should override this function.
+   */
+  virtual size_t GetElemQty(const Object* object) const { return object->datalength() / sizeof(dist_t); }
  protected:
   virtual dist_t HiddenDistance(const Object* obj1, const Object* obj2) const = 0;
+  /*
+   * A helper for HiddenDistanceBlock: distances between vectors of the length
+   * ElemQty are computed by a functor, which is called directly rather than
+   * through the virtual function HiddenDistance.
+   */
+  template <typename DistFunc>
+  static void ComputeDistanceBlock(const DistFunc& distFunc, size_t ElemQty,
+                                   const Object* const* objs, size_t qty,
+                                   const Object* obj2, dist_t* dists) {
+    const dist_t* y = reinterpret_cast<const dist_t*>(obj2->data());
+    for (size_t i = 0; i < qty; ++i) {
+      CHECK(objs[i]->datalength() == obj2->datalength());
+      dists[i] = distFunc(reinterpret_cast<const dist_t*>(objs[i]->data()), y, ElemQty);
+    }
+  }
   void ReadVec(std::string line, LabelType& label, std::vector<dist_t>& v) const;
+  // Query objects can have a different format, by default they are the same as data objects
+  virtual Object* CreateQueryObjFromVect(IdType id, LabelType label, const std::vector<dist_t>& InpVect) const {
+    return CreateObjFromVect(id, label, InpVect);
+  }
+ private:
+  void ReadVectors(ObjectVector& dataset,
+                   const ExperimentConfig<dist_t>* config,
+                   const char* inputfile,
+                   const int MaxNumObjects,
+                   bool bQueries) const;
 };
 
 }  // namespace similarity
@@ -85,21 +85,24 @@ bool IsFileExists(const char* filename);
 
 inline bool IsFileExists(const string& filename) { return IsFileExists(filename.c_str()); }
 
+// Retrieves the size and the modification time of a file, returns false if the file cannot be accessed.
+bool GetFileSizeAndTime(const string& filename, uint64_t& size, int64_t& mtime);
+
 inline int RandomInt() {
-    // Static is thread-safe in C++ 11
-    static random_device rdev;
-    static mt19937 gen(rdev());
-    static std::uniform_int_distribution<int> distr(0, std::numeric_limits<int>::max());
+    // Each thread has its own generator: sharing one generator among threads is a data race
+    static thread_local random_device rdev;
+    static thread_local mt19937 gen(rdev());
+    static thread_local std::uniform_int_distribution<int> distr(0, std::numeric_limits<int>::max());
   
     return distr(gen); 
 }
 
 template <class T>
 inline T RandomReal() {
-    // Static is thread-safe in C++ 11
-    static random_device rdev;
-    static mt19937 gen(rdev());
-    static std::uniform_real_distribution<T> distr(0, 1);
+    // Each thread has its own generator (see RandomInt)
+    static thread_local random_device rdev;
+    static thread_local mt19937 gen(rdev());
+    static thread_local std::uniform_real_distribution<T> distr(0, 1);
 
     return distr(gen); 
 }
@@ -0,0 +1,206 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#ifndef _WORK_STEALING_POOL_H_
+#define _WORK_STEALING_POOL_H_
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+
+#include "global.h"
+#include "logging.h"
+
+namespace similarity {
+
+using std::vector;
+using std::deque;
+using std::unique_ptr;
+using std::thread;
+using std::mutex;
+using std::unique_lock;
+using std::condition_variable;
+using std::function;
+
+/*
+ * A fixed pool of worker threads. Each worker has its own task queue
+ * and submitted tasks are distributed among queues in a round-robin fashion.
+ * A worker takes tasks from its own queue and, when the queue is empty,
+ * steals tasks from queues of other workers. Thus, unlike static partitioning, 
+ * a long task (e.g., a hard query) delays tasks queued after it only if 
+ * all the workers are busy.
+ *
+ * Queues have their own locks: a worker that has tasks in its queue 
+ * doesn't contend with other workers. The shared state is limited to
+ * atomic counters, and the pool lock is taken only by workers that
+ * have found no tasks (to fall asleep) and by Submit() if some workers sleep.
+ *
+ * Tasks are taken from the queue front (both by owners and thieves):
+ * the oldest task always goes first, which keeps the queueing delay low.
+ */
+class WorkStealingPool {
+public:
+  // If ThreadQty is zero, the number of threads is equal to the number of cores
+  explicit WorkStealingPool(unsigned ThreadQty) :
+                            NextQueue_(0), QueuedQty_(0), UnfinishedQty_(0), IdleQty_(0), bStop_(false) {
+    if (!ThreadQty) ThreadQty = std::max(1U, thread::hardware_concurrency());
+
+    for (unsigned i = 0; i < ThreadQty; ++i) {
+      Queues_.push_back(unique_ptr<TaskQueue>(new TaskQueue()));
+    }
+    for (unsigned i = 0; i < ThreadQty; ++i) {
+      Threads_.push_back(thread(&WorkStealingPool::Worker, this, i));
+    }
+  }
+  /*
+   * Waits until all the submitted tasks are finished. An exception 
+   * thrown by a task is lost, unless WaitAll() is called before.
+   */
+  ~WorkStealingPool() {
+    {
+      unique_lock<mutex> lock(Guard_);
+      AllFinished_.wait(lock, [this]() { return UnfinishedQty_ == 0; });
+      if (Error_) LOG(LIB_ERROR) << "Ignoring an exception thrown by a task of the thread pool";
+      bStop_ = true;
+    }
+    TaskAvailable_.notify_all();
+    for (thread& t: Threads_) t.join();
+  }
+
+  unsigned GetThreadQty() const { return static_cast<unsigned>(Threads_.size()); }
+
+  void Submit(const function<void()>& task) {
+    ++UnfinishedQty_;
+
+    TaskQueue& queue = *Queues_[NextQueue_++ % Queues_.size()];
+    {
+      unique_lock<mutex> lock(queue.Guard_);
+      queue.Tasks_.push_back(task);
+      // Changed under the queue lock: the counter is decremented only after the task is taken
+      ++QueuedQty_;
+    }
+    /*
+     * A worker increments IdleQty_ before it checks QueuedQty_ (see Worker).
+     * Thus, either the worker sees the new task, or we see the sleeping worker.
+     */
+    if (IdleQty_ > 0) {
+      unique_lock<mutex> lock(Guard_);
+      TaskAvailable_.notify_one();
+    }
+  }
+
+  /*
+   * Waits until all the tasks submitted so far are finished.
+   * If some of them threw exceptions, the first exception is rethrown.
+   */
+  void WaitAll() {
+    std::exception_ptr err;
+    {
+      unique_lock<mutex> lock(Guard_);
+      AllFinished_.wait(lock, [this]() { return UnfinishedQty_ == 0; });
+      std::swap(err, Error_);
+    }
+    if (err) std::rethrow_exception(err);
+  }
+
+private:
+  struct TaskQueue {
+    mutex                   Guard_;
+    deque<function<void()>> Tasks_;
+  };
+
+  bool TryPopFrom(TaskQueue& queue, function<void()>& task) {
+    unique_lock<mutex> lock(queue.Guard_);
+    if (queue.Tasks_.empty()) return false;
+    task = std::move(queue.Tasks_.front());
+    queue.Tasks_.pop_front();
+    --QueuedQty_;
+    return true;
+  }
+
+  // Checks the own queue first and then tries to steal a task
+  bool TryPop(unsigned WorkerId, function<void()>& task) {
+    if (TryPopFrom(*Queues_[WorkerId], task)) return true;
+    for (size_t i = 1; i < Queues_.size(); ++i) {
+      if (TryPopFrom(*Queues_[(WorkerId + i) % Queues_.size()], task)) return true;
+    }
+    return false;
+  }
+
+  void Worker(unsigned WorkerId) {
+    function<void()> task;
+
+    while (true) {
+      if (!TryPop(WorkerId, task)) {
+        unique_lock<mutex> lock(Guard_);
+        ++IdleQty_;
+        TaskAvailable_.wait(lock, [this]() { return bStop_ || QueuedQty_ > 0; });
+        --IdleQty_;
+        if (bStop_) return; // all the tasks are finished before the pool is stopped
+        continue;
+      }
+
+      std::exception_ptr err;
+      try {
+        task();
+      } catch (...) {
+        err = std::current_exception();
+      }
+      task = nullptr;
+
+      if (err) {
+        unique_lock<mutex> lock(Guard_);
+        // The exception is rethrown by WaitAll
+        if (!Error_) Error_ = err;
+      }
+      if (--UnfinishedQty_ == 0) {
+        // Notifying under the lock: WaitAll checks the counter while holding it
+        unique_lock<mutex> lock(Guard_);
+        AllFinished_.notify_all();
+      }
+    }
+  }
+
+  vector<unique_ptr<TaskQueue>> Queues_;
+  vector<thread>                Threads_;
+  std::atomic<size_t>           NextQueue_;
+  // The number of tasks in all the queues
+  std::atomic<size_t>           QueuedQty_;
+  // The number of tasks that are queued or running
+  std::atomic<size_t>           UnfinishedQty_;
+  // The number of workers that have found no tasks and are (about to be) sleeping
+  std::atomic<size_t>           IdleQty_;
+
+  // Protects the first exception and the stop flag, used to put idle workers to sleep
+  mutex                         Guard_;
+  condition_variable            TaskAvailable_;
+  condition_variable            AllFinished_;
+  std::exception_ptr            Error_;
+  bool                          bStop_;
+
+  DISABLE_COPY_AND_ASSIGN(WorkStealingPool);
+};
+
+}  // namespace similarity
+
+#endif     // _WORK_STEALING_POOL_H_
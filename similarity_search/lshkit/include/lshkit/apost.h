@@ -256,10 +256,7 @@ private:
         for (unsigned i = 0; i < Super::lshs_.size(); ++i) {
             model[i].genProbeSequence(Super::lshs_[i], obj, recall, T, &seq);
             BOOST_FOREACH(unsigned j, seq) {
-                typename Super::Bin const &bin = Super::tables_[i][j];
-                BOOST_FOREACH(Key key, bin) {
-                    scanner(key);
-                }
+                Super::scanBin(i, j, scanner);
             }
         }
     }
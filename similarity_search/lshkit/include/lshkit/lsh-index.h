@@ -39,6 +39,12 @@ namespace lshkit {
   * LSH functions.  Given a query point q, the points in the bins to which q is
   * hashed to are scanned for the nearest neighbors of q.
   *
+  * After all points are inserted, the index can be frozen: each hash table
+  * is then packed into two contiguous arrays (bin offsets and keys, as in the
+  * CSR sparse matrix format).  This removes per-bin vector headers and heap
+  * blocks, and the keys of a bin are read sequentially.  No points can
+  * be inserted into a frozen index.
+  *
   * @param LSH The LSH class.
   * @param KEY The key type.
   */
@@ -58,9 +64,39 @@ protected:
     std::vector<LSH> lshs_;
     std::vector<std::vector<Bin> > tables_;
 
+    // The frozen index: keys of the j-th bin of the i-th table are
+    // frozenKeys_[i][frozenOffsets_[i][j]], ..., frozenKeys_[i][frozenOffsets_[i][j+1]-1]
+    bool frozen_;
+    std::vector<std::vector<unsigned> > frozenOffsets_;
+    std::vector<std::vector<Key> > frozenKeys_;
+
+    const Key *binBegin (unsigned i, unsigned j) const {
+        return frozen_ ? &frozenKeys_[i][0] + frozenOffsets_[i][j] : &tables_[i][j][0];
+    }
+
+    unsigned binSize (unsigned i, unsigned j) const {
+        return frozen_ ? frozenOffsets_[i][j + 1] - frozenOffsets_[i][j] : tables_[i][j].size();
+    }
+
+    unsigned tableSize (unsigned i) const {
+        return frozen_ ? frozenOffsets_[i].size() - 1 : tables_[i].size();
+    }
+
+    /// Pass all keys of the j-th bin of the i-th table to the scanner.
+    template <typename SCANNER>
+    void scanBin (unsigned i, unsigned j, SCANNER &scanner) const
+    {
+        const unsigned n = binSize(i, j);
+        if (n == 0) return;
+        const Key *p = binBegin(i, j);
+        for (unsigned k = 0; k < n; ++k) {
+            scanner(p[k]);
+        }
+    }
+
 public:
     /// Constructor.
-    LshIndex() {
+    LshIndex() : frozen_(false) {
     }
 
     /// Initialize the hash tables.
@@ -75,6 +111,7 @@ public:
     {
         BOOST_VERIFY(lshs_.size() == 0);
         BOOST_VERIFY(tables_.size() == 0);
+        BOOST_VERIFY(!frozen_);
         lshs_.resize(L);
         tables_.resize(L);
 
@@ -93,6 +130,7 @@ public:
     {
         unsigned L;
         ar & L;
+        BOOST_VERIFY(!frozen_);
         lshs_.resize(L);
         tables_.resize(L);
         for (unsigned i = 0; i < L; ++i) {
@@ -120,17 +158,16 @@ public:
         ar & L;
         for (unsigned i = 0; i < L; ++i) {
             lshs_[i].serialize(ar, 0);
-            std::vector<Bin> &table = tables_[i];
-            unsigned l = table.size();
+            unsigned l = tableSize(i);
             ar & l;
             unsigned idx, ll;
             for (unsigned j = 0; j < l; ++j) {
-                if (table[j].empty()) continue;
+                if (binSize(i, j) == 0) continue;
                 idx = j;
-                ll = table[j].size();
+                ll = binSize(i, j);
                 ar & idx;
                 ar & ll;
-                ar.write((char *)&table[j][0], ll * sizeof(Key));
+                ar.write((const char *)binBegin(i, j), ll * sizeof(Key));
             }
             idx = ll = 0;
             ar & idx;
@@ -148,6 +185,9 @@ public:
       */
     void insert (Key key, Domain value)
     {
+        if (frozen_) {
+            throw std::logic_error("Cannot insert into a frozen LSH index.");
+        }
         #if DEBUG_LEVEL > 50
           std::cerr << "key " << key << std::endl;
         #endif
@@ -181,16 +221,42 @@ public:
               std::cerr << "query lshs_ index " << index << std::endl;
             #endif
 
-            BOOST_FOREACH(Key key, tables_[i][index]) {
-
-                #if DEBUG_LEVEL > 50
-                  std::cout << "key " << key << std::endl;    // object ID
-                #endif
+            scanBin(i, index, scanner);
+        }
+    }
 
-                scanner(key);
+    /// Pack the hash tables into contiguous arrays.
+    /**
+      * Tables are converted one by one, so the memory overhead
+      * of the conversion doesn't exceed the size of a single table.
+      * Freezing a frozen index has no effect.
+      */
+    void freeze ()
+    {
+        if (frozen_) return;
+        unsigned L = tables_.size();
+        frozenOffsets_.resize(L);
+        frozenKeys_.resize(L);
+        for (unsigned i = 0; i < L; ++i) {
+            std::vector<Bin> &table = tables_[i];
+            std::vector<unsigned> &offsets = frozenOffsets_[i];
+            std::vector<Key> &keys = frozenKeys_[i];
+            offsets.resize(table.size() + 1);
+            offsets[0] = 0;
+            for (unsigned j = 0; j < table.size(); ++j) {
+                offsets[j + 1] = offsets[j] + table[j].size();
+            }
+            keys.reserve(offsets.back());
+            for (unsigned j = 0; j < table.size(); ++j) {
+                keys.insert(keys.end(), table[j].begin(), table[j].end());
             }
+            // Release the memory of the table
+            std::vector<Bin>().swap(table);
         }
+        frozen_ = true;
     }
+
+    bool isFrozen () const { return frozen_; }
 };
 
 
@@ -328,12 +328,44 @@ public:
         for (unsigned i = 0; i < Super::lshs_.size(); ++i) {
             Super::lshs_[i].genProbeSequence(obj, seq, T);
             for (unsigned j = 0; j < seq.size(); ++j) {
-                typename Super::Bin &bin = Super::tables_[i][seq[j]];
-                BOOST_FOREACH(Key key, bin) {
-                    scanner(key);
+                Super::scanBin(i, seq[j], scanner);
+            }
+        }
+    }
+
+    /// Query for R-NNs.
+    /**
+      * @param obj the query object.
+      * @param R the query radius (l2 distance, not squared).
+      * @param T the maximum number of bins probed in each table (at most Probe::MAX_T).
+      * @param recall if recall > 0, the smallest number of probes (not exceeding T)
+      *        is used for which the recall model predicts that a point at the
+      *        distance R is found with the probability of at least recall
+      *        (closer points are found with at least the same probability).
+      * @return the recall predicted for a point at the distance R.
+      */
+    template <typename SCANNER>
+    float query_range (Domain obj, float R, unsigned T, float recall, SCANNER &scanner) const
+    {
+        BOOST_VERIFY(T > 0 && T <= Probe::MAX_T);
+        const float dist = R / param_.W;
+        unsigned probeQty = T;
+        if (recall > 0) {
+            for (unsigned t = 1; t < T; ++t) {
+                if (recall_.lookup(dist, t) >= recall) {
+                    probeQty = t;
+                    break;
                 }
             }
         }
+        std::vector<unsigned> seq;
+        for (unsigned i = 0; i < Super::lshs_.size(); ++i) {
+            Super::lshs_[i].genProbeSequence(obj, seq, probeQty);
+            for (unsigned j = 0; j < seq.size(); ++j) {
+                Super::scanBin(i, seq[j], scanner);
+            }
+        }
+        return recall_.lookup(dist, probeQty);
     }
 
     /// Query for K-NNs, try to achieve the given recall by adaptive probing.
@@ -358,9 +390,7 @@ public:
         for (unsigned j = 0; j < Probe::MAX_T; ++j) {
             if (j >= seqs[0].size()) break;
             for (unsigned i = 0; i < L; ++i) {
-                BOOST_FOREACH(Key key, Super::tables_[i][seqs[i][j]]) {
-                    scanner(key);
-                }
+                Super::scanBin(i, seqs[i][j], scanner);
             }
             float r = 0.0;
             for (unsigned i = 0; i < K; ++i) {
@@ -62,8 +62,9 @@ bool is_good_value (double v) {
             (v < std::numeric_limits<double>::max()));
 }
 
-inline
-std::string FitData(const FloatMatrix& data,
+/// MatrixType can be any class with the same read-only interface as FloatMatrix.
+template <typename MatrixType>
+std::string FitData(const MatrixType& data,
                     unsigned N,            // number of points to use
                     unsigned P,            // number of pairs to sample
                     unsigned Q,            // number of queries to sample
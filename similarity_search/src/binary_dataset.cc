@@ -0,0 +1,185 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "binary_dataset.h"
+#include "logging.h"
+
+namespace similarity {
+
+using std::ofstream;
+using std::ifstream;
+
+const size_t SIGNATURE_SIZE = 8;
+const size_t RECORD_ALIGN   = 8;
+
+static inline size_t AlignRecord(size_t len) {
+  return (len + RECORD_ALIGN - 1) / RECORD_ALIGN * RECORD_ALIGN;
+}
+
+static const char ZeroPad[RECORD_ALIGN] = {0};
+
+void WriteBinaryDataset(const string& SpaceDesc, const ObjectVector& dataset, const string& FileName) {
+  ofstream out(FileName.c_str(), std::ios::binary | std::ios::trunc | std::ios::out);
+
+  if (!out) {
+    LOG(LIB_FATAL) << "Cannot open: '" << FileName << "' for writing!";
+  }
+  out.exceptions(std::ios::badbit | std::ios::failbit);
+
+  uint64_t qty     = dataset.size();
+  uint64_t descLen = SpaceDesc.size();
+
+  out.write(BINARY_DATASET_SIGNATURE, SIGNATURE_SIZE);
+  out.write(reinterpret_cast<const char*>(&qty), sizeof qty);
+  out.write(reinterpret_cast<const char*>(&descLen), sizeof descLen);
+  out.write(SpaceDesc.data(), descLen);
+  out.write(ZeroPad, AlignRecord(descLen) - descLen);
+
+  for (const Object* obj: dataset) {
+    size_t len = obj->bufferlength();
+    out.write(obj->buffer(), len);
+    out.write(ZeroPad, AlignRecord(len) - len);
+  }
+  out.close();
+}
+
+bool IsBinaryDataset(const string& FileName) {
+  ifstream in(FileName.c_str(), std::ios::binary | std::ios::in);
+  char sig[SIGNATURE_SIZE];
+
+  if (!in || !in.read(sig, SIGNATURE_SIZE)) return false;
+
+  return memcmp(sig, BINARY_DATASET_SIGNATURE, SIGNATURE_SIZE) == 0;
+}
+
+MappedDataset::MappedDataset(const string& FileName)
+                : FileName_(FileName), pMapped_(NULL), MappedSize_(0),
+                  DataOffset_(0), ObjQty_(0) {
+#ifdef _MSC_VER
+  hFile_    = INVALID_HANDLE_VALUE;
+  hMapping_ = NULL;
+
+  hFile_ = CreateFileA(FileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (hFile_ == INVALID_HANDLE_VALUE) {
+    LOG(LIB_FATAL) << "Cannot open file: " << FileName;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(hFile_, &fileSize)) {
+    LOG(LIB_FATAL) << "Cannot obtain the size of the file: " << FileName;
+  }
+  MappedSize_ = static_cast<size_t>(fileSize.QuadPart);
+  hMapping_ = CreateFileMappingA(hFile_, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (hMapping_ == NULL) {
+    LOG(LIB_FATAL) << "Cannot memory map the file: " << FileName;
+  }
+  pMapped_ = reinterpret_cast<char*>(MapViewOfFile(hMapping_, FILE_MAP_READ, 0, 0, 0));
+  if (pMapped_ == NULL) {
+    LOG(LIB_FATAL) << "Cannot memory map the file: " << FileName;
+  }
+#else
+  int fd = open(FileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(LIB_FATAL) << "Cannot open file: " << FileName;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    LOG(LIB_FATAL) << "Cannot obtain the size of the file: " << FileName;
+  }
+  MappedSize_ = st.st_size;
+  void* p = mmap(NULL, MappedSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the file is closed
+  close(fd);
+  if (p == MAP_FAILED) {
+    LOG(LIB_FATAL) << "Cannot memory map the file: " << FileName;
+  }
+  pMapped_ = reinterpret_cast<char*>(p);
+  // Objects are normally read sequentially
+  madvise(p, MappedSize_, MADV_SEQUENTIAL);
+#endif
+
+  const size_t HeaderSize = SIGNATURE_SIZE + 2 * sizeof(uint64_t);
+
+  if (MappedSize_ < HeaderSize || memcmp(pMapped_, BINARY_DATASET_SIGNATURE, SIGNATURE_SIZE) != 0) {
+    LOG(LIB_FATAL) << "The file: " << FileName << " is not a binary data set";
+  }
+  uint64_t qty, descLen;
+  memcpy(&qty, pMapped_ + SIGNATURE_SIZE, sizeof qty);
+  memcpy(&descLen, pMapped_ + SIGNATURE_SIZE + sizeof qty, sizeof descLen);
+
+  if (HeaderSize + AlignRecord(descLen) > MappedSize_) {
+    LOG(LIB_FATAL) << "The binary data set file: " << FileName << " is truncated";
+  }
+  SpaceDesc_.assign(pMapped_ + HeaderSize, descLen);
+  DataOffset_ = HeaderSize + AlignRecord(descLen);
+  ObjQty_     = qty;
+}
+
+void MappedDataset::CreateObjects(ObjectVector& dataset, size_t MaxNumObjects) const {
+  const size_t qty = MaxNumObjects ? std::min(MaxNumObjects, ObjQty_) : ObjQty_;
+  const size_t ObjHeaderSize = ID_SIZE + LABEL_SIZE + DATALENGTH_SIZE;
+
+  dataset.clear();
+  dataset.reserve(qty);
+
+  size_t offset = DataOffset_;
+
+  for (size_t i = 0; i < qty; ++i) {
+    if (offset + ObjHeaderSize > MappedSize_) {
+      LOG(LIB_FATAL) << "The binary data set file: " << FileName_ << " is truncated";
+    }
+    // Record offsets are multiples of 8, hence, data is properly aligned
+    Object* obj = new Object(pMapped_ + offset);
+    offset += AlignRecord(obj->bufferlength());
+    if (offset > MappedSize_) {
+      delete obj;
+      LOG(LIB_FATAL) << "The binary data set file: " << FileName_ << " is truncated";
+    }
+    dataset.push_back(obj);
+  }
+}
+
+void MappedDataset::Unmap() {
+#ifdef _MSC_VER
+  if (pMapped_ != NULL) UnmapViewOfFile(pMapped_);
+  if (hMapping_ != NULL) CloseHandle(hMapping_);
+  if (hFile_ != INVALID_HANDLE_VALUE) CloseHandle(hFile_);
+#else
+  if (pMapped_ != NULL) munmap(pMapped_, MappedSize_);
+#endif
+  pMapped_ = NULL;
+}
+
+MappedDataset::~MappedDataset() {
+  Unmap();
+}
+
+}  // namespace similarity
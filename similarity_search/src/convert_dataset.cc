@@ -0,0 +1,132 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+/*
+ * Converts a text data file into the binary data set format (see binary_dataset.h),
+ * which can be memory mapped by the experiment program without parsing.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <boost/program_options.hpp>
+
+#include "init.h"
+#include "global.h"
+#include "utils.h"
+#include "space.h"
+#include "spacefactory.h"
+#include "params.h"
+#include "logging.h"
+#include "binary_dataset.h"
+
+using namespace similarity;
+using std::string;
+using std::vector;
+using std::unique_ptr;
+
+namespace po = boost::program_options;
+
+template <typename dist_t>
+void Convert(const string& SpaceType, const AnyParams& SpaceParams,
+             const string& InpFile, const string& OutFile, unsigned MaxNumData) {
+  unique_ptr<Space<dist_t>> space(SpaceFactoryRegistry<dist_t>::
+                                  Instance().CreateSpace(SpaceType, SpaceParams));
+  ObjectVector  data;
+
+  // Such spaces keep original data outside of objects (see SpaceQuantized)
+  if (space->GetRerankQty(1) != 1) {
+    LOG(LIB_FATAL) << "Binary data sets cannot be created for a space that re-ranks k-NN candidates: "
+                   << space->ToString();
+  }
+  space->ReadDataset(data, NULL, InpFile.c_str(), MaxNumData);
+  WriteBinaryDataset(space->ToString(), data, OutFile);
+
+  LOG(LIB_INFO) << "Saved " << data.size() << " objects to: " << OutFile;
+
+  for (const Object* obj: data) delete obj;
+}
+
+int main(int argc, char* argv[]) {
+  string    SpaceArg, DistType, InpFile, OutFile, LogFile;
+  unsigned  MaxNumData;
+
+  po::options_description ProgOptDesc("Allowed options");
+  ProgOptDesc.add_options()
+    ("help,h", "produce help message")
+    ("spaceType,s",     po::value<string>(&SpaceArg)->required(),
+                        "space type, e.g., l1, l2, lp:p=0.25")
+    ("distType",        po::value<string>(&DistType)->default_value("float"),
+                        "distance value type: int, float, double")
+    ("inpFile,i",       po::value<string>(&InpFile)->required(),
+                        "input (text) data file")
+    ("outFile,o",       po::value<string>(&OutFile)->required(),
+                        "output (binary) data file")
+    ("maxNumData",      po::value<unsigned>(&MaxNumData)->default_value(0),
+                        "if non-zero, only the first maxNumData elements are used")
+    ("logFile,l",       po::value<string>(&LogFile)->default_value(""),
+                        "log file")
+    ;
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, ProgOptDesc), vm);
+    if (vm.count("help")) {
+      std::cout << argv[0] << std::endl << ProgOptDesc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (const std::exception& e) {
+    std::cout << argv[0] << std::endl << ProgOptDesc << std::endl;
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  initLibrary(LogFile.empty() ? LIB_LOGSTDERR:LIB_LOGFILE, LogFile.c_str());
+
+  ToLower(DistType);
+  ToLower(SpaceArg);
+
+  vector<string> tmp;
+  if (!SplitStr(SpaceArg, tmp, ':') || tmp.size() > 2  || !tmp.size()) {
+    LOG(LIB_FATAL) << "Wrong format of the space argument: '" << SpaceArg;
+  }
+  vector<string> SpaceDesc;
+  if (tmp.size() == 2) {
+    if (!SplitStr(tmp[1], SpaceDesc, ',')) {
+      LOG(LIB_FATAL) << "Cannot split space arguments in: " << tmp[1];
+    }
+  }
+  AnyParams SpaceParams(SpaceDesc);
+
+  try {
+    if ("int" == DistType) {
+      Convert<int>(tmp[0], SpaceParams, InpFile, OutFile, MaxNumData);
+    } else if ("float" == DistType) {
+      Convert<float>(tmp[0], SpaceParams, InpFile, OutFile, MaxNumData);
+    } else if ("double" == DistType) {
+      Convert<double>(tmp[0], SpaceParams, InpFile, OutFile, MaxNumData);
+    } else {
+      LOG(LIB_FATAL) << "Unknown distance value type: " << DistType;
+    }
+  } catch (const std::exception& e) {
+    LOG(LIB_FATAL) << "Exception: " << e.what();
+  }
+
+  return 0;
+}
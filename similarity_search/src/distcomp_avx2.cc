@@ -0,0 +1,705 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+/*
+ * 256-bit versions of SIMD distance functions. This file is compiled
+ * with -mavx2 -mfma -mf16c (see src/CMakeLists.txt) and the kernels are used only
+ * if the CPU supports AVX2, FMA, and F16C (see distcomp_dispatch.h).
+ *
+ * To avoid placing AVX instructions into shared inline functions,
+ * we don't call anything from the standard library here
+ * (e.g., we use FLT_MIN rather than numeric_limits<float>::min()).
+ */
+#include <cstddef>
+#include <cfloat>
+
+#include "distcomp_dispatch.h"
+#include "simdutils.h"
+#include "utils.h"
+
+#if defined(__AVX2__) && ((defined(__FMA__) && defined(__F16C__)) || defined(_MSC_VER))
+#define AVX2_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace similarity {
+
+#ifndef AVX2_KERNELS
+#pragma message WARN("distcomp_avx2.cc is compiled without AVX2/FMA/F16C support, AVX2 distance functions will not be used!")
+
+bool GetAVX2Kernels(SIMDKernels<float>& FloatKernels, SIMDKernels<double>& DoubleKernels,
+                    SQKernels& QuantKernels, SparseKernels& SparseVectKernels) {
+  return false;
+}
+
+/*
+ * Tier-specific functors of dist_kernel.h refer to these functions,
+ * but never call them, because the AVX2 tier is not supported.
+ */
+float LInfNormAVX2(const float* pVect1, const float* pVect2, size_t qty) { return LInfNormSSE(pVect1, pVect2, qty); }
+double LInfNormAVX2(const double* pVect1, const double* pVect2, size_t qty) { return LInfNormSSE(pVect1, pVect2, qty); }
+float L1NormAVX2(const float* pVect1, const float* pVect2, size_t qty) { return L1NormSSE(pVect1, pVect2, qty); }
+double L1NormAVX2(const double* pVect1, const double* pVect2, size_t qty) { return L1NormSSE(pVect1, pVect2, qty); }
+float L2SqrAVX2(const float* pVect1, const float* pVect2, size_t qty) { return L2SqrSSE(pVect1, pVect2, qty); }
+double L2SqrAVX2(const double* pVect1, const double* pVect2, size_t qty) { return L2SqrSSE(pVect1, pVect2, qty); }
+
+#else
+
+namespace {
+
+const float   CLOG2F = 0.693147180559945309417f;
+const double  CLOG2D = 0.693147180559945309417;
+
+inline float HorizontalSum(__m256 v) {
+    float PORTABLE_ALIGN32 TmpRes[8];
+    _mm256_store_ps(TmpRes, v);
+    return TmpRes[0] + TmpRes[1] + TmpRes[2] + TmpRes[3] +
+           TmpRes[4] + TmpRes[5] + TmpRes[6] + TmpRes[7];
+}
+
+inline double HorizontalSum(__m256d v) {
+    double PORTABLE_ALIGN32 TmpRes[4];
+    _mm256_store_pd(TmpRes, v);
+    return TmpRes[0] + TmpRes[1] + TmpRes[2] + TmpRes[3];
+}
+
+inline float HorizontalMax(__m256 v) {
+    float PORTABLE_ALIGN32 TmpRes[8];
+    _mm256_store_ps(TmpRes, v);
+    float res = TmpRes[0];
+    for (int i = 1; i < 8; ++i) res = TmpRes[i] > res ? TmpRes[i] : res;
+    return res;
+}
+
+inline double HorizontalMax(__m256d v) {
+    double PORTABLE_ALIGN32 TmpRes[4];
+    _mm256_store_pd(TmpRes, v);
+    double res = TmpRes[0];
+    for (int i = 1; i < 4; ++i) res = TmpRes[i] > res ? TmpRes[i] : res;
+    return res;
+}
+
+template <class T> inline T Abs(T x) { return x < 0 ? -x : x; }
+
+}
+
+/*
+ * Lp-norm kernels have external linkage: tier-specific functors
+ * of dist_kernel.h call them directly.
+ */
+
+/*
+ * LInf-norm
+ */
+
+float LInfNormAVX2(const float* pVect1, const float* pVect2, size_t qty) {
+    const __m256 mask_sign = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 max1 = _mm256_setzero_ps(), max2 = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        max1 = _mm256_max_ps(max1, _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(pVect1 + i),     _mm256_loadu_ps(pVect2 + i)),     mask_sign));
+        max2 = _mm256_max_ps(max2, _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(pVect1 + i + 8), _mm256_loadu_ps(pVect2 + i + 8)), mask_sign));
+    }
+    for (; i + 8 <= qty; i += 8) {
+        max1 = _mm256_max_ps(max1, _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(pVect1 + i),     _mm256_loadu_ps(pVect2 + i)),     mask_sign));
+    }
+
+    float res = HorizontalMax(_mm256_max_ps(max1, max2));
+
+    for (; i < qty; ++i) {
+        float diff = Abs(pVect1[i] - pVect2[i]);
+        res = diff > res ? diff : res;
+    }
+
+    return res;
+}
+
+double LInfNormAVX2(const double* pVect1, const double* pVect2, size_t qty) {
+    const __m256d mask_sign = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    __m256d max1 = _mm256_setzero_pd(), max2 = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 8 <= qty; i += 8) {
+        max1 = _mm256_max_pd(max1, _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(pVect1 + i),     _mm256_loadu_pd(pVect2 + i)),     mask_sign));
+        max2 = _mm256_max_pd(max2, _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(pVect1 + i + 4), _mm256_loadu_pd(pVect2 + i + 4)), mask_sign));
+    }
+    for (; i + 4 <= qty; i += 4) {
+        max1 = _mm256_max_pd(max1, _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(pVect1 + i),     _mm256_loadu_pd(pVect2 + i)),     mask_sign));
+    }
+
+    double res = HorizontalMax(_mm256_max_pd(max1, max2));
+
+    for (; i < qty; ++i) {
+        double diff = Abs(pVect1[i] - pVect2[i]);
+        res = diff > res ? diff : res;
+    }
+
+    return res;
+}
+
+/*
+ * L1-norm
+ */
+
+float L1NormAVX2(const float* pVect1, const float* pVect2, size_t qty) {
+    const __m256 mask_sign = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 sum1 = _mm256_setzero_ps(), sum2 = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        sum1 = _mm256_add_ps(sum1, _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(pVect1 + i),     _mm256_loadu_ps(pVect2 + i)),     mask_sign));
+        sum2 = _mm256_add_ps(sum2, _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(pVect1 + i + 8), _mm256_loadu_ps(pVect2 + i + 8)), mask_sign));
+    }
+    for (; i + 8 <= qty; i += 8) {
+        sum1 = _mm256_add_ps(sum1, _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(pVect1 + i),     _mm256_loadu_ps(pVect2 + i)),     mask_sign));
+    }
+
+    float res = HorizontalSum(_mm256_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        res += Abs(pVect1[i] - pVect2[i]);
+    }
+
+    return res;
+}
+
+double L1NormAVX2(const double* pVect1, const double* pVect2, size_t qty) {
+    const __m256d mask_sign = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    __m256d sum1 = _mm256_setzero_pd(), sum2 = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 8 <= qty; i += 8) {
+        sum1 = _mm256_add_pd(sum1, _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(pVect1 + i),     _mm256_loadu_pd(pVect2 + i)),     mask_sign));
+        sum2 = _mm256_add_pd(sum2, _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(pVect1 + i + 4), _mm256_loadu_pd(pVect2 + i + 4)), mask_sign));
+    }
+    for (; i + 4 <= qty; i += 4) {
+        sum1 = _mm256_add_pd(sum1, _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(pVect1 + i),     _mm256_loadu_pd(pVect2 + i)),     mask_sign));
+    }
+
+    double res = HorizontalSum(_mm256_add_pd(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        res += Abs(pVect1[i] - pVect2[i]);
+    }
+
+    return res;
+}
+
+/*
+ * The square of the L2-norm
+ */
+
+float L2SqrAVX2(const float* pVect1, const float* pVect2, size_t qty) {
+    __m256 sum1 = _mm256_setzero_ps(), sum2 = _mm256_setzero_ps(), diff;
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        diff = _mm256_sub_ps(_mm256_loadu_ps(pVect1 + i),     _mm256_loadu_ps(pVect2 + i));
+        sum1 = _mm256_fmadd_ps(diff, diff, sum1);
+        diff = _mm256_sub_ps(_mm256_loadu_ps(pVect1 + i + 8), _mm256_loadu_ps(pVect2 + i + 8));
+        sum2 = _mm256_fmadd_ps(diff, diff, sum2);
+    }
+    for (; i + 8 <= qty; i += 8) {
+        diff = _mm256_sub_ps(_mm256_loadu_ps(pVect1 + i),     _mm256_loadu_ps(pVect2 + i));
+        sum1 = _mm256_fmadd_ps(diff, diff, sum1);
+    }
+
+    float res = HorizontalSum(_mm256_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        float d = pVect1[i] - pVect2[i];
+        res += d * d;
+    }
+
+    return res;
+}
+
+double L2SqrAVX2(const double* pVect1, const double* pVect2, size_t qty) {
+    __m256d sum1 = _mm256_setzero_pd(), sum2 = _mm256_setzero_pd(), diff;
+    size_t i = 0;
+
+    for (; i + 8 <= qty; i += 8) {
+        diff = _mm256_sub_pd(_mm256_loadu_pd(pVect1 + i),     _mm256_loadu_pd(pVect2 + i));
+        sum1 = _mm256_fmadd_pd(diff, diff, sum1);
+        diff = _mm256_sub_pd(_mm256_loadu_pd(pVect1 + i + 4), _mm256_loadu_pd(pVect2 + i + 4));
+        sum2 = _mm256_fmadd_pd(diff, diff, sum2);
+    }
+    for (; i + 4 <= qty; i += 4) {
+        diff = _mm256_sub_pd(_mm256_loadu_pd(pVect1 + i),     _mm256_loadu_pd(pVect2 + i));
+        sum1 = _mm256_fmadd_pd(diff, diff, sum1);
+    }
+
+    double res = HorizontalSum(_mm256_add_pd(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        double d = pVect1[i] - pVect2[i];
+        res += d * d;
+    }
+
+    return res;
+}
+
+namespace {
+
+/*
+ * KL-divergence (logarithms are stored after vector elements, see distcomp.h)
+ */
+
+float KLPrecompAVX2(const float* pVect1, const float* pVect2, size_t qty) {
+    const float* pVectLog1 = pVect1 + qty;
+    const float* pVectLog2 = pVect2 + qty;
+
+    __m256 sum1 = _mm256_setzero_ps(), sum2 = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pVect1 + i),
+                               _mm256_sub_ps(_mm256_loadu_ps(pVectLog1 + i), _mm256_loadu_ps(pVectLog2 + i)), sum1);
+        sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(pVect1 + i + 8),
+                               _mm256_sub_ps(_mm256_loadu_ps(pVectLog1 + i + 8), _mm256_loadu_ps(pVectLog2 + i + 8)), sum2);
+    }
+    for (; i + 8 <= qty; i += 8) {
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pVect1 + i),
+                               _mm256_sub_ps(_mm256_loadu_ps(pVectLog1 + i), _mm256_loadu_ps(pVectLog2 + i)), sum1);
+    }
+
+    float res = HorizontalSum(_mm256_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        res += pVect1[i] * (pVectLog1[i] - pVectLog2[i]);
+    }
+
+    return res;
+}
+
+double KLPrecompAVX2(const double* pVect1, const double* pVect2, size_t qty) {
+    const double* pVectLog1 = pVect1 + qty;
+    const double* pVectLog2 = pVect2 + qty;
+
+    __m256d sum1 = _mm256_setzero_pd(), sum2 = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 8 <= qty; i += 8) {
+        sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(pVect1 + i),
+                               _mm256_sub_pd(_mm256_loadu_pd(pVectLog1 + i), _mm256_loadu_pd(pVectLog2 + i)), sum1);
+        sum2 = _mm256_fmadd_pd(_mm256_loadu_pd(pVect1 + i + 4),
+                               _mm256_sub_pd(_mm256_loadu_pd(pVectLog1 + i + 4), _mm256_loadu_pd(pVectLog2 + i + 4)), sum2);
+    }
+    for (; i + 4 <= qty; i += 4) {
+        sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(pVect1 + i),
+                               _mm256_sub_pd(_mm256_loadu_pd(pVectLog1 + i), _mm256_loadu_pd(pVectLog2 + i)), sum1);
+    }
+
+    double res = HorizontalSum(_mm256_add_pd(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        res += pVect1[i] * (pVectLog1[i] - pVectLog2[i]);
+    }
+
+    return res;
+}
+
+/*
+ * Itakura-Saito distance (logarithms are stored after vector elements, see distcomp.h)
+ */
+
+float ItakuraSaitoPrecompAVX2(const float* pVect1, const float* pVect2, size_t qty) {
+    const float* pVectLog1 = pVect1 + qty;
+    const float* pVectLog2 = pVect2 + qty;
+
+    __m256 sum = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 8 <= qty; i += 8) {
+        __m256 v1     = _mm256_loadu_ps(pVect1 + i);
+        __m256 v2     = _mm256_loadu_ps(pVect2 + i);
+        __m256 vLog1  = _mm256_loadu_ps(pVectLog1 + i);
+        __m256 vLog2  = _mm256_loadu_ps(pVectLog2 + i);
+        sum = _mm256_add_ps(sum, _mm256_sub_ps(_mm256_div_ps(v1, v2), _mm256_sub_ps(vLog1, vLog2)));
+    }
+
+    float res = HorizontalSum(sum);
+
+    for (; i < qty; ++i) {
+        res += pVect1[i] / pVect2[i] - (pVectLog1[i] - pVectLog2[i]);
+    }
+
+    return res - qty;
+}
+
+double ItakuraSaitoPrecompAVX2(const double* pVect1, const double* pVect2, size_t qty) {
+    const double* pVectLog1 = pVect1 + qty;
+    const double* pVectLog2 = pVect2 + qty;
+
+    __m256d sum = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 4 <= qty; i += 4) {
+        __m256d v1    = _mm256_loadu_pd(pVect1 + i);
+        __m256d v2    = _mm256_loadu_pd(pVect2 + i);
+        __m256d vLog1 = _mm256_loadu_pd(pVectLog1 + i);
+        __m256d vLog2 = _mm256_loadu_pd(pVectLog2 + i);
+        sum = _mm256_add_pd(sum, _mm256_sub_pd(_mm256_div_pd(v1, v2), _mm256_sub_pd(vLog1, vLog2)));
+    }
+
+    double res = HorizontalSum(sum);
+
+    for (; i < qty; ++i) {
+        res += pVect1[i] / pVect2[i] - (pVectLog1[i] - pVectLog2[i]);
+    }
+
+    return res - qty;
+}
+
+/*
+ * Jensen-Shannon divergence with approximate logarithms: see JSPrecompSSEApproxLog
+ * in distcomp_js.cc for details. Unlike the SSE version, table lookups are done
+ * using the gather instruction.
+ */
+
+template <class T>
+inline T JSApproxLogElem(T v1, T v2, T lv1, T lv2, const T* ltbl, T clog2, T minVal) {
+    T res = v1 * lv1 + v2 * lv2;
+
+    if (v1 > v2) {
+        T tmp = v1; v1 = v2; v2 = tmp;
+        tmp = lv1; lv1 = lv2; lv2 = tmp;
+    }
+    if (v2 >= minVal) {
+        // Casting to unsigned is the same as floor, because the argument is non-negative
+        res -= (v1 + v2) * (lv2 + ltbl[static_cast<unsigned>(LogQty * (v1 / v2))] - clog2);
+    }
+    return res;
+}
+
+float JSPrecompApproxLogAVX2(const float* pVect1, const float* pVect2, size_t qty) {
+    const float* ltbl = GetApproxLogTable<float>();
+
+    const float* pVectLog1 = pVect1 + qty;
+    const float* pVectLog2 = pVect2 + qty;
+
+    const __m256 cmult     = _mm256_set1_ps(LogQty);
+    const __m256 clog2simd = _mm256_set1_ps(CLOG2F);
+    const __m256 minVal    = _mm256_set1_ps(FLT_MIN);
+
+    __m256 sum = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 8 <= qty; i += 8) {
+        __m256 v1     = _mm256_loadu_ps(pVect1 + i);
+        __m256 v2     = _mm256_loadu_ps(pVect2 + i);
+        __m256 vLog1  = _mm256_loadu_ps(pVectLog1 + i);
+        __m256 vLog2  = _mm256_loadu_ps(pVectLog2 + i);
+
+        sum = _mm256_fmadd_ps(v1, vLog1, sum);
+        sum = _mm256_fmadd_ps(v2, vLog2, sum);
+        /*
+         * If v1 == v2 == 0, the second factor in (v1 + v2)*(lv2 + ltbl[lapprox(v1/v2)] - clog2)
+         * doesn't need to be computed correctly, but we need to avoid division by zero.
+         */
+        __m256 maxv         = _mm256_max_ps(_mm256_max_ps(v1, v2), minVal);
+        // This is the log with the largest modulo (recall that logs are < 0 here)
+        __m256 max_mod_logv = _mm256_max_ps(vLog1, vLog2);
+        __m256 minv         = _mm256_min_ps(v1, v2);
+        __m256i tmpi        = _mm256_cvttps_epi32(_mm256_mul_ps(cmult, _mm256_div_ps(minv, maxv)));
+        __m256 ltmp         = _mm256_i32gather_ps(ltbl, tmpi, 4);
+        __m256 d            = _mm256_sub_ps(_mm256_add_ps(max_mod_logv, ltmp), clog2simd);
+
+        sum = _mm256_fnmadd_ps(_mm256_add_ps(v1, v2), d, sum);
+    }
+
+    float res = HorizontalSum(sum);
+
+    for (; i < qty; ++i) {
+        res += JSApproxLogElem(pVect1[i], pVect2[i], pVectLog1[i], pVectLog2[i], ltbl, CLOG2F, FLT_MIN);
+    }
+
+    // Due to computation/rounding errors, we may get a small-magnitude negative number
+    return res > 0 ? 0.5f * res : 0.0f;
+}
+
+double JSPrecompApproxLogAVX2(const double* pVect1, const double* pVect2, size_t qty) {
+    const double* ltbl = GetApproxLogTable<double>();
+
+    const double* pVectLog1 = pVect1 + qty;
+    const double* pVectLog2 = pVect2 + qty;
+
+    const __m256d cmult     = _mm256_set1_pd(LogQty);
+    const __m256d clog2simd = _mm256_set1_pd(CLOG2D);
+    const __m256d minVal    = _mm256_set1_pd(DBL_MIN);
+    /*
+     * GCC implements _mm256_i32gather_pd using an undefined pass-through
+     * operand (which triggers -Wmaybe-uninitialized). The masked gather
+     * with all mask bits set and a zero pass-through operand is the same instruction.
+     */
+    const __m256d fullMask  = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+    __m256d sum = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 4 <= qty; i += 4) {
+        __m256d v1    = _mm256_loadu_pd(pVect1 + i);
+        __m256d v2    = _mm256_loadu_pd(pVect2 + i);
+        __m256d vLog1 = _mm256_loadu_pd(pVectLog1 + i);
+        __m256d vLog2 = _mm256_loadu_pd(pVectLog2 + i);
+
+        sum = _mm256_fmadd_pd(v1, vLog1, sum);
+        sum = _mm256_fmadd_pd(v2, vLog2, sum);
+
+        __m256d maxv          = _mm256_max_pd(_mm256_max_pd(v1, v2), minVal);
+        __m256d max_mod_logv  = _mm256_max_pd(vLog1, vLog2);
+        __m256d minv          = _mm256_min_pd(v1, v2);
+        __m128i tmpi          = _mm256_cvttpd_epi32(_mm256_mul_pd(cmult, _mm256_div_pd(minv, maxv)));
+        __m256d ltmp          = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), ltbl, tmpi, fullMask, 8);
+        __m256d d             = _mm256_sub_pd(_mm256_add_pd(max_mod_logv, ltmp), clog2simd);
+
+        sum = _mm256_fnmadd_pd(_mm256_add_pd(v1, v2), d, sum);
+    }
+
+    double res = HorizontalSum(sum);
+
+    for (; i < qty; ++i) {
+        res += JSApproxLogElem(pVect1[i], pVect2[i], pVectLog1[i], pVectLog2[i], ltbl, CLOG2D, DBL_MIN);
+    }
+
+    // Due to computation/rounding errors, we may get a small-magnitude negative number
+    return res > 0 ? 0.5 * res : 0.0;
+}
+
+/*
+ * Scalar quantization: 8-bit codes are expanded to 32-bit integers
+ * and converted to floats, half-precision numbers are converted using F16C.
+ */
+
+inline __m256 DecodeSQ8x8(__m128i c, __m256 vMin, __m256 vScale) {
+    return _mm256_fmadd_ps(vScale, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(c)), vMin);
+}
+
+float L2SqrSQ8AVX2(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty) {
+    const __m256 vMin = _mm256_set1_ps(min), vScale = _mm256_set1_ps(scale);
+    __m256  sum1 = _mm256_setzero_ps(), sum2 = _mm256_setzero_ps(), diff;
+    __m128i c;
+    size_t  i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        c    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCodes + i));
+        diff = _mm256_sub_ps(_mm256_loadu_ps(pVect + i),     DecodeSQ8x8(c, vMin, vScale));
+        sum1 = _mm256_fmadd_ps(diff, diff, sum1);
+        diff = _mm256_sub_ps(_mm256_loadu_ps(pVect + i + 8), DecodeSQ8x8(_mm_srli_si128(c, 8), vMin, vScale));
+        sum2 = _mm256_fmadd_ps(diff, diff, sum2);
+    }
+
+    float res = HorizontalSum(_mm256_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        float d = pVect[i] - (min + scale * pCodes[i]);
+        res += d * d;
+    }
+
+    return res;
+}
+
+float ScalarProductSQ8AVX2(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty) {
+    const __m256 vMin = _mm256_set1_ps(min), vScale = _mm256_set1_ps(scale);
+    __m256  sum1 = _mm256_setzero_ps(), sum2 = _mm256_setzero_ps();
+    __m128i c;
+    size_t  i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        c    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCodes + i));
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pVect + i),     DecodeSQ8x8(c, vMin, vScale), sum1);
+        sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(pVect + i + 8), DecodeSQ8x8(_mm_srli_si128(c, 8), vMin, vScale), sum2);
+    }
+
+    float res = HorizontalSum(_mm256_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        res += pVect[i] * (min + scale * pCodes[i]);
+    }
+
+    return res;
+}
+
+inline __m256 DecodeFP16x8(const uint16_t* pCodes) {
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pCodes)));
+}
+
+// Converts one half-precision number
+inline float DecodeFP16x1(uint16_t code) {
+    return _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(code)));
+}
+
+float L2SqrFP16AVX2(const float* pVect, const uint16_t* pCodes, size_t qty) {
+    __m256 sum1 = _mm256_setzero_ps(), sum2 = _mm256_setzero_ps(), diff;
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        diff = _mm256_sub_ps(_mm256_loadu_ps(pVect + i),     DecodeFP16x8(pCodes + i));
+        sum1 = _mm256_fmadd_ps(diff, diff, sum1);
+        diff = _mm256_sub_ps(_mm256_loadu_ps(pVect + i + 8), DecodeFP16x8(pCodes + i + 8));
+        sum2 = _mm256_fmadd_ps(diff, diff, sum2);
+    }
+    for (; i + 8 <= qty; i += 8) {
+        diff = _mm256_sub_ps(_mm256_loadu_ps(pVect + i),     DecodeFP16x8(pCodes + i));
+        sum1 = _mm256_fmadd_ps(diff, diff, sum1);
+    }
+
+    float res = HorizontalSum(_mm256_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        float d = pVect[i] - DecodeFP16x1(pCodes[i]);
+        res += d * d;
+    }
+
+    return res;
+}
+
+float ScalarProductFP16AVX2(const float* pVect, const uint16_t* pCodes, size_t qty) {
+    __m256 sum1 = _mm256_setzero_ps(), sum2 = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pVect + i),     DecodeFP16x8(pCodes + i),     sum1);
+        sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(pVect + i + 8), DecodeFP16x8(pCodes + i + 8), sum2);
+    }
+    for (; i + 8 <= qty; i += 8) {
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(pVect + i),     DecodeFP16x8(pCodes + i),     sum1);
+    }
+
+    float res = HorizontalSum(_mm256_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        res += pVect[i] * DecodeFP16x1(pCodes[i]);
+    }
+
+    return res;
+}
+
+/*
+ * Sparse vectors. AVX2 has no analog of _mm_cmpistrm, so ids are
+ * compared 8 x 8 using SSE 4.2 (which is implied by AVX2). However,
+ * instead of storing matching values in buffers (as the SSE version does),
+ * they are compacted using a single 8-element permutation and
+ * multiplied right away.
+ *
+ * The element with the index mask of SparsePermTable contains the positions
+ * of the set bits in the mask. SparsePermTable and SparseCountTable
+ * are filled by GetAVX2Kernels, i.e., only if the CPU supports AVX2.
+ */
+int32_t PORTABLE_ALIGN32 SparsePermTable[256][8];
+int32_t                  SparseCountTable[256];
+
+void InitSparseTables() {
+  for (int mask = 0; mask < 256; ++mask) {
+    int qty = 0;
+    for (int i = 0; i < 8; ++i) {
+      SparsePermTable[mask][i] = 0;
+    }
+    for (int i = 0; i < 8; ++i) {
+      if (mask & (1 << i)) SparsePermTable[mask][qty++] = i;
+    }
+    SparseCountTable[mask] = qty;
+  }
+}
+
+float SparseBlockScalarProductAVX2(const uint16_t* pBlockIds1, const float* pBlockVals1, size_t qty1,
+                                   const uint16_t* pBlockIds2, const float* pBlockVals2, size_t qty2) {
+    const __m256i laneIds = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 sum = _mm256_setzero_ps();
+
+    size_t i1 = 0, i2 = 0;
+    const size_t iEnd1 = qty1 / 8 * 8;
+    const size_t iEnd2 = qty2 / 8 * 8;
+
+    while (i1 < iEnd1 && i2 < iEnd2) {
+        const uint16_t id1max = pBlockIds1[i1 + 7];
+        const uint16_t id2max = pBlockIds2[i2 + 7];
+
+        __m128i id1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pBlockIds1[i1]));
+        __m128i id2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pBlockIds2[i2]));
+
+        /*
+         * This loop has no unpredictable branches: when there are no matches,
+         * the mask is zero and the products are discarded.
+         */
+        const int r1 = _mm_extract_epi32(_mm_cmpistrm(id2, id1,
+                                                      _SIDD_UWORD_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK), 0);
+        const int r2 = _mm_extract_epi32(_mm_cmpistrm(id1, id2,
+                                                      _SIDD_UWORD_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK), 0);
+        /*
+         * Ids are sorted and unique, so the i-th matching value
+         * in the first block corresponds to the i-th matching value
+         * in the second block.
+         */
+        __m256 v1 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(pBlockVals1 + i1),
+                        _mm256_load_si256(reinterpret_cast<const __m256i*>(SparsePermTable[r1])));
+        __m256 v2 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(pBlockVals2 + i2),
+                        _mm256_load_si256(reinterpret_cast<const __m256i*>(SparsePermTable[r2])));
+        __m256 mask = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(SparseCountTable[r1]), laneIds));
+        sum = _mm256_add_ps(sum, _mm256_and_ps(_mm256_mul_ps(v1, v2), mask));
+
+        i1 += id1max <= id2max ? 8 : 0;
+        i2 += id1max >= id2max ? 8 : 0;
+    }
+
+    float res = HorizontalSum(sum);
+
+    while (i1 < qty1 && i2 < qty2) {
+        if (pBlockIds1[i1] == pBlockIds2[i2]) {
+            res += pBlockVals1[i1++] * pBlockVals2[i2++];
+        } else if (pBlockIds1[i1] < pBlockIds2[i2]) {
+            ++i1;
+        } else {
+            ++i2;
+        }
+    }
+
+    return res;
+}
+
+}
+
+bool GetAVX2Kernels(SIMDKernels<float>& FloatKernels, SIMDKernels<double>& DoubleKernels,
+                    SQKernels& QuantKernels, SparseKernels& SparseVectKernels) {
+  FloatKernels.LInfNorm             = LInfNormAVX2;
+  FloatKernels.L1Norm               = L1NormAVX2;
+  FloatKernels.L2Sqr                = L2SqrAVX2;
+  FloatKernels.KLPrecomp            = KLPrecompAVX2;
+  FloatKernels.ItakuraSaitoPrecomp  = ItakuraSaitoPrecompAVX2;
+  FloatKernels.JSPrecompApproxLog   = JSPrecompApproxLogAVX2;
+
+  DoubleKernels.LInfNorm            = LInfNormAVX2;
+  DoubleKernels.L1Norm              = L1NormAVX2;
+  DoubleKernels.L2Sqr               = L2SqrAVX2;
+  DoubleKernels.KLPrecomp           = KLPrecompAVX2;
+  DoubleKernels.ItakuraSaitoPrecomp = ItakuraSaitoPrecompAVX2;
+  DoubleKernels.JSPrecompApproxLog  = JSPrecompApproxLogAVX2;
+
+  QuantKernels.L2SqrSQ8             = L2SqrSQ8AVX2;
+  QuantKernels.ScalarProductSQ8     = ScalarProductSQ8AVX2;
+  QuantKernels.L2SqrFP16            = L2SqrFP16AVX2;
+  QuantKernels.ScalarProductFP16    = ScalarProductFP16AVX2;
+
+  InitSparseTables();
+  SparseVectKernels.BlockScalarProduct = SparseBlockScalarProductAVX2;
+
+  return true;
+}
+
+#endif
+
+}
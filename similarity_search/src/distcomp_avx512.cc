@@ -0,0 +1,624 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+/*
+ * 512-bit versions of SIMD distance functions. This file is compiled
+ * with -mavx512f -mf16c (see src/CMakeLists.txt) and the kernels are used only
+ * if the CPU supports AVX-512F and F16C (see distcomp_dispatch.h). Only AVX-512F
+ * (and F16C) instructions are used, so that the code runs on all AVX-512 CPUs.
+ *
+ * Tails are processed using masked loads: the masked-out elements
+ * are chosen so that they contribute zero to the result. As in
+ * distcomp_avx2.cc, nothing from the standard library is called here.
+ */
+#include <cstddef>
+#include <cfloat>
+
+#include "distcomp_dispatch.h"
+#include "simdutils.h"
+#include "utils.h"
+
+#if defined(__AVX512F__) && defined(__AVX2__) && ((defined(__FMA__) && defined(__F16C__)) || defined(_MSC_VER))
+#define AVX512_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace similarity {
+
+#ifndef AVX512_KERNELS
+#pragma message WARN("distcomp_avx512.cc is compiled without AVX-512 support, AVX-512 distance functions will not be used!")
+
+bool GetAVX512Kernels(SIMDKernels<float>& FloatKernels, SIMDKernels<double>& DoubleKernels,
+                      SQKernels& QuantKernels) {
+  return false;
+}
+
+/*
+ * Tier-specific functors of dist_kernel.h refer to these functions,
+ * but never call them, because the AVX-512 tier is not supported.
+ */
+float LInfNormAVX512(const float* pVect1, const float* pVect2, size_t qty) { return LInfNormSSE(pVect1, pVect2, qty); }
+double LInfNormAVX512(const double* pVect1, const double* pVect2, size_t qty) { return LInfNormSSE(pVect1, pVect2, qty); }
+float L1NormAVX512(const float* pVect1, const float* pVect2, size_t qty) { return L1NormSSE(pVect1, pVect2, qty); }
+double L1NormAVX512(const double* pVect1, const double* pVect2, size_t qty) { return L1NormSSE(pVect1, pVect2, qty); }
+float L2SqrAVX512(const float* pVect1, const float* pVect2, size_t qty) { return L2SqrSSE(pVect1, pVect2, qty); }
+double L2SqrAVX512(const double* pVect1, const double* pVect2, size_t qty) { return L2SqrSSE(pVect1, pVect2, qty); }
+
+#else
+
+namespace {
+
+const float   CLOG2F = 0.693147180559945309417f;
+const double  CLOG2D = 0.693147180559945309417;
+
+inline float HorizontalSum(__m512 v) {
+    float PORTABLE_ALIGN64 TmpRes[16];
+    _mm512_store_ps(TmpRes, v);
+    float res = 0;
+    for (int i = 0; i < 16; ++i) res += TmpRes[i];
+    return res;
+}
+
+inline double HorizontalSum(__m512d v) {
+    double PORTABLE_ALIGN64 TmpRes[8];
+    _mm512_store_pd(TmpRes, v);
+    double res = 0;
+    for (int i = 0; i < 8; ++i) res += TmpRes[i];
+    return res;
+}
+
+inline float HorizontalMax(__m512 v) {
+    float PORTABLE_ALIGN64 TmpRes[16];
+    _mm512_store_ps(TmpRes, v);
+    float res = TmpRes[0];
+    for (int i = 1; i < 16; ++i) res = TmpRes[i] > res ? TmpRes[i] : res;
+    return res;
+}
+
+inline double HorizontalMax(__m512d v) {
+    double PORTABLE_ALIGN64 TmpRes[8];
+    _mm512_store_pd(TmpRes, v);
+    double res = TmpRes[0];
+    for (int i = 1; i < 8; ++i) res = TmpRes[i] > res ? TmpRes[i] : res;
+    return res;
+}
+
+// The mask of the first qty (< 16) elements
+inline __mmask16 TailMask16(size_t qty) { return static_cast<__mmask16>((1u << qty) - 1); }
+// The mask of the first qty (< 8) elements
+inline __mmask8  TailMask8(size_t qty)  { return static_cast<__mmask8>((1u << qty) - 1); }
+
+/*
+ * GCC implements unmasked max/min, gathers, and conversions using an undefined
+ * pass-through operand, which triggers -Wmaybe-uninitialized. Hence, we use
+ * masked forms with all mask bits set and a zero pass-through operand:
+ * these are the same instructions.
+ */
+const __mmask16 FullMask16 = 0xFFFF;
+const __mmask8  FullMask8  = 0xFF;
+
+inline __m512  Max(__m512 a, __m512 b)   { return _mm512_maskz_max_ps(FullMask16, a, b); }
+inline __m512d Max(__m512d a, __m512d b) { return _mm512_maskz_max_pd(FullMask8, a, b); }
+inline __m512  Min(__m512 a, __m512 b)   { return _mm512_maskz_min_ps(FullMask16, a, b); }
+inline __m512d Min(__m512d a, __m512d b) { return _mm512_maskz_min_pd(FullMask8, a, b); }
+
+}
+
+/*
+ * Lp-norm kernels have external linkage: tier-specific functors
+ * of dist_kernel.h call them directly.
+ */
+
+/*
+ * LInf-norm
+ */
+
+float LInfNormAVX512(const float* pVect1, const float* pVect2, size_t qty) {
+    __m512 max1 = _mm512_setzero_ps(), max2 = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 32 <= qty; i += 32) {
+        max1 = Max(max1, _mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(pVect1 + i),      _mm512_loadu_ps(pVect2 + i))));
+        max2 = Max(max2, _mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(pVect1 + i + 16), _mm512_loadu_ps(pVect2 + i + 16))));
+    }
+    for (; i + 16 <= qty; i += 16) {
+        max1 = Max(max1, _mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(pVect1 + i),      _mm512_loadu_ps(pVect2 + i))));
+    }
+    if (i < qty) {
+        __mmask16 mask = TailMask16(qty - i);
+        max2 = Max(max2, _mm512_abs_ps(_mm512_sub_ps(_mm512_maskz_loadu_ps(mask, pVect1 + i),
+                                                     _mm512_maskz_loadu_ps(mask, pVect2 + i))));
+    }
+
+    return HorizontalMax(Max(max1, max2));
+}
+
+double LInfNormAVX512(const double* pVect1, const double* pVect2, size_t qty) {
+    __m512d max1 = _mm512_setzero_pd(), max2 = _mm512_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        max1 = Max(max1, _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(pVect1 + i),     _mm512_loadu_pd(pVect2 + i))));
+        max2 = Max(max2, _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(pVect1 + i + 8), _mm512_loadu_pd(pVect2 + i + 8))));
+    }
+    for (; i + 8 <= qty; i += 8) {
+        max1 = Max(max1, _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(pVect1 + i),     _mm512_loadu_pd(pVect2 + i))));
+    }
+    if (i < qty) {
+        __mmask8 mask = TailMask8(qty - i);
+        max2 = Max(max2, _mm512_abs_pd(_mm512_sub_pd(_mm512_maskz_loadu_pd(mask, pVect1 + i),
+                                                     _mm512_maskz_loadu_pd(mask, pVect2 + i))));
+    }
+
+    return HorizontalMax(Max(max1, max2));
+}
+
+/*
+ * L1-norm
+ */
+
+float L1NormAVX512(const float* pVect1, const float* pVect2, size_t qty) {
+    __m512 sum1 = _mm512_setzero_ps(), sum2 = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 32 <= qty; i += 32) {
+        sum1 = _mm512_add_ps(sum1, _mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(pVect1 + i),      _mm512_loadu_ps(pVect2 + i))));
+        sum2 = _mm512_add_ps(sum2, _mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(pVect1 + i + 16), _mm512_loadu_ps(pVect2 + i + 16))));
+    }
+    for (; i + 16 <= qty; i += 16) {
+        sum1 = _mm512_add_ps(sum1, _mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(pVect1 + i),      _mm512_loadu_ps(pVect2 + i))));
+    }
+    if (i < qty) {
+        __mmask16 mask = TailMask16(qty - i);
+        sum2 = _mm512_add_ps(sum2, _mm512_abs_ps(_mm512_sub_ps(_mm512_maskz_loadu_ps(mask, pVect1 + i),
+                                                               _mm512_maskz_loadu_ps(mask, pVect2 + i))));
+    }
+
+    return HorizontalSum(_mm512_add_ps(sum1, sum2));
+}
+
+double L1NormAVX512(const double* pVect1, const double* pVect2, size_t qty) {
+    __m512d sum1 = _mm512_setzero_pd(), sum2 = _mm512_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        sum1 = _mm512_add_pd(sum1, _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(pVect1 + i),     _mm512_loadu_pd(pVect2 + i))));
+        sum2 = _mm512_add_pd(sum2, _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(pVect1 + i + 8), _mm512_loadu_pd(pVect2 + i + 8))));
+    }
+    for (; i + 8 <= qty; i += 8) {
+        sum1 = _mm512_add_pd(sum1, _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(pVect1 + i),     _mm512_loadu_pd(pVect2 + i))));
+    }
+    if (i < qty) {
+        __mmask8 mask = TailMask8(qty - i);
+        sum2 = _mm512_add_pd(sum2, _mm512_abs_pd(_mm512_sub_pd(_mm512_maskz_loadu_pd(mask, pVect1 + i),
+                                                               _mm512_maskz_loadu_pd(mask, pVect2 + i))));
+    }
+
+    return HorizontalSum(_mm512_add_pd(sum1, sum2));
+}
+
+/*
+ * The square of the L2-norm
+ */
+
+float L2SqrAVX512(const float* pVect1, const float* pVect2, size_t qty) {
+    __m512 sum1 = _mm512_setzero_ps(), sum2 = _mm512_setzero_ps(), diff;
+    size_t i = 0;
+
+    for (; i + 32 <= qty; i += 32) {
+        diff = _mm512_sub_ps(_mm512_loadu_ps(pVect1 + i),      _mm512_loadu_ps(pVect2 + i));
+        sum1 = _mm512_fmadd_ps(diff, diff, sum1);
+        diff = _mm512_sub_ps(_mm512_loadu_ps(pVect1 + i + 16), _mm512_loadu_ps(pVect2 + i + 16));
+        sum2 = _mm512_fmadd_ps(diff, diff, sum2);
+    }
+    for (; i + 16 <= qty; i += 16) {
+        diff = _mm512_sub_ps(_mm512_loadu_ps(pVect1 + i),      _mm512_loadu_ps(pVect2 + i));
+        sum1 = _mm512_fmadd_ps(diff, diff, sum1);
+    }
+    if (i < qty) {
+        __mmask16 mask = TailMask16(qty - i);
+        diff = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, pVect1 + i), _mm512_maskz_loadu_ps(mask, pVect2 + i));
+        sum2 = _mm512_fmadd_ps(diff, diff, sum2);
+    }
+
+    return HorizontalSum(_mm512_add_ps(sum1, sum2));
+}
+
+double L2SqrAVX512(const double* pVect1, const double* pVect2, size_t qty) {
+    __m512d sum1 = _mm512_setzero_pd(), sum2 = _mm512_setzero_pd(), diff;
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        diff = _mm512_sub_pd(_mm512_loadu_pd(pVect1 + i),     _mm512_loadu_pd(pVect2 + i));
+        sum1 = _mm512_fmadd_pd(diff, diff, sum1);
+        diff = _mm512_sub_pd(_mm512_loadu_pd(pVect1 + i + 8), _mm512_loadu_pd(pVect2 + i + 8));
+        sum2 = _mm512_fmadd_pd(diff, diff, sum2);
+    }
+    for (; i + 8 <= qty; i += 8) {
+        diff = _mm512_sub_pd(_mm512_loadu_pd(pVect1 + i),     _mm512_loadu_pd(pVect2 + i));
+        sum1 = _mm512_fmadd_pd(diff, diff, sum1);
+    }
+    if (i < qty) {
+        __mmask8 mask = TailMask8(qty - i);
+        diff = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, pVect1 + i), _mm512_maskz_loadu_pd(mask, pVect2 + i));
+        sum2 = _mm512_fmadd_pd(diff, diff, sum2);
+    }
+
+    return HorizontalSum(_mm512_add_pd(sum1, sum2));
+}
+
+namespace {
+
+/*
+ * KL-divergence (logarithms are stored after vector elements, see distcomp.h)
+ */
+
+float KLPrecompAVX512(const float* pVect1, const float* pVect2, size_t qty) {
+    const float* pVectLog1 = pVect1 + qty;
+    const float* pVectLog2 = pVect2 + qty;
+
+    __m512 sum1 = _mm512_setzero_ps(), sum2 = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 32 <= qty; i += 32) {
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(pVect1 + i),
+                               _mm512_sub_ps(_mm512_loadu_ps(pVectLog1 + i), _mm512_loadu_ps(pVectLog2 + i)), sum1);
+        sum2 = _mm512_fmadd_ps(_mm512_loadu_ps(pVect1 + i + 16),
+                               _mm512_sub_ps(_mm512_loadu_ps(pVectLog1 + i + 16), _mm512_loadu_ps(pVectLog2 + i + 16)), sum2);
+    }
+    for (; i + 16 <= qty; i += 16) {
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(pVect1 + i),
+                               _mm512_sub_ps(_mm512_loadu_ps(pVectLog1 + i), _mm512_loadu_ps(pVectLog2 + i)), sum1);
+    }
+    if (i < qty) {
+        __mmask16 mask = TailMask16(qty - i);
+        sum2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, pVect1 + i),
+                               _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, pVectLog1 + i),
+                                             _mm512_maskz_loadu_ps(mask, pVectLog2 + i)), sum2);
+    }
+
+    return HorizontalSum(_mm512_add_ps(sum1, sum2));
+}
+
+double KLPrecompAVX512(const double* pVect1, const double* pVect2, size_t qty) {
+    const double* pVectLog1 = pVect1 + qty;
+    const double* pVectLog2 = pVect2 + qty;
+
+    __m512d sum1 = _mm512_setzero_pd(), sum2 = _mm512_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        sum1 = _mm512_fmadd_pd(_mm512_loadu_pd(pVect1 + i),
+                               _mm512_sub_pd(_mm512_loadu_pd(pVectLog1 + i), _mm512_loadu_pd(pVectLog2 + i)), sum1);
+        sum2 = _mm512_fmadd_pd(_mm512_loadu_pd(pVect1 + i + 8),
+                               _mm512_sub_pd(_mm512_loadu_pd(pVectLog1 + i + 8), _mm512_loadu_pd(pVectLog2 + i + 8)), sum2);
+    }
+    for (; i + 8 <= qty; i += 8) {
+        sum1 = _mm512_fmadd_pd(_mm512_loadu_pd(pVect1 + i),
+                               _mm512_sub_pd(_mm512_loadu_pd(pVectLog1 + i), _mm512_loadu_pd(pVectLog2 + i)), sum1);
+    }
+    if (i < qty) {
+        __mmask8 mask = TailMask8(qty - i);
+        sum2 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, pVect1 + i),
+                               _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, pVectLog1 + i),
+                                             _mm512_maskz_loadu_pd(mask, pVectLog2 + i)), sum2);
+    }
+
+    return HorizontalSum(_mm512_add_pd(sum1, sum2));
+}
+
+/*
+ * Itakura-Saito distance (logarithms are stored after vector elements, see distcomp.h)
+ * In the tail, masked-out elements of the second vector are set to one to avoid 0/0.
+ */
+
+float ItakuraSaitoPrecompAVX512(const float* pVect1, const float* pVect2, size_t qty) {
+    const float* pVectLog1 = pVect1 + qty;
+    const float* pVectLog2 = pVect2 + qty;
+
+    __m512 sum = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        __m512 v1     = _mm512_loadu_ps(pVect1 + i);
+        __m512 v2     = _mm512_loadu_ps(pVect2 + i);
+        __m512 vLog1  = _mm512_loadu_ps(pVectLog1 + i);
+        __m512 vLog2  = _mm512_loadu_ps(pVectLog2 + i);
+        sum = _mm512_add_ps(sum, _mm512_sub_ps(_mm512_div_ps(v1, v2), _mm512_sub_ps(vLog1, vLog2)));
+    }
+    if (i < qty) {
+        __mmask16 mask = TailMask16(qty - i);
+        __m512 v1     = _mm512_maskz_loadu_ps(mask, pVect1 + i);
+        __m512 v2     = _mm512_mask_loadu_ps(_mm512_set1_ps(1.0f), mask, pVect2 + i);
+        __m512 vLog1  = _mm512_maskz_loadu_ps(mask, pVectLog1 + i);
+        __m512 vLog2  = _mm512_maskz_loadu_ps(mask, pVectLog2 + i);
+        sum = _mm512_add_ps(sum, _mm512_sub_ps(_mm512_div_ps(v1, v2), _mm512_sub_ps(vLog1, vLog2)));
+    }
+
+    return HorizontalSum(sum) - qty;
+}
+
+double ItakuraSaitoPrecompAVX512(const double* pVect1, const double* pVect2, size_t qty) {
+    const double* pVectLog1 = pVect1 + qty;
+    const double* pVectLog2 = pVect2 + qty;
+
+    __m512d sum = _mm512_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 8 <= qty; i += 8) {
+        __m512d v1    = _mm512_loadu_pd(pVect1 + i);
+        __m512d v2    = _mm512_loadu_pd(pVect2 + i);
+        __m512d vLog1 = _mm512_loadu_pd(pVectLog1 + i);
+        __m512d vLog2 = _mm512_loadu_pd(pVectLog2 + i);
+        sum = _mm512_add_pd(sum, _mm512_sub_pd(_mm512_div_pd(v1, v2), _mm512_sub_pd(vLog1, vLog2)));
+    }
+    if (i < qty) {
+        __mmask8 mask = TailMask8(qty - i);
+        __m512d v1    = _mm512_maskz_loadu_pd(mask, pVect1 + i);
+        __m512d v2    = _mm512_mask_loadu_pd(_mm512_set1_pd(1.0), mask, pVect2 + i);
+        __m512d vLog1 = _mm512_maskz_loadu_pd(mask, pVectLog1 + i);
+        __m512d vLog2 = _mm512_maskz_loadu_pd(mask, pVectLog2 + i);
+        sum = _mm512_add_pd(sum, _mm512_sub_pd(_mm512_div_pd(v1, v2), _mm512_sub_pd(vLog1, vLog2)));
+    }
+
+    return HorizontalSum(sum) - qty;
+}
+
+/*
+ * Jensen-Shannon divergence with approximate logarithms: see JSPrecompSSEApproxLog
+ * in distcomp_js.cc for details. Masked-out tail elements (and logarithms)
+ * are zeros: their contribution is zero, because the last summand
+ * is multiplied by (v1 + v2).
+ */
+
+inline __m512 JSApproxLogStep(__m512 sum, __m512 v1, __m512 v2, __m512 vLog1, __m512 vLog2,
+                              const float* ltbl, __m512 cmult, __m512 clog2simd, __m512 minVal) {
+    sum = _mm512_fmadd_ps(v1, vLog1, sum);
+    sum = _mm512_fmadd_ps(v2, vLog2, sum);
+    /*
+     * If v1 == v2 == 0, the second factor in (v1 + v2)*(lv2 + ltbl[lapprox(v1/v2)] - clog2)
+     * doesn't need to be computed correctly, but we need to avoid division by zero.
+     */
+    __m512  maxv          = Max(Max(v1, v2), minVal);
+    // This is the log with the largest modulo (recall that logs are < 0 here)
+    __m512  max_mod_logv  = Max(vLog1, vLog2);
+    __m512  minv          = Min(v1, v2);
+    __m512i tmpi          = _mm512_maskz_cvttps_epi32(FullMask16, _mm512_mul_ps(cmult, _mm512_div_ps(minv, maxv)));
+    __m512  ltmp          = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), FullMask16, tmpi, ltbl, 4);
+    __m512  d             = _mm512_sub_ps(_mm512_add_ps(max_mod_logv, ltmp), clog2simd);
+
+    return _mm512_fnmadd_ps(_mm512_add_ps(v1, v2), d, sum);
+}
+
+inline __m512d JSApproxLogStep(__m512d sum, __m512d v1, __m512d v2, __m512d vLog1, __m512d vLog2,
+                               const double* ltbl, __m512d cmult, __m512d clog2simd, __m512d minVal) {
+    sum = _mm512_fmadd_pd(v1, vLog1, sum);
+    sum = _mm512_fmadd_pd(v2, vLog2, sum);
+
+    __m512d maxv          = Max(Max(v1, v2), minVal);
+    __m512d max_mod_logv  = Max(vLog1, vLog2);
+    __m512d minv          = Min(v1, v2);
+    __m256i tmpi          = _mm512_maskz_cvttpd_epi32(FullMask8, _mm512_mul_pd(cmult, _mm512_div_pd(minv, maxv)));
+    __m512d ltmp          = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), FullMask8, tmpi, ltbl, 8);
+    __m512d d             = _mm512_sub_pd(_mm512_add_pd(max_mod_logv, ltmp), clog2simd);
+
+    return _mm512_fnmadd_pd(_mm512_add_pd(v1, v2), d, sum);
+}
+
+float JSPrecompApproxLogAVX512(const float* pVect1, const float* pVect2, size_t qty) {
+    const float* ltbl = GetApproxLogTable<float>();
+
+    const float* pVectLog1 = pVect1 + qty;
+    const float* pVectLog2 = pVect2 + qty;
+
+    const __m512 cmult     = _mm512_set1_ps(LogQty);
+    const __m512 clog2simd = _mm512_set1_ps(CLOG2F);
+    const __m512 minVal    = _mm512_set1_ps(FLT_MIN);
+
+    __m512 sum = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 16 <= qty; i += 16) {
+        sum = JSApproxLogStep(sum, _mm512_loadu_ps(pVect1 + i), _mm512_loadu_ps(pVect2 + i),
+                              _mm512_loadu_ps(pVectLog1 + i), _mm512_loadu_ps(pVectLog2 + i),
+                              ltbl, cmult, clog2simd, minVal);
+    }
+    if (i < qty) {
+        __mmask16 mask = TailMask16(qty - i);
+        sum = JSApproxLogStep(sum, _mm512_maskz_loadu_ps(mask, pVect1 + i), _mm512_maskz_loadu_ps(mask, pVect2 + i),
+                              _mm512_maskz_loadu_ps(mask, pVectLog1 + i), _mm512_maskz_loadu_ps(mask, pVectLog2 + i),
+                              ltbl, cmult, clog2simd, minVal);
+    }
+
+    float res = HorizontalSum(sum);
+
+    // Due to computation/rounding errors, we may get a small-magnitude negative number
+    return res > 0 ? 0.5f * res : 0.0f;
+}
+
+double JSPrecompApproxLogAVX512(const double* pVect1, const double* pVect2, size_t qty) {
+    const double* ltbl = GetApproxLogTable<double>();
+
+    const double* pVectLog1 = pVect1 + qty;
+    const double* pVectLog2 = pVect2 + qty;
+
+    const __m512d cmult     = _mm512_set1_pd(LogQty);
+    const __m512d clog2simd = _mm512_set1_pd(CLOG2D);
+    const __m512d minVal    = _mm512_set1_pd(DBL_MIN);
+
+    __m512d sum = _mm512_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 8 <= qty; i += 8) {
+        sum = JSApproxLogStep(sum, _mm512_loadu_pd(pVect1 + i), _mm512_loadu_pd(pVect2 + i),
+                              _mm512_loadu_pd(pVectLog1 + i), _mm512_loadu_pd(pVectLog2 + i),
+                              ltbl, cmult, clog2simd, minVal);
+    }
+    if (i < qty) {
+        __mmask8 mask = TailMask8(qty - i);
+        sum = JSApproxLogStep(sum, _mm512_maskz_loadu_pd(mask, pVect1 + i), _mm512_maskz_loadu_pd(mask, pVect2 + i),
+                              _mm512_maskz_loadu_pd(mask, pVectLog1 + i), _mm512_maskz_loadu_pd(mask, pVectLog2 + i),
+                              ltbl, cmult, clog2simd, minVal);
+    }
+
+    double res = HorizontalSum(sum);
+
+    // Due to computation/rounding errors, we may get a small-magnitude negative number
+    return res > 0 ? 0.5 * res : 0.0;
+}
+
+/*
+ * Scalar quantization. Loading a part of codes requires AVX-512BW,
+ * so the tails are processed one element at a time.
+ */
+
+inline __m512 DecodeSQ8x16(const uint8_t* pCodes, __m512 vMin, __m512 vScale) {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCodes));
+    return _mm512_fmadd_ps(vScale, _mm512_maskz_cvtepi32_ps(FullMask16, _mm512_maskz_cvtepu8_epi32(FullMask16, c)), vMin);
+}
+
+float L2SqrSQ8AVX512(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty) {
+    const __m512 vMin = _mm512_set1_ps(min), vScale = _mm512_set1_ps(scale);
+    __m512 sum1 = _mm512_setzero_ps(), sum2 = _mm512_setzero_ps(), diff;
+    size_t i = 0;
+
+    for (; i + 32 <= qty; i += 32) {
+        diff = _mm512_sub_ps(_mm512_loadu_ps(pVect + i),      DecodeSQ8x16(pCodes + i, vMin, vScale));
+        sum1 = _mm512_fmadd_ps(diff, diff, sum1);
+        diff = _mm512_sub_ps(_mm512_loadu_ps(pVect + i + 16), DecodeSQ8x16(pCodes + i + 16, vMin, vScale));
+        sum2 = _mm512_fmadd_ps(diff, diff, sum2);
+    }
+    for (; i + 16 <= qty; i += 16) {
+        diff = _mm512_sub_ps(_mm512_loadu_ps(pVect + i),      DecodeSQ8x16(pCodes + i, vMin, vScale));
+        sum1 = _mm512_fmadd_ps(diff, diff, sum1);
+    }
+
+    float res = HorizontalSum(_mm512_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        float d = pVect[i] - (min + scale * pCodes[i]);
+        res += d * d;
+    }
+
+    return res;
+}
+
+float ScalarProductSQ8AVX512(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty) {
+    const __m512 vMin = _mm512_set1_ps(min), vScale = _mm512_set1_ps(scale);
+    __m512 sum1 = _mm512_setzero_ps(), sum2 = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 32 <= qty; i += 32) {
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(pVect + i),      DecodeSQ8x16(pCodes + i, vMin, vScale),      sum1);
+        sum2 = _mm512_fmadd_ps(_mm512_loadu_ps(pVect + i + 16), DecodeSQ8x16(pCodes + i + 16, vMin, vScale), sum2);
+    }
+    for (; i + 16 <= qty; i += 16) {
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(pVect + i),      DecodeSQ8x16(pCodes + i, vMin, vScale),      sum1);
+    }
+
+    float res = HorizontalSum(_mm512_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        res += pVect[i] * (min + scale * pCodes[i]);
+    }
+
+    return res;
+}
+
+inline __m512 DecodeFP16x16(const uint16_t* pCodes) {
+    return _mm512_maskz_cvtph_ps(FullMask16, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pCodes)));
+}
+
+// Converts one half-precision number
+inline float DecodeFP16x1(uint16_t code) {
+    return _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(code)));
+}
+
+float L2SqrFP16AVX512(const float* pVect, const uint16_t* pCodes, size_t qty) {
+    __m512 sum1 = _mm512_setzero_ps(), sum2 = _mm512_setzero_ps(), diff;
+    size_t i = 0;
+
+    for (; i + 32 <= qty; i += 32) {
+        diff = _mm512_sub_ps(_mm512_loadu_ps(pVect + i),      DecodeFP16x16(pCodes + i));
+        sum1 = _mm512_fmadd_ps(diff, diff, sum1);
+        diff = _mm512_sub_ps(_mm512_loadu_ps(pVect + i + 16), DecodeFP16x16(pCodes + i + 16));
+        sum2 = _mm512_fmadd_ps(diff, diff, sum2);
+    }
+    for (; i + 16 <= qty; i += 16) {
+        diff = _mm512_sub_ps(_mm512_loadu_ps(pVect + i),      DecodeFP16x16(pCodes + i));
+        sum1 = _mm512_fmadd_ps(diff, diff, sum1);
+    }
+
+    float res = HorizontalSum(_mm512_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        float d = pVect[i] - DecodeFP16x1(pCodes[i]);
+        res += d * d;
+    }
+
+    return res;
+}
+
+float ScalarProductFP16AVX512(const float* pVect, const uint16_t* pCodes, size_t qty) {
+    __m512 sum1 = _mm512_setzero_ps(), sum2 = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 32 <= qty; i += 32) {
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(pVect + i),      DecodeFP16x16(pCodes + i),      sum1);
+        sum2 = _mm512_fmadd_ps(_mm512_loadu_ps(pVect + i + 16), DecodeFP16x16(pCodes + i + 16), sum2);
+    }
+    for (; i + 16 <= qty; i += 16) {
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(pVect + i),      DecodeFP16x16(pCodes + i),      sum1);
+    }
+
+    float res = HorizontalSum(_mm512_add_ps(sum1, sum2));
+
+    for (; i < qty; ++i) {
+        res += pVect[i] * DecodeFP16x1(pCodes[i]);
+    }
+
+    return res;
+}
+
+}
+
+bool GetAVX512Kernels(SIMDKernels<float>& FloatKernels, SIMDKernels<double>& DoubleKernels,
+                      SQKernels& QuantKernels) {
+  FloatKernels.LInfNorm             = LInfNormAVX512;
+  FloatKernels.L1Norm               = L1NormAVX512;
+  FloatKernels.L2Sqr                = L2SqrAVX512;
+  FloatKernels.KLPrecomp            = KLPrecompAVX512;
+  FloatKernels.ItakuraSaitoPrecomp  = ItakuraSaitoPrecompAVX512;
+  FloatKernels.JSPrecompApproxLog   = JSPrecompApproxLogAVX512;
+
+  DoubleKernels.LInfNorm            = LInfNormAVX512;
+  DoubleKernels.L1Norm              = L1NormAVX512;
+  DoubleKernels.L2Sqr               = L2SqrAVX512;
+  DoubleKernels.KLPrecomp           = KLPrecompAVX512;
+  DoubleKernels.ItakuraSaitoPrecomp = ItakuraSaitoPrecompAVX512;
+  DoubleKernels.JSPrecompApproxLog  = JSPrecompApproxLogAVX512;
+
+  QuantKernels.L2SqrSQ8             = L2SqrSQ8AVX512;
+  QuantKernels.ScalarProductSQ8     = ScalarProductSQ8AVX512;
+  QuantKernels.L2SqrFP16            = L2SqrFP16AVX512;
+  QuantKernels.ScalarProductFP16    = ScalarProductFP16AVX512;
+
+  return true;
+}
+
+#endif
+
+}
@@ -14,6 +14,7 @@
  *
  */
 #include "distcomp.h"
+#include "distcomp_dispatch.h"
 #include "string.h"
 #include "utils.h"
 #include "simdutils.h"
@@ -83,10 +84,10 @@ template double ItakuraSaitoPrecomp<double>(const double* pVect1, const double*
  * Ensuring that both pVect1 and pVect2 are similarly aligned could be hard.
  */
 template <>
-float ItakuraSaitoPrecompSIMD(const float* pVect1, const float* pVect2, size_t qty)
+float ItakuraSaitoPrecompSSE(const float* pVect1, const float* pVect2, size_t qty)
 {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("ItakuraSaitoPrecompSIMD<float>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("ItakuraSaitoPrecompSSE<float>: SSE2 is not available, defaulting to pure C++ implementation!")
     return ItakuraSaitoPrecomp(pVect1, pVect2, qty);
 #else
     size_t qty4  = qty/4;
@@ -152,10 +153,10 @@ float ItakuraSaitoPrecompSIMD(const float* pVect1, const float* pVect2, size_t q
 }
 
 template <>
-double ItakuraSaitoPrecompSIMD(const double* pVect1, const double* pVect2, size_t qty)
+double ItakuraSaitoPrecompSSE(const double* pVect1, const double* pVect2, size_t qty)
 {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("ItakuraSaitoPrecompSIMD<double>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("ItakuraSaitoPrecompSSE<double>: SSE2 is not available, defaulting to pure C++ implementation!")
     return ItakuraSaitoPrecomp(pVect1, pVect2, qty);
 #else
     size_t qty8 = qty/8;
@@ -197,8 +198,8 @@ double ItakuraSaitoPrecompSIMD(const double* pVect1, const double* pVect2, size_
 #endif
 }
 
-template float  ItakuraSaitoPrecompSIMD<float>(const float* pVect1, const float* pVect2, size_t qty);
-template double ItakuraSaitoPrecompSIMD<double>(const double* pVect1, const double* pVect2, size_t qty);
+template float  ItakuraSaitoPrecompSSE<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double ItakuraSaitoPrecompSSE<double>(const double* pVect1, const double* pVect2, size_t qty);
 
 
 /*
@@ -267,10 +268,10 @@ template double KLPrecomp<double>(const double* pVect1, const double* pVect2, si
  * Ensuring that both pVect1 and pVect2 are similarly aligned could be hard.
  */
 template <>
-float KLPrecompSIMD(const float* pVect1, const float* pVect2, size_t qty)
+float KLPrecompSSE(const float* pVect1, const float* pVect2, size_t qty)
 {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("KLPrecompSIMD<float>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("KLPrecompSSE<float>: SSE2 is not available, defaulting to pure C++ implementation!")
     return KLPrecomp(pVect1, pVect2, qty);
 #else
     size_t qty4  = qty/4;
@@ -329,10 +330,10 @@ float KLPrecompSIMD(const float* pVect1, const float* pVect2, size_t qty)
 }
 
 template <>
-double KLPrecompSIMD(const double* pVect1, const double* pVect2, size_t qty)
+double KLPrecompSSE(const double* pVect1, const double* pVect2, size_t qty)
 {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("KLPrecompSIMD<double>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("KLPrecompSSE<double>: SSE2 is not available, defaulting to pure C++ implementation!")
     return KLPrecomp(pVect1, pVect2, qty);
 #else
     size_t qty8 = qty/8;
@@ -371,8 +372,8 @@ double KLPrecompSIMD(const double* pVect1, const double* pVect2, size_t qty)
 #endif
 }
 
-template float KLPrecompSIMD<float>(const float* pVect1, const float* pVect2, size_t qty);
-template double KLPrecompSIMD<double>(const double* pVect1, const double* pVect2, size_t qty);
+template float KLPrecompSSE<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double KLPrecompSSE<double>(const double* pVect1, const double* pVect2, size_t qty);
 
 template <class T> T KLGeneralStandard(const T *pVect1, const T *pVect2, size_t qty) 
 { 
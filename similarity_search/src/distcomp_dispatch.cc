@@ -0,0 +1,309 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <sstream>
+
+#include "distcomp.h"
+#include "distcomp_dispatch.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+namespace similarity {
+
+using namespace std;
+
+namespace {
+
+#if defined(_MSC_VER) || (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#define HAS_CPUID
+
+void CPUID(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+  int tmp[4];
+  __cpuidex(tmp, leaf, subleaf);
+  for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned>(tmp[i]);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Reads the extended control register, which tells what registers are saved by the OS
+uint64_t XGetBV(unsigned idx) {
+#if defined(_MSC_VER)
+  return _xgetbv(idx);
+#else
+  uint32_t eax, edx;
+  __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(idx));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+SIMDTier DetectCPUSIMDTier() {
+#ifdef HAS_CPUID
+  unsigned regs[4]; // EAX, EBX, ECX, EDX
+
+  CPUID(0, 0, regs);
+  const unsigned MaxLeaf = regs[0];
+  if (MaxLeaf < 7) return kSIMDTierSSE;
+
+  CPUID(1, 0, regs);
+  const bool bOSXSAVE = (regs[2] >> 27) & 1;
+  const bool bFMA     = (regs[2] >> 12) & 1;
+  const bool bF16C    = (regs[2] >> 29) & 1;
+  if (!bOSXSAVE) return kSIMDTierSSE;
+
+  const uint64_t XCR0 = XGetBV(0);
+  // The OS saves XMM and YMM registers
+  const bool bOSAVX    = (XCR0 & 0x6) == 0x6;
+  // ... as well as opmask registers and upper halves of ZMM registers
+  const bool bOSAVX512 = (XCR0 & 0xe6) == 0xe6;
+
+  CPUID(7, 0, regs);
+  const bool bAVX2    = (regs[1] >> 5) & 1;
+  const bool bAVX512F = (regs[1] >> 16) & 1;
+
+  if (bOSAVX512 && bAVX512F && bAVX2 && bFMA && bF16C) return kSIMDTierAVX512;
+  if (bOSAVX && bAVX2 && bFMA && bF16C) return kSIMDTierAVX2;
+#endif
+  return kSIMDTierSSE;
+}
+
+struct KernelTable {
+  KernelTable() {
+    const SIMDKernels<float>  SSEFloat  = { LInfNormSSE<float>, L1NormSSE<float>, L2SqrSSE<float>,
+                                            KLPrecompSSE<float>, ItakuraSaitoPrecompSSE<float>,
+                                            JSPrecompSSEApproxLog<float> };
+    const SIMDKernels<double> SSEDouble = { LInfNormSSE<double>, L1NormSSE<double>, L2SqrSSE<double>,
+                                            KLPrecompSSE<double>, ItakuraSaitoPrecompSSE<double>,
+                                            JSPrecompSSEApproxLog<double> };
+    const SQKernels           SSEQuant  = { L2SqrSQ8SSE, ScalarProductSQ8SSE,
+                                            L2SqrFP16SSE, ScalarProductFP16SSE };
+    const SparseKernels       SSESparse = { SparseBlockScalarProductSSE };
+    for (int i = 0; i <= kSIMDTierMax; ++i) {
+      bSupported_[i] = false;
+      Float_[i]  = SSEFloat;
+      Double_[i] = SSEDouble;
+      Quant_[i]  = SSEQuant;
+      Sparse_[i] = SSESparse;
+    }
+    bSupported_[kSIMDTierSSE] = true;
+
+    const SIMDTier CPUTier = DetectCPUSIMDTier();
+
+    if (CPUTier >= kSIMDTierAVX2) {
+      bSupported_[kSIMDTierAVX2] = GetAVX2Kernels(Float_[kSIMDTierAVX2], Double_[kSIMDTierAVX2],
+                                                   Quant_[kSIMDTierAVX2], Sparse_[kSIMDTierAVX2]);
+    }
+    if (CPUTier >= kSIMDTierAVX512) {
+      Sparse_[kSIMDTierAVX512] = Sparse_[kSIMDTierAVX2];
+      bSupported_[kSIMDTierAVX512] = GetAVX512Kernels(Float_[kSIMDTierAVX512], Double_[kSIMDTierAVX512],
+                                                       Quant_[kSIMDTierAVX512]);
+    }
+
+    BestTier_ = kSIMDTierSSE;
+    for (int i = 0; i <= kSIMDTierMax; ++i) {
+      if (bSupported_[i]) BestTier_ = static_cast<SIMDTier>(i);
+    }
+  }
+
+  bool                bSupported_[kSIMDTierMax + 1];
+  SIMDKernels<float>  Float_[kSIMDTierMax + 1];
+  SIMDKernels<double> Double_[kSIMDTierMax + 1];
+  SQKernels           Quant_[kSIMDTierMax + 1];
+  SparseKernels       Sparse_[kSIMDTierMax + 1];
+  SIMDTier            BestTier_;
+};
+
+const KernelTable& GetKernelTable() {
+  static KernelTable Table; // Thread-safe in C++11
+  return Table;
+}
+
+/*
+ * Pointers to currently used kernels. They are initialized during the startup,
+ * but if a *SIMD function is called by a static initializer of some other
+ * translation unit, the pointers can still be NULL. To handle this case,
+ * the *SIMD functions call GetFloatKernels/GetDoubleKernels/GetQuantKernels/GetSparseKernels.
+ */
+const SIMDKernels<float>*   pFloatKernels  = NULL;
+const SIMDKernels<double>*  pDoubleKernels = NULL;
+const SQKernels*            pQuantKernels  = NULL;
+const SparseKernels*        pSparseKernels = NULL;
+SIMDTier                    CurrTier       = kSIMDTierSSE;
+
+void SetSIMDTierInternal(SIMDTier tier) {
+  const KernelTable& Table = GetKernelTable();
+  pFloatKernels  = &Table.Float_[tier];
+  pDoubleKernels = &Table.Double_[tier];
+  pQuantKernels  = &Table.Quant_[tier];
+  pSparseKernels = &Table.Sparse_[tier];
+  CurrTier       = tier;
+}
+
+struct KernelSelector {
+  KernelSelector() { SetSIMDTierInternal(GetKernelTable().BestTier_); }
+} SelectBestKernels;
+
+inline const SIMDKernels<float>& GetFloatKernels() {
+  if (pFloatKernels == NULL) SetSIMDTierInternal(GetKernelTable().BestTier_);
+  return *pFloatKernels;
+}
+
+inline const SIMDKernels<double>& GetDoubleKernels() {
+  if (pDoubleKernels == NULL) SetSIMDTierInternal(GetKernelTable().BestTier_);
+  return *pDoubleKernels;
+}
+
+inline const SQKernels& GetQuantKernels() {
+  if (pQuantKernels == NULL) SetSIMDTierInternal(GetKernelTable().BestTier_);
+  return *pQuantKernels;
+}
+
+inline const SparseKernels& GetSparseKernels() {
+  if (pSparseKernels == NULL) SetSIMDTierInternal(GetKernelTable().BestTier_);
+  return *pSparseKernels;
+}
+
+}
+
+const char* SIMDTierName(SIMDTier tier) {
+  switch (tier) {
+    case kSIMDTierSSE:    return "SSE";
+    case kSIMDTierAVX2:   return "AVX2";
+    case kSIMDTierAVX512: return "AVX-512";
+  }
+  return "unknown";
+}
+
+bool IsSIMDTierSupported(SIMDTier tier) {
+  return tier >= kSIMDTierSSE && tier <= kSIMDTierMax && GetKernelTable().bSupported_[tier];
+}
+
+SIMDTier GetBestSIMDTier() {
+  return GetKernelTable().BestTier_;
+}
+
+SIMDTier GetSIMDTier() {
+  GetFloatKernels();
+  return CurrTier;
+}
+
+void SetSIMDTier(SIMDTier tier) {
+  if (!IsSIMDTierSupported(tier)) {
+    stringstream err;
+    err << "The SIMD tier " << SIMDTierName(tier) << " is not supported by this CPU or this binary";
+    throw runtime_error(err.str());
+  }
+  SetSIMDTierInternal(tier);
+}
+
+/*
+ * The *SIMD functions simply call the selected kernel.
+ */
+
+template <>
+float LInfNormSIMD(const float* pVect1, const float* pVect2, size_t qty) {
+  return GetFloatKernels().LInfNorm(pVect1, pVect2, qty);
+}
+
+template <>
+double LInfNormSIMD(const double* pVect1, const double* pVect2, size_t qty) {
+  return GetDoubleKernels().LInfNorm(pVect1, pVect2, qty);
+}
+
+template <>
+float L1NormSIMD(const float* pVect1, const float* pVect2, size_t qty) {
+  return GetFloatKernels().L1Norm(pVect1, pVect2, qty);
+}
+
+template <>
+double L1NormSIMD(const double* pVect1, const double* pVect2, size_t qty) {
+  return GetDoubleKernels().L1Norm(pVect1, pVect2, qty);
+}
+
+float L2SqrSIMD(const float* pVect1, const float* pVect2, size_t qty) {
+  return GetFloatKernels().L2Sqr(pVect1, pVect2, qty);
+}
+
+template <>
+float L2NormSIMD(const float* pVect1, const float* pVect2, size_t qty) {
+  return sqrt(GetFloatKernels().L2Sqr(pVect1, pVect2, qty));
+}
+
+template <>
+double L2NormSIMD(const double* pVect1, const double* pVect2, size_t qty) {
+  return sqrt(GetDoubleKernels().L2Sqr(pVect1, pVect2, qty));
+}
+
+template <>
+float KLPrecompSIMD(const float* pVect1, const float* pVect2, size_t qty) {
+  return GetFloatKernels().KLPrecomp(pVect1, pVect2, qty);
+}
+
+template <>
+double KLPrecompSIMD(const double* pVect1, const double* pVect2, size_t qty) {
+  return GetDoubleKernels().KLPrecomp(pVect1, pVect2, qty);
+}
+
+template <>
+float ItakuraSaitoPrecompSIMD(const float* pVect1, const float* pVect2, size_t qty) {
+  return GetFloatKernels().ItakuraSaitoPrecomp(pVect1, pVect2, qty);
+}
+
+template <>
+double ItakuraSaitoPrecompSIMD(const double* pVect1, const double* pVect2, size_t qty) {
+  return GetDoubleKernels().ItakuraSaitoPrecomp(pVect1, pVect2, qty);
+}
+
+template <>
+float JSPrecompSIMDApproxLog(const float* pVect1, const float* pVect2, size_t qty) {
+  return GetFloatKernels().JSPrecompApproxLog(pVect1, pVect2, qty);
+}
+
+template <>
+double JSPrecompSIMDApproxLog(const double* pVect1, const double* pVect2, size_t qty) {
+  return GetDoubleKernels().JSPrecompApproxLog(pVect1, pVect2, qty);
+}
+
+float L2SqrSQ8SIMD(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty) {
+  return GetQuantKernels().L2SqrSQ8(pVect, pCodes, min, scale, qty);
+}
+
+float ScalarProductSQ8SIMD(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty) {
+  return GetQuantKernels().ScalarProductSQ8(pVect, pCodes, min, scale, qty);
+}
+
+float L2SqrFP16SIMD(const float* pVect, const uint16_t* pCodes, size_t qty) {
+  return GetQuantKernels().L2SqrFP16(pVect, pCodes, qty);
+}
+
+float ScalarProductFP16SIMD(const float* pVect, const uint16_t* pCodes, size_t qty) {
+  return GetQuantKernels().ScalarProductFP16(pVect, pCodes, qty);
+}
+
+float SparseBlockScalarProductSIMD(const uint16_t* pBlockIds1, const float* pBlockVals1, size_t qty1,
+                                   const uint16_t* pBlockIds2, const float* pBlockVals2, size_t qty2) {
+  return GetSparseKernels().BlockScalarProduct(pBlockIds1, pBlockVals1, qty1, pBlockIds2, pBlockVals2, qty2);
+}
+
+}
@@ -14,6 +14,7 @@
  *
  */
 #include "distcomp.h"
+#include "distcomp_dispatch.h"
 #include "string.h"
 #include "utils.h"
 #include "simdutils.h"
@@ -93,8 +94,6 @@ T JSPrecomp(const T* pVect1, const T* pVect2, size_t qty) {
 template float JSPrecomp<float>(const float* pVect1, const float* pVect2, size_t qty);
 template double JSPrecomp<double>(const double* pVect1, const double* pVect2, size_t qty);
 
-const unsigned LogQty = 65536;
-
 template <class T>
 inline unsigned lapprox(T f) {
   return static_cast<unsigned>(floor(LogQty*f));
@@ -113,6 +112,15 @@ public:
   T LogTable[LogQty + 2];
 };
 
+template <class T>
+const T* GetApproxLogTable() {
+  static ApproxLogs<T> ApproxLogs; // Thread-safe in C++11
+  return ApproxLogs.LogTable;
+}
+
+template const float* GetApproxLogTable<float>();
+template const double* GetApproxLogTable<double>();
+
 template <class T> T 
 JSPrecompApproxLog(const T *pVect1, const T *pVect2, size_t qty) {
     static ApproxLogs<T> ApproxLogs; // Thread-safe in C++11 
@@ -150,10 +158,10 @@ template float JSPrecompApproxLog<float>(const float* pVect1, const float* pVect
 template double JSPrecompApproxLog<double>(const double* pVect1, const double* pVect2, size_t qty);
 
 template <>
-float JSPrecompSIMDApproxLog(const float* pVect1, const float* pVect2, size_t qty)
+float JSPrecompSSEApproxLog(const float* pVect1, const float* pVect2, size_t qty)
 {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("JSPrecompSIMDApproxLog<float>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("JSPrecompSSEApproxLog<float>: SSE2 is not available, defaulting to pure C++ implementation!")
     return JSPrecompApproxLog(pVect1, pVect2, qty);
 #else
     size_t qty4  = qty/4;
@@ -235,10 +243,10 @@ float JSPrecompSIMDApproxLog(const float* pVect1, const float* pVect2, size_t qt
     
 
 template <>
-double JSPrecompSIMDApproxLog(const double* pVect1, const double* pVect2, size_t qty)
+double JSPrecompSSEApproxLog(const double* pVect1, const double* pVect2, size_t qty)
 {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("JSPrecompSIMDApproxLog<double>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("JSPrecompSSEApproxLog<double>: SSE2 is not available, defaulting to pure C++ implementation!")
     return JSPrecompApproxLog(pVect1, pVect2, qty);
 #else
     size_t qty2  = qty/2;
@@ -319,7 +327,7 @@ double JSPrecompSIMDApproxLog(const double* pVect1, const double* pVect2, size_t
 #endif
 }
 
-template float JSPrecompSIMDApproxLog<float>(const float* pVect1, const float* pVect2, size_t qty);
-template double JSPrecompSIMDApproxLog<double>(const double* pVect1, const double* pVect2, size_t qty);
+template float JSPrecompSSEApproxLog<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double JSPrecompSSEApproxLog<double>(const double* pVect1, const double* pVect2, size_t qty);
 
 }
@@ -14,6 +14,7 @@
  *
  */
 #include "distcomp.h"
+#include "distcomp_dispatch.h"
 #include "simdutils.h"
 #include "string.h"
 #include "logging.h"
@@ -83,9 +84,9 @@ template double LInfNorm<double>(const double* pVect1, const double* pVect2, siz
  */
 
 template <> 
-float LInfNormSIMD(const float* pVect1, const float* pVect2, size_t qty) {
+float LInfNormSSE(const float* pVect1, const float* pVect2, size_t qty) {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("LInfNormSIMD<float>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("LInfNormSSE<float>: SSE2 is not available, defaulting to pure C++ implementation!")
     return LInfNormStandard(pVect1, pVect2, qty);
 #else
     size_t qty4  = qty/4;
@@ -148,9 +149,9 @@ float LInfNormSIMD(const float* pVect1, const float* pVect2, size_t qty) {
 }
 
 template <> 
-double LInfNormSIMD(const double* pVect1, const double* pVect2, size_t qty) {
+double LInfNormSSE(const double* pVect1, const double* pVect2, size_t qty) {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("LInfNormSIMD<double>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("LInfNormSSE<double>: SSE2 is not available, defaulting to pure C++ implementation!")
     return LInfNormStandard(pVect1, pVect2, qty);
 #else
     size_t qty8 = qty/8;
@@ -189,8 +190,8 @@ double LInfNormSIMD(const double* pVect1, const double* pVect2, size_t qty) {
 #endif
 }
 
-template float LInfNormSIMD<float>(const float* pVect1, const float* pVect2, size_t qty);
-template double LInfNormSIMD<double>(const double* pVect1, const double* pVect2, size_t qty);
+template float LInfNormSSE<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double LInfNormSSE<double>(const double* pVect1, const double* pVect2, size_t qty);
 
 /*
  * L1-norm.
@@ -242,9 +243,9 @@ template double L1Norm<double>(const double* pVect1, const double* pVect2, size_
  */
 
 template <> 
-float L1NormSIMD(const float* pVect1, const float* pVect2, size_t qty) {
+float L1NormSSE(const float* pVect1, const float* pVect2, size_t qty) {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("L1NormSIMD<float>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("L1NormSSE<float>: SSE2 is not available, defaulting to pure C++ implementation!")
     return L1NormStandard(pVect1, pVect2, qty);
 #else
     size_t qty4  = qty/4;
@@ -306,9 +307,9 @@ float L1NormSIMD(const float* pVect1, const float* pVect2, size_t qty) {
 }
 
 template <> 
-double L1NormSIMD(const double* pVect1, const double* pVect2, size_t qty) {
+double L1NormSSE(const double* pVect1, const double* pVect2, size_t qty) {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("L1NormSIMD<double>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("L1NormSSE<double>: SSE2 is not available, defaulting to pure C++ implementation!")
 	return L1NormStandard(pVect1, pVect2, qty);
 #else
 	size_t qty8 = qty/8;
@@ -348,8 +349,8 @@ double L1NormSIMD(const double* pVect1, const double* pVect2, size_t qty) {
 #endif
 }
 
-template float L1NormSIMD<float>(const float* pVect1, const float* pVect2, size_t qty);
-template double L1NormSIMD<double>(const double* pVect1, const double* pVect2, size_t qty);
+template float L1NormSSE<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double L1NormSSE<double>(const double* pVect1, const double* pVect2, size_t qty);
 
 /*
  * L2-norm.
@@ -402,9 +403,10 @@ template double L2Norm<double>(const double* pVect1, const double* pVect2, size_
  * Ensuring that both pVect1 and pVect2 are similarly aligned could be hard.
  */
 
-float L2SqrSIMD(const float* pVect1, const float* pVect2, size_t qty) {
+template <> 
+float L2SqrSSE(const float* pVect1, const float* pVect2, size_t qty) {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("L2SqrSIMD<float>: SSE2 is not available, defaulting to pure C++ implementation!")
+#pragma message WARN("L2SqrSSE<float>: SSE2 is not available, defaulting to pure C++ implementation!")
     float res = 0, diff;
     for (int i = 0; i < qty; ++i) {
         diff = pVect1[i] - pVect2[i];
@@ -466,16 +468,15 @@ float L2SqrSIMD(const float* pVect1, const float* pVect2, size_t qty) {
 }
 
 template <> 
-float L2NormSIMD(const float* pVect1, const float* pVect2, size_t qty) {
-    float res = L2SqrSIMD(pVect1, pVect2, qty);
-    return sqrt(res);
-}
-
-template <> 
-double L2NormSIMD(const double* pVect1, const double* pVect2, size_t qty) {
+double L2SqrSSE(const double* pVect1, const double* pVect2, size_t qty) {
 #ifndef PORTABLE_SSE2
-#pragma message WARN("L2NormSIMD<double>: SSE2 is not available, defaulting to pure C++ implementation!")
-    return L2NormStandard(pVect1, pVect2, qty);
+#pragma message WARN("L2SqrSSE<double>: SSE2 is not available, defaulting to pure C++ implementation!")
+    double res = 0, diff;
+    for (size_t i = 0; i < qty; ++i) {
+        diff = pVect1[i] - pVect2[i];
+        res += diff * diff;
+    }
+    return res;
 #else
     size_t qty8 = qty/8;
 
@@ -507,12 +508,12 @@ double L2NormSIMD(const double* pVect1, const double* pVect2, size_t qty) {
         res += diff * diff;
     }
 
-    return sqrt(res);
+    return res;
 #endif
 }
 
-template float  L2NormSIMD<float>(const float* pVect1, const float* pVect2, size_t qty);
-template double L2NormSIMD<double>(const double* pVect1, const double* pVect2, size_t qty);
+template float  L2SqrSSE<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double L2SqrSSE<double>(const double* pVect1, const double* pVect2, size_t qty);
 
 /*
  * Slower versions of LP-distance
@@ -0,0 +1,300 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#include "distcomp.h"
+#include "distcomp_dispatch.h"
+#include "simdutils.h"
+#include "string.h"
+#include "utils.h"
+
+#include <cstdint>
+
+#ifdef PORTABLE_SSE4
+#include <immintrin.h>
+#endif
+
+/*
+ * F16C instructions are available on all CPUs that support AVX2,
+ * but MSVC doesn't define a separate macro for F16C.
+ */
+#if defined(PORTABLE_SSE4) && (defined(__F16C__) || defined(__AVX2__))
+#define PORTABLE_F16C
+#endif
+
+namespace similarity {
+
+using namespace std;
+
+/*
+ * Conversion to half-precision numbers rounds to the nearest even value.
+ * Numbers that are too large become infinite.
+ */
+uint16_t FloatToHalf(float x) {
+  uint32_t f;
+  memcpy(&f, &x, sizeof f);
+
+  const uint16_t sign = static_cast<uint16_t>((f >> 16) & 0x8000);
+  f &= 0x7fffffff;
+
+  if (f >= 0x7f800000) { // Inf or NaN
+    return sign | 0x7c00 | (f > 0x7f800000 ? 0x200 : 0);
+  }
+  if (f >= 0x477ff000) { // >= 65520, i.e., rounds to infinity
+    return sign | 0x7c00;
+  }
+  if (f < 0x38800000) { // Smaller than the smallest normal half-precision number 2^-14
+    if (f <= 0x33000000) return sign; // <= 2^-25 rounds to zero
+    const uint32_t shift = 126 - (f >> 23);
+    const uint32_t mant  = (f & 0x7fffff) | 0x800000;
+    const uint32_t rem   = mant & ((1u << shift) - 1);
+    const uint32_t half  = 1u << (shift - 1);
+    uint32_t       h     = mant >> shift;
+    if (rem > half || (rem == half && (h & 1))) ++h;
+    return sign | static_cast<uint16_t>(h);
+  }
+  // Re-biasing the exponent: 127 - 15 = 112
+  uint32_t       h   = (f - 0x38000000) >> 13;
+  const uint32_t rem = f & 0x1fff;
+  if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) ++h;
+  return sign | static_cast<uint16_t>(h);
+}
+
+float HalfToFloat(uint16_t h) {
+  const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+  const uint32_t exp  = (h >> 10) & 0x1f;
+  const uint32_t mant = h & 0x3ff;
+  uint32_t f;
+
+  if (exp == 0x1f) {
+    f = sign | 0x7f800000 | (mant << 13);
+  } else if (exp) {
+    f = sign | ((exp + 112) << 23) | (mant << 13);
+  } else {
+    // Zero or subnormal: the value is mant * 2^-24
+    const float res = static_cast<float>(mant) * 5.9604644775390625e-8f;
+    return sign ? -res : res;
+  }
+
+  float res;
+  memcpy(&res, &f, sizeof res);
+  return res;
+}
+
+void DecodeSQ8(const uint8_t* pCodes, float min, float scale, float* pVect, size_t qty) {
+  for (size_t i = 0; i < qty; ++i) {
+    pVect[i] = min + scale * pCodes[i];
+  }
+}
+
+void DecodeFP16(const uint16_t* pCodes, float* pVect, size_t qty) {
+  for (size_t i = 0; i < qty; ++i) {
+    pVect[i] = HalfToFloat(pCodes[i]);
+  }
+}
+
+#ifdef PORTABLE_SSE4
+namespace {
+
+/*
+ * Decodes 4 lower bytes of c.
+ */
+inline __m128 DecodeSQ8x4(__m128i c, __m128 vMin, __m128 vScale) {
+  return _mm_add_ps(vMin, _mm_mul_ps(vScale, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(c))));
+}
+
+inline __m128 DecodeFP16x4(const uint16_t* pCodes) {
+#ifdef PORTABLE_F16C
+  return _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pCodes)));
+#else
+  return _mm_set_ps(HalfToFloat(pCodes[3]), HalfToFloat(pCodes[2]),
+                    HalfToFloat(pCodes[1]), HalfToFloat(pCodes[0]));
+#endif
+}
+
+inline float HorizontalSum(__m128 sum) {
+  float PORTABLE_ALIGN16 TmpRes[4];
+
+  _mm_store_ps(TmpRes, sum);
+  return TmpRes[0] + TmpRes[1] + TmpRes[2] + TmpRes[3];
+}
+
+}
+#endif
+
+float L2SqrSQ8SSE(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty) {
+#ifndef PORTABLE_SSE4
+#pragma message WARN("L2SqrSQ8SSE: SSE4 is not available, defaulting to pure C++ implementation!")
+  float res = 0;
+  for (size_t i = 0; i < qty; ++i) {
+    float diff = pVect[i] - (min + scale * pCodes[i]);
+    res += diff * diff;
+  }
+  return res;
+#else
+  size_t qty16 = qty / 16;
+
+  const float* pEnd1 = pVect + 16 * qty16;
+  const float* pEnd2 = pVect + qty;
+
+  const __m128  vMin   = _mm_set1_ps(min);
+  const __m128  vScale = _mm_set1_ps(scale);
+  // Independent sums hide the latency of additions
+  __m128        sum1   = _mm_set1_ps(0);
+  __m128        sum2   = _mm_set1_ps(0);
+  __m128        diff1, diff2;
+  __m128i       c;
+
+  while (pVect < pEnd1) {
+    c     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCodes)); pCodes += 16;
+
+    diff1 = _mm_sub_ps(_mm_loadu_ps(pVect), DecodeSQ8x4(c, vMin, vScale));
+    diff2 = _mm_sub_ps(_mm_loadu_ps(pVect + 4), DecodeSQ8x4(_mm_srli_si128(c, 4), vMin, vScale));
+    sum1  = _mm_add_ps(sum1, _mm_mul_ps(diff1, diff1));
+    sum2  = _mm_add_ps(sum2, _mm_mul_ps(diff2, diff2));
+
+    diff1 = _mm_sub_ps(_mm_loadu_ps(pVect + 8), DecodeSQ8x4(_mm_srli_si128(c, 8), vMin, vScale));
+    diff2 = _mm_sub_ps(_mm_loadu_ps(pVect + 12), DecodeSQ8x4(_mm_srli_si128(c, 12), vMin, vScale));
+    sum1  = _mm_add_ps(sum1, _mm_mul_ps(diff1, diff1));
+    sum2  = _mm_add_ps(sum2, _mm_mul_ps(diff2, diff2));
+
+    pVect += 16;
+  }
+
+  float res = HorizontalSum(_mm_add_ps(sum1, sum2));
+
+  while (pVect < pEnd2) {
+    float diff = *pVect++ - (min + scale * *pCodes++);
+    res += diff * diff;
+  }
+
+  return res;
+#endif
+}
+
+float ScalarProductSQ8SSE(const float* pVect, const uint8_t* pCodes, float min, float scale, size_t qty) {
+#ifndef PORTABLE_SSE4
+#pragma message WARN("ScalarProductSQ8SSE: SSE4 is not available, defaulting to pure C++ implementation!")
+  float res = 0;
+  for (size_t i = 0; i < qty; ++i) {
+    res += pVect[i] * (min + scale * pCodes[i]);
+  }
+  return res;
+#else
+  size_t qty16 = qty / 16;
+
+  const float* pEnd1 = pVect + 16 * qty16;
+  const float* pEnd2 = pVect + qty;
+
+  const __m128  vMin   = _mm_set1_ps(min);
+  const __m128  vScale = _mm_set1_ps(scale);
+  __m128        sum1   = _mm_set1_ps(0);
+  __m128        sum2   = _mm_set1_ps(0);
+  __m128i       c;
+
+  while (pVect < pEnd1) {
+    c     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCodes)); pCodes += 16;
+
+    sum1  = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(pVect), DecodeSQ8x4(c, vMin, vScale)));
+    sum2  = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(pVect + 4), DecodeSQ8x4(_mm_srli_si128(c, 4), vMin, vScale)));
+    sum1  = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(pVect + 8), DecodeSQ8x4(_mm_srli_si128(c, 8), vMin, vScale)));
+    sum2  = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(pVect + 12), DecodeSQ8x4(_mm_srli_si128(c, 12), vMin, vScale)));
+
+    pVect += 16;
+  }
+
+  float res = HorizontalSum(_mm_add_ps(sum1, sum2));
+
+  while (pVect < pEnd2) {
+    res += *pVect++ * (min + scale * *pCodes++);
+  }
+
+  return res;
+#endif
+}
+
+float L2SqrFP16SSE(const float* pVect, const uint16_t* pCodes, size_t qty) {
+#ifndef PORTABLE_SSE4
+#pragma message WARN("L2SqrFP16SSE: SSE4 is not available, defaulting to pure C++ implementation!")
+  float res = 0;
+  for (size_t i = 0; i < qty; ++i) {
+    float diff = pVect[i] - HalfToFloat(pCodes[i]);
+    res += diff * diff;
+  }
+  return res;
+#else
+  size_t qty8 = qty / 8;
+
+  const float* pEnd1 = pVect + 8 * qty8;
+  const float* pEnd2 = pVect + qty;
+
+  __m128  sum1 = _mm_set1_ps(0);
+  __m128  sum2 = _mm_set1_ps(0);
+  __m128  diff1, diff2;
+
+  while (pVect < pEnd1) {
+    diff1 = _mm_sub_ps(_mm_loadu_ps(pVect), DecodeFP16x4(pCodes));
+    diff2 = _mm_sub_ps(_mm_loadu_ps(pVect + 4), DecodeFP16x4(pCodes + 4));
+    sum1  = _mm_add_ps(sum1, _mm_mul_ps(diff1, diff1));
+    sum2  = _mm_add_ps(sum2, _mm_mul_ps(diff2, diff2));
+
+    pVect += 8; pCodes += 8;
+  }
+
+  float res = HorizontalSum(_mm_add_ps(sum1, sum2));
+
+  while (pVect < pEnd2) {
+    float diff = *pVect++ - HalfToFloat(*pCodes++);
+    res += diff * diff;
+  }
+
+  return res;
+#endif
+}
+
+float ScalarProductFP16SSE(const float* pVect, const uint16_t* pCodes, size_t qty) {
+#ifndef PORTABLE_SSE4
+#pragma message WARN("ScalarProductFP16SSE: SSE4 is not available, defaulting to pure C++ implementation!")
+  float res = 0;
+  for (size_t i = 0; i < qty; ++i) {
+    res += pVect[i] * HalfToFloat(pCodes[i]);
+  }
+  return res;
+#else
+  size_t qty8 = qty / 8;
+
+  const float* pEnd1 = pVect + 8 * qty8;
+  const float* pEnd2 = pVect + qty;
+
+  __m128  sum1 = _mm_set1_ps(0);
+  __m128  sum2 = _mm_set1_ps(0);
+
+  while (pVect < pEnd1) {
+    sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(pVect), DecodeFP16x4(pCodes)));
+    sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(pVect + 4), DecodeFP16x4(pCodes + 4)));
+
+    pVect += 8; pCodes += 8;
+  }
+
+  float res = HorizontalSum(_mm_add_ps(sum1, sum2));
+
+  while (pVect < pEnd2) {
+    res += *pVect++ * HalfToFloat(*pCodes++);
+  }
+
+  return res;
+#endif
+}
+
+}
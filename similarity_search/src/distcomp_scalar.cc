@@ -14,12 +14,18 @@
  *
  */
 #include "distcomp.h"
+#include "simdutils.h"
 #include "string.h"
+#include "utils.h"
 
 #include <cstdlib>
 #include <limits>
 #include <algorithm>
 
+#ifdef PORTABLE_SSE2
+#include <immintrin.h>
+#endif
+
 namespace similarity {
 
 using namespace std;
@@ -89,4 +95,167 @@ T CosineSimilarity(const T *p1, const T *p2, size_t qty)
 template float  CosineSimilarity<float>(const float* pVect1, const float* pVect2, size_t qty);
 template double CosineSimilarity<double>(const double* pVect1, const double* pVect2, size_t qty);
 
+/*
+ * Scalar product
+ */
+
+template <class T>
+T ScalarProduct(const T *p1, const T *p2, size_t qty) 
+{ 
+    T sum = 0;
+
+    for (size_t i = 0; i < qty; i++) {
+      sum += p1[i] * p2[i];
+    }
+    return sum;
+}
+
+template float  ScalarProduct<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double ScalarProduct<double>(const double* pVect1, const double* pVect2, size_t qty);
+
+template <>
+float ScalarProductSIMD(const float* pVect1, const float* pVect2, size_t qty) {
+#ifndef PORTABLE_SSE2
+#pragma message WARN("ScalarProductSIMD<float>: SSE2 is not available, defaulting to pure C++ implementation!")
+    return ScalarProduct(pVect1, pVect2, qty);
+#else
+    size_t qty4  = qty/4;
+    size_t qty16 = qty/16;
+
+    const float* pEnd1 = pVect1 + 16 * qty16;
+    const float* pEnd2 = pVect1 + 4  * qty4;
+    const float* pEnd3 = pVect1 + qty;
+
+    __m128  v1, v2;
+    __m128  sum = _mm_set1_ps(0);
+
+    while (pVect1 < pEnd1) {
+        v1   = _mm_loadu_ps(pVect1); pVect1 += 4;
+        v2   = _mm_loadu_ps(pVect2); pVect2 += 4;
+        sum  = _mm_add_ps(sum, _mm_mul_ps(v1, v2));
+
+        v1   = _mm_loadu_ps(pVect1); pVect1 += 4;
+        v2   = _mm_loadu_ps(pVect2); pVect2 += 4;
+        sum  = _mm_add_ps(sum, _mm_mul_ps(v1, v2));
+
+        v1   = _mm_loadu_ps(pVect1); pVect1 += 4;
+        v2   = _mm_loadu_ps(pVect2); pVect2 += 4;
+        sum  = _mm_add_ps(sum, _mm_mul_ps(v1, v2));
+
+        v1   = _mm_loadu_ps(pVect1); pVect1 += 4;
+        v2   = _mm_loadu_ps(pVect2); pVect2 += 4;
+        sum  = _mm_add_ps(sum, _mm_mul_ps(v1, v2));
+    }
+
+    while (pVect1 < pEnd2) {
+        v1   = _mm_loadu_ps(pVect1); pVect1 += 4;
+        v2   = _mm_loadu_ps(pVect2); pVect2 += 4;
+        sum  = _mm_add_ps(sum, _mm_mul_ps(v1, v2));
+    }
+
+    float PORTABLE_ALIGN16 TmpRes[4];
+
+    _mm_store_ps(TmpRes, sum);
+    float res = TmpRes[0] + TmpRes[1] + TmpRes[2] + TmpRes[3];
+
+    while (pVect1 < pEnd3) {
+        res += (*pVect1++) * (*pVect2++);
+    }
+
+    return res;
+#endif
+}
+
+template <>
+double ScalarProductSIMD(const double* pVect1, const double* pVect2, size_t qty) {
+#ifndef PORTABLE_SSE2
+#pragma message WARN("ScalarProductSIMD<double>: SSE2 is not available, defaulting to pure C++ implementation!")
+    return ScalarProduct(pVect1, pVect2, qty);
+#else
+    size_t qty8 = qty/8;
+
+    const double* pEnd1 = pVect1 + 8 * qty8;
+    const double* pEnd2 = pVect1 + qty;
+
+    __m128d  v1, v2;
+    __m128d  sum = _mm_set1_pd(0);
+
+    while (pVect1 < pEnd1) {
+        v1   = _mm_loadu_pd(pVect1); pVect1 += 2;
+        v2   = _mm_loadu_pd(pVect2); pVect2 += 2;
+        sum  = _mm_add_pd(sum, _mm_mul_pd(v1, v2));
+
+        v1   = _mm_loadu_pd(pVect1); pVect1 += 2;
+        v2   = _mm_loadu_pd(pVect2); pVect2 += 2;
+        sum  = _mm_add_pd(sum, _mm_mul_pd(v1, v2));
+
+        v1   = _mm_loadu_pd(pVect1); pVect1 += 2;
+        v2   = _mm_loadu_pd(pVect2); pVect2 += 2;
+        sum  = _mm_add_pd(sum, _mm_mul_pd(v1, v2));
+
+        v1   = _mm_loadu_pd(pVect1); pVect1 += 2;
+        v2   = _mm_loadu_pd(pVect2); pVect2 += 2;
+        sum  = _mm_add_pd(sum, _mm_mul_pd(v1, v2));
+    }
+
+    double PORTABLE_ALIGN16 TmpRes[2];
+
+    _mm_store_pd(TmpRes, sum);
+    double res = TmpRes[0] + TmpRes[1];
+
+    while (pVect1 < pEnd2) {
+        res += (*pVect1++) * (*pVect2++);
+    }
+
+    return res;
+#endif
+}
+
+template float  ScalarProductSIMD<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double ScalarProductSIMD<double>(const double* pVect1, const double* pVect2, size_t qty);
+
+/*
+ * Normalized scalar product with precomputed inverse norms:
+ * only one scalar product needs to be computed.
+ */
+
+template <class T>
+T NormScalarProductPrecompSIMD(const T *p1, const T *p2, size_t qty) 
+{ 
+    const T invNorm1 = p1[qty];
+    const T invNorm2 = p2[qty];
+
+    // Zero vectors are treated the same way as in NormScalarProduct
+    if (invNorm1 == 0) {
+      if (invNorm2 == 0) return 1;
+      return 0;
+    }
+    if (invNorm2 == 0) return 0;
+
+    T sum = ScalarProductSIMD(p1, p2, qty);
+
+    return max(T(-1), min(T(1), sum * invNorm1 * invNorm2));
+}
+
+template float  NormScalarProductPrecompSIMD<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double NormScalarProductPrecompSIMD<double>(const double* pVect1, const double* pVect2, size_t qty);
+
+template <class T>
+T AngularDistancePrecompSIMD(const T *p1, const T *p2, size_t qty) 
+{ 
+    return acos(NormScalarProductPrecompSIMD(p1, p2, qty));
+}
+
+template float  AngularDistancePrecompSIMD<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double AngularDistancePrecompSIMD<double>(const double* pVect1, const double* pVect2, size_t qty);
+
+template <class T>
+T CosineSimilarityPrecompSIMD(const T *p1, const T *p2, size_t qty) 
+{ 
+    return std::max(T(0), 1 - NormScalarProductPrecompSIMD(p1, p2, qty));
+}
+
+template float  CosineSimilarityPrecompSIMD<float>(const float* pVect1, const float* pVect2, size_t qty);
+template double CosineSimilarityPrecompSIMD<double>(const double* pVect1, const double* pVect2, size_t qty);
+
 }
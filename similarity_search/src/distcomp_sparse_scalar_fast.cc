@@ -19,6 +19,7 @@
 #include "utils.h"
 #include "logging.h"
 #include "simdutils.h"
+#include "distcomp.h"
 
 #include "space/space_sparse_vector_inter.h"
 
@@ -81,9 +82,188 @@ const static __m128i shuffle_mask16[16] = {
  *    version of the _mm_cmpistrm.
  *
  */
+float SparseBlockScalarProductSSE(const uint16_t* pBlockIds1, const float* pBlockVals1, size_t qty1,
+                                  const uint16_t* pBlockIds2, const float* pBlockVals2, size_t qty2) {
+  float                        buf1[MAX_BUFFER_QTY];
+  float                        buf2[MAX_BUFFER_QTY];
+  unique_ptr<float[]>        mem1;
+  unique_ptr<float[]>        mem2;
+
+  size_t mx = max(qty1, qty2);
+
+  float* val1 = buf1;
+  float* val2 = buf2;
+
+  /* 
+   * Let's do some flexible memory allocation. 
+   * If there is enough space on stack, use the stack,
+   * otherwise allocate a large chunk of memory      
+   */
+  if (mx > MAX_BUFFER_QTY) {
+      mem1.reset(new float[mx]);
+      mem2.reset(new float[mx]);
+      val1 = mem1.get();
+      val2 = mem2.get();
+  }
+
+  float* pVal1 = val1;
+  float* pVal2 = val2;
+
+  size_t i1 = 0, i2 = 0;
+  size_t iEnd1 = qty1 / 8 * 8; 
+  size_t iEnd2 = qty2 / 8 * 8; 
+
+#ifdef PORTABLE_SSE4
+  if (i1 < iEnd1 && i2 < iEnd2) {
+    while (pBlockIds1[i1 + 7] < pBlockIds2[i2]) {
+      i1 += 8;
+      if (i1 >= iEnd1) goto scalar_inter; 
+    }
+    while (pBlockIds2[i2 + 7] < pBlockIds1[i1]) {
+      i2 += 8;
+      if (i2 >= iEnd2) goto scalar_inter; 
+    }
+    __m128i id1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockIds1[i1]));
+    __m128i id2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockIds2[i2]));
+
+    while (true) {
+      __m128i cmpRes = _mm_cmpistrm(id2, id1,
+                                    _SIDD_UWORD_OPS | 
+                                    _SIDD_CMP_EQUAL_ANY | 
+                                    _SIDD_BIT_MASK);
+
+      int r = _mm_extract_epi32(cmpRes, 0);
+
+      if (r) {
+
+        int r1 = r & 15;
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockVals1[i1]));
+        __m128  vs = _mm_castsi128_ps(_mm_shuffle_epi8(v, shuffle_mask16[r1]));
+        _mm_storeu_ps(pVal1, vs);
+        pVal1 += _mm_popcnt_u32(r1);
+
+        int r2 = (r >> 4) & 15;
+        v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockVals1[i1+4]));
+        vs = _mm_castsi128_ps(_mm_shuffle_epi8(v, shuffle_mask16[r2]));
+        _mm_storeu_ps(pVal1, vs);
+        pVal1 += _mm_popcnt_u32(r2);
+
+        cmpRes = _mm_cmpistrm(id1, id2,
+                            _SIDD_UWORD_OPS | 
+                            _SIDD_CMP_EQUAL_ANY | 
+                            _SIDD_BIT_MASK);
+        r = _mm_extract_epi32(cmpRes, 0);
+
+        r1 = r & 15;
+
+        v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockVals2[i2]));
+        vs = _mm_castsi128_ps(_mm_shuffle_epi8(v, shuffle_mask16[r1]));
+        _mm_storeu_ps(pVal2, vs);
+        pVal2 += _mm_popcnt_u32(r1);
+
+        r2 = (r >> 4) & 15;
+        v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockVals2[i2+4]));
+        vs = _mm_castsi128_ps(_mm_shuffle_epi8(v, shuffle_mask16[r2]));
+        _mm_storeu_ps(pVal2, vs);
+        pVal2 += _mm_popcnt_u32(r2);
+      }
+
+      const uint16_t id1max = pBlockIds1[i1 + 7];
+      if (id1max <= pBlockIds2[i2 + 7]) {
+        i1 += 8;
+        if (i1 >= iEnd1) goto scalar_inter; 
+        id1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockIds1[i1]));
+      }
+      if (id1max >= pBlockIds2[i2 + 7]) {
+        i2 += 8;
+        if (i2 >= iEnd2) goto scalar_inter; 
+        id2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockIds2[i2]));
+      }
+    }
+  }
+  scalar_inter:
+#else
+#pragma message WARN("No SSE 4.2, defaulting to scalar implementation!")
+#endif
+
+  while (i1 < qty1 && i2 < qty2) {
+    if (pBlockIds1[i1] == pBlockIds2[i2]) {
+      *pVal1++ = pBlockVals1[i1]; 
+      *pVal2++ = pBlockVals2[i2];
+      ++i1;
+      ++i2;
+    } else if (pBlockIds1[i1] < pBlockIds2[i2]) {
+      ++i1;
+    } else {
+      ++i2;
+    } 
+  }
+
+  ssize_t resQty = pVal1 - val1;
+
+  CHECK(resQty == pVal2 - val2);
+
+  float sum = 0;
+
+#ifdef PORTABLE_SSE4
+  ssize_t resQty4 = resQty / 4 * 4;
+
+  if (resQty4) {
+    __m128 sum128 = _mm_set1_ps(0);
+
+    for (ssize_t k = 0; k < resQty4; k += 4) {
+      sum128 = _mm_add_ps(sum128,
+                          _mm_mul_ps(_mm_loadu_ps(val1 + k),
+                                     _mm_loadu_ps(val2 + k)));
+    }
+
+    sum += MM_EXTRACT_FLOAT(sum128, 0);
+    sum += MM_EXTRACT_FLOAT(sum128, 1);
+    sum += MM_EXTRACT_FLOAT(sum128, 2);
+    sum += MM_EXTRACT_FLOAT(sum128, 3);
+  }
+
+  for (ssize_t k = resQty4; k < resQty; ++k)
+      sum += val1[k] * val2[k];
+#else
+  for (ssize_t k = 0; k < resQty; ++k)
+      sum += val1[k] * val2[k];
+#endif
+
+  return sum;
+}
+
+/*
+ * The galloping intersection of two blocks, where the first block is much shorter.
+ */
+float SparseBlockScalarProductGallop(const uint16_t* pBlockIds1, const float* pBlockVals1, size_t qty1,
+                                     const uint16_t* pBlockIds2, const float* pBlockVals2, size_t qty2) {
+  float sum = 0;
+
+  const uint16_t* pCurr2 = pBlockIds2;
+  const uint16_t* pEnd2  = pBlockIds2 + qty2;
+
+  for (size_t i1 = 0; i1 < qty1 && pCurr2 < pEnd2; ++i1) {
+    pCurr2 = GallopLowerBound(pCurr2, pEnd2, pBlockIds1[i1]);
+    if (pCurr2 < pEnd2 && *pCurr2 == pBlockIds1[i1]) {
+      sum += pBlockVals1[i1] * pBlockVals2[pCurr2 - pBlockIds2];
+      ++pCurr2;
+    }
+  }
+
+  return sum;
+}
+
+/*
+ * ScalarProjectFast intersects only blocks with equal offsets.
+ * The intersection of (not too) different-length blocks
+ * is carried out by the SIMD function SparseBlockScalarProductSIMD,
+ * which has SSE (see above) and AVX2 versions (see distcomp_avx2.cc).
+ * If one block is much longer than the other, we use galloping instead.
+ */
 float ScalarProjectFast(const char* pData1, size_t len1,
                         const char* pData2, size_t len2) {
-  float           norm1 = 0, norm2 = 0;
+  float           invNorm1 = 0, invNorm2 = 0;
   size_t          blockQty1 = 0, blockQty2 = 0;
   const size_t*   pBlockQtys1 = NULL; 
   const size_t*   pBlockQtys2 = NULL; 
@@ -92,14 +272,8 @@ float ScalarProjectFast(const char* pData1, size_t len1,
   const char*     pBlockBeg1 = NULL; 
   const char*     pBlockBeg2 = NULL;
 
-  float                        buf1[MAX_BUFFER_QTY];
-  float                        buf2[MAX_BUFFER_QTY];
-  unique_ptr<float[]>        mem1;
-  unique_ptr<float[]>        mem2;
-  size_t                    allocQty = 0;
-
-  ParseSparseElementHeader(pData1, blockQty1, norm1, pBlockQtys1, pBlockOffs1, pBlockBeg1);
-  ParseSparseElementHeader(pData2, blockQty2, norm2, pBlockQtys2, pBlockOffs2, pBlockBeg2);
+  ParseSparseElementHeader(pData1, blockQty1, invNorm1, pBlockQtys1, pBlockOffs1, pBlockBeg1);
+  ParseSparseElementHeader(pData2, blockQty2, invNorm2, pBlockQtys2, pBlockOffs2, pBlockBeg2);
 
   float sum = 0;
 
@@ -117,153 +291,19 @@ float ScalarProjectFast(const char* pData1, size_t len1,
       const uint16_t* pBlockIds2 = reinterpret_cast<const uint16_t*>(pBlockBeg2);
       const float*    pBlockVals2 = reinterpret_cast<const float*>(pBlockIds2 + qty2);
 
-      size_t mx = max(qty1, qty2);
-
-      float* val1 = buf1;
-      float* val2 = buf2;
-
-      /* 
-       * Let's do some flexible memory allocation. 
-       * If there is enough space on stack, use the stack,
-       * otherwise allocate a large chunk of memory      
-       */
-      if (mx > MAX_BUFFER_QTY) {
-          if (allocQty < mx) {
-              mem1.reset(new float[mx]);
-              mem2.reset(new float[mx]);
-              allocQty = mx;
-          }
-          val1 = mem1.get();
-          val2 = mem2.get();
-      }
-  
-      float* pVal1 = val1;
-      float* pVal2 = val2;
-
-      size_t i1 = 0, i2 = 0;
-      size_t iEnd1 = qty1 / 8 * 8; 
-      size_t iEnd2 = qty2 / 8 * 8; 
-
-#ifdef PORTABLE_SSE4
-      if (i1 < iEnd1 && i2 < iEnd2) {
-        while (pBlockIds1[i1 + 7] < pBlockIds2[i2]) {
-          i1 += 8;
-          if (i1 >= iEnd1) goto scalar_inter; 
-        }
-        while (pBlockIds2[i2 + 7] < pBlockIds1[i1]) {
-          i2 += 8;
-          if (i2 >= iEnd2) goto scalar_inter; 
-        }
-        __m128i id1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockIds1[i1]));
-        __m128i id2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockIds2[i2]));
-
-        while (true) {
-          __m128i cmpRes = _mm_cmpistrm(id2, id1,
-                                        _SIDD_UWORD_OPS | 
-                                        _SIDD_CMP_EQUAL_ANY | 
-                                        _SIDD_BIT_MASK);
-
-          int r = _mm_extract_epi32(cmpRes, 0);
-
-          if (r) {
-
-            int r1 = r & 15;
-            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockVals1[i1]));
-            __m128  vs = _mm_castsi128_ps(_mm_shuffle_epi8(v, shuffle_mask16[r1]));
-            _mm_storeu_ps(pVal1, vs);
-            pVal1 += _mm_popcnt_u32(r1);
-
-            int r2 = (r >> 4) & 15;
-            v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockVals1[i1+4]));
-            vs = _mm_castsi128_ps(_mm_shuffle_epi8(v, shuffle_mask16[r2]));
-            _mm_storeu_ps(pVal1, vs);
-            pVal1 += _mm_popcnt_u32(r2);
-
-            cmpRes = _mm_cmpistrm(id1, id2,
-                                _SIDD_UWORD_OPS | 
-                                _SIDD_CMP_EQUAL_ANY | 
-                                _SIDD_BIT_MASK);
-            r = _mm_extract_epi32(cmpRes, 0);
-
-            r1 = r & 15;
-
-            v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockVals2[i2]));
-            vs = _mm_castsi128_ps(_mm_shuffle_epi8(v, shuffle_mask16[r1]));
-            _mm_storeu_ps(pVal2, vs);
-            pVal2 += _mm_popcnt_u32(r1);
-
-            r2 = (r >> 4) & 15;
-            v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockVals2[i2+4]));
-            vs = _mm_castsi128_ps(_mm_shuffle_epi8(v, shuffle_mask16[r2]));
-            _mm_storeu_ps(pVal2, vs);
-            pVal2 += _mm_popcnt_u32(r2);
-          }
-
-          const uint16_t id1max = pBlockIds1[i1 + 7];
-          if (id1max <= pBlockIds2[i2 + 7]) {
-            i1 += 8;
-            if (i1 >= iEnd1) goto scalar_inter; 
-            id1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockIds1[i1]));
-          }
-          if (id1max >= pBlockIds2[i2 + 7]) {
-            i2 += 8;
-            if (i2 >= iEnd2) goto scalar_inter; 
-            id2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&pBlockIds2[i2]));
-          }
-        }
-      }
-  scalar_inter:
-#else
-    #pragma message WARN("No SSE 4.2, defaulting to scalar implementation!")
-#endif
-
-      while (i1 < qty1 && i2 < qty2) {
-        if (pBlockIds1[i1] == pBlockIds2[i2]) {
-          *pVal1++ = pBlockVals1[i1]; 
-          *pVal2++ = pBlockVals2[i2];
-          ++i1;
-          ++i2;
-        } else if (pBlockIds1[i1] < pBlockIds2[i2]) {
-          ++i1;
-        } else {
-          ++i2;
-        } 
+      if (qty2 >= SPARSE_GALLOP_RATIO * qty1) {
+        sum += SparseBlockScalarProductGallop(pBlockIds1, pBlockVals1, qty1,
+                                              pBlockIds2, pBlockVals2, qty2);
+      } else if (qty1 >= SPARSE_GALLOP_RATIO * qty2) {
+        sum += SparseBlockScalarProductGallop(pBlockIds2, pBlockVals2, qty2,
+                                              pBlockIds1, pBlockVals1, qty1);
+      } else {
+        sum += SparseBlockScalarProductSIMD(pBlockIds1, pBlockVals1, qty1,
+                                            pBlockIds2, pBlockVals2, qty2);
       }
 
       pBlockBeg1 += elemSize * pBlockQtys1[bid1++];
       pBlockBeg2 += elemSize * pBlockQtys2[bid2++];
-
-      ssize_t resQty = pVal1 - val1;
-
-      CHECK(resQty == pVal2 - val2);
-
-      
-
-#ifdef PORTABLE_SSE4
-      ssize_t resQty4 = resQty / 4 * 4;
-
-      if (resQty4) {
-        __m128 sum128 = _mm_set1_ps(0);
-
-        for (ssize_t k = 0; k < resQty4; k += 4) {
-          sum128 = _mm_add_ps(sum128,
-                              _mm_mul_ps(_mm_loadu_ps(val1 + k),
-                                         _mm_loadu_ps(val2 + k)));
-        }
-
-        sum += MM_EXTRACT_FLOAT(sum128, 0);
-        sum += MM_EXTRACT_FLOAT(sum128, 1);
-        sum += MM_EXTRACT_FLOAT(sum128, 2);
-        sum += MM_EXTRACT_FLOAT(sum128, 3);
-      }
-
-      for (ssize_t k = resQty4; k < resQty; ++k)
-          sum += val1[k] * val2[k];
-#else
-      for (ssize_t k = 0; k < resQty; ++k)
-          sum += val1[k] * val2[k];
-#endif
-
     } else if (pBlockOffs1[bid1] < pBlockOffs2[bid2]) {
       pBlockBeg1 += elemSize * pBlockQtys1[bid1++];
     } else {
@@ -288,7 +328,7 @@ float ScalarProjectFast(const char* pData1, size_t len1,
   * This throws off other functions that use scalar product, e.g., acos
   */
 
-  return max(float(-1), min(float(1), sum / sqrt(norm1) / sqrt(norm2)));
+  return max(float(-1), min(float(1), sum * invNorm1 * invNorm2));
 }
 
 }
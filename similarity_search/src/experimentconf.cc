@@ -49,13 +49,36 @@ void ExperimentConfig<dist_t>::SelectTestSet(int SetNum) {
   }
 }
 
+template <typename dist_t>
+void ExperimentConfig<dist_t>::ReadObjects(ObjectVector& dataset,
+                                           const string& FileName,
+                                           unsigned MaxNumObjects,
+                                           std::unique_ptr<MappedDataset>& mapped,
+                                           bool bQueries) {
+  if (!IsBinaryDataset(FileName)) {
+    if (bQueries) space->ReadQuerySet(dataset, this, FileName.c_str(), MaxNumObjects);
+    else          space->ReadDataset(dataset, this, FileName.c_str(), MaxNumObjects);
+    return;
+  }
+  mapped.reset(new MappedDataset(FileName));
+  if (mapped->GetSpaceDesc() != space->ToString()) {
+    LOG(LIB_FATAL) << "The binary data set: " << FileName << " was created for the space: '"
+                   << mapped->GetSpaceDesc() << "', but the current space is: '" << space->ToString() << "'";
+  }
+  if (dimension) {
+    LOG(LIB_FATAL) << "Restricting the dimensionality is not supported for binary data sets";
+  }
+  mapped->CreateObjects(dataset, MaxNumObjects);
+  LOG(LIB_INFO) << "Memory mapped " << dataset.size() << " objects from the binary data set: " << FileName;
+}
+
 template <typename dist_t>
 void ExperimentConfig<dist_t>::ReadDataset() {
   CHECK(space != NULL);
   CHECK(dataobjects.empty());
   CHECK(queryobjects.empty());
 
-  space->ReadDataset(OrigData, this, datafile.c_str(), MaxNumData);
+  ReadObjects(OrigData, datafile, MaxNumData, MappedData, false);
 
   /*
    * Note!!! 
@@ -66,7 +89,7 @@ void ExperimentConfig<dist_t>::ReadDataset() {
    */
   if (!NoQueryFile) {
     dataobjects = OrigData;
-    space->ReadDataset(queryobjects, this, queryfile.c_str(), MaxNumQuery);
+    ReadObjects(queryobjects, queryfile, MaxNumQuery, MappedQuery, true);
     OrigQuery = queryobjects;
   } else {
     size_t OrigQty = OrigData.size();
@@ -27,11 +27,13 @@
 #include "factory/init_spaces.h"
 
 #include "logging.h"
+#include "distcomp_dispatch.h"
 
 namespace similarity {
 
 void initLibrary(LogChoice choice, const char* pLogFile) {
   InitializeLogger(choice, pLogFile);
+  LOG(LIB_INFO) << "SIMD distance functions: " << SIMDTierName(GetSIMDTier());
   initSpaces();
   initMethods();
 }
@@ -28,12 +28,16 @@
 namespace similarity {
 
 using std::unique_ptr;
+using std::vector;
 
 template <typename dist_t>
 KNNQuery<dist_t>::KNNQuery(const Space<dist_t>* space, const Object* query_object, const unsigned K, float eps)
     : Query<dist_t>(space, query_object),
       K_(K), eps_(eps),
-      result_(new KNNQueue<dist_t>(K)) {
+      RerankQty_(std::max(K, space->GetRerankQty(K))),
+      reranked_(false),
+      result_(new KNNQueue<dist_t>(RerankQty_)) {
+  this->use_proxy_distance_ = RerankQty_ != K_;
 }
 
 template <typename dist_t>
@@ -45,30 +49,62 @@ template <typename dist_t>
 void KNNQuery<dist_t>::Reset() {
   this->ResetStats();
   result_->Reset();
+  reranked_ = false;
 }
 
 template <typename dist_t>
 const KNNQueue<dist_t>* KNNQuery<dist_t>::Result() const {
+  Rerank();
   return result_;
 }
 
+/*
+ * Re-computes distances to candidates using the real distance
+ * and keeps K_ closest ones.
+ */
+template <typename dist_t>
+void KNNQuery<dist_t>::Rerank() const {
+  if (RerankQty_ == K_ || reranked_) return;
+
+  vector<typename KNNQueue<dist_t>::QueueElement> cand(result_->GetElements());
+
+  for (auto& elem: cand) {
+    elem.first = this->space_->HiddenDistance(elem.second, this->query_object_);
+  }
+  this->distance_computations_ += cand.size();
+
+  const size_t qty = std::min(cand.size(), static_cast<size_t>(K_));
+  std::partial_sort(cand.begin(), cand.begin() + qty, cand.end());
+
+  result_->Reset();
+  result_->PushBatch(cand.data(), qty);
+  reranked_ = true;
+}
+
 template <typename dist_t>
 dist_t KNNQuery<dist_t>::Radius() const {
-  return result_->Size() < static_cast<size_t>(K_)
+  return result_->Size() < static_cast<size_t>(reranked_ ? K_ : RerankQty_)
       ? DistMax<dist_t>()
       : static_cast<dist_t>(result_->TopDistance() / (static_cast<dist_t>(1) + eps_));
 }
 
 template <typename dist_t>
 unsigned KNNQuery<dist_t>::ResultSize() const {
-  return result_->Size();
+  return Result()->Size();
 }
 
 template <typename dist_t>
 bool KNNQuery<dist_t>::CheckAndAddToResult(const dist_t distance,
                                            const Object* object) {
-  if (result_->Size() < static_cast<size_t>(K_) ||
+  return AddToResult(distance, object);
+}
+
+template <typename dist_t>
+bool KNNQuery<dist_t>::AddToResult(const dist_t distance,
+                                   const Object* object) {
+  if (result_->Size() < static_cast<size_t>(RerankQty_) ||
       distance < result_->TopDistance()) {
+    reranked_ = false;
     result_->Push(distance, object);
     return true;
   }
@@ -77,57 +113,78 @@ bool KNNQuery<dist_t>::CheckAndAddToResult(const dist_t distance,
 
 template <typename dist_t>
 bool KNNQuery<dist_t>::CheckAndAddToResult(const Object* object) {
-  return this->CheckAndAddToResult(this->DistanceObjLeft(object), object);
+  return AddToResult(this->DistanceObjLeft(object), object);
 }
 
 template <typename dist_t>
 size_t KNNQuery<dist_t>::CheckAndAddToResult(const ObjectVector& bucket) {
-  size_t res = 0;
-  for (size_t i = 0; i < bucket.size(); ++i) {
-    if (CheckAndAddToResult(bucket[i])) {
-      ++res;
-    }
+  return CheckAndAddToResult(bucket.data(), bucket.size());
+}
+
+/*
+ * Distances to all bucket objects are computed first (see DistanceObjLeftBlock),
+ * and then objects are added to the queue in one batch.
+ */
+template <typename dist_t>
+size_t KNNQuery<dist_t>::CheckAndAddToResult(const Object* const* objs, size_t qty) {
+  batch_.resize(qty);
+  batchDists_.resize(qty);
+  this->DistanceObjLeftBlock(objs, qty, batchDists_.data());
+  for (size_t i = 0; i < qty; ++i) {
+    batch_[i] = std::make_pair(batchDists_[i], objs[i]);
   }
+  const size_t res = result_->PushBatch(batch_.data(), batch_.size());
+  if (res) reranked_ = false;
   return res;
 }
 
+template <typename dist_t>
+void KNNQuery<dist_t>::Merge(const KNNQuery<dist_t>& other) {
+  // Re-ranked elements (if any) are re-ranked again together with the others
+  const auto& elems = other.result_->GetElements();
+  result_->PushBatch(elems.data(), elems.size());
+  reranked_ = false;
+  this->distance_computations_ += other.distance_computations_;
+}
+
 template <typename dist_t>
 bool KNNQuery<dist_t>::Equals(const KNNQuery<dist_t>* other) const {
-  bool equal = true;
-  unique_ptr<KNNQueue<dist_t>> first(result_->Clone());
-  unique_ptr<KNNQueue<dist_t>> second(other->result_->Clone());
-  while (equal && !first->Empty() && !second->Empty()) {
-    equal = equal && ApproxEqual(first->TopDistance(), second->TopDistance());
-    if (!equal) {
+  vector<typename KNNQueue<dist_t>::QueueElement> first, second;
+  Result()->GetSortedElements(first);
+  other->Result()->GetSortedElements(second);
+
+  if (first.size() != second.size()) return false;
+
+  for (size_t i = 0; i < first.size(); ++i) {
+    if (!ApproxEqual(first[i].first, second[i].first)) {
       std::cerr << "Equality check failed: "
-                << first->TopDistance() <<  " != "
-                << second->TopDistance() << std::endl;
+                << first[i].first <<  " != "
+                << second[i].first << std::endl;
+      return false;
     }
-    first->Pop();
-    second->Pop();
   }
-  equal = equal && first->Empty() && second->Empty();   // both should be empty
-  return equal;
+  return true;
 }
 
 template <typename dist_t>
 void KNNQuery<dist_t>::Print() const {
-  unique_ptr<KNNQueue<dist_t>> clone(Result()->Clone());
+  vector<typename KNNQueue<dist_t>::QueueElement> elems;
+  Result()->GetSortedElements(elems);
   std::cerr << "queryID = " << this->query_object_->id()
             << " size = " << ResultSize()
             << " (k=" << GetK()
             << " dc=" << this->DistanceComputations()
             << ") ";
-  while (!clone->Empty()) {
-    if (clone->TopObject() == NULL) {
-      std::cerr << "null (" << clone->TopDistance() << ")";
+  // The farthest objects go first
+  for (auto it = elems.rbegin(); it != elems.rend(); ++it) {
+    if (it->second == NULL) {
+      std::cerr << "null (" << it->first << ")";
     } else {
-      const Object* object = reinterpret_cast<const Object*>(clone->TopObject());
+      const Object* object = it->second;
       std::cerr << object->id() << "("
-                << clone->TopDistance() << " "
+                << it->first << " "
                 << this->space_->IndexTimeDistance(object, this->QueryObject()) << ") ";
     }
-    clone->Pop();
   }
   std::cerr << std::endl;
 }
@@ -133,7 +133,11 @@ void RunExper(const vector<shared_ptr<MethodWithParams>>& MethodsDesc,
              unsigned                     MaxNumQuery,
              const                        vector<unsigned>& knn,
              const                        float eps,
-             const string&                RangeArg
+             const string&                RangeArg,
+             const string&                SaveIndexPrefix,
+             const string&                LoadIndexPrefix,
+             unsigned                     ThreadGSQty,
+             const string&                CachePrefixGS
 )
 {
   LOG(LIB_INFO) << "### Append? : "       << DoAppend;
@@ -219,18 +223,42 @@ void RunExper(const vector<shared_ptr<MethodWithParams>>& MethodsDesc,
           }
         }
 
-        LOG(LIB_INFO) << (bCreateNew ? "Creating a new index":"Using a previosuly created index");
-
-        IndexPtrs.push_back(
-                bCreateNew ?
-                           shared_ptr<Index<dist_t>>(
+        /*
+         * Each method has its own index file, e.g.,
+         * <prefix>_0_small_world_rand, <prefix>_1_vptree, ...
+         */
+        stringstream IndexFileSuffix;
+        IndexFileSuffix << "_" << MethNum << "_" << MethodName;
+
+        if (!bCreateNew) {
+          LOG(LIB_INFO) << "Using a previosuly created index";
+          IndexPtrs.push_back(IndexPtrs.back());
+        } else if (!LoadIndexPrefix.empty()) {
+          const string IndexFile = LoadIndexPrefix + IndexFileSuffix.str();
+          LOG(LIB_INFO) << "Loading the index from: " << IndexFile;
+          IndexPtrs.push_back(shared_ptr<Index<dist_t>>(
+                           MethodFactoryRegistry<dist_t>::Instance().
+                           LoadMethod(IndexFile,
+                                      MethodName, 
+                                      SpaceType, config.GetSpace(), 
+                                      config.GetDataObjects(), MethPars)
+                           ));
+        } else {
+          LOG(LIB_INFO) << "Creating a new index";
+          IndexPtrs.push_back(shared_ptr<Index<dist_t>>(
                            MethodFactoryRegistry<dist_t>::Instance().
                            CreateMethod(true /* print progress */,
                                         MethodName, 
                                         SpaceType, config.GetSpace(), 
                                         config.GetDataObjects(), MethPars)
-                           )
-                           :IndexPtrs.back());
+                           ));
+        }
+
+        if (bCreateNew && !SaveIndexPrefix.empty()) {
+          const string IndexFile = SaveIndexPrefix + IndexFileSuffix.str();
+          LOG(LIB_INFO) << "Saving the index to: " << IndexFile;
+          IndexPtrs.back()->SaveIndex(IndexFile);
+        }
 
         LOG(LIB_INFO) << "==============================================";
 
@@ -263,11 +291,15 @@ void RunExper(const vector<shared_ptr<MethodWithParams>>& MethodsDesc,
         }
       }
 
+      GoldStandardManager<dist_t> GSManager(config);
+
+      GSManager.Compute(ThreadGSQty, CachePrefixGS.empty() ? string("") : GetGSCacheFileName(CachePrefixGS, TestSetId));
+
       Experiments<dist_t>::RunAll(true /* print info */, 
                                       ThreadTestQty, 
                                       TestSetId,
                                       ExpResRange, ExpResKNN,
-                                      config, 
+                                      config, GSManager,
                                       IndexPtrs, MethodsDesc);
 
 
@@ -351,6 +383,10 @@ int main(int ac, char* av[]) {
   unsigned              dimension;
   float                 eps = 0.0;
   unsigned              ThreadTestQty;
+  string                SaveIndexPrefix;
+  string                LoadIndexPrefix;
+  unsigned              ThreadGSQty;
+  string                CachePrefixGS;
 
   vector<shared_ptr<MethodWithParams>>        MethodsDesc;
 
@@ -370,6 +406,10 @@ int main(int ac, char* av[]) {
                        knn,
                        eps,
                        RangeArg,
+                       SaveIndexPrefix,
+                       LoadIndexPrefix,
+                       ThreadGSQty,
+                       CachePrefixGS,
                        MethodsDesc);
 
   initLibrary(LogFile.empty() ? LIB_LOGSTDERR:LIB_LOGFILE, LogFile.c_str());
@@ -393,7 +433,11 @@ int main(int ac, char* av[]) {
                   MaxNumQuery,
                   knn,
                   eps,
-                  RangeArg
+                  RangeArg,
+                  SaveIndexPrefix,
+                  LoadIndexPrefix,
+                  ThreadGSQty,
+                  CachePrefixGS
                  );
   } else if ("float" == DistType) {
     RunExper<float>(MethodsDesc,
@@ -410,7 +454,11 @@ int main(int ac, char* av[]) {
                   MaxNumQuery,
                   knn,
                   eps,
-                  RangeArg
+                  RangeArg,
+                  SaveIndexPrefix,
+                  LoadIndexPrefix,
+                  ThreadGSQty,
+                  CachePrefixGS
                  );
   } else if ("double" == DistType) {
     RunExper<double>(MethodsDesc,
@@ -427,7 +475,11 @@ int main(int ac, char* av[]) {
                   MaxNumQuery,
                   knn,
                   eps,
-                  RangeArg
+                  RangeArg,
+                  SaveIndexPrefix,
+                  LoadIndexPrefix,
+                  ThreadGSQty,
+                  CachePrefixGS
                  );
   } else {
     LOG(LIB_FATAL) << "Unknown distance value type: " << DistType;
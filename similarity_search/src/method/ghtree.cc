@@ -15,11 +15,13 @@
  */
 
 #include <limits>
+#include <fstream>
 
 #include "space.h"
 #include "knnquery.h"
 #include "rangequery.h"
 #include "method/ghtree.h"
+#include "method/parallel_tree_builder.h"
 #include "utils.h"
 
 namespace similarity {
@@ -28,24 +30,54 @@ template <typename dist_t>
 GHTree<dist_t>::GHTree(const Space<dist_t>* space,
                        const ObjectVector& data,
                        const AnyParams& MethParams,
-                       bool use_random_center)
-    : BucketSize_(50),
+                       bool use_random_center,
+                       bool BuildIndex)
+    : data_(data),
+      root_(NULL),
+      BucketSize_(50),
       MaxLeavesToVisit_(FAKE_MAX_LEAVES_TO_VISIT),
-      ChunkBucket_(true) {
+      ChunkBucket_(true),
+      IndexThreadQty_(0) {
   AnyParamManager pmgr(MethParams);
 
   pmgr.GetParamOptional("bucketSize", BucketSize_);
   pmgr.GetParamOptional("chunkBucket", ChunkBucket_);
   pmgr.GetParamOptional("maxLeavesToVisit", MaxLeavesToVisit_);
+  pmgr.GetParamOptional("indexThreadQty", IndexThreadQty_);
 
-  root_ = new GHNode(space, const_cast<ObjectVector&>(data),
-                     BucketSize_, ChunkBucket_,
-                     use_random_center, true);
+  if (!BuildIndex) return;
+
+  unique_ptr<ParallelTreeBuilder> builder;
+  if (IndexThreadQty_ > 1) {
+    builder.reset(new ParallelTreeBuilder(static_cast<unsigned>(IndexThreadQty_), data.size()));
+  }
+
+  // The root is owned by unique_ptr until all subtrees are built: a failed task doesn't leak the tree
+  unique_ptr<GHNode> root(new GHNode(space, const_cast<ObjectVector&>(data),
+                                     BucketSize_, ChunkBucket_,
+                                     use_random_center, true,
+                                     builder.get()));
+
+  if (builder) builder->Finish();
+  root_ = root.release();
 }
 
 template <typename dist_t>
 GHTree<dist_t>::~GHTree() { delete root_; }
 
+template <typename dist_t>
+vector<string> GHTree<dist_t>::GetQueryTimeParamNames() const {
+  vector<string> names;
+  names.push_back("maxLeavesToVisit");
+  return names;
+}
+
+template <typename dist_t>
+void GHTree<dist_t>::SetQueryTimeParamsInternal(AnyParamManager& pmgr) {
+  MaxLeavesToVisit_ = FAKE_MAX_LEAVES_TO_VISIT;
+  pmgr.GetParamOptional("maxLeavesToVisit", MaxLeavesToVisit_);
+}
+
 template <typename dist_t>
 const std::string GHTree<dist_t>::ToString() const {
   return "ghtree";
@@ -63,11 +95,102 @@ void GHTree<dist_t>::Search(KNNQuery<dist_t>* query) {
   root_->GenericSearch(query, mx);
 }
 
+/*
+ * The tree is saved in the pre-order: each node starts with a one-byte type
+ * (a bucket or an inner node). A bucket is a list of object positions.
+ * An inner node stores positions of its pivots (a missing pivot is saved
+ * as the number of data points) and flags indicating whether children exist.
+ * Children follow the node.
+ */
+enum GHTreeNodeType { kGHTreeBucket = 0, kGHTreeInnerNode = 1 };
+
+template <typename dist_t>
+void GHTree<dist_t>::SaveIndex(const string& location) {
+  std::ofstream out;
+  OpenIndexFileForWriting(location, out);
+  WriteIndexHeader(out, METH_GHTREE, data_.size());
+
+  ObjectPositionMap objPos(data_);
+
+  WriteBinaryPOD(out, static_cast<uint8_t>(root_ != NULL));
+  if (root_ != NULL) SaveNode(out, objPos, root_);
+  out.close();
+}
+
+template <typename dist_t>
+void GHTree<dist_t>::LoadIndex(const string& location) {
+  std::ifstream in;
+  OpenIndexFileForReading(location, in);
+  ReadIndexHeader(in, METH_GHTREE, data_.size());
+
+  delete root_;
+  root_ = NULL;
+
+  uint8_t hasRoot;
+  ReadBinaryPOD(in, hasRoot);
+  if (hasRoot) root_ = LoadNode(in);
+}
+
+template <typename dist_t>
+void GHTree<dist_t>::SaveNode(std::ostream& out,
+                              const ObjectPositionMap& objPos,
+                              const GHNode* node) const {
+  if (node->bucket_) {
+    WriteBinaryPOD(out, static_cast<uint8_t>(kGHTreeBucket));
+    WriteObjectPositions(out, objPos, *node->bucket_);
+    return;
+  }
+  const uint64_t NoPivot = data_.size();
+  WriteBinaryPOD(out, static_cast<uint8_t>(kGHTreeInnerNode));
+  WriteBinaryPOD(out, node->pivot1_ ? objPos.GetPos(node->pivot1_) : NoPivot);
+  WriteBinaryPOD(out, node->pivot2_ ? objPos.GetPos(node->pivot2_) : NoPivot);
+  WriteBinaryPOD(out, static_cast<uint8_t>(node->left_child_ != NULL));
+  WriteBinaryPOD(out, static_cast<uint8_t>(node->right_child_ != NULL));
+  if (node->left_child_)  SaveNode(out, objPos, node->left_child_);
+  if (node->right_child_) SaveNode(out, objPos, node->right_child_);
+}
+
+template <typename dist_t>
+typename GHTree<dist_t>::GHNode* GHTree<dist_t>::LoadNode(std::istream& in) const {
+  unique_ptr<GHNode> node(new GHNode());
+
+  uint8_t nodeType;
+  ReadBinaryPOD(in, nodeType);
+
+  if (nodeType == kGHTreeBucket) {
+    ObjectVector bucket;
+    ReadObjectPositions(in, data_, bucket);
+    if (ChunkBucket_) {
+      CreateCacheOptimizedBucket(bucket, node->CacheOptimizedBucket_, node->bucket_);
+    } else {
+      node->bucket_ = new ObjectVector(bucket);
+    }
+    return node.release();
+  }
+  if (nodeType != kGHTreeInnerNode) throw runtime_error("Corrupt index file: unknown GH-tree node type");
+
+  uint64_t pivot1Pos, pivot2Pos;
+  uint8_t  hasLeft, hasRight;
+  ReadBinaryPOD(in, pivot1Pos);
+  ReadBinaryPOD(in, pivot2Pos);
+  ReadBinaryPOD(in, hasLeft);
+  ReadBinaryPOD(in, hasRight);
+
+  if (pivot1Pos != data_.size()) node->pivot1_ = GetObjectByPos(data_, pivot1Pos);
+  if (pivot2Pos != data_.size()) node->pivot2_ = GetObjectByPos(data_, pivot2Pos);
+
+  if (hasLeft)  node->left_child_  = LoadNode(in);
+  if (hasRight) node->right_child_ = LoadNode(in);
+
+  return node.release();
+}
+
 template <typename dist_t>
 GHTree<dist_t>::GHNode::GHNode(
     const Space<dist_t>* space, ObjectVector& data,
     size_t bucket_size, bool chunk_bucket,
-    const bool use_random_center, bool is_root)
+    const bool use_random_center, bool is_root,
+    ParallelTreeBuilder* builder)
   : pivot1_(NULL), pivot2_(NULL), left_child_(NULL), right_child_(NULL),
     bucket_(NULL), CacheOptimizedBucket_(NULL) {
   CHECK(!data.empty());
@@ -106,13 +229,18 @@ GHTree<dist_t>::GHNode::GHNode(
 
   if (data.size() >= 3) {   // at least 1 object except pivot1 & 2
     ObjectVector left_subset, right_subset;
-    dist_t dist_to_pivot1, dist_to_pivot2;
+    // Distances are computed (possibly in parallel) before data points are split
+    vector<char> close_to_pivot1(data_size);
+    auto ComputeDist = [this, &close_to_pivot1, &data, space, pivot1_id, pivot2_id](size_t i) {
+      if (static_cast<int>(i) == pivot1_id || static_cast<int>(i) == pivot2_id) return;
+      close_to_pivot1[i] = space->IndexTimeDistance(pivot1_, data[i]) < 
+                           space->IndexTimeDistance(pivot2_, data[i]);
+    };
+    BuildParallelFor(builder, data.size(), ComputeDist);
     for (int i = 0; i < data_size; ++i) {
       if (i == pivot1_id || i == pivot2_id)
         continue;
-      dist_to_pivot1 = space->IndexTimeDistance(pivot1_, data[i]);
-      dist_to_pivot2 = space->IndexTimeDistance(pivot2_, data[i]);
-      if (dist_to_pivot1 < dist_to_pivot2) {    // close to pivot1
+      if (close_to_pivot1[i]) {
         left_subset.push_back(data[i]);
       } else {
         right_subset.push_back(data[i]);
@@ -123,13 +251,22 @@ GHTree<dist_t>::GHNode::GHNode(
       ObjectVector().swap(data);
     }
 
-    if (!left_subset.empty()) {
-      left_child_ = new GHNode(space, left_subset, bucket_size, chunk_bucket, use_random_center, false);
-    }
+    // Small subtrees are queued: they will be created by the builder's threads
+    auto CreateChild = [&](GHNode*& child, ObjectVector& subset) {
+      if (builder && subset.size() <= builder->GetSubtreeQty()) {
+        // Data points are moved rather than copied to the task
+        std::shared_ptr<ObjectVector> pSubset(new ObjectVector());
+        pSubset->swap(subset);
+        builder->AddSubtreeTask([=, &child]() {
+          child = new GHNode(space, *pSubset, bucket_size, chunk_bucket, use_random_center, false, NULL);
+        });
+      } else {
+        child = new GHNode(space, subset, bucket_size, chunk_bucket, use_random_center, false, builder);
+      }
+    };
 
-    if (!right_subset.empty()) {
-      right_child_ = new GHNode(space, right_subset, bucket_size, chunk_bucket, use_random_center, false);
-    }
+    if (!left_subset.empty()) CreateChild(left_child_, left_subset);
+    if (!right_subset.empty()) CreateChild(right_child_, right_subset);
   }
 }
 
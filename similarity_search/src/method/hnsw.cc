@@ -0,0 +1,454 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#include <cmath>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <fstream>
+
+#include "space.h"
+#include "knnquery.h"
+#include "rangequery.h"
+#include "utils.h"
+#include "index_io.h"
+#include "method/hnsw.h"
+
+namespace similarity {
+
+using std::thread;
+
+template <typename dist_t>
+struct IndexThreadParamsHnsw {
+  const Space<dist_t>*                        space_;
+  Hnsw<dist_t>&                               index_;
+  size_t                                      dataQty_;
+  size_t                                      index_every_;
+  size_t                                      out_of_;
+
+  IndexThreadParamsHnsw(
+                     const Space<dist_t>*             space,
+                     Hnsw<dist_t>&                    index,
+                     size_t                           dataQty,
+                     size_t                           index_every,
+                     size_t                           out_of
+                      ) :
+                     space_(space),
+                     index_(index),
+                     dataQty_(dataQty),
+                     index_every_(index_every),
+                     out_of_(out_of)
+                     {
+  }
+};
+
+template <typename dist_t>
+struct IndexThreadHnsw {
+  void operator()(IndexThreadParamsHnsw<dist_t>& prm) {
+    /*
+     * Skip the first element, it was added already
+     */
+    for (size_t i = 1; i < prm.dataQty_; ++i) {
+      if (prm.index_every_ == i % prm.out_of_) {
+        prm.index_.AddNode(prm.space_, i);
+      }
+    }
+  }
+};
+
+template <typename dist_t>
+Hnsw<dist_t>::Hnsw(const Space<dist_t>* space,
+                   const ObjectVector& data,
+                   const AnyParams& MethParams,
+                   bool BuildIndex) :
+                   M_(16),
+                   efConstruction_(200),
+                   efSearch_(10),
+                   indexThreadQty_(0),
+                   data_(data),
+                   EnterPoint_(0),
+                   MaxLevel_(0),
+                   VisitedListPool_(new VisitedListPool(1, data.size()))
+{
+  AnyParamManager pmgr(MethParams);
+
+  pmgr.GetParamOptional("M",              M_);
+  pmgr.GetParamOptional("efConstruction", efConstruction_);
+  pmgr.GetParamOptional("efSearch",       efSearch_);
+  pmgr.GetParamOptional("indexThreadQty", indexThreadQty_);
+
+  if (M_ < 2) {
+    throw runtime_error("The parameter M should be at least 2");
+  }
+  // The optimal value according to the paper
+  mult_ = 1 / log(static_cast<double>(M_));
+  pmgr.GetParamOptional("mult",           mult_);
+
+  LOG(LIB_INFO) << "M                   = " << M_;
+  LOG(LIB_INFO) << "efConstruction      = " << efConstruction_;
+  LOG(LIB_INFO) << "efSearch            = " << efSearch_;
+  LOG(LIB_INFO) << "mult                = " << mult_;
+  LOG(LIB_INFO) << "indexThreadQty      = " << indexThreadQty_;
+
+  if (!BuildIndex || data.empty()) return;
+
+  /*
+   * Levels are generated before indexing starts,
+   * so that indexing threads don't need a random number generator.
+   */
+  nodes_.resize(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    // 1 - RandomReal is in (0, 1]
+    int level = static_cast<int>(-log(1 - RandomReal<double>()) * mult_);
+    nodes_[i] = new HnswNode(level);
+  }
+
+  EnterPoint_ = 0;
+  MaxLevel_   = nodes_[0]->GetLevel();
+
+  if (indexThreadQty_ <= 1) {
+    // Skip the first element, one element is already added
+    for (size_t i = 1; i != data.size(); ++i) {
+      AddNode(space, i);
+    }
+  } else {
+    vector<thread>                                      threads(indexThreadQty_);
+    vector<shared_ptr<IndexThreadParamsHnsw<dist_t>>>   threadParams;
+
+    for (size_t i = 0; i < indexThreadQty_; ++i) {
+      threadParams.push_back(shared_ptr<IndexThreadParamsHnsw<dist_t>>(
+                              new IndexThreadParamsHnsw<dist_t>(space, *this, data.size(), i, indexThreadQty_)));
+    }
+    for (size_t i = 0; i < indexThreadQty_; ++i) {
+      LOG(LIB_INFO) << "Creating indexing thread: " << (i+1) << " out of " << indexThreadQty_;
+      threads[i] = thread(IndexThreadHnsw<dist_t>(), ref(*threadParams[i]));
+    }
+    for (size_t i = 0; i < indexThreadQty_; ++i) {
+      threads[i].join();
+    }
+  }
+  LOG(LIB_INFO) << "The number of levels: " << (MaxLevel_ + 1);
+}
+
+template <typename dist_t>
+Hnsw<dist_t>::~Hnsw() {
+  for (HnswNode* node: nodes_) delete node;
+}
+
+/*
+ * For each node, we store its level followed by
+ * lists of friends for levels 0, 1, ..., level.
+ */
+template <typename dist_t>
+void Hnsw<dist_t>::SaveIndex(const string& location) {
+  std::ofstream out;
+  OpenIndexFileForWriting(location, out);
+  WriteIndexHeader(out, METH_HNSW, data_.size());
+
+  WriteBinaryPOD(out, static_cast<uint64_t>(M_));
+  WriteBinaryPOD(out, static_cast<int32_t>(MaxLevel_));
+  WriteBinaryPOD(out, static_cast<uint32_t>(EnterPoint_));
+
+  for (const HnswNode* node: nodes_) {
+    WriteBinaryPOD(out, static_cast<int32_t>(node->GetLevel()));
+    for (const vector<unsigned>& friends: node->friends_) {
+      WriteBinaryVector(out, friends);
+    }
+  }
+
+  out.close();
+}
+
+template <typename dist_t>
+void Hnsw<dist_t>::LoadIndex(const string& location) {
+  std::ifstream in;
+  OpenIndexFileForReading(location, in);
+  ReadIndexHeader(in, METH_HNSW, data_.size());
+
+  uint64_t  M;
+  int32_t   MaxLevel;
+  uint32_t  EnterPoint;
+  ReadBinaryPOD(in, M);
+  ReadBinaryPOD(in, MaxLevel);
+  ReadBinaryPOD(in, EnterPoint);
+  M_ = M;
+  MaxLevel_ = MaxLevel;
+  EnterPoint_ = EnterPoint;
+
+  for (HnswNode* node: nodes_) delete node;
+  nodes_.clear();
+  nodes_.reserve(data_.size());
+
+  for (size_t i = 0; i < data_.size(); ++i) {
+    int32_t level;
+    ReadBinaryPOD(in, level);
+    if (level < 0 || level > MaxLevel_) {
+      throw runtime_error("Corrupt index file: a node level is out of range");
+    }
+    nodes_.push_back(new HnswNode(level));
+    for (vector<unsigned>& friends: nodes_.back()->friends_) {
+      ReadBinaryVector(in, friends);
+      for (unsigned id: friends) {
+        if (id >= data_.size()) throw runtime_error("Corrupt index file: a neighbor id is out of range");
+      }
+    }
+  }
+  if (!nodes_.empty() && 
+      (EnterPoint_ >= nodes_.size() || nodes_[EnterPoint_]->GetLevel() != MaxLevel_)) {
+    throw runtime_error("Corrupt index file: invalid entry point");
+  }
+  LOG(LIB_INFO) << "Loaded " << data_.size() << " nodes, M = " << M_ << ", the number of levels: " << (MaxLevel_ + 1);
+}
+
+template <typename dist_t>
+void
+Hnsw<dist_t>::SetQueryTimeParamsInternal(AnyParamManager& pmgr) {
+  pmgr.GetParamOptional("efSearch", efSearch_);
+}
+
+template <typename dist_t>
+vector<string>
+Hnsw<dist_t>::GetQueryTimeParamNames() const {
+  vector<string> names;
+  names.push_back("efSearch");
+  return names;
+}
+
+template <typename dist_t>
+const std::string Hnsw<dist_t>::ToString() const {
+  return METH_HNSW;
+}
+
+template <typename dist_t>
+template <typename DistFunc>
+void Hnsw<dist_t>::GreedySearchLevel(const DistFunc& distFunc, int level, bool lockNodes,
+                                     unsigned& curr, dist_t& currDist) const {
+  bool changed = true;
+
+  while (changed) {
+    changed = false;
+
+    unique_lock<mutex> lock;
+    if (lockNodes) lock = unique_lock<mutex>(nodes_[curr]->accessGuard_);
+
+    // curr may change in the loop, but the lock protects the list we iterate over
+    const vector<unsigned>& friends = nodes_[curr]->friends_[level];
+    for (unsigned f: friends) {
+      dist_t d = distFunc(f);
+      if (d < currDist) {
+        currDist = d;
+        curr = f;
+        changed = true;
+      }
+    }
+  }
+}
+
+template <typename dist_t>
+template <typename DistFunc>
+void Hnsw<dist_t>::SearchLevel(const DistFunc& distFunc, int level, bool lockNodes,
+                               unsigned entry, dist_t entryDist, size_t ef,
+                               VisitedList& visited, FarthestQueue& result) const {
+  visited.Reset();
+
+  ClosestQueue      candidates;
+  vector<unsigned>  friendsCopy;
+
+  candidates.push(DistNodePair(entryDist, entry));
+  result.push(DistNodePair(entryDist, entry));
+  visited.MarkVisited(entry);
+
+  while (!candidates.empty()) {
+    const DistNodePair curr = candidates.top();
+    // All the remaining candidates are farther than the farthest result
+    if (curr.first > result.top().first) break;
+    candidates.pop();
+
+    const vector<unsigned>* friends = &nodes_[curr.second]->friends_[level];
+    if (lockNodes) {
+      unique_lock<mutex> lock(nodes_[curr.second]->accessGuard_);
+      friendsCopy = *friends;
+      friends = &friendsCopy;
+    }
+
+    for (unsigned f: *friends) {
+      if (visited.IsVisited(f)) continue;
+      visited.MarkVisited(f);
+
+      dist_t d = distFunc(f);
+      if (result.size() < ef || d < result.top().first) {
+        candidates.push(DistNodePair(d, f));
+        result.push(DistNodePair(d, f));
+        if (result.size() > ef) result.pop();
+      }
+    }
+  }
+}
+
+template <typename dist_t>
+void Hnsw<dist_t>::SelectNeighbors(const Space<dist_t>* space,
+                                   vector<DistNodePair>& candidates, size_t MaxQty,
+                                   vector<unsigned>& selected) const {
+  std::sort(candidates.begin(), candidates.end());
+
+  selected.clear();
+
+  for (const DistNodePair& c: candidates) {
+    if (selected.size() >= MaxQty) break;
+
+    bool bKeep = true;
+    for (unsigned s: selected) {
+      if (space->IndexTimeDistance(data_[s], data_[c.second]) < c.first) {
+        bKeep = false;
+        break;
+      }
+    }
+    if (bKeep) selected.push_back(c.second);
+  }
+}
+
+template <typename dist_t>
+void Hnsw<dist_t>::AddNode(const Space<dist_t>* space, size_t id) {
+  HnswNode*     node  = nodes_[id];
+  const Object* obj   = data_[id];
+  const int     level = node->GetLevel();
+
+  auto distFunc = [space, obj, this](unsigned n) -> dist_t {
+    return space->IndexTimeDistance(data_[n], obj);
+  };
+
+  /*
+   * If the new node becomes the entry point, we hold the lock
+   * until the node is inserted: this is rare (the number of levels
+   * is logarithmic in the number of points).
+   */
+  unique_lock<mutex> entryLock(EntryGuard_);
+  const int maxLevel = MaxLevel_;
+  unsigned  curr     = EnterPoint_;
+  if (level <= maxLevel) entryLock.unlock();
+
+  dist_t currDist = distFunc(curr);
+
+  for (int lev = maxLevel; lev > level; --lev) {
+    GreedySearchLevel(distFunc, lev, true, curr, currDist);
+  }
+
+  VisitedListHolder     visitedHolder(*VisitedListPool_);
+  vector<DistNodePair>  candidates;
+  vector<unsigned>      selected;
+
+  for (int lev = std::min(level, maxLevel); lev >= 0; --lev) {
+    FarthestQueue top;
+    SearchLevel(distFunc, lev, true, curr, currDist, efConstruction_, visitedHolder.GetList(), top);
+
+    candidates.clear();
+    while (!top.empty()) {
+      candidates.push_back(top.top());
+      top.pop();
+    }
+    // The closest point is the entry point for the next level
+    curr      = candidates.back().second;
+    currDist  = candidates.back().first;
+
+    SelectNeighbors(space, candidates, M_, selected);
+
+    const size_t maxFriendQty = MaxFriendQty(lev);
+    {
+      /*
+       * Other threads can reach this node via upper levels and
+       * link to it before we get here: their links are kept.
+       */
+      unique_lock<mutex> lock(node->accessGuard_);
+      vector<unsigned>& friends = node->friends_[lev];
+
+      for (unsigned n: selected) {
+        if (std::find(friends.begin(), friends.end(), n) == friends.end()) friends.push_back(n);
+      }
+      if (friends.size() > maxFriendQty) {
+        candidates.clear();
+        for (unsigned f: friends) {
+          candidates.push_back(DistNodePair(distFunc(f), f));
+        }
+        SelectNeighbors(space, candidates, maxFriendQty, friends);
+      }
+    }
+
+    for (unsigned n: selected) {
+      HnswNode* fnode = nodes_[n];
+
+      unique_lock<mutex> lock(fnode->accessGuard_);
+      vector<unsigned>& friends = fnode->friends_[lev];
+
+      if (friends.size() < maxFriendQty) {
+        friends.push_back(id);
+      } else {
+        // Too many friends: let's re-select them using the heuristic
+        candidates.clear();
+        candidates.push_back(DistNodePair(space->IndexTimeDistance(data_[n], obj), id));
+        for (unsigned f: friends) {
+          candidates.push_back(DistNodePair(space->IndexTimeDistance(data_[n], data_[f]), f));
+        }
+        SelectNeighbors(space, candidates, maxFriendQty, friends);
+      }
+    }
+  }
+
+  if (level > maxLevel) {
+    EnterPoint_ = id;
+    MaxLevel_   = level;
+  }
+}
+
+template <typename dist_t>
+void Hnsw<dist_t>::Search(RangeQuery<dist_t>* query) {
+  throw runtime_error("Range search is not supported!");
+}
+
+/*
+ * The graph is read-only after indexing, thus, the search doesn't lock nodes.
+ */
+template <typename dist_t>
+void Hnsw<dist_t>::Search(KNNQuery<dist_t>* query) {
+  if (nodes_.empty()) return;
+
+  auto distFunc = [query, this](unsigned n) -> dist_t {
+    return query->DistanceObjLeft(data_[n]);
+  };
+
+  unsigned  curr     = EnterPoint_;
+  dist_t    currDist = distFunc(curr);
+
+  for (int lev = MaxLevel_; lev > 0; --lev) {
+    GreedySearchLevel(distFunc, lev, false, curr, currDist);
+  }
+
+  VisitedListHolder   visitedHolder(*VisitedListPool_);
+  FarthestQueue       top;
+
+  SearchLevel(distFunc, 0, false, curr, currDist,
+              std::max(efSearch_, static_cast<size_t>(query->GetK())),
+              visitedHolder.GetList(), top);
+
+  while (!top.empty()) {
+    query->CheckAndAddToResult(top.top().first, data_[top.top().second]);
+    top.pop();
+  }
+}
+
+template class Hnsw<float>;
+template class Hnsw<double>;
+template class Hnsw<int>;
+
+}
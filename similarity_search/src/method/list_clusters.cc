@@ -189,6 +189,71 @@ void ListClusters<dist_t>::Search(KNNQuery<dist_t>* query) {
   GenSearch(query);
 }
 
+template <typename dist_t>
+void ListClusters<dist_t>::SearchBatch(vector<RangeQuery<dist_t>*>& queries) {
+  GenSearchBatch(queries);
+}
+
+template <typename dist_t>
+void ListClusters<dist_t>::SearchBatch(vector<KNNQuery<dist_t>*>& queries) {
+  GenSearchBatch(queries);
+}
+
+/*
+ * Clusters are visited in the same order for all queries. Hence, we can
+ * process the list cluster by cluster: each bucket is compared against
+ * all the queries that need it, while it is in cache. For every query, 
+ * the sequence of steps is exactly the same as in GenSearch.
+ */
+template <typename dist_t>
+template <typename QueryType>
+void ListClusters<dist_t>::GenSearchBatch(vector<QueryType*>& queries) {
+  if (MaxLeavesToVisit_ != FAKE_MAX_LEAVES_TO_VISIT) {
+    // Early termination relies on a per-query priority queue
+    for (QueryType* query : queries) GenSearch(query);
+    return;
+  }
+
+  vector<QueryType*>  active(queries);
+  vector<QueryType*>  visit;
+  vector<dist_t>      VisitDist;
+
+  for (const auto& cluster : cluster_list_) {
+    if (active.empty()) break;
+
+    visit.clear();
+    VisitDist.clear();
+
+    for (QueryType* query : active) {
+      const dist_t dist_qc = query->DistanceObjLeft(cluster->GetCenter());
+      query->CheckAndAddToResult(dist_qc, cluster->GetCenter());
+
+      if (dist_qc - query->Radius() < cluster->GetCoveringRadius()) {
+        visit.push_back(query);
+        VisitDist.push_back(dist_qc);
+      }
+    }
+
+    cluster->SearchBatch(visit);
+
+    /* 
+     * If the query ball is inside the current cluster, all the
+     * query points have been found already (see GenSearch).
+     */
+    size_t ActiveQty = 0, VisitPos = 0;
+    for (QueryType* query : active) {
+      // visited queries are a subsequence of active ones
+      if (VisitPos < visit.size() && visit[VisitPos] == query) {
+        bool bInside = VisitDist[VisitPos] + query->Radius() < cluster->GetCoveringRadius();
+        ++VisitPos;
+        if (bInside) continue;
+      }
+      active[ActiveQty++] = query;
+    }
+    active.resize(ActiveQty);
+  }
+}
+
 template <typename dist_t>
 template <typename QueryType>
 void ListClusters<dist_t>::GenSearch(QueryType* query) {
@@ -350,6 +415,16 @@ void ListClusters<dist_t>::Cluster::Search(QueryType* query) const {
   }
 }
 
+template <typename dist_t>
+template <typename QueryType>
+void ListClusters<dist_t>::Cluster::SearchBatch(const vector<QueryType*>& queries) const {
+  for (QueryType* query : queries) {
+    for (const auto& object : (*bucket_)) {
+      query->CheckAndAddToResult(object);
+    }
+  }
+}
+
 template class ListClusters<double>;
 template class ListClusters<float>;
 template class ListClusters<int>;
@@ -14,6 +14,7 @@
  *
  */
 
+#include <cmath>
 #include <limits>
 
 #include "space.h"
@@ -38,22 +39,16 @@ MultiProbeLSH<dist_t>::MultiProbeLSH(const Space<dist_t>* space,
                                      unsigned T,
                                      unsigned H,
                                      int    M,
-                                     float  W)
-    : data_(data) {
+                                     float  W,
+                                     unsigned RangeT,
+                                     float    RangeRecall)
+    : data_(data), matrix_(data),
+      RangeT_(RangeT), RangeRecall_(RangeRecall),
+      RangeQueryQty_(0), RangeRecallSum_(0) {
   int is_float = std::is_same<float,dist_t>::value;
   CHECK(is_float);
   CHECK(sizeof(dist_t) == sizeof(float));
-  CHECK(!data.empty());
-  const size_t datalength = data[0]->datalength();
-  dim_ = static_cast<int>(datalength / sizeof(float));
-  matrix_ = new lshkit::FloatMatrix(dim_, static_cast<int>(data.size()));
-  for (size_t i = 0; i < data.size(); ++i) {
-    CHECK(datalength == data[i]->datalength());
-    const float* x = reinterpret_cast<const float*>(data[i]->data());
-    for (int j = 0; j < dim_; ++j) {
-      (*matrix_)[i][j] = x[j];
-    }
-  }
+  dim_ = matrix_.getDim();
   T_ = T;
 
   if (W <= 0) {
@@ -64,7 +59,7 @@ MultiProbeLSH<dist_t>::MultiProbeLSH(const Space<dist_t>* space,
 #ifdef TUNE_MPLSH_PARAMS
   R_ = R;
 
-  const std::string fit_data = lshkit::FitData(*matrix_, N1, P, Q, K, F);
+  const std::string fit_data = lshkit::FitData(matrix_, N1, P, Q, K, F);
 
   lshkit::MPLSHTune(N2, fit_data, T_, L, R, K, M, W);
 #endif
@@ -77,8 +72,13 @@ MultiProbeLSH<dist_t>::MultiProbeLSH(const Space<dist_t>* space,
   LOG(LIB_INFO) << "R (desired recall) :      "  << R;
   LOG(LIB_INFO) << "P (# of sample pairs) :   "  << P;
   LOG(LIB_INFO) << "Q (# of sample queries) : "  << Q;
+  LOG(LIB_INFO) << "rangeT :                  "  << RangeT_;
+  LOG(LIB_INFO) << "rangeRecall :             "  << RangeRecall_;
+
+  if (RangeT_ == 0 || RangeT_ > lshkit::Probe::MAX_T) {
+    LOG(LIB_FATAL) << "rangeT should be in [1," << static_cast<unsigned>(lshkit::Probe::MAX_T) << "]";
+  }
 
-  lshkit::FloatMatrix::Accessor accessor(*matrix_);
   LshIndexType::Parameter param;
   param.W = W;
   param.range = H;
@@ -89,14 +89,15 @@ MultiProbeLSH<dist_t>::MultiProbeLSH(const Space<dist_t>* space,
   index_ = new LshIndexType;
   index_->init(param, rng, L);
 
-  for (int i = 0; i < matrix_->getSize(); ++i) {
-    index_->insert(i, (*matrix_)[i]);
+  for (int i = 0; i < matrix_.getSize(); ++i) {
+    index_->insert(i, matrix_[i]);
   }
+  // Hash tables are packed into contiguous arrays: no more insertions are possible
+  index_->freeze();
 }
 
 template <typename dist_t>
 MultiProbeLSH<dist_t>::~MultiProbeLSH() {
-  delete matrix_;
   delete index_;
 }
 
@@ -105,9 +106,73 @@ const std::string MultiProbeLSH<dist_t>::ToString() const {
   return "multiprobe lsh";
 }
 
+template <typename dist_t>
+vector<string> MultiProbeLSH<dist_t>::GetQueryTimeParamNames() const {
+  vector<string> names;
+  names.push_back("rangeT");
+  names.push_back("rangeRecall");
+  return names;
+}
+
+template <typename dist_t>
+void MultiProbeLSH<dist_t>::SetQueryTimeParamsInternal(AnyParamManager& pmgr) {
+  pmgr.GetParamOptional("rangeT", RangeT_);
+  pmgr.GetParamOptional("rangeRecall", RangeRecall_);
+  if (RangeT_ == 0 || RangeT_ > lshkit::Probe::MAX_T) {
+    LOG(LIB_FATAL) << "rangeT should be in [1," << static_cast<unsigned>(lshkit::Probe::MAX_T) << "]";
+  }
+  RangeQueryQty_ = 0;
+  RangeRecallSum_ = 0;
+}
+
+template <typename dist_t>
+vector<pair<string, double>> MultiProbeLSH<dist_t>::GetSearchStats() const {
+  vector<pair<string, double>> stats;
+  const uint64_t qty = RangeQueryQty_;
+  if (qty) {
+    stats.push_back(std::make_pair("Predicted range recall", 
+                                   static_cast<double>(RangeRecallSum_) / RANGE_RECALL_SCALE / qty));
+  }
+  return stats;
+}
+
+/*
+ * Passes candidates (each candidate only once) to the range query.
+ */
+template <typename dist_t>
+class LSHRangeScanner {
+ public:
+  LSHRangeScanner(const LSHObjectMatrix& matrix, const ObjectVector& data,
+                  RangeQuery<dist_t>* query, const float* q)
+      : accessor_(matrix), data_(data), dim_(matrix.getDim()), query_(query), q_(q) {}
+
+  void operator()(unsigned key) {
+    if (!accessor_.mark(key)) return;
+    query_->AddDistanceComputations(1);
+    query_->CheckAndAddToResult(sqrt(LSHMultiProbeLp(q_, accessor_(key), dim_)), data_[key]);
+  }
+
+ private:
+  LSHObjectMatrix::Accessor accessor_;
+  const ObjectVector&       data_;
+  int                       dim_;
+  RangeQuery<dist_t>*       query_;
+  const float*              q_;
+};
+
 template <typename dist_t>
 void MultiProbeLSH<dist_t>::Search(RangeQuery<dist_t>* query) {
-  LOG(LIB_FATAL) << "Not applicable";
+  const size_t datalength = query->QueryObject()->datalength();
+  const int dim = static_cast<int>(datalength / sizeof(float));
+  CHECK(dim == dim_);
+
+  const float* q = reinterpret_cast<const float*>(query->QueryObject()->data());
+
+  LSHRangeScanner<dist_t> range_scanner(matrix_, data_, query, q);
+  const float recall = index_->query_range(q, query->Radius(), RangeT_, RangeRecall_, range_scanner);
+
+  ++RangeQueryQty_;
+  RangeRecallSum_ += static_cast<uint64_t>(std::round(recall * RANGE_RECALL_SCALE));
 }
 
 template <typename dist_t>
@@ -118,9 +183,9 @@ void MultiProbeLSH<dist_t>::Search(KNNQuery<dist_t>* query) {
 
   const float* q = reinterpret_cast<const float*>(query->QueryObject()->data());
 
-  lshkit::FloatMatrix::Accessor accessor(*matrix_);
+  LSHObjectMatrix::Accessor accessor(matrix_);
   LSHMultiProbeLpSpace<dist_t> lp(dim_, query);
-  lshkit::TopkScanner<lshkit::FloatMatrix::Accessor, LSHMultiProbeLpSpace<dist_t>>
+  lshkit::TopkScanner<LSHObjectMatrix::Accessor, LSHMultiProbeLpSpace<dist_t>>
       query_scanner(accessor, lp, query->GetK());
   query_scanner.reset(q);
 
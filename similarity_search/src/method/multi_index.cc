@@ -109,17 +109,15 @@ void MultiIndex<dist_t>::Search(KNNQuery<dist_t>* query) {
     KNNQuery<dist_t> TmpRes(space_, query->QueryObject(), query->GetK(), query->GetEPS());
 
     indices_[i]->Search(&TmpRes);
-    unique_ptr<KNNQueue<dist_t>> ResQ(TmpRes.Result()->Clone());
 
     query->AddDistanceComputations(TmpRes.DistanceComputations());
-    while(!ResQ->Empty()) {
-      const Object* obj = reinterpret_cast<const Object*>(ResQ->TopObject());
+    for (const auto& elem: TmpRes.Result()->GetElements()) {
+      const Object* obj = elem.second;
 
       if (!found.count(obj->id())) {
-        query->CheckAndAddToResult(ResQ->TopDistance(), obj);
+        query->CheckAndAddToResult(elem.first, obj);
         found.insert(obj->id());
       }
-      ResQ->Pop();
     }
   }
 }
@@ -22,6 +22,7 @@
 #include "utils.h"
 #include "method/multi_vantage_point_tree_utils.h"
 #include "method/multi_vantage_point_tree.h"
+#include "method/parallel_tree_builder.h"
 
 namespace similarity {
 
@@ -34,13 +35,15 @@ MultiVantagePointTree<dist_t>::MultiVantagePointTree(
     MaxPathLength_(5),
     BucketSize_(50),
     ChunkBucket_(true),
-    MaxLeavesToVisit_(FAKE_MAX_LEAVES_TO_VISIT) {
+    MaxLeavesToVisit_(FAKE_MAX_LEAVES_TO_VISIT),
+    IndexThreadQty_(0) {
   AnyParamManager pmgr(MethParams);
 
   pmgr.GetParamOptional("maxPathLen", MaxPathLength_);
   pmgr.GetParamOptional("bucketSize", BucketSize_);
   pmgr.GetParamOptional("chunkBucket", ChunkBucket_);
   pmgr.GetParamOptional("maxLeavesToVisit", MaxLeavesToVisit_);
+  pmgr.GetParamOptional("indexThreadQty", IndexThreadQty_);
 
 
   if (BucketSize_ < 2) {
@@ -52,7 +55,17 @@ MultiVantagePointTree<dist_t>::MultiVantagePointTree(
   for (size_t i = 0; i < data.size(); ++i) {
     entries.push_back(Entry(data[i]));
   }
-  root_= BuildTree(space, entries);
+
+  unique_ptr<ParallelTreeBuilder> builder;
+  if (IndexThreadQty_ > 1) {
+    builder.reset(new ParallelTreeBuilder(static_cast<unsigned>(IndexThreadQty_), data.size()));
+  }
+
+  // The root is owned by unique_ptr until all subtrees are built: a failed task doesn't leak the tree
+  unique_ptr<Node> root(BuildTree(space, entries, builder.get()));
+
+  if (builder) builder->Finish();
+  root_ = root.release();
 }
 
 template <typename dist_t>
@@ -60,6 +73,19 @@ MultiVantagePointTree<dist_t>::~MultiVantagePointTree() {
   delete root_;
 }
 
+template <typename dist_t>
+vector<string> MultiVantagePointTree<dist_t>::GetQueryTimeParamNames() const {
+  vector<string> names;
+  names.push_back("maxLeavesToVisit");
+  return names;
+}
+
+template <typename dist_t>
+void MultiVantagePointTree<dist_t>::SetQueryTimeParamsInternal(AnyParamManager& pmgr) {
+  MaxLeavesToVisit_ = FAKE_MAX_LEAVES_TO_VISIT;
+  pmgr.GetParamOptional("maxLeavesToVisit", MaxLeavesToVisit_);
+}
+
 template <typename dist_t>
 const std::string MultiVantagePointTree<dist_t>::ToString() const {
   return "mvp-tree";
@@ -69,7 +95,8 @@ template <typename dist_t>
 typename MultiVantagePointTree<dist_t>::Node*
 MultiVantagePointTree<dist_t>::BuildTree(
     const Space<dist_t>* space,
-    typename MultiVantagePointTree<dist_t>::Entries& entries) {
+    typename MultiVantagePointTree<dist_t>::Entries& entries,
+    ParallelTreeBuilder* builder) {
   if (entries.empty()) {
     return NULL;
   }
@@ -102,30 +129,30 @@ MultiVantagePointTree<dist_t>::BuildTree(
     MultiVantagePointTree::Entries entry_list11, entry_list12;
     MultiVantagePointTree::Entries entry_list21, entry_list22;
     if (!entries.empty()) {
-      for (size_t i = 0; i < entries.size(); ++i) {
+      BuildParallelFor(builder, entries.size(), [this, &entries, space, pivot1](size_t i) {
         entries[i].d1 = space->IndexTimeDistance(pivot1, entries[i].object);
         if (entries[i].path.size() < MaxPathLength_) {
           entries[i].path.push_back(entries[i].d1);
         }
-      }
+      });
       std::sort(entries.begin(), entries.end(), Dist1AscComparator());
       CHECK(entries[0].d1 <= entries[entries.size() - 1].d1);
       // entries = elist1+elist2
       MultiVantagePointTree::Entries elist1, elist2;
       m1 = SplitByMedian(entries, elist1, elist2).d1;
       pivot2 = Remove(elist2, RandomInt() % elist2.size()).object;
-      for (size_t i = 0; i < elist1.size(); ++i) {
+      BuildParallelFor(builder, elist1.size(), [this, &elist1, space, pivot2](size_t i) {
         elist1[i].d2 = space->IndexTimeDistance(pivot2, elist1[i].object);
         if (elist1[i].path.size() < MaxPathLength_) {
           elist1[i].path.push_back(elist1[i].d2);
         }
-      }
-      for (size_t i = 0; i < elist2.size(); ++i) {
+      });
+      BuildParallelFor(builder, elist2.size(), [this, &elist2, space, pivot2](size_t i) {
         elist2[i].d2 = space->IndexTimeDistance(pivot2, elist2[i].object);
         if (elist2[i].path.size() < MaxPathLength_) {
           elist2[i].path.push_back(elist2[i].d2);
         }
-      }
+      });
       std::sort(elist1.begin(), elist1.end(), Dist2AscComparator());
       CHECK(elist1[0].d2 <= elist1[elist1.size() - 1].d2); 
       std::sort(elist2.begin(), elist2.end(), Dist2AscComparator());
@@ -134,10 +161,23 @@ MultiVantagePointTree<dist_t>::BuildTree(
       m22 = SplitByMedian(elist2, entry_list21, entry_list22).d2;
     }
     InternalNode* node = new InternalNode(pivot1, pivot2, m1, m21, m22);
-    node->child1_ = BuildTree(space, entry_list11);
-    node->child2_ = BuildTree(space, entry_list12);
-    node->child3_ = BuildTree(space, entry_list21);
-    node->child4_ = BuildTree(space, entry_list22);
+    // Small subtrees are queued: they will be created by the builder's threads
+    auto CreateChild = [&](Node*& child, Entries& ChildEntries) {
+      if (builder && ChildEntries.size() <= builder->GetSubtreeQty()) {
+        // Entries are moved rather than copied to the task
+        std::shared_ptr<Entries> pEntries(new Entries());
+        pEntries->swap(ChildEntries);
+        builder->AddSubtreeTask([this, space, pEntries, &child]() {
+          child = BuildTree(space, *pEntries, NULL);
+        });
+      } else {
+        child = BuildTree(space, ChildEntries, builder);
+      }
+    };
+    CreateChild(node->child1_, entry_list11);
+    CreateChild(node->child2_, entry_list12);
+    CreateChild(node->child3_, entry_list21);
+    CreateChild(node->child4_, entry_list22);
     return node;
   }
 }
@@ -41,17 +41,17 @@ PermBinVPTree<dist_t, RankCorrelDistFunc>::PermBinVPTree(
 {
   AnyParamManager pmgr(AllParams);
 
-  double        DbScanFrac   = 0.05;
   size_t        NumPivot     = 16;
+  db_scan_frac_  = 0.05;
   bin_threshold_ = 8;
 
-  pmgr.GetParamOptional("dbScanFrac", DbScanFrac);
+  pmgr.GetParamOptional("dbScanFrac", db_scan_frac_);
   pmgr.GetParamOptional("numPivot", NumPivot);
   pmgr.GetParamOptional("binThreshold", bin_threshold_);
 
   bin_perm_word_qty_ = (NumPivot + 31)/32;
 
-  if (DbScanFrac < 0.0 || DbScanFrac > 1.0) {
+  if (db_scan_frac_ < 0.0 || db_scan_frac_ > 1.0) {
     LOG(LIB_FATAL) << METH_PERM_BIN_VPTREE << " requires that dbScanFrac is in the range [0,1]";
   }
 
@@ -60,7 +60,7 @@ PermBinVPTree<dist_t, RankCorrelDistFunc>::PermBinVPTree(
   LOG(LIB_INFO) << "# pivots                  = " << NumPivot;
   LOG(LIB_INFO) << "# binarization threshold = "  << bin_threshold_;
   LOG(LIB_INFO) << "# binary entry size (words) = "  << bin_perm_word_qty_;
-  LOG(LIB_INFO) << "db scan fraction = " << DbScanFrac;
+  LOG(LIB_INFO) << "db scan fraction = " << db_scan_frac_;
 
   double AlphaLeft = 1.0, AlphaRight = 1.0;
 
@@ -76,8 +76,7 @@ PermBinVPTree<dist_t, RankCorrelDistFunc>::PermBinVPTree(
                          "alphaRight",
                         });
 
-  // db_can_qty_ should always be > 0
-  db_scan_qty_ = max(size_t(1), static_cast<size_t>(DbScanFrac * data.size())),
+  ComputeDbScanQty(db_scan_frac_);
   GetPermutationPivot(data, space, NumPivot, &pivots_);
   BinPermData_.resize(data.size());
 
@@ -105,6 +104,21 @@ PermBinVPTree<dist_t, RankCorrelDistFunc>::PermBinVPTree(
                                     );
 }
 
+template <typename dist_t, PivotIdType (*RankCorrelDistFunc)(const PivotIdType*, const PivotIdType*, size_t)>
+void 
+PermBinVPTree<dist_t, RankCorrelDistFunc>::SetQueryTimeParamsInternal(AnyParamManager& pmgr) {
+  pmgr.GetParamOptional("dbScanFrac", db_scan_frac_);  
+  ComputeDbScanQty(db_scan_frac_);
+}
+
+template <typename dist_t, PivotIdType (*RankCorrelDistFunc)(const PivotIdType*, const PivotIdType*, size_t)>
+vector<string>
+PermBinVPTree<dist_t, RankCorrelDistFunc>::GetQueryTimeParamNames() const {
+  vector<string> names;
+  names.push_back("dbScanFrac");
+  return names;
+}    
+
 template <typename dist_t, PivotIdType (*RankCorrelDistFunc)(const PivotIdType*, const PivotIdType*, size_t)>
 PermBinVPTree<dist_t, RankCorrelDistFunc>::~PermBinVPTree() {
   for (size_t i = 0; i < data_.size(); ++i) {
@@ -136,12 +150,9 @@ void PermBinVPTree<dist_t, RankCorrelDistFunc>::Search(RangeQuery<dist_t>* query
 
   VPTreeIndex_->Search(VPTreeQuery.get());
 
-  unique_ptr<KNNQueue<int>> ResQueue(VPTreeQuery->Result()->Clone());
-
-  while (!ResQueue->Empty()) {
-      size_t id = reinterpret_cast<const Object*>(ResQueue->TopObject())->id();
+  for (const auto& elem: VPTreeQuery->Result()->GetElements()) {
+      size_t id = elem.second->id();
       query->CheckAndAddToResult(data_[id]);
-      ResQueue->Pop();
   }
 }
 
@@ -160,12 +171,9 @@ void PermBinVPTree<dist_t, RankCorrelDistFunc>::Search(KNNQuery<dist_t>* query)
 
   VPTreeIndex_->Search(VPTreeQuery.get());
 
-  unique_ptr<KNNQueue<int>> ResQueue(VPTreeQuery->Result()->Clone());
-
-  while (!ResQueue->Empty()) {
-      size_t id = reinterpret_cast<const Object*>(ResQueue->TopObject())->id();
+  for (const auto& elem: VPTreeQuery->Result()->GetElements()) {
+      size_t id = elem.second->id();
       query->CheckAndAddToResult(data_[id]);
-      ResQueue->Pop();
   }
 }
 
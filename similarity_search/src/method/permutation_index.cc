@@ -16,10 +16,12 @@
 
 #include <algorithm>
 #include <sstream>
+#include <fstream>
 
 #include "space.h"
 #include "rangequery.h"
 #include "knnquery.h"
+#include "index_io.h"
 #include "method/permutation_index.h"
 #include "utils.h"
 
@@ -31,26 +33,68 @@ PermutationIndex<dist_t>::PermutationIndex(
     const ObjectVector& data,
     const size_t num_pivot,
     const double db_scan_fraction,
-    const IntDistFuncPtr permfunc)
+    const IntDistFuncPtr permfunc,
+    bool BuildIndex)
     : data_(data),   // reference
-      db_scan_(max(size_t(1), static_cast<size_t>(db_scan_fraction * data.size()))),
       permfunc_(permfunc) {
-  CHECK(db_scan_fraction > 0.0);
-  CHECK(db_scan_fraction <= 1.0);
+  ComputeDbScan(db_scan_fraction);
   CHECK(permfunc != NULL);
+  LOG(LIB_INFO) << "# pivots         = " << num_pivot;
+  LOG(LIB_INFO) << "db scan fraction = " << db_scan_fraction;
+  if (!BuildIndex) return;
   GetPermutationPivot(data, space, num_pivot, &pivot_);
   permtable_.resize(data.size());
   for (size_t i = 0; i < data.size(); ++i) {
     GetPermutation(pivot_, space, data[i], &permtable_[i]);
   }
-  LOG(LIB_INFO) << "# pivots         = " << num_pivot;
-  LOG(LIB_INFO) << "db scan fraction = " << db_scan_fraction;
+}
+
+template <typename dist_t>
+void PermutationIndex<dist_t>::SaveIndex(const string& location) {
+  std::ofstream out;
+  OpenIndexFileForWriting(location, out);
+  WriteIndexHeader(out, METH_PERMUTATION, data_.size());
+
+  WriteObjectPositions(out, ObjectPositionMap(data_), pivot_);
+  // permtable_ has one entry per data point, see the constructor
+  for (const Permutation& perm: permtable_) WriteBinaryVector(out, perm);
+  out.close();
+}
+
+template <typename dist_t>
+void PermutationIndex<dist_t>::LoadIndex(const string& location) {
+  std::ifstream in;
+  OpenIndexFileForReading(location, in);
+  ReadIndexHeader(in, METH_PERMUTATION, data_.size());
+
+  ReadObjectPositions(in, data_, pivot_);
+  permtable_.resize(data_.size());
+  for (Permutation& perm: permtable_) {
+    ReadBinaryVector(in, perm);
+    if (perm.size() != pivot_.size()) {
+      throw runtime_error("Corrupt index file: the permutation size doesn't match the number of pivots");
+    }
+  }
 }
 
 template <typename dist_t>
 PermutationIndex<dist_t>::~PermutationIndex() {
 }
 
+template <typename dist_t>
+void PermutationIndex<dist_t>::SetQueryTimeParamsInternal(AnyParamManager& pmgr) {
+  double db_scan_fraction = db_scan_frac_;
+  pmgr.GetParamOptional("dbScanFrac", db_scan_fraction);
+  ComputeDbScan(db_scan_fraction);
+}
+
+template <typename dist_t>
+vector<string> PermutationIndex<dist_t>::GetQueryTimeParamNames() const {
+  vector<string> names;
+  names.push_back("dbScanFrac");
+  return names;
+}
+
 template <typename dist_t>
 const std::string PermutationIndex<dist_t>::ToString() const {
   std::stringstream str;
@@ -205,16 +205,9 @@ void PermutationVPTree<dist_t, RankCorrelDistFunc>::Search(RangeQuery<dist_t>* q
 #endif
   VPTreeIndex_->Search(VPTreeQuery.get());
 
-#ifdef USE_VPTREE_SAMPLE
-  unique_ptr<KNNQueue<PivotIdType>> ResQueue(VPTreeQuery->Result()->Clone());
-#else
-  unique_ptr<KNNQueue<float>> ResQueue(VPTreeQuery->Result()->Clone());
-#endif
-
-  while (!ResQueue->Empty()) {
-      size_t id = reinterpret_cast<const Object*>(ResQueue->TopObject())->id();
+  for (const auto& elem: VPTreeQuery->Result()->GetElements()) {
+      size_t id = elem.second->id();
       query->CheckAndAddToResult(data_[id]);
-      ResQueue->Pop();
   }
 }
 
@@ -238,16 +231,9 @@ void PermutationVPTree<dist_t, RankCorrelDistFunc>::Search(KNNQuery<dist_t>* que
 #endif
   VPTreeIndex_->Search(VPTreeQuery.get());
 
-#ifdef USE_VPTREE_SAMPLE
-  unique_ptr<KNNQueue<PivotIdType>> ResQueue(VPTreeQuery->Result()->Clone());
-#else
-  unique_ptr<KNNQueue<float>> ResQueue(VPTreeQuery->Result()->Clone());
-#endif
-
-  while (!ResQueue->Empty()) {
-      size_t id = reinterpret_cast<const Object*>(ResQueue->TopObject())->id();
+  for (const auto& elem: VPTreeQuery->Result()->GetElements()) {
+      size_t id = elem.second->id();
       query->CheckAndAddToResult(data_[id]);
-      ResQueue->Pop();
   }
 }
 
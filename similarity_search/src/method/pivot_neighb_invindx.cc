@@ -19,11 +19,13 @@
 #include <thread>
 #include <memory>
 #include <unordered_map>
+#include <fstream>
 
 #include "space.h"
 #include "rangequery.h"
 #include "knnquery.h"
 #include "incremental_quick_select.h"
+#include "index_io.h"
 #include "method/pivot_neighb_invindx.h"
 #include "utils.h"
 
@@ -125,7 +127,8 @@ template <typename dist_t>
 PivotNeighbInvertedIndex<dist_t>::PivotNeighbInvertedIndex(
     const Space<dist_t>* space,
     const ObjectVector& data,
-    const AnyParams& AllParams) 
+    const AnyParams& AllParams,
+    bool BuildIndex) 
 : data_(data),   // reference
   space_(space), // pointer
   chunk_index_size_(65536),
@@ -164,6 +167,8 @@ PivotNeighbInvertedIndex<dist_t>::PivotNeighbInvertedIndex(
   
   SetQueryTimeParamsInternal(pmgr);
 
+  if (!BuildIndex) return;
+
   GetPermutationPivot(data_, space_, num_pivot_, &pivot_);
 
   posting_lists_.resize(indexQty);
@@ -203,6 +208,71 @@ PivotNeighbInvertedIndex<dist_t>::PivotNeighbInvertedIndex(
   }
 }
 
+/*
+ * Parameters that define the index structure are saved together with
+ * the index. When the index is loaded, they override parameters
+ * specified by the user.
+ */
+template <typename dist_t>
+void 
+PivotNeighbInvertedIndex<dist_t>::SaveIndex(const string& location) {
+  std::ofstream out;
+  OpenIndexFileForWriting(location, out);
+  WriteIndexHeader(out, METH_PIVOT_NEIGHB_INVINDEX, data_.size());
+
+  WriteBinaryPOD(out, static_cast<uint64_t>(chunk_index_size_));
+  WriteBinaryPOD(out, static_cast<uint64_t>(num_pivot_));
+  WriteBinaryPOD(out, static_cast<uint64_t>(num_prefix_));
+  WriteObjectPositions(out, ObjectPositionMap(data_), pivot_);
+
+  WriteBinaryPOD(out, static_cast<uint64_t>(posting_lists_.size()));
+  for (const auto& chunkPostLists: posting_lists_) {
+    CHECK(chunkPostLists->size() == num_pivot_);
+    for (const PostingListInt& p: *chunkPostLists) WriteBinaryVector(out, p);
+  }
+  out.close();
+}
+
+template <typename dist_t>
+void 
+PivotNeighbInvertedIndex<dist_t>::LoadIndex(const string& location) {
+  std::ifstream in;
+  OpenIndexFileForReading(location, in);
+  ReadIndexHeader(in, METH_PIVOT_NEIGHB_INVINDEX, data_.size());
+
+  uint64_t chunkIndexSize, numPivot, numPrefix, indexQty;
+  ReadBinaryPOD(in, chunkIndexSize);
+  ReadBinaryPOD(in, numPivot);
+  ReadBinaryPOD(in, numPrefix);
+
+  if (!chunkIndexSize || numPrefix > numPivot) {
+    throw runtime_error("Corrupt index file: invalid index parameters");
+  }
+  chunk_index_size_ = chunkIndexSize;
+  num_pivot_        = numPivot;
+  num_prefix_       = numPrefix;
+
+  ReadObjectPositions(in, data_, pivot_);
+  if (pivot_.size() != num_pivot_) {
+    throw runtime_error("Corrupt index file: the number of pivots doesn't match numPivot");
+  }
+
+  ReadBinaryPOD(in, indexQty);
+  if (indexQty != (data_.size() + chunk_index_size_ - 1) / chunk_index_size_) {
+    throw runtime_error("Corrupt index file: unexpected number of index chunks");
+  }
+  posting_lists_.resize(indexQty);
+  for (auto& chunkPostLists: posting_lists_) {
+    chunkPostLists = shared_ptr<vector<PostingListInt>>(new vector<PostingListInt>(num_pivot_));
+    for (PostingListInt& p: *chunkPostLists) ReadBinaryVector(in, p);
+  }
+
+  LOG(LIB_INFO) << "# of entries in an index chunk  = " << chunk_index_size_;
+  LOG(LIB_INFO) << "# of index chunks  = " << indexQty;
+  LOG(LIB_INFO) << "# pivots      = " << num_pivot_;
+  LOG(LIB_INFO) << "# prefix (K)  = " << num_prefix_;
+}
+
 template <typename dist_t>
 void 
 PivotNeighbInvertedIndex<dist_t>::IndexChunk(size_t chunkId) {
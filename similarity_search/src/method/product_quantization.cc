@@ -0,0 +1,353 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#include <random>
+#include <thread>
+#include <numeric>
+#include <algorithm>
+
+#include "space.h"
+#include "space/space_lp.h"
+#include "knnquery.h"
+#include "knnqueue.h"
+#include "rangequery.h"
+#include "distcomp.h"
+#include "index_io.h"
+#include "utils.h"
+#include "method/product_quantization.h"
+
+namespace similarity {
+
+using std::thread;
+
+namespace {
+
+/*
+ * Calls f(i) for each i in [0, qty), the i-th call is
+ * carried out by the thread number i % ThreadQty.
+ */
+template <typename Func>
+void ParallelFor(size_t qty, size_t ThreadQty, const Func& f) {
+  if (ThreadQty <= 1) {
+    for (size_t i = 0; i < qty; ++i) f(i);
+    return;
+  }
+  vector<thread> threads(ThreadQty);
+  for (size_t t = 0; t < ThreadQty; ++t) {
+    threads[t] = thread([&f, qty, ThreadQty, t]() {
+      for (size_t i = t; i < qty; i += ThreadQty) f(i);
+    });
+  }
+  for (thread& t: threads) t.join();
+}
+
+template <typename dist_t>
+size_t NearestCentroid(const dist_t* pVect, const dist_t* pCentroids, size_t centroidQty, size_t subDim) {
+  size_t  best = 0;
+  dist_t  bestDist = L2SqrSIMD(pVect, pCentroids, subDim);
+  for (size_t c = 1; c < centroidQty; ++c) {
+    dist_t d = L2SqrSIMD(pVect, pCentroids + c * subDim, subDim);
+    if (d < bestDist) {
+      bestDist = d;
+      best = c;
+    }
+  }
+  return best;
+}
+
+// The squared L2 distance between the query and the data point approximated using the table
+template <typename dist_t>
+inline dist_t ADCDistance(const dist_t* pTable, const uint8_t* pCodes, size_t subVectQty, size_t centroidQty) {
+  dist_t sum = 0;
+  for (size_t m = 0; m < subVectQty; ++m, pTable += centroidQty) {
+    sum += pTable[pCodes[m]];
+  }
+  return sum;
+}
+
+}
+
+template <typename dist_t>
+ProductQuantization<dist_t>::ProductQuantization(const Space<dist_t>* space,
+                                                 const ObjectVector& data,
+                                                 const AnyParams& MethParams,
+                                                 bool BuildIndex) :
+                                                 data_(data),
+                                                 dim_(0),
+                                                 subVectQty_(8),
+                                                 centroidQty_(256),
+                                                 trainSampleQty_(65536),
+                                                 iterQty_(10),
+                                                 shortListQty_(100),
+                                                 indexThreadQty_(0)
+{
+  const SpaceLp<dist_t>* L2Space = dynamic_cast<const SpaceLp<dist_t>*>(space);
+  if (L2Space == NULL || L2Space->getP() != 2) {
+    LOG(LIB_FATAL) << METH_PQ << " works only with the dense vector space " << SPACE_L2;
+  }
+
+  AnyParamManager pmgr(MethParams);
+
+  pmgr.GetParamOptional("subVectQty",     subVectQty_);
+  pmgr.GetParamOptional("centroidQty",    centroidQty_);
+  pmgr.GetParamOptional("trainSampleQty", trainSampleQty_);
+  pmgr.GetParamOptional("iterQty",        iterQty_);
+  pmgr.GetParamOptional("shortListQty",   shortListQty_);
+  pmgr.GetParamOptional("indexThreadQty", indexThreadQty_);
+
+  if (centroidQty_ < 1 || centroidQty_ > 256) {
+    LOG(LIB_FATAL) << METH_PQ << " requires that centroidQty is in the range [1,256]";
+  }
+
+  LOG(LIB_INFO) << "subVectQty          = " << subVectQty_;
+  LOG(LIB_INFO) << "centroidQty         = " << centroidQty_;
+  LOG(LIB_INFO) << "trainSampleQty      = " << trainSampleQty_;
+  LOG(LIB_INFO) << "iterQty             = " << iterQty_;
+  LOG(LIB_INFO) << "shortListQty        = " << shortListQty_;
+  LOG(LIB_INFO) << "indexThreadQty      = " << indexThreadQty_;
+
+  if (!BuildIndex || data.empty()) return;
+
+  dim_ = data[0]->datalength() / sizeof(dist_t);
+  for (const Object* obj: data) GetVector(obj); // Checks the dimensionality
+
+  if (subVectQty_ < 1 || subVectQty_ > dim_) {
+    LOG(LIB_FATAL) << METH_PQ << " requires that subVectQty is in the range [1," << dim_ << "]";
+  }
+  centroidQty_ = min(centroidQty_, data.size());
+
+  /*
+   * The training sample is stratified: we select one random point from
+   * each of SampleQty equal-size chunks of the data set. Thus, sampled points
+   * are distinct and we don't need to keep a permutation of the whole data set.
+   */
+  const size_t SampleQty = max(centroidQty_, min(trainSampleQty_, data.size()));
+  vector<size_t> sample(SampleQty);
+  for (size_t i = 0; i < SampleQty; ++i) {
+    size_t start = i * data.size() / SampleQty;
+    size_t end   = (i + 1) * data.size() / SampleQty;
+    sample[i] = start + static_cast<size_t>(RandomInt()) % (end - start);
+  }
+
+  // Each sub-vector has its own generator, so the codebooks don't depend on the number of threads
+  vector<unsigned> seeds(subVectQty_);
+  for (unsigned& seed: seeds) seed = RandomInt();
+
+  centroids_.resize(centroidQty_ * dim_);
+  ParallelFor(subVectQty_, indexThreadQty_,
+              [this, &sample, &seeds](size_t m) { TrainSubVect(m, sample, seeds[m]); });
+  LOG(LIB_INFO) << "Codebooks are trained using " << SampleQty << " data points";
+
+  const size_t BlockSize = 4096;
+  codes_.resize(data.size() * subVectQty_);
+  ParallelFor((data.size() + BlockSize - 1) / BlockSize, indexThreadQty_,
+              [this, BlockSize](size_t b) {
+                EncodeRange(b * BlockSize, min(data_.size(), (b + 1) * BlockSize));
+              });
+  LOG(LIB_INFO) << "Code size: " << codes_.size() << " bytes";
+}
+
+template <typename dist_t>
+ProductQuantization<dist_t>::~ProductQuantization() {
+}
+
+template <typename dist_t>
+const dist_t* ProductQuantization<dist_t>::GetVector(const Object* obj) const {
+  if (obj->datalength() != dim_ * sizeof(dist_t)) {
+    std::stringstream err;
+    err << METH_PQ << " expects vectors of the dimensionality " << dim_
+        << ", but got a vector of the dimensionality " << obj->datalength() / sizeof(dist_t);
+    throw runtime_error(err.str());
+  }
+  return reinterpret_cast<const dist_t*>(obj->data());
+}
+
+template <typename dist_t>
+void ProductQuantization<dist_t>::TrainSubVect(size_t m, const vector<size_t>& sample, unsigned seed) {
+  const size_t start = SubVectStart(m);
+  const size_t subDim = SubVectStart(m + 1) - start;
+  const size_t SampleQty = sample.size();
+
+  // Sub-vectors are copied to contiguous memory, so that k-means iterations don't miss the cache
+  vector<dist_t> points(SampleQty * subDim);
+  for (size_t i = 0; i < SampleQty; ++i) {
+    const dist_t* pVect = GetVector(data_[sample[i]]) + start;
+    copy(pVect, pVect + subDim, &points[i * subDim]);
+  }
+
+  std::mt19937 gen(seed);
+
+  // Initial centroids are distinct sample points
+  dist_t* pCentroids = &centroids_[centroidQty_ * start];
+  vector<size_t> perm(SampleQty);
+  std::iota(perm.begin(), perm.end(), 0);
+  for (size_t c = 0; c < centroidQty_; ++c) {
+    std::swap(perm[c], perm[c + gen() % (SampleQty - c)]);
+    copy(&points[perm[c] * subDim], &points[perm[c] * subDim] + subDim, pCentroids + c * subDim);
+  }
+
+  vector<dist_t> sums(centroidQty_ * subDim);
+  vector<size_t> counts(centroidQty_);
+
+  for (size_t iter = 0; iter < iterQty_; ++iter) {
+    fill(sums.begin(), sums.end(), 0);
+    fill(counts.begin(), counts.end(), 0);
+
+    for (size_t i = 0; i < SampleQty; ++i) {
+      const dist_t* pVect = &points[i * subDim];
+      size_t c = NearestCentroid(pVect, pCentroids, centroidQty_, subDim);
+      counts[c]++;
+      for (size_t k = 0; k < subDim; ++k) sums[c * subDim + k] += pVect[k];
+    }
+
+    for (size_t c = 0; c < centroidQty_; ++c) {
+      if (counts[c]) {
+        for (size_t k = 0; k < subDim; ++k) pCentroids[c * subDim + k] = sums[c * subDim + k] / counts[c];
+      } else {
+        // An empty cluster gets a new random centroid
+        const dist_t* pVect = &points[(gen() % SampleQty) * subDim];
+        copy(pVect, pVect + subDim, pCentroids + c * subDim);
+      }
+    }
+  }
+}
+
+template <typename dist_t>
+void ProductQuantization<dist_t>::EncodeRange(size_t start, size_t end) {
+  for (size_t i = start; i < end; ++i) {
+    const dist_t* pVect = GetVector(data_[i]);
+    for (size_t m = 0; m < subVectQty_; ++m) {
+      const size_t subDim = SubVectStart(m + 1) - SubVectStart(m);
+      codes_[i * subVectQty_ + m] = static_cast<uint8_t>(
+                NearestCentroid(pVect + SubVectStart(m), SubVectCentroids(m), centroidQty_, subDim));
+    }
+  }
+}
+
+template <typename dist_t>
+void ProductQuantization<dist_t>::ComputeDistTable(const Object* query, vector<dist_t>& table) const {
+  const dist_t* pQuery = GetVector(query);
+
+  table.resize(subVectQty_ * centroidQty_);
+  for (size_t m = 0; m < subVectQty_; ++m) {
+    const size_t  subDim = SubVectStart(m + 1) - SubVectStart(m);
+    const dist_t* pCentroids = SubVectCentroids(m);
+    for (size_t c = 0; c < centroidQty_; ++c) {
+      table[m * centroidQty_ + c] = L2SqrSIMD(pQuery + SubVectStart(m), pCentroids + c * subDim, subDim);
+    }
+  }
+}
+
+/*
+ * ShortListQty data points with the smallest approximate distances are verified.
+ * Data points whose approximate squared distance doesn't exceed MaxADCDist
+ * are verified as well (a negative value means that there are no such points).
+ */
+template <typename dist_t>
+template <typename QueryType>
+void ProductQuantization<dist_t>::GenSearch(QueryType* query, size_t ShortListQty, dist_t MaxADCDist) const {
+  if (data_.empty()) return;
+
+  vector<dist_t> table;
+  ComputeDistTable(query->QueryObject(), table);
+
+  const uint8_t* pCodes = &codes_[0];
+
+  ObjectVector      candidates;
+  KNNQueue<dist_t>  shortList(ShortListQty);
+  for (size_t i = 0; i < data_.size(); ++i, pCodes += subVectQty_) {
+    const dist_t d = ADCDistance(&table[0], pCodes, subVectQty_, centroidQty_);
+    if (d <= MaxADCDist) {
+      candidates.push_back(data_[i]);
+    } else {
+      shortList.Push(d, data_[i]);
+    }
+  }
+
+  candidates.reserve(candidates.size() + shortList.Size());
+  while (!shortList.Empty()) candidates.push_back(shortList.Pop());
+  query->CheckAndAddToResult(candidates);
+}
+
+template <typename dist_t>
+void ProductQuantization<dist_t>::Search(RangeQuery<dist_t>* query) {
+  // Quantization errors may overestimate distances, hence, the short list is verified as well
+  GenSearch(query, shortListQty_, query->Radius() * query->Radius());
+}
+
+template <typename dist_t>
+void ProductQuantization<dist_t>::Search(KNNQuery<dist_t>* query) {
+  GenSearch(query, max(shortListQty_, static_cast<size_t>(query->GetK())), static_cast<dist_t>(-1));
+}
+
+template <typename dist_t>
+void ProductQuantization<dist_t>::SaveIndex(const string& location) {
+  std::ofstream out;
+  OpenIndexFileForWriting(location, out);
+  WriteIndexHeader(out, METH_PQ, data_.size());
+
+  WriteBinaryPOD(out, static_cast<uint64_t>(dim_));
+  WriteBinaryPOD(out, static_cast<uint64_t>(subVectQty_));
+  WriteBinaryPOD(out, static_cast<uint64_t>(centroidQty_));
+  WriteBinaryVector(out, centroids_);
+  WriteBinaryVector(out, codes_);
+  out.close();
+}
+
+template <typename dist_t>
+void ProductQuantization<dist_t>::LoadIndex(const string& location) {
+  std::ifstream in;
+  OpenIndexFileForReading(location, in);
+  ReadIndexHeader(in, METH_PQ, data_.size());
+
+  uint64_t dim, subVectQty, centroidQty;
+  ReadBinaryPOD(in, dim);
+  ReadBinaryPOD(in, subVectQty);
+  ReadBinaryPOD(in, centroidQty);
+  dim_         = dim;
+  subVectQty_  = subVectQty;
+  centroidQty_ = centroidQty;
+  if (centroidQty_ < 1 || centroidQty_ > 256 || subVectQty_ < 1 || subVectQty_ > dim_) {
+    throw runtime_error("Corrupt index file: wrong quantization parameters");
+  }
+  ReadBinaryVector(in, centroids_);
+  ReadBinaryVector(in, codes_);
+  if (centroids_.size() != centroidQty_ * dim_ || codes_.size() != data_.size() * subVectQty_) {
+    throw runtime_error("Corrupt index file: the size of codebooks or codes doesn't match quantization parameters");
+  }
+  for (const Object* obj: data_) GetVector(obj);
+}
+
+template <typename dist_t>
+void ProductQuantization<dist_t>::SetQueryTimeParamsInternal(AnyParamManager& pmgr) {
+  pmgr.GetParamOptional("shortListQty", shortListQty_);
+}
+
+template <typename dist_t>
+vector<string> ProductQuantization<dist_t>::GetQueryTimeParamNames() const {
+  vector<string> names;
+  names.push_back("shortListQty");
+  return names;
+}
+
+template <typename dist_t>
+const std::string ProductQuantization<dist_t>::ToString() const {
+  return METH_PQ;
+}
+
+// The ADC table and the k-means use the float version of L2SqrSIMD
+template class ProductQuantization<float>;
+
+}
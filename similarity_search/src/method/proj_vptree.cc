@@ -56,10 +56,10 @@ ProjectionVPTree<dist_t>::ProjectionVPTree(
   }
   AnyParamManager pmgr(AllParams);
 
-  double    DbScanFrac = 0.05;
-  pmgr.GetParamOptional("dbScanFrac", DbScanFrac);
+  db_scan_frac_ = 0.05;
+  pmgr.GetParamOptional("dbScanFrac", db_scan_frac_);
 
-  if (DbScanFrac < 0.0 || DbScanFrac > 1.0) {
+  if (db_scan_frac_ < 0.0 || db_scan_frac_ > 1.0) {
     LOG(LIB_FATAL) << METH_PROJ_VPTREE << " requires that dbScanFrac is in the range [0,1]";
   }
 
@@ -88,8 +88,7 @@ ProjectionVPTree<dist_t>::ProjectionVPTree(
                          "alphaRight"
                         });
 
-  // db_can_qty_ should always be > 0
-  db_scan_qty_ = max(size_t(1), static_cast<size_t>(DbScanFrac * data.size())),
+  ComputeDbScanQty(db_scan_frac_);
   projData_.resize(data.size());
 
   for (size_t id = 0; id < data.size(); ++id) {
@@ -110,6 +109,21 @@ ProjectionVPTree<dist_t>::ProjectionVPTree(
                                     );
 }
 
+template <typename dist_t>
+void 
+ProjectionVPTree<dist_t>::SetQueryTimeParamsInternal(AnyParamManager& pmgr) {
+  pmgr.GetParamOptional("dbScanFrac", db_scan_frac_);  
+  ComputeDbScanQty(db_scan_frac_);
+}
+
+template <typename dist_t>
+vector<string>
+ProjectionVPTree<dist_t>::GetQueryTimeParamNames() const {
+  vector<string> names;
+  names.push_back("dbScanFrac");
+  return names;
+}    
+
 template <typename dist_t>
 ProjectionVPTree<dist_t>::~ProjectionVPTree() {
   for (size_t i = 0; i < data_.size(); ++i) {
@@ -136,12 +150,9 @@ void ProjectionVPTree<dist_t>::Search(RangeQuery<dist_t>* query) {
 
   VPTreeIndex_->Search(VPTreeQuery.get());
 
-  unique_ptr<KNNQueue<float>> ResQueue(VPTreeQuery->Result()->Clone());
-
-  while (!ResQueue->Empty()) {
-      size_t id = reinterpret_cast<const Object*>(ResQueue->TopObject())->id();
+  for (const auto& elem: VPTreeQuery->Result()->GetElements()) {
+      size_t id = elem.second->id();
       query->CheckAndAddToResult(data_[id]);
-      ResQueue->Pop();
   }
 }
 
@@ -152,12 +163,9 @@ void ProjectionVPTree<dist_t>::Search(KNNQuery<dist_t>* query) {
 
   VPTreeIndex_->Search(VPTreeQuery.get());
 
-  unique_ptr<KNNQueue<float>> ResQueue(VPTreeQuery->Result()->Clone());
-
-  while (!ResQueue->Empty()) {
-      size_t id = reinterpret_cast<const Object*>(ResQueue->TopObject())->id();
+  for (const auto& elem: VPTreeQuery->Result()->GetElements()) {
+      size_t id = elem.second->id();
       query->CheckAndAddToResult(data_[id]);
-      ResQueue->Pop();
   }
 }
 
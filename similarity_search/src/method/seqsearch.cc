@@ -14,6 +14,10 @@
  *
  */
 
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
 #include "space.h"
 #include "rangequery.h"
 #include "knnquery.h"
@@ -21,17 +25,125 @@
 
 namespace similarity {
 
+using std::mutex;
+using std::unique_lock;
+using std::condition_variable;
+
 template <typename dist_t>
-void SeqSearch<dist_t>::Search(RangeQuery<dist_t>* query) {
-  for (size_t i = 0; i < data_.size(); ++i) {
-    query->CheckAndAddToResult(data_[i]);
+SeqSearch<dist_t>::SeqSearch(const Space<dist_t>* space, 
+                             const ObjectVector& data, 
+                             const AnyParams& MethParams) : 
+                                space_(space), data_(data), threadQty_(1) {
+  AnyParamManager pmgr(MethParams);
+
+  pmgr.GetParamOptional("threadQty", threadQty_);
+
+  if (threadQty_ > 1) {
+    pool_.reset(new WorkStealingPool(static_cast<unsigned>(threadQty_ - 1)));
   }
 }
 
+template <typename dist_t>
+void SeqSearch<dist_t>::Search(RangeQuery<dist_t>* query) {
+  vector<RangeQuery<dist_t>*> queries(1, query);
+  GenSearchBatch(queries);
+}
+
 template <typename dist_t>
 void SeqSearch<dist_t>::Search(KNNQuery<dist_t>* query) {
-  for (size_t i = 0; i < data_.size(); ++i) {
-    query->CheckAndAddToResult(data_[i]);
+  vector<KNNQuery<dist_t>*> queries(1, query);
+  GenSearchBatch(queries);
+}
+
+template <typename dist_t>
+void SeqSearch<dist_t>::SearchBatch(vector<RangeQuery<dist_t>*>& queries) {
+  GenSearchBatch(queries);
+}
+
+template <typename dist_t>
+void SeqSearch<dist_t>::SearchBatch(vector<KNNQuery<dist_t>*>& queries) {
+  GenSearchBatch(queries);
+}
+
+template <typename dist_t>
+KNNQuery<dist_t>* SeqSearch<dist_t>::CreatePartQuery(const KNNQuery<dist_t>* query) const {
+  return new KNNQuery<dist_t>(space_, query->QueryObject(), query->GetK(), query->GetEPS());
+}
+
+template <typename dist_t>
+RangeQuery<dist_t>* SeqSearch<dist_t>::CreatePartQuery(const RangeQuery<dist_t>* query) const {
+  return new RangeQuery<dist_t>(space_, query->QueryObject(), query->Radius());
+}
+
+template <typename dist_t>
+template <typename QueryType>
+void SeqSearch<dist_t>::GenSearchBatch(vector<QueryType*>& queries) {
+  const size_t partQty = pool_ ? std::min(threadQty_, data_.size() / MIN_PART_QTY) : 1;
+
+  if (partQty <= 1) {
+    ScanPart(queries, 0, data_.size());
+    return;
+  }
+
+  // The first part is scanned using original queries
+  vector<vector<unique_ptr<QueryType>>> partQueries(partQty);
+  vector<vector<QueryType*>>            partQueryPtrs(partQty);
+  partQueryPtrs[0] = queries;
+  for (size_t part = 1; part < partQty; ++part) {
+    for (const QueryType* query : queries) {
+      partQueries[part].push_back(unique_ptr<QueryType>(CreatePartQuery(query)));
+      partQueryPtrs[part].push_back(partQueries[part].back().get());
+    }
+  }
+
+  mutex               guard;
+  condition_variable  allFinished;
+  size_t              unfinishedQty = partQty;
+  std::exception_ptr  err;
+
+  auto ScanFunc = [&](size_t part) {
+    std::exception_ptr partErr;
+    try {
+      ScanPart(partQueryPtrs[part], data_.size() * part / partQty, data_.size() * (part + 1) / partQty);
+    } catch (...) {
+      partErr = std::current_exception();
+    }
+    unique_lock<mutex> lock(guard);
+    if (partErr) err = partErr;
+    // Notifying while holding the lock: local variables may be destroyed right after the lock is released
+    if (--unfinishedQty == 0) allFinished.notify_one();
+  };
+
+  for (size_t part = 1; part < partQty; ++part) {
+    pool_->Submit([&ScanFunc, part]() { ScanFunc(part); });
+  }
+  ScanFunc(0);
+  {
+    unique_lock<mutex> lock(guard);
+    allFinished.wait(lock, [&unfinishedQty]() { return unfinishedQty == 0; });
+  }
+  if (err) std::rethrow_exception(err);
+
+  for (size_t part = 1; part < partQty; ++part) {
+    for (size_t i = 0; i < queries.size(); ++i) {
+      queries[i]->Merge(*partQueries[part][i]);
+    }
+  }
+}
+
+template <typename dist_t>
+template <typename QueryType>
+void SeqSearch<dist_t>::ScanPart(const vector<QueryType*>& queries, size_t start, size_t end) const {
+  while (start < end) {
+    size_t blockEnd = start;
+    size_t BlockSize = 0;
+    while (blockEnd < end && BlockSize < BATCH_BLOCK_SIZE) {
+      BlockSize += data_[blockEnd++]->bufferlength();
+    }
+    for (QueryType* query: queries) {
+      query->CheckAndAddToResult(&data_[start], blockEnd - start);
+    }
+    start = blockEnd;
   }
 }
 
@@ -20,6 +20,7 @@
 #include "space.h"
 #include "knnquery.h"
 #include "rangequery.h"
+#include "index_io.h"
 #include "method/small_world_rand.h"
 
 #include <vector>
@@ -27,8 +28,8 @@
 #include <map>
 #include <sstream>
 #include <typeinfo>
-#include <unordered_set>
 #include <queue>
+#include <fstream>
 
 namespace similarity {
 
@@ -64,7 +65,7 @@ struct IndexThreadSW {
      */
     for (size_t i = 1; i < prm.data_.size(); ++i) {
       if (prm.index_every_ == i % prm.out_of_) {
-        MSWNode* node = new MSWNode(prm.data_[i]);
+        MSWNode* node = new MSWNode(prm.data_[i], i);
         prm.index_.add(prm.space_, node);
       }
     }
@@ -74,12 +75,15 @@ struct IndexThreadSW {
 template <typename dist_t>
 SmallWorldRand<dist_t>::SmallWorldRand(const Space<dist_t>* space,
                                                    const ObjectVector& data,
-                                                   const AnyParams& MethParams) :
+                                                   const AnyParams& MethParams,
+                                                   bool BuildIndex) :
                                                    NN_(5),
                                                    initIndexAttempts_(2),
                                                    initSearchAttempts_(10),
                                                    size_(0),
-                                                   indexThreadQty_(0)
+                                                   indexThreadQty_(0),
+                                                   data_(data),
+                                                   VisitedListPool_(new VisitedListPool(1, data.size()))
 {
   AnyParamManager pmgr(MethParams);
 
@@ -93,14 +97,16 @@ SmallWorldRand<dist_t>::SmallWorldRand(const Space<dist_t>* space,
   LOG(LIB_INFO) << "initSearchAttempts  = " << initSearchAttempts_;
   LOG(LIB_INFO) << "indexThreadQty      = " << indexThreadQty_;
 
-  if (data.empty()) return;
+  distKernel_ = GetDataDistKernel(space, data);
 
-  ElList_.push_back(new MSWNode(data[0]));
+  if (!BuildIndex || data.empty()) return;
+
+  ElList_.push_back(new MSWNode(data[0], 0));
 
   if (indexThreadQty_ <= 1) {
     // Skip the first element, one element is already added
     for (size_t i = 1; i != data.size(); ++i) {
-      MSWNode* node = new MSWNode(data[i]);
+      MSWNode* node = new MSWNode(data[i], i);
       add(space, node);
     }
   } else {
@@ -119,6 +125,33 @@ SmallWorldRand<dist_t>::SmallWorldRand(const Space<dist_t>* space,
       threads[i].join();
     }
   }
+
+  FreezeGraph();
+}
+
+template <typename dist_t>
+void SmallWorldRand<dist_t>::FreezeGraph() {
+  vector<MSWNode*> nodes(data_.size());
+
+  for (MSWNode* node: ElList_) {
+    CHECK(node->getId() < nodes.size());
+    nodes[node->getId()] = node;
+  }
+
+  FrozenOffsets_.resize(data_.size() + 1);
+  FrozenNeighbors_.clear();
+
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    FrozenOffsets_[i] = FrozenNeighbors_.size();
+    if (nodes[i] == NULL) continue;
+    for (MSWNode* f: nodes[i]->getAllFriends()) {
+      FrozenNeighbors_.push_back(f->getId());
+    }
+  }
+  FrozenOffsets_[nodes.size()] = FrozenNeighbors_.size();
+
+  for (MSWNode* node: ElList_) delete node;
+  ElList_.clear();
 }
 
 template <typename dist_t>
@@ -135,6 +168,51 @@ SmallWorldRand<dist_t>::GetQueryTimeParamNames() const {
   return names;
 }
 
+/*
+ * The frozen graph is stored as follows: NN, the array
+ * of offsets, and the array of neighbor ids.
+ */
+template <typename dist_t>
+void SmallWorldRand<dist_t>::SaveIndex(const string& location) {
+  std::ofstream out;
+  OpenIndexFileForWriting(location, out);
+  WriteIndexHeader(out, METH_SMALL_WORLD_RAND, data_.size());
+
+  WriteBinaryPOD(out, static_cast<uint64_t>(NN_));
+  WriteBinaryVector(out, FrozenOffsets_);
+  WriteBinaryVector(out, FrozenNeighbors_);
+
+  out.close();
+}
+
+template <typename dist_t>
+void SmallWorldRand<dist_t>::LoadIndex(const string& location) {
+  std::ifstream in;
+  OpenIndexFileForReading(location, in);
+  ReadIndexHeader(in, METH_SMALL_WORLD_RAND, data_.size());
+
+  uint64_t NN;
+  ReadBinaryPOD(in, NN);
+  NN_ = NN;
+
+  ReadBinaryVector(in, FrozenOffsets_);
+  ReadBinaryVector(in, FrozenNeighbors_);
+
+  if (FrozenOffsets_.size() != data_.size() + 1 || 
+      FrozenOffsets_.back() != FrozenNeighbors_.size()) {
+    throw runtime_error("Corrupt index file: the size of the neighbor array doesn't match offsets");
+  }
+  for (size_t i = 0; i < data_.size(); ++i) {
+    if (FrozenOffsets_[i] > FrozenOffsets_[i + 1]) {
+      throw runtime_error("Corrupt index file: neighbor offsets are not sorted");
+    }
+  }
+  for (unsigned id: FrozenNeighbors_) {
+    if (id >= data_.size()) throw runtime_error("Corrupt index file: a neighbor id is out of range");
+  }
+  LOG(LIB_INFO) << "Loaded " << data_.size() << " nodes, NN = " << NN_;
+}
+
 template <typename dist_t>
 const std::string SmallWorldRand<dist_t>::ToString() const {
   return "small_world_rand";
@@ -159,7 +237,7 @@ MSWNode* SmallWorldRand<dist_t>::getRandomEntryPoint() const {
   if(!ElList_.size()) {
     return NULL;
   } else {
-    size_t num = rand()%size;
+    size_t num = RandomInt() % size;
     return ElList_[num];
   }
 }
@@ -174,7 +252,9 @@ SmallWorldRand<dist_t>::kSearchElementsWithAttempts(const Space<dist_t>* space,
                                                     set <EvaluatedMSWNode<dist_t>>& resultSet) const
 {
   resultSet.clear();
-  unordered_set <MSWNode*>       visitedNodes;
+
+  VisitedListHolder   visitedHolder(*VisitedListPool_);
+  VisitedList&        visitedNodes = visitedHolder.GetList();
 
   for (size_t i=0; i < initIndexAttempts; i++){
 
@@ -191,7 +271,7 @@ SmallWorldRand<dist_t>::kSearchElementsWithAttempts(const Space<dist_t>* space,
 
     candidateSet.push(ev);
     closestDistQueue.push(d);
-    visitedNodes.insert(provider);
+    visitedNodes.MarkVisited(provider->getId());
     resultSet.insert(ev);
 
     while (!candidateSet.empty()) {
@@ -219,10 +299,10 @@ SmallWorldRand<dist_t>::kSearchElementsWithAttempts(const Space<dist_t>* space,
 
       // calculate distance to each neighbor
       for (auto iter = neighbor.begin(); iter != neighbor.end(); ++iter){
-        if (visitedNodes.find(*iter) == visitedNodes.end()){
+        if (!visitedNodes.IsVisited((*iter)->getId())){
           d = space->IndexTimeDistance(queryObj, (*iter)->getData());
           EvaluatedMSWNode<dist_t> evE1(d, *iter);
-          visitedNodes.insert(*iter);
+          visitedNodes.MarkVisited((*iter)->getId());
           closestDistQueue.push(d);
           if (closestDistQueue.size() > NN) {
             closestDistQueue.pop();
@@ -272,73 +352,80 @@ void SmallWorldRand<dist_t>::Search(RangeQuery<dist_t>* query) {
   throw runtime_error("Range search is not supported!");
 }
 
+/*
+ * The search works with the frozen graph and doesn't need any locks.
+ * Every visited point is passed to the query, which keeps the k closest ones.
+ */
 template <typename dist_t>
 void SmallWorldRand<dist_t>::Search(KNNQuery<dist_t>* query) {
-  size_t k = query->GetK();
-  set <EvaluatedMSWNode<dist_t>>    resultSet;
-  unordered_set <MSWNode*>          visitedNodes;
+  if (distKernel_.Fits(query->QueryObject())) {
+    SearchVisitor visitor(*this, query);
+    DispatchDistKernel<dist_t>(distKernel_, visitor);
+  } else {
+    SearchKernel(query, VirtualDistKernel<dist_t>());
+  }
+}
+
+template <typename dist_t>
+template <typename Kernel>
+void SmallWorldRand<dist_t>::SearchKernel(KNNQuery<dist_t>* query, const Kernel& kernel) {
+  const size_t nodeQty = data_.size();
+  if (!nodeQty) return;
+
+  typedef std::pair<dist_t, unsigned>  DistNodePair;
+
+  VisitedListHolder   visitedHolder(*VisitedListPool_);
+  VisitedList&        visitedNodes = visitedHolder.GetList();
 
   for (size_t i=0; i < initSearchAttempts_; i++) {
   /**
    * Search of most k-closest elements to the query.
    */
-    MSWNode* provider = getRandomEntryPoint();
+    unsigned provider = RandomInt() % nodeQty;
+
+    if (visitedNodes.IsVisited(provider)) continue;
 
     priority_queue <dist_t>                   closestDistQueue; //The set of all elements which distance was calculated
-    priority_queue <EvaluatedMSWNode<dist_t>> candidateSet; //the set of elements which we can use to evaluate
+    // the set of elements which we can use to evaluate (the closest one is on top)
+    priority_queue <DistNodePair, vector<DistNodePair>, std::greater<DistNodePair>> candidateSet; 
 
-    dist_t d = query->DistanceObjLeft(provider->getData());
-    EvaluatedMSWNode<dist_t> ev(d, provider);
+    dist_t d = kernel.DistanceObjLeft(query, data_[provider]);
 
-    candidateSet.push(ev);
+    candidateSet.push(std::make_pair(d, provider));
     closestDistQueue.push(d);
-    visitedNodes.insert(provider);
-    resultSet.insert(ev);
+    visitedNodes.MarkVisited(provider);
+    query->CheckAndAddToResult(d, data_[provider]);
 
     while(!candidateSet.empty()){
-
-    auto iter = candidateSet.top();
-    const EvaluatedMSWNode<dist_t>& currEv = iter;
-    dist_t lowerBound = closestDistQueue.top();
+      const DistNodePair& currEv = candidateSet.top();
+      dist_t lowerBound = closestDistQueue.top();
 
       // Did we reach a local minimum?
-      if (currEv.getDistance() > lowerBound) {
+      if (currEv.first > lowerBound) {
         break;
       }
 
-      const vector<MSWNode*>& neighbor = (currEv.getMSWNode())->getAllFriends();
-
-      // Can't access curEv anymore! The reference would become invalid
+      const unsigned currNode = currEv.second;
       candidateSet.pop();
 
       //calculate distance to each neighbor
-      for (auto iter = neighbor.begin(); iter != neighbor.end(); ++iter){
-        if (visitedNodes.find(*iter) == visitedNodes.end()){
-            d = query->DistanceObjLeft((*iter)->getData());
-            EvaluatedMSWNode<dist_t> evE1(d, *iter);
-            visitedNodes.insert(*iter);
-            closestDistQueue.push(d);
-            if (closestDistQueue.size() > NN_) { 
-              closestDistQueue.pop(); 
-            }
-            candidateSet.push(evE1);
-            resultSet.insert(evE1);
+      for (size_t pos = FrozenOffsets_[currNode]; pos < FrozenOffsets_[currNode + 1]; ++pos) {
+        const unsigned neighbor = FrozenNeighbors_[pos];
+        if (!visitedNodes.IsVisited(neighbor)){
+          d = kernel.DistanceObjLeft(query, data_[neighbor]);
+          visitedNodes.MarkVisited(neighbor);
+          closestDistQueue.push(d);
+          if (closestDistQueue.size() > NN_) { 
+            closestDistQueue.pop(); 
           }
+          candidateSet.push(std::make_pair(d, neighbor));
+          query->CheckAndAddToResult(d, data_[neighbor]);
+        }
       }
     }
   }
-
-  auto iter = resultSet.rbegin();
-
-  while(k && iter != resultSet.rend()) {
-    query->CheckAndAddToResult(iter->getDistance(), iter->getMSWNode()->getData());
-    iter++;
-    k--;
-  }
 }
 
-
-
 template class SmallWorldRand<float>;
 template class SmallWorldRand<double>;
 template class SmallWorldRand<int>;
@@ -0,0 +1,407 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include <functional>
+
+#include "space.h"
+#include "space/space_sparse_scalar.h"
+#include "space/space_sparse_scalar_fast.h"
+#include "knnquery.h"
+#include "knnqueue.h"
+#include "rangequery.h"
+#include "index_io.h"
+#include "method/sparse_inv_index.h"
+
+namespace similarity {
+
+using std::unordered_map;
+
+namespace {
+
+/*
+ * Scores are sums of floating-point numbers, which are computed
+ * differently by the index and by the space. To compensate for rounding errors,
+ * we compute real distances to all data points whose scores are larger
+ * than the threshold minus this value.
+ */
+const double kScoreEps = 1e-4;
+
+}
+
+template <typename dist_t>
+SparseInvIndex<dist_t>::SparseInvIndex(const Space<dist_t>* space,
+                                       const ObjectVector& data,
+                                       const AnyParams& MethParams,
+                                       bool BuildIndex) :
+                                       space_(dynamic_cast<const SpaceSparseVector<dist_t>*>(space)),
+                                       data_(data),
+                                       bAngular_(false),
+                                       taatRatio_(1.0) {
+  if (dynamic_cast<const SpaceSparseAngularDistance<dist_t>*>(space) != NULL ||
+      dynamic_cast<const SpaceSparseAngularDistanceFast*>(space) != NULL) {
+    bAngular_ = true;
+  } else if (dynamic_cast<const SpaceSparseCosineSimilarity<dist_t>*>(space) == NULL &&
+             dynamic_cast<const SpaceSparseCosineSimilarityFast*>(space) == NULL) {
+    LOG(LIB_FATAL) << METH_SPARSE_INV_INDEX << " works only with spaces: " 
+                   << SPACE_SPARSE_COSINE_SIMILARITY << ", " << SPACE_SPARSE_ANGULAR_DISTANCE << ", "
+                   << SPACE_SPARSE_COSINE_SIMILARITY_FAST << ", " << SPACE_SPARSE_ANGULAR_DISTANCE_FAST;
+  }
+  if (data.size() > std::numeric_limits<uint32_t>::max()) {
+    LOG(LIB_FATAL) << METH_SPARSE_INV_INDEX << " cannot index more than " 
+                   << std::numeric_limits<uint32_t>::max() << " data points";
+  }
+
+  AnyParamManager pmgr(MethParams);
+
+  pmgr.GetParamOptional("taatRatio", taatRatio_);
+
+  LOG(LIB_INFO) << "taatRatio           = " << taatRatio_;
+
+  if (!BuildIndex) return;
+
+  vector<ElemType> elems;
+
+  // The first pass computes the length of each posting list
+  unordered_map<uint32_t, size_t> termMap;
+  for (const Object* obj: data_) {
+    space_->GetVector(obj, elems);
+    for (const ElemType& e: elems) termMap[e.id_]++;
+  }
+
+  termIds_.reserve(termMap.size());
+  for (const auto& it: termMap) termIds_.push_back(it.first);
+  sort(termIds_.begin(), termIds_.end());
+
+  postOffsets_.resize(termIds_.size() + 1);
+  postOffsets_[0] = 0;
+  for (size_t i = 0; i < termIds_.size(); ++i) {
+    size_t& qty = termMap[termIds_[i]];
+    postOffsets_[i + 1] = postOffsets_[i] + qty;
+    qty = postOffsets_[i]; // From now on, this is the position to add the next posting
+  }
+
+  postObjIds_.resize(postOffsets_.back());
+  postVals_.resize(postOffsets_.back());
+  maxVals_.assign(termIds_.size(), -std::numeric_limits<dist_t>::max());
+  minVals_.assign(termIds_.size(), std::numeric_limits<dist_t>::max());
+
+  // The second pass fills posting lists, which become sorted by data point positions
+  for (size_t objId = 0; objId < data_.size(); ++objId) {
+    space_->GetVector(data_[objId], elems);
+
+    dist_t norm = 0;
+    for (const ElemType& e: elems) norm += e.val_ * e.val_;
+    // See the comment in NormScalarProduct
+    const dist_t invNorm = norm < std::numeric_limits<dist_t>::min() * 2 ? dist_t(0) : dist_t(1) / sqrt(norm);
+
+    for (const ElemType& e: elems) {
+      size_t& pos = termMap[e.id_];
+      postObjIds_[pos] = static_cast<uint32_t>(objId);
+      postVals_[pos] = e.val_ * invNorm;
+      ++pos;
+    }
+  }
+
+  for (size_t i = 0; i < termIds_.size(); ++i) {
+    for (uint64_t k = postOffsets_[i]; k < postOffsets_[i + 1]; ++k) {
+      maxVals_[i] = max(maxVals_[i], postVals_[k]);
+      minVals_[i] = min(minVals_[i], postVals_[k]);
+    }
+  }
+
+  LOG(LIB_INFO) << "The number of indexed elements: " << termIds_.size();
+  LOG(LIB_INFO) << "The number of postings:         " << postObjIds_.size();
+}
+
+template <typename dist_t>
+SparseInvIndex<dist_t>::~SparseInvIndex() {
+}
+
+template <typename dist_t>
+void SparseInvIndex<dist_t>::CreateCursors(const Object* query, vector<PostCursor>& cursors) const {
+  vector<ElemType> elems;
+  space_->GetVector(query, elems);
+
+  dist_t norm = 0;
+  for (const ElemType& e: elems) norm += e.val_ * e.val_;
+  const dist_t invNorm = norm < std::numeric_limits<dist_t>::min() * 2 ? dist_t(0) : dist_t(1) / sqrt(norm);
+
+  cursors.clear();
+  for (const ElemType& e: elems) {
+    auto it = lower_bound(termIds_.begin(), termIds_.end(), e.id_);
+    if (it == termIds_.end() || *it != e.id_) continue;
+    const size_t termId = it - termIds_.begin();
+
+    PostCursor cursor;
+    cursor.pObjIds_  = &postObjIds_[postOffsets_[termId]];
+    cursor.pVals_    = &postVals_[postOffsets_[termId]];
+    cursor.pos_      = 0;
+    cursor.qty_      = postOffsets_[termId + 1] - postOffsets_[termId];
+    cursor.queryVal_ = e.val_ * invNorm;
+    // Values can be negative, a contribution can be positive only if signs match
+    cursor.maxScore_ = max(dist_t(0), max(cursor.queryVal_ * maxVals_[termId],
+                                          cursor.queryVal_ * minVals_[termId]));
+    cursors.push_back(cursor);
+  }
+}
+
+template <typename dist_t>
+template <typename CheckFunc, typename ThreshFunc>
+void SparseInvIndex<dist_t>::MaxScoreSearch(vector<PostCursor>& cursors, 
+                                            const CheckFunc& Check, const ThreshFunc& Thresh) const {
+  const size_t qty = cursors.size();
+
+  sort(cursors.begin(), cursors.end(), 
+       [](const PostCursor& c1, const PostCursor& c2) { return c1.maxScore_ < c2.maxScore_; });
+
+  // upperBounds[i] is the sum of maximum contributions of first i + 1 cursors
+  vector<dist_t> upperBounds(qty);
+  dist_t sum = 0;
+  for (size_t i = 0; i < qty; ++i) {
+    sum += cursors[i].maxScore_;
+    upperBounds[i] = sum;
+  }
+
+  const uint32_t EndId = std::numeric_limits<uint32_t>::max();
+
+  /*
+   * Cursors [0, essQty) are non-essential: data points that
+   * occur only in their posting lists cannot have scores larger than the threshold.
+   */
+  size_t essQty = 0;
+  dist_t thresh = Thresh();
+  while (essQty < qty && upperBounds[essQty] <= thresh) ++essQty;
+
+  uint32_t objId = EndId;
+  for (size_t i = essQty; i < qty; ++i) objId = min(objId, cursors[i].ObjId());
+
+  while (essQty < qty && objId != EndId) {
+    // Scores the current data point and finds the next one in the same pass
+    dist_t   score = 0;
+    uint32_t nextObjId = EndId;
+    for (size_t i = essQty; i < qty; ++i) {
+      PostCursor& cursor = cursors[i];
+      if (cursor.ObjId() == objId) {
+        score += cursor.Score();
+        cursor.pos_++;
+      }
+      nextObjId = min(nextObjId, cursor.ObjId());
+    }
+    // Adding contributions of non-essential cursors while the upper bound exceeds the threshold
+    size_t i = essQty;
+    for (; i > 0 && score + upperBounds[i - 1] > thresh; --i) {
+      PostCursor& cursor = cursors[i - 1];
+      cursor.SkipTo(objId);
+      if (cursor.ObjId() == objId) score += cursor.Score();
+    }
+    if (i == 0) {
+      Check(score, objId);
+      thresh = Thresh();
+      if (essQty < qty && upperBounds[essQty] <= thresh) {
+        while (essQty < qty && upperBounds[essQty] <= thresh) ++essQty;
+        // Cursors that became non-essential don't define the next data point anymore
+        nextObjId = EndId;
+        for (size_t k = essQty; k < qty; ++k) nextObjId = min(nextObjId, cursors[k].ObjId());
+      }
+    }
+    objId = nextObjId;
+  }
+}
+
+template <typename dist_t>
+void SparseInvIndex<dist_t>::TAATScores(const vector<PostCursor>& cursors, vector<dist_t>& scores) const {
+  scores.assign(data_.size(), 0);
+  for (const PostCursor& cursor: cursors) {
+    for (size_t k = 0; k < cursor.qty_; ++k) {
+      scores[cursor.pObjIds_[k]] += cursor.queryVal_ * cursor.pVals_[k];
+    }
+  }
+}
+
+template <typename dist_t>
+bool SparseInvIndex<dist_t>::UseTAAT(const vector<PostCursor>& cursors) const {
+  uint64_t postQty = 0;
+  for (const PostCursor& cursor: cursors) postQty += cursor.qty_;
+  return static_cast<double>(postQty) * cursors.size() >= taatRatio_ * data_.size();
+}
+
+template <typename dist_t>
+dist_t SparseInvIndex<dist_t>::MinScore(dist_t dist) const {
+  if (bAngular_) {
+    // acos(-1) is pi, the maximum angular distance
+    return dist >= acos(dist_t(-1)) ? dist_t(-1) : cos(dist);
+  }
+  return 1 - dist;
+}
+
+template <typename dist_t>
+void SparseInvIndex<dist_t>::Search(RangeQuery<dist_t>* query) {
+  const dist_t minScore = MinScore(query->Radius()) - kScoreEps;
+
+  // Data points without common elements have zero scores
+  if (minScore <= 0) {
+    for (const Object* obj: data_) query->CheckAndAddToResult(obj);
+    return;
+  }
+
+  vector<PostCursor> cursors;
+  CreateCursors(query->QueryObject(), cursors);
+
+  if (UseTAAT(cursors)) {
+    vector<dist_t> scores;
+    TAATScores(cursors, scores);
+    for (size_t objId = 0; objId < data_.size(); ++objId) {
+      if (scores[objId] > minScore) query->CheckAndAddToResult(data_[objId]);
+    }
+    return;
+  }
+
+  MaxScoreSearch(cursors, 
+                 [this, query, minScore](dist_t score, uint32_t objId) {
+                   if (score > minScore) query->CheckAndAddToResult(data_[objId]);
+                 },
+                 [minScore]() { return minScore; });
+}
+
+template <typename dist_t>
+void SparseInvIndex<dist_t>::Search(KNNQuery<dist_t>* query) {
+  const size_t K = query->GetK();
+
+  vector<PostCursor> cursors;
+  CreateCursors(query->QueryObject(), cursors);
+
+  if (UseTAAT(cursors)) {
+    vector<dist_t> scores;
+    TAATScores(cursors, scores);
+
+    // Negative scores of the best data points with positive scores
+    KNNQueue<dist_t> scoreQueue(K);
+    for (size_t objId = 0; objId < scores.size(); ++objId) {
+      const dist_t score = scores[objId];
+      if (score > 0 && (scoreQueue.Size() < K || -score < scoreQueue.TopDistance())) {
+        scoreQueue.Push(-score, data_[objId]);
+      }
+    }
+    // If fewer than K data points have positive scores, all data points are checked
+    const dist_t minScore = scoreQueue.Size() < K ? 
+                            std::numeric_limits<dist_t>::lowest() : 
+                            -scoreQueue.TopDistance() - dist_t(kScoreEps);
+    for (size_t objId = 0; objId < data_.size(); ++objId) {
+      if (scores[objId] > minScore) query->CheckAndAddToResult(data_[objId]);
+    }
+    return;
+  }
+
+  // Negative scores of the best data points with positive scores
+  KNNQueue<dist_t> scoreQueue(K);
+  // Positions of data points whose distances were computed
+  vector<uint32_t> checked;
+
+  auto thresh = [&scoreQueue, K]() { 
+    return (scoreQueue.Size() < K ? dist_t(0) : -scoreQueue.TopDistance()) - dist_t(kScoreEps);
+  };
+
+  MaxScoreSearch(cursors,
+                 [this, query, &scoreQueue, &checked, &thresh](dist_t score, uint32_t objId) {
+                   if (score > thresh()) {
+                     query->CheckAndAddToResult(data_[objId]);
+                     checked.push_back(objId);
+                     if (score > 0) scoreQueue.Push(-score, data_[objId]);
+                   }
+                 },
+                 thresh);
+
+  if (scoreQueue.Size() < K) {
+    /*
+     * Fewer than K data points have positive scores. The remaining
+     * data points can be as good as the ones we checked. Positions
+     * of checked data points are sorted, because MaxScoreSearch visits 
+     * data points in the increasing order.
+     */
+    auto it = checked.begin();
+    for (size_t objId = 0; objId < data_.size(); ++objId) {
+      if (it != checked.end() && *it == objId) {
+        ++it;
+        continue;
+      }
+      query->CheckAndAddToResult(data_[objId]);
+    }
+  }
+}
+
+template <typename dist_t>
+void SparseInvIndex<dist_t>::SaveIndex(const string& location) {
+  std::ofstream out;
+  OpenIndexFileForWriting(location, out);
+  WriteIndexHeader(out, METH_SPARSE_INV_INDEX, data_.size());
+
+  WriteBinaryVector(out, termIds_);
+  WriteBinaryVector(out, postOffsets_);
+  WriteBinaryVector(out, postObjIds_);
+  WriteBinaryVector(out, postVals_);
+  WriteBinaryVector(out, maxVals_);
+  WriteBinaryVector(out, minVals_);
+  out.close();
+}
+
+template <typename dist_t>
+void SparseInvIndex<dist_t>::LoadIndex(const string& location) {
+  std::ifstream in;
+  OpenIndexFileForReading(location, in);
+  ReadIndexHeader(in, METH_SPARSE_INV_INDEX, data_.size());
+
+  ReadBinaryVector(in, termIds_);
+  ReadBinaryVector(in, postOffsets_);
+  ReadBinaryVector(in, postObjIds_);
+  ReadBinaryVector(in, postVals_);
+  ReadBinaryVector(in, maxVals_);
+  ReadBinaryVector(in, minVals_);
+
+  if (postOffsets_.size() != termIds_.size() + 1 || 
+      maxVals_.size() != termIds_.size() || minVals_.size() != termIds_.size() ||
+      postObjIds_.size() != postOffsets_.back() || postVals_.size() != postOffsets_.back()) {
+    throw runtime_error("Corrupt index file: the sizes of posting lists don't match");
+  }
+  for (uint32_t objId: postObjIds_) {
+    if (objId >= data_.size()) {
+      throw runtime_error("Corrupt index file: a posting refers to a non-existing data point");
+    }
+  }
+}
+
+template <typename dist_t>
+void SparseInvIndex<dist_t>::SetQueryTimeParamsInternal(AnyParamManager& pmgr) {
+  pmgr.GetParamOptional("taatRatio", taatRatio_);
+}
+
+template <typename dist_t>
+vector<string> SparseInvIndex<dist_t>::GetQueryTimeParamNames() const {
+  vector<string> names;
+  names.push_back("taatRatio");
+  return names;
+}
+
+template <typename dist_t>
+const std::string SparseInvIndex<dist_t>::ToString() const {
+  return METH_SPARSE_INV_INDEX;
+}
+
+template class SparseInvIndex<float>;
+template class SparseInvIndex<double>;
+
+}
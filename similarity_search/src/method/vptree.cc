@@ -19,6 +19,9 @@
 #include <sstream>
 #include <string>
 #include <cmath>
+#include <cstring>
+#include <new>
+#include <mutex>
 
 #include "space.h"
 #include "rangequery.h"
@@ -26,6 +29,7 @@
 #include "searchoracle.h"
 #include "method/vptree.h"
 #include "method/vptree_utils.h"
+#include "method/parallel_tree_builder.h"
 #include "methodfactory.h"
 
 namespace similarity {
@@ -42,11 +46,19 @@ VPTree<dist_t, SearchOracle, SearchOracleCreator>::VPTree(
                        const Space<dist_t>* space,
                        const ObjectVector& data,
                        const AnyParams& MethParams,
-                       bool use_random_center) : 
+                       bool use_random_center,
+                       bool BuildIndex) : 
+                              data_(data),
+                              OracleCreator_(OracleCreator),
+                              root_(NULL),
+                              flatTree_(NULL),
+                              flatTreeSize_(0),
                               BucketSize_(50),
                               MaxLeavesToVisit_(FAKE_MAX_LEAVES_TO_VISIT),
                               ChunkBucket_(true),
-                              SaveHistFileName_("")
+                              SaveHistFileName_(""),
+                              IndexThreadQty_(0),
+                              Flatten_(false)
                        {
   AnyParamManager pmgr(MethParams);
 
@@ -54,22 +66,68 @@ VPTree<dist_t, SearchOracle, SearchOracleCreator>::VPTree(
   pmgr.GetParamOptional("chunkBucket", ChunkBucket_);
   pmgr.GetParamOptional("maxLeavesToVisit", MaxLeavesToVisit_);
   pmgr.GetParamOptional("saveHistFileName", SaveHistFileName_);
+  pmgr.GetParamOptional("indexThreadQty", IndexThreadQty_);
+  pmgr.GetParamOptional("flatten", Flatten_);
 
-  size_t IndexedQty = 0;
+  distKernel_ = GetDataDistKernel(space, data);
+
+  if (!BuildIndex) return;
+
+  std::atomic<size_t> IndexedQty(0);
+
+  unique_ptr<ParallelTreeBuilder> builder;
+  if (IndexThreadQty_ > 1) {
+    builder.reset(new ParallelTreeBuilder(static_cast<unsigned>(IndexThreadQty_), data.size()));
+  }
   
-  root_ = new VPNode(
+  // The root is owned by unique_ptr until all subtrees are built: a failed task doesn't leak the tree
+  unique_ptr<VPNode> root(new VPNode(
                      PrintProgress, 0,
                      data.size(), IndexedQty,
                      OracleCreator, space,
                      const_cast<ObjectVector&>(data),
                      BucketSize_, ChunkBucket_,
                      SaveHistFileName_,
-                     use_random_center, true);
+                     use_random_center, true,
+                     builder.get()));
+
+  if (builder) builder->Finish();
+  root_ = root.release();
+
+  if (Flatten_) Flatten();
 }
 
 template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
 VPTree<dist_t, SearchOracle, SearchOracleCreator>::~VPTree() {
   delete root_;
+  delete [] flatTree_;
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+vector<string> 
+VPTree<dist_t, SearchOracle, SearchOracleCreator>::GetQueryTimeParamNames() const {
+  vector<string> names = SearchOracleCreator::GetQueryTimeParamNames();
+  names.push_back("maxLeavesToVisit");
+  return names;
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+void 
+VPTree<dist_t, SearchOracle, SearchOracleCreator>::SetQueryTimeParamsInternal(AnyParamManager& pmgr) {
+  MaxLeavesToVisit_ = FAKE_MAX_LEAVES_TO_VISIT;
+  pmgr.GetParamOptional("maxLeavesToVisit", MaxLeavesToVisit_);
+  OracleCreator_.SetQueryTimeParams(pmgr);
+
+  UpdateOracles(root_);
+  for (SearchOracle& oracle : flatOracles_) OracleCreator_.UpdateOracle(oracle);
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::UpdateOracles(VPNode* node) {
+  if (node == NULL) return;
+  if (node->oracle_ != NULL) OracleCreator_.UpdateOracle(*node->oracle_);
+  UpdateOracles(node->left_child_);
+  UpdateOracles(node->right_child_);
 }
 
 template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
@@ -79,29 +137,374 @@ const std::string VPTree<dist_t, SearchOracle, SearchOracleCreator>::ToString()
 
 template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
 void VPTree<dist_t, SearchOracle, SearchOracleCreator>::Search(RangeQuery<dist_t>* query) {
-  int mx = MaxLeavesToVisit_;
-  root_->GenericSearch(query, mx);
+  GenSearch(query);
 }
 
 template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
 void VPTree<dist_t, SearchOracle, SearchOracleCreator>::Search(KNNQuery<dist_t>* query) {
+  GenSearch(query);
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::SearchBatch(vector<RangeQuery<dist_t>*>& queries) {
+  GenSearchBatch(queries);
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::SearchBatch(vector<KNNQuery<dist_t>*>& queries) {
+  GenSearchBatch(queries);
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+template <typename QueryType>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::GenSearch(QueryType* query) {
+  if (distKernel_.Fits(query->QueryObject())) {
+    SearchVisitor<QueryType> visitor(*this, query);
+    DispatchDistKernel<dist_t>(distKernel_, visitor);
+  } else {
+    GenSearchKernel(query, VirtualDistKernel<dist_t>());
+  }
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+template <typename QueryType>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::GenSearchBatch(vector<QueryType*>& queries) {
+  bool bFits = true;
+  for (const QueryType* query : queries) {
+    bFits = bFits && distKernel_.Fits(query->QueryObject());
+  }
+  if (bFits) {
+    SearchBatchVisitor<QueryType> visitor(*this, queries);
+    DispatchDistKernel<dist_t>(distKernel_, visitor);
+  } else {
+    GenSearchBatchKernel(queries, VirtualDistKernel<dist_t>());
+  }
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+template <typename QueryType, typename Kernel>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::GenSearchKernel(QueryType* query, const Kernel& kernel) {
   int mx = MaxLeavesToVisit_;
-  root_->GenericSearch(query, mx);
+  if (flatTree_ != NULL) {
+    GenericSearch(FlatNodeRef(*this, 0), query, kernel, mx);
+  } else if (root_ != NULL) {
+    GenericSearch(PtrNodeRef(root_), query, kernel, mx);
+  }
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+template <typename QueryType, typename Kernel>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::GenSearchBatchKernel(vector<QueryType*>& queries,
+                                                                             const Kernel& kernel) {
+  vector<int>     mx(queries.size(), MaxLeavesToVisit_);
+  vector<size_t>  qids(queries.size());
+  for (size_t i = 0; i < qids.size(); ++i) qids[i] = i;
+  if (flatTree_ != NULL) {
+    GenericSearchBatch(FlatNodeRef(*this, 0), queries, kernel, mx, qids);
+  } else if (root_ != NULL) {
+    GenericSearchBatch(PtrNodeRef(root_), queries, kernel, mx, qids);
+  }
+}
+
+/*
+ * The index starts with a one-byte layout type. The pointer-based tree
+ * is saved in the pre-order: each node starts with a one-byte type 
+ * (a bucket or an inner node). A bucket is a list of object positions. 
+ * An inner node stores the position of the pivot, the median distance, 
+ * and flags indicating whether children exist. Children follow the node.
+ * The flattened tree is saved as its breadth-first node table,
+ * where objects are replaced with their positions.
+ */
+enum VPTreeLayout   { kVPTreeEmpty = 0, kVPTreePreOrder = 1, kVPTreeFlat = 2 };
+enum VPTreeNodeType { kVPTreeBucket = 0, kVPTreeInnerNode = 1 };
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::SaveIndex(const string& location) {
+  if (!SearchOracle::IsDataIndependent()) {
+    throw runtime_error("Saving of the index is not supported for the search oracle: " + SearchOracle::GetName() +
+                        " (the oracle is learned from the data and it is not stored in the index)");
+  }
+  std::ofstream out;
+  OpenIndexFileForWriting(location, out);
+  WriteIndexHeader(out, METH_VPTREE, data_.size());
+
+  ObjectPositionMap objPos(data_);
+
+  if (flatTree_ != NULL) {
+    FlatNodeTable table;
+    GetFlatNodeTable(table);
+    WriteBinaryPOD(out, static_cast<uint8_t>(kVPTreeFlat));
+    WriteBinaryVector(out, table.isBucket_);
+    WriteBinaryVector(out, table.mediandist_);
+    WriteBinaryVector(out, table.leftChild_);
+    WriteBinaryVector(out, table.rightChild_);
+    WriteBinaryVector(out, table.objStart_);
+    WriteObjectPositions(out, objPos, table.objs_);
+  } else if (root_ != NULL) {
+    WriteBinaryPOD(out, static_cast<uint8_t>(kVPTreePreOrder));
+    SaveNode(out, objPos, root_);
+  } else {
+    WriteBinaryPOD(out, static_cast<uint8_t>(kVPTreeEmpty));
+  }
+  out.close();
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::LoadIndex(const string& location) {
+  if (!SearchOracle::IsDataIndependent()) {
+    throw runtime_error("Loading of the index is not supported for the search oracle: " + SearchOracle::GetName() +
+                        " (the oracle is learned from the data and it is not stored in the index)");
+  }
+  std::ifstream in;
+  OpenIndexFileForReading(location, in);
+  ReadIndexHeader(in, METH_VPTREE, data_.size());
+
+  delete root_;
+  root_ = NULL;
+  delete [] flatTree_;
+  flatTree_ = NULL;
+  flatTreeSize_ = 0;
+  flatOracles_.clear();
+
+  uint8_t layout;
+  ReadBinaryPOD(in, layout);
+  if (layout == kVPTreePreOrder) {
+    root_ = LoadNode(in, 0);
+    if (Flatten_) Flatten();
+  } else if (layout == kVPTreeFlat) {
+    FlatNodeTable table;
+    ReadBinaryVector(in, table.isBucket_);
+    ReadBinaryVector(in, table.mediandist_);
+    ReadBinaryVector(in, table.leftChild_);
+    ReadBinaryVector(in, table.rightChild_);
+    ReadBinaryVector(in, table.objStart_);
+    ReadObjectPositions(in, data_, table.objs_);
+
+    const size_t nodeQty = table.isBucket_.size();
+    if (table.mediandist_.size() != nodeQty ||
+        table.leftChild_.size() != nodeQty || table.rightChild_.size() != nodeQty ||
+        table.objStart_.size() != nodeQty + 1 || table.objStart_.back() != table.objs_.size()) {
+      throw runtime_error("Corrupt index file: inconsistent VP-tree node table");
+    }
+    // Parents precede children, so levels can be computed in one pass
+    vector<unsigned> level(nodeQty);
+    table.oracles_.resize(nodeQty);
+    for (size_t i = 0; i < nodeQty; ++i) {
+      if (table.objStart_[i] > table.objStart_[i + 1]) throw runtime_error("Corrupt index file: inconsistent VP-tree node table");
+      for (uint32_t child : { table.leftChild_[i], table.rightChild_[i] }) {
+        if (child != 0) {
+          if (child <= i || child >= nodeQty) throw runtime_error("Corrupt index file: a VP-tree node index is out of range");
+          level[child] = level[i] + 1;
+        }
+      }
+      if (!table.isBucket_[i]) {
+        if (table.objStart_[i] + 1 != table.objStart_[i + 1]) throw runtime_error("Corrupt index file: a VP-tree inner node should have one pivot");
+        table.oracles_[i] = OracleCreator_.Create(level[i], table.objs_[table.objStart_[i]], DistObjectPairVector<dist_t>());
+      }
+    }
+    CreateFlatTree(table);
+  } else if (layout != kVPTreeEmpty) {
+    throw runtime_error("Corrupt index file: unknown VP-tree layout");
+  }
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::Flatten() {
+  if (root_ == NULL) return;
+
+  FlatNodeTable table;
+  // The breadth-first traversal: nodes are numbered in the order they are added
+  vector<VPNode*> nodes(1, root_);
+  table.objStart_.push_back(0);
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    VPNode* node = nodes[i];
+    uint32_t left = 0, right = 0;
+    if (node->bucket_ != NULL) {
+      table.objs_.insert(table.objs_.end(), node->bucket_->begin(), node->bucket_->end());
+      table.oracles_.push_back(NULL);
+    } else {
+      table.objs_.push_back(node->pivot_);
+      // The oracle is moved to the flattened tree
+      table.oracles_.push_back(node->oracle_);
+      node->oracle_ = NULL;
+      if (node->left_child_) {
+        left = nodes.size();
+        nodes.push_back(node->left_child_);
+      }
+      if (node->right_child_) {
+        right = nodes.size();
+        nodes.push_back(node->right_child_);
+      }
+    }
+    table.isBucket_.push_back(node->bucket_ != NULL);
+    table.mediandist_.push_back(node->mediandist_);
+    table.leftChild_.push_back(left);
+    table.rightChild_.push_back(right);
+    table.objStart_.push_back(table.objs_.size());
+  }
+  // Objects are copied, so the pointer-based tree can be deleted only afterwards
+  CreateFlatTree(table);
+  delete root_;
+  root_ = NULL;
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::CreateFlatTree(FlatNodeTable& table) {
+  const size_t nodeQty = table.isBucket_.size();
+  vector<uint64_t> offsets(nodeQty);
+
+  size_t totalSize = 0;
+  for (size_t i = 0; i < nodeQty; ++i) {
+    offsets[i] = totalSize;
+    totalSize += sizeof(FlatNode);
+    for (size_t k = table.objStart_[i]; k < table.objStart_[i + 1]; ++k) {
+      totalSize += FlatObjectSize(table.objs_[k]);
+    }
+  }
+
+  delete [] flatTree_;
+  flatTree_ = new char[totalSize];
+  flatTreeSize_ = totalSize;
+  memset(flatTree_, 0, totalSize);
+  flatOracles_.clear();
+  flatOracles_.reserve(nodeQty);
+
+  for (size_t i = 0; i < nodeQty; ++i) {
+    FlatNode* node = reinterpret_cast<FlatNode*>(flatTree_ + offsets[i]);
+    // The root has the offset zero and it is nobody's child
+    node->leftChild_  = table.leftChild_[i]  ? offsets[table.leftChild_[i]]  : 0;
+    node->rightChild_ = table.rightChild_[i] ? offsets[table.rightChild_[i]] : 0;
+    node->mediandist_ = table.mediandist_[i];
+    node->objQty_     = table.objStart_[i + 1] - table.objStart_[i];
+    node->isBucket_   = table.isBucket_[i];
+    node->oracleId_   = 0;
+    if (!table.isBucket_[i]) {
+      node->oracleId_ = flatOracles_.size();
+      flatOracles_.push_back(std::move(*table.oracles_[i]));
+      delete table.oracles_[i];
+      table.oracles_[i] = NULL;
+    }
+    char* p = reinterpret_cast<char*>(node + 1);
+    for (size_t k = table.objStart_[i]; k < table.objStart_[i + 1]; ++k) {
+      const Object* obj = table.objs_[k];
+      memcpy(p + sizeof(Object), obj->buffer(), obj->bufferlength());
+      new (p) Object(p + sizeof(Object));
+      p += FlatObjectSize(obj);
+    }
+  }
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+size_t VPTree<dist_t, SearchOracle, SearchOracleCreator>::FlatNodeSize(uint64_t offset) const {
+  const FlatNode* node = reinterpret_cast<const FlatNode*>(flatTree_ + offset);
+  const char* p = reinterpret_cast<const char*>(node + 1);
+  for (uint32_t i = 0; i < node->objQty_; ++i) {
+    p += FlatObjectSize(reinterpret_cast<const Object*>(p));
+  }
+  return p - reinterpret_cast<const char*>(node);
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::GetFlatNodeTable(FlatNodeTable& table) const {
+  // Nodes follow each other in the breadth-first order
+  vector<uint64_t> offsets;
+  for (uint64_t offset = 0; offset < flatTreeSize_; offset += FlatNodeSize(offset)) {
+    offsets.push_back(offset);
+  }
+  auto NodeIndex = [&offsets](uint64_t offset) -> uint32_t {
+    return offset ? std::lower_bound(offsets.begin(), offsets.end(), offset) - offsets.begin() : 0;
+  };
+
+  table = FlatNodeTable();
+  table.objStart_.push_back(0);
+  for (uint64_t offset : offsets) {
+    const FlatNode* node = reinterpret_cast<const FlatNode*>(flatTree_ + offset);
+    table.isBucket_.push_back(node->isBucket_ != 0);
+    table.mediandist_.push_back(node->mediandist_);
+    table.leftChild_.push_back(NodeIndex(node->leftChild_));
+    table.rightChild_.push_back(NodeIndex(node->rightChild_));
+    const char* p = reinterpret_cast<const char*>(node + 1);
+    for (uint32_t i = 0; i < node->objQty_; ++i) {
+      const Object* obj = reinterpret_cast<const Object*>(p);
+      table.objs_.push_back(obj);
+      p += FlatObjectSize(obj);
+    }
+    table.objStart_.push_back(table.objs_.size());
+  }
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::SaveNode(std::ostream& out, 
+                                                                 const ObjectPositionMap& objPos,
+                                                                 const VPNode* node) const {
+  if (node->bucket_) {
+    WriteBinaryPOD(out, static_cast<uint8_t>(kVPTreeBucket));
+    WriteObjectPositions(out, objPos, *node->bucket_);
+    return;
+  }
+  WriteBinaryPOD(out, static_cast<uint8_t>(kVPTreeInnerNode));
+  WriteBinaryPOD(out, objPos.GetPos(node->pivot_));
+  WriteBinaryPOD(out, node->mediandist_);
+  WriteBinaryPOD(out, static_cast<uint8_t>(node->left_child_ != NULL));
+  WriteBinaryPOD(out, static_cast<uint8_t>(node->right_child_ != NULL));
+  if (node->left_child_)  SaveNode(out, objPos, node->left_child_);
+  if (node->right_child_) SaveNode(out, objPos, node->right_child_);
+}
+
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+typename VPTree<dist_t, SearchOracle, SearchOracleCreator>::VPNode* 
+VPTree<dist_t, SearchOracle, SearchOracleCreator>::LoadNode(std::istream& in, unsigned level) const {
+  unique_ptr<VPNode> node(new VPNode());
+
+  uint8_t nodeType;
+  ReadBinaryPOD(in, nodeType);
+
+  if (nodeType == kVPTreeBucket) {
+    ObjectVector bucket;
+    ReadObjectPositions(in, data_, bucket);
+    if (ChunkBucket_) {
+      CreateCacheOptimizedBucket(bucket, node->CacheOptimizedBucket_, node->bucket_);
+    } else {
+      node->bucket_ = new ObjectVector(bucket);
+    }
+    return node.release();
+  }
+  if (nodeType != kVPTreeInnerNode) throw runtime_error("Corrupt index file: unknown VP-tree node type");
+
+  uint64_t pivotPos;
+  uint8_t  hasLeft, hasRight;
+  ReadBinaryPOD(in, pivotPos);
+  ReadBinaryPOD(in, node->mediandist_);
+  ReadBinaryPOD(in, hasLeft);
+  ReadBinaryPOD(in, hasRight);
+
+  node->pivot_  = GetObjectByPos(data_, pivotPos);
+  node->oracle_ = OracleCreator_.Create(level, node->pivot_, DistObjectPairVector<dist_t>());
+
+  if (hasLeft)  node->left_child_  = LoadNode(in, level + 1);
+  if (hasRight) node->right_child_ = LoadNode(in, level + 1);
+
+  return node.release();
 }
 
 template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
 void VPTree<dist_t, SearchOracle, SearchOracleCreator>::VPNode::CreateBucket(bool ChunkBucket, 
                                                                              const ObjectVector& data, 
                                                                              bool PrintProgress,
-                                                                             size_t&  IndexedQty,
+                                                                             std::atomic<size_t>&  IndexedQty,
                                                                              size_t   TotalQty) {
     if (ChunkBucket) {
       CreateCacheOptimizedBucket(data, CacheOptimizedBucket_, bucket_);
     } else {
       bucket_ = new ObjectVector(data);
     }
-    IndexedQty += data.size();
-    if (PrintProgress) std::cout << "\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\bBuilding an index: " << std::round(1000.0 * IndexedQty / TotalQty)/10.0 << "% done     \r"; // Note the trailing spaces - they are to compensate differences in output length.
+    const size_t qty = IndexedQty += data.size();
+    // Buckets can be created by the builder's threads, so the output is serialized
+    if (PrintProgress) {
+      static std::mutex ProgressMutex;
+      std::lock_guard<std::mutex> lock(ProgressMutex);
+      std::cout << "\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\bBuilding an index: " << std::round(1000.0 * qty / TotalQty)/10.0 << "% done     \r"; // Note the trailing spaces - they are to compensate differences in output length.
+    }
 }
 
 template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
@@ -109,12 +512,13 @@ VPTree<dist_t, SearchOracle, SearchOracleCreator>::VPNode::VPNode(
                                bool     PrintProgress,
                                unsigned level,
                                size_t   TotalQty,
-                               size_t&  IndexedQty,
+                               std::atomic<size_t>&  IndexedQty,
                                const SearchOracleCreator& OracleCreator,
                                const Space<dist_t>* space, const ObjectVector& data,
                                size_t BucketSize, bool ChunkBucket,
                                const string& SaveHistFileName,
-                               bool use_random_center, bool is_root)
+                               bool use_random_center, bool is_root,
+                               ParallelTreeBuilder* builder)
     : pivot_(NULL), mediandist_(0),
       left_child_(NULL), right_child_(NULL), oracle_(NULL),
       bucket_(NULL), CacheOptimizedBucket_(NULL) 
@@ -130,14 +534,14 @@ VPTree<dist_t, SearchOracle, SearchOracleCreator>::VPNode::VPNode(
   pivot_ = data[index];
 
   if (data.size() >= 2) {
-    DistObjectPairVector<dist_t> dp;
-    for (size_t i = 0; i < data.size(); ++i) {
-      if (i == index) {
-        continue;
-      }
+    DistObjectPairVector<dist_t> dp(data.size() - 1);
+    // The i-th pair corresponds to the data point with the index i (if i < index) or i + 1
+    auto ComputeDist = [this, &dp, &data, space, index](size_t i) {
+      const Object* obj = data[i < index ? i : i + 1];
       // Distance can be asymmetric, the pivot is always on the left side!
-      dp.push_back(std::make_pair(space->IndexTimeDistance(pivot_, data[i]), data[i]));
-    }
+      dp[i] = std::make_pair(space->IndexTimeDistance(pivot_, obj), obj);
+    };
+    BuildParallelFor(builder, dp.size(), ComputeDist);
 
     std::sort(dp.begin(), dp.end(), DistObjectPairAscComparator<dist_t>());
     DistObjectPair<dist_t>  medianDistObj = GetMedian(dp);
@@ -213,13 +617,22 @@ VPTree<dist_t, SearchOracle, SearchOracleCreator>::VPNode::VPNode(
         return;
     }
 
-    if (!left.empty()) {
-      left_child_ = new VPNode(PrintProgress, level + 1, TotalQty, IndexedQty, OracleCreator, space, left, BucketSize, ChunkBucket, "", use_random_center, false);
-    }
+    // Small subtrees are queued: they will be created by the builder's threads
+    auto CreateChild = [&](VPNode*& child, ObjectVector& ChildData) {
+      if (builder && ChildData.size() <= builder->GetSubtreeQty()) {
+        // Data points are moved rather than copied to the task
+        std::shared_ptr<ObjectVector> pChildData(new ObjectVector());
+        pChildData->swap(ChildData);
+        builder->AddSubtreeTask([=, &child, &IndexedQty, &OracleCreator]() {
+          child = new VPNode(PrintProgress, level + 1, TotalQty, IndexedQty, OracleCreator, space, *pChildData, BucketSize, ChunkBucket, "", use_random_center, false, NULL);
+        });
+      } else {
+        child = new VPNode(PrintProgress, level + 1, TotalQty, IndexedQty, OracleCreator, space, ChildData, BucketSize, ChunkBucket, "", use_random_center, false, builder);
+      }
+    };
 
-    if (!right.empty()) {
-      right_child_ = new VPNode(PrintProgress, level + 1, TotalQty, IndexedQty, OracleCreator, space, right, BucketSize, ChunkBucket, "", use_random_center, false);
-    }
+    if (!left.empty()) CreateChild(left_child_, left);
+    if (!right.empty()) CreateChild(right_child_, right);
   }
 }
 
@@ -232,41 +645,134 @@ VPTree<dist_t, SearchOracle, SearchOracleCreator>::VPNode::~VPNode() {
 }
 
 template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
-template <typename QueryType>
-void VPTree<dist_t, SearchOracle, SearchOracleCreator>::VPNode::GenericSearch(QueryType* query,
-                                                                          int& MaxLeavesToVisit) {
+template <typename NodeRef, typename QueryType, typename Kernel>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::GenericSearch(NodeRef node,
+                                                                      QueryType* query,
+                                                                      const Kernel& kernel,
+                                                                      int& MaxLeavesToVisit) {
   if (MaxLeavesToVisit <= 0) return; // early termination
-  if (bucket_) {
+  if (node.IsBucket()) {
     --MaxLeavesToVisit;
 
-    for (unsigned i = 0; i < bucket_->size(); ++i) {
-      const Object* Obj = (*bucket_)[i];
-      dist_t distQC = query->DistanceObjLeft(Obj);
+    node.ForEachObject([query, &kernel](const Object* Obj) {
+      dist_t distQC = kernel.DistanceObjLeft(query, Obj);
       query->CheckAndAddToResult(distQC, Obj);
-    }
+    });
     return;
   }
 
+  const Object*  pivot = node.Pivot();
+  const float    mediandist = node.Median();
+  SearchOracle&  oracle = node.Oracle();
+
   // Distance can be asymmetric, the pivot is always on the left side (see the function that create the node)!
-  dist_t distQC = query->DistanceObjLeft(pivot_);
-  query->CheckAndAddToResult(distQC, pivot_);
+  dist_t distQC = kernel.DistanceObjLeft(query, pivot);
+  query->CheckAndAddToResult(distQC, pivot);
 
-  if (distQC < mediandist_) {      // the query is inside
+  if (distQC < mediandist) {      // the query is inside
     // then first check inside
-    if (left_child_ != NULL && oracle_->Classify(distQC, query->Radius(), mediandist_) != kVisitRight)
-       left_child_->GenericSearch(query, MaxLeavesToVisit);
+    if (node.HasLeft() && oracle.Classify(distQC, query->Radius(), mediandist) != kVisitRight)
+       GenericSearch(node.Left(), query, kernel, MaxLeavesToVisit);
 
     // after that outside
-    if (right_child_ != NULL && oracle_->Classify(distQC, query->Radius(), mediandist_) != kVisitLeft)
-       right_child_->GenericSearch(query, MaxLeavesToVisit);
+    if (node.HasRight() && oracle.Classify(distQC, query->Radius(), mediandist) != kVisitLeft)
+       GenericSearch(node.Right(), query, kernel, MaxLeavesToVisit);
   } else {                         // the query is outside
     // then first check outside
-    if (right_child_ != NULL && oracle_->Classify(distQC, query->Radius(), mediandist_) != kVisitLeft)
-       right_child_->GenericSearch(query, MaxLeavesToVisit);
+    if (node.HasRight() && oracle.Classify(distQC, query->Radius(), mediandist) != kVisitLeft)
+       GenericSearch(node.Right(), query, kernel, MaxLeavesToVisit);
 
     // after that inside
-    if (left_child_ != NULL && oracle_->Classify(distQC, query->Radius(), mediandist_) != kVisitRight)
-      left_child_->GenericSearch(query, MaxLeavesToVisit);
+    if (node.HasLeft() && oracle.Classify(distQC, query->Radius(), mediandist) != kVisitRight)
+      GenericSearch(node.Left(), query, kernel, MaxLeavesToVisit);
+  }
+}
+
+/*
+ * For each query, children are visited in the same order as in GenericSearch
+ * and the oracle is consulted right before a child is visited. Thus, every
+ * query gets exactly the same result and the same number of distance computations.
+ * Queries inside the median ball go left and then right, the remaining ones
+ * go right and then left:
+ *
+ *  1) queries inside the ball visit the left child;
+ *  2) all queries that need the right child visit it;
+ *  3) queries outside the ball visit the left child.
+ */
+template <typename dist_t, typename SearchOracle, typename SearchOracleCreator>
+template <typename NodeRef, typename QueryType, typename Kernel>
+void VPTree<dist_t, SearchOracle, SearchOracleCreator>::GenericSearchBatch(
+                                                              NodeRef node,
+                                                              const vector<QueryType*>& queries,
+                                                              const Kernel& kernel,
+                                                              vector<int>& MaxLeavesToVisit,
+                                                              const vector<size_t>& qids) {
+  if (node.IsBucket()) {
+    for (size_t qid : qids) {
+      if (MaxLeavesToVisit[qid] <= 0) continue; // early termination
+      --MaxLeavesToVisit[qid];
+
+      QueryType* query = queries[qid];
+      node.ForEachObject([query, &kernel](const Object* Obj) {
+        dist_t distQC = kernel.DistanceObjLeft(query, Obj);
+        query->CheckAndAddToResult(distQC, Obj);
+      });
+    }
+    return;
+  }
+
+  const Object*  pivot = node.Pivot();
+  const float    mediandist = node.Median();
+  SearchOracle&  oracle = node.Oracle();
+
+  vector<size_t>  InsideIds,  OutsideIds;
+  vector<dist_t>  InsideDist, OutsideDist;
+
+  for (size_t qid : qids) {
+    if (MaxLeavesToVisit[qid] <= 0) continue; // early termination
+    QueryType* query = queries[qid];
+    // Distance can be asymmetric, the pivot is always on the left side (see the function that create the node)!
+    dist_t distQC = kernel.DistanceObjLeft(query, pivot);
+    query->CheckAndAddToResult(distQC, pivot);
+    if (distQC < mediandist) {
+      InsideIds.push_back(qid);
+      InsideDist.push_back(distQC);
+    } else {
+      OutsideIds.push_back(qid);
+      OutsideDist.push_back(distQC);
+    }
+  }
+
+  vector<size_t> VisitIds;
+
+  if (node.HasLeft()) {
+    for (size_t i = 0; i < InsideIds.size(); ++i) {
+      if (oracle.Classify(InsideDist[i], queries[InsideIds[i]]->Radius(), mediandist) != kVisitRight)
+        VisitIds.push_back(InsideIds[i]);
+    }
+    if (!VisitIds.empty()) GenericSearchBatch(node.Left(), queries, kernel, MaxLeavesToVisit, VisitIds);
+  }
+
+  if (node.HasRight()) {
+    VisitIds.clear();
+    for (size_t i = 0; i < OutsideIds.size(); ++i) {
+      if (oracle.Classify(OutsideDist[i], queries[OutsideIds[i]]->Radius(), mediandist) != kVisitLeft)
+        VisitIds.push_back(OutsideIds[i]);
+    }
+    for (size_t i = 0; i < InsideIds.size(); ++i) {
+      if (oracle.Classify(InsideDist[i], queries[InsideIds[i]]->Radius(), mediandist) != kVisitLeft)
+        VisitIds.push_back(InsideIds[i]);
+    }
+    if (!VisitIds.empty()) GenericSearchBatch(node.Right(), queries, kernel, MaxLeavesToVisit, VisitIds);
+  }
+
+  if (node.HasLeft()) {
+    VisitIds.clear();
+    for (size_t i = 0; i < OutsideIds.size(); ++i) {
+      if (oracle.Classify(OutsideDist[i], queries[OutsideIds[i]]->Radius(), mediandist) != kVisitRight)
+        VisitIds.push_back(OutsideIds[i]);
+    }
+    if (!VisitIds.empty()) GenericSearchBatch(node.Left(), queries, kernel, MaxLeavesToVisit, VisitIds);
   }
 }
 
@@ -57,6 +57,10 @@ void ParseCommandLine(int argc, char*argv[],
                       vector<unsigned>&       knn,
                       float&                  eps,
                       string&                 RangeArg,
+                      string&                 SaveIndexPrefix,
+                      string&                 LoadIndexPrefix,
+                      unsigned&               ThreadGSQty,
+                      string&                 CachePrefixGS,
                       vector<shared_ptr<MethodWithParams>>& pars) {
   knn.clear();
   RangeArg.clear();
@@ -105,6 +109,16 @@ void ParseCommandLine(int argc, char*argv[],
                         "output file prefix")
     ("appendToResFile", po::value<bool>(&AppendToResFile)->default_value(false),
                         "do not override information in results files, append new data")
+    ("saveIndex",       po::value<string>(&SaveIndexPrefix)->default_value(""),
+                        "if specified, indices are saved to files with this prefix")
+    ("loadIndex",       po::value<string>(&LoadIndexPrefix)->default_value(""),
+                        "if specified, indices are loaded from files with this prefix"
+                        " (rather than being created)")
+    ("threadGSQty",     po::value<unsigned>(&ThreadGSQty)->default_value(0),
+                        "# of threads used to compute the gold standard data (0 means the # of cores)")
+    ("cachePrefixGS",   po::value<string>(&CachePrefixGS)->default_value(""),
+                        "if specified, the gold standard data is cached in files with this prefix"
+                        " (and is reused, if it was computed for the same data, queries, and space)")
 
     ;
 
@@ -183,6 +197,14 @@ void ParseCommandLine(int argc, char*argv[],
   if (!MaxNumQuery && QueryFile.empty()) {
     LOG(LIB_FATAL) << "Set a positive # of queries or specify a query file!"; 
   }
+
+  /*
+   * Without a query file, queries are randomly selected from the data set.
+   * Thus, each run would produce a different set of data points.
+   */
+  if ((!SaveIndexPrefix.empty() || !LoadIndexPrefix.empty()) && QueryFile.empty()) {
+    LOG(LIB_FATAL) << "Saving and loading of indices requires a query file!";
+  }
 }
 
 };
@@ -28,7 +28,8 @@ template <typename dist_t>
 Query<dist_t>::Query(const Space<dist_t>* space, const Object* query_object)
     : space_(space),
       query_object_(query_object),
-      distance_computations_(0) {
+      distance_computations_(0),
+      use_proxy_distance_(false) {
 }
 
 template <typename dist_t>
@@ -55,7 +56,8 @@ dist_t Query<dist_t>::Distance(
     const Object* object1,
     const Object* object2) {
   ++distance_computations_;
-  return space_->HiddenDistance(object1, object2);
+  return use_proxy_distance_ ? space_->ProxyDistance(object1, object2) :
+                               space_->HiddenDistance(object1, object2);
 }
 
 template <typename dist_t>
@@ -68,6 +70,16 @@ dist_t Query<dist_t>::DistanceObjRight(const Object* object) {
   return Distance(query_object_, object);
 }
 
+template <typename dist_t>
+void Query<dist_t>::DistanceObjLeftBlock(const Object* const* objs, size_t qty, dist_t* dists) {
+  distance_computations_ += qty;
+  if (use_proxy_distance_) {
+    for (size_t i = 0; i < qty; ++i) dists[i] = space_->ProxyDistance(objs[i], query_object_);
+  } else {
+    space_->HiddenDistanceBlock(objs, qty, query_object_, dists);
+  }
+}
+
 template class Query<float>;
 template class Query<double>;
 template class Query<int>;
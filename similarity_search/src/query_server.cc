@@ -0,0 +1,587 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+/*
+ * A search server: the index is created (or loaded) once and then queries
+ * are read from the standard input or from connections to a Unix domain socket.
+ * A query is a line in the data file format. Queries are answered by
+ * a pool of worker threads (see work_stealing_pool.h) and answers are
+ * written in the order of completion, one line per query:
+ *
+ * <query #>\t<id>:<distance>\t<id>:<distance>...
+ *
+ * where query # is the (0-based) number of the query line (empty lines
+ * are skipped) and the results are sorted by the distance. If the query
+ * cannot be answered, the line is:
+ *
+ * <query #>\terror: <message>
+ *
+ * When the input is closed, the server logs the throughput as well as the
+ * percentiles of latencies. The latency is measured from the moment the
+ * query is read till the moment the answer is written, i.e., it includes
+ * the queueing delay. Thus, it is possible to measure tail latencies
+ * under sustained load, e.g., by piping a stream of queries.
+ * Percentiles are computed using histograms with a fixed number of buckets
+ * (see TimeHistogram): the memory footprint doesn't grow with the number
+ * of queries, but percentiles are approximate.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+#include <cmath>
+#include <cstring>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include <boost/program_options.hpp>
+
+#include "init.h"
+#include "global.h"
+#include "utils.h"
+#include "ztimer.h"
+#include "space.h"
+#include "spacefactory.h"
+#include "methodfactory.h"
+#include "experimentconf.h"
+#include "knnquery.h"
+#include "knnqueue.h"
+#include "rangequery.h"
+#include "params.h"
+#include "logging.h"
+#include "work_stealing_pool.h"
+
+using namespace similarity;
+using std::string;
+using std::vector;
+using std::unique_ptr;
+using std::shared_ptr;
+using std::stringstream;
+using std::mutex;
+using std::unique_lock;
+using std::condition_variable;
+using std::thread;
+using std::runtime_error;
+
+namespace po = boost::program_options;
+
+class QueryStream {
+public:
+  virtual ~QueryStream() {}
+  // Returns false when the input is closed
+  virtual bool ReadLine(string& line) = 0;
+  virtual void WriteLine(const string& line) = 0;
+};
+
+class StdQueryStream : public QueryStream {
+public:
+  virtual bool ReadLine(string& line) {
+    return static_cast<bool>(std::getline(std::cin, line));
+  }
+  virtual void WriteLine(const string& line) {
+    std::cout << line << std::endl;
+  }
+};
+
+#ifndef _WIN32
+class SocketQueryStream : public QueryStream {
+public:
+  explicit SocketQueryStream(int fd) : fd_(fd), start_(0) {}
+  ~SocketQueryStream() { close(fd_); }
+
+  virtual bool ReadLine(string& line) {
+    while (true) {
+      size_t pos = buf_.find('\n', start_);
+      if (pos != string::npos) {
+        line.assign(buf_, start_, pos - start_);
+        start_ = pos + 1;
+        return true;
+      }
+      buf_.erase(0, start_);
+      start_ = 0;
+
+      char    tmp[65536];
+      ssize_t qty = read(fd_, tmp, sizeof tmp);
+      if (qty < 0 && errno == EINTR) continue;
+      if (qty <= 0) {
+        // The last line doesn't have to end with a newline
+        if (buf_.empty()) return false;
+        line.swap(buf_);
+        buf_.clear();
+        return true;
+      }
+      buf_.append(tmp, qty);
+    }
+  }
+  virtual void WriteLine(const string& line) {
+    string      out = line + "\n";
+    const char* p = out.data();
+    size_t      qty = out.size();
+
+    while (qty) {
+      ssize_t res = send(fd_, p, qty, MSG_NOSIGNAL);
+      if (res < 0 && errno == EINTR) continue;
+      // The client is gone, its answers are discarded
+      if (res <= 0) return;
+      p += res;
+      qty -= res;
+    }
+  }
+
+private:
+  int     fd_;
+  string  buf_;
+  size_t  start_;
+
+  DISABLE_COPY_AND_ASSIGN(SocketQueryStream);
+};
+#endif
+
+/*
+ * A histogram of times (in microseconds), which has a fixed memory footprint
+ * no matter how many queries are answered. Times smaller than kSubBucketQty 
+ * are counted exactly. Larger times are split into buckets, whose width is
+ * 1/kSubBucketQty of their lower bound. Thus, the relative error 
+ * of percentiles is smaller than 1/kSubBucketQty (about 1.6%).
+ */
+class TimeHistogram {
+public:
+  TimeHistogram() : Counts_(kBucketQty), Qty_(0), Sum_(0), Max_(0) {}
+
+  void Add(uint64_t t) {
+    ++Counts_[GetBucketId(t)];
+    ++Qty_;
+    Sum_ += t;
+    Max_ = std::max(Max_, t);
+  }
+  uint64_t GetQty() const { return Qty_; }
+  double GetMean() const { return Qty_ ? static_cast<double>(Sum_) / Qty_ : 0; }
+  uint64_t GetMax() const { return Max_; }
+  // The percentile is in [0, 100], the upper bound of its bucket is returned
+  uint64_t GetPercentile(double perc) const {
+    if (!Qty_) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(perc / 100 * Qty_));
+    if (!rank) rank = 1;
+
+    uint64_t qty = 0;
+    for (size_t id = 0; id < kBucketQty; ++id) {
+      qty += Counts_[id];
+      if (qty >= rank) return std::min(Max_, GetBucketMax(id));
+    }
+    return Max_;
+  }
+
+private:
+  static const unsigned kSubBucketBits = 6;
+  static const uint64_t kSubBucketQty  = 1 << kSubBucketBits;
+  // Exact values plus kSubBucketQty buckets for each position of the highest bit
+  static const size_t   kBucketQty     = kSubBucketQty * (64 - kSubBucketBits + 1);
+
+  static unsigned GetHighestBit(uint64_t t) {
+    unsigned bit = 0;
+    while (t >>= 1) ++bit;
+    return bit;
+  }
+  static size_t GetBucketId(uint64_t t) {
+    if (t < kSubBucketQty) return t;
+    const unsigned bit = GetHighestBit(t);
+    // kSubBucketBits bits that follow the highest one
+    const uint64_t sub = (t >> (bit - kSubBucketBits)) & (kSubBucketQty - 1);
+    return kSubBucketQty * (bit - kSubBucketBits + 1) + sub;
+  }
+  static uint64_t GetBucketMax(size_t id) {
+    if (id < kSubBucketQty) return id;
+    const unsigned bit   = id / kSubBucketQty + kSubBucketBits - 1;
+    const unsigned shift = bit - kSubBucketBits;
+    const uint64_t sub   = id % kSubBucketQty;
+    return ((uint64_t(1) << bit) | (sub << shift)) + (uint64_t(1) << shift) - 1;
+  }
+
+  vector<uint64_t>  Counts_;
+  uint64_t          Qty_;
+  uint64_t          Sum_;
+  uint64_t          Max_;
+};
+
+void LogTimes(const string& Desc, const TimeHistogram& times) {
+  LOG(LIB_INFO) << Desc << " (ms): mean: " << times.GetMean() / 1e3
+                << " p50: "   << times.GetPercentile(50) / 1e3
+                << " p99: "   << times.GetPercentile(99) / 1e3
+                << " p99.9: " << times.GetPercentile(99.9) / 1e3
+                << " max: "   << times.GetMax() / 1e3;
+}
+
+template <typename dist_t>
+class QueryServer {
+public:
+  QueryServer(const Space<dist_t>* space, const ObjectVector& data, Index<dist_t>& index,
+              unsigned K, float eps, const vector<dist_t>& range) :
+              space_(space), index_(index), K_(K), eps_(eps), range_(range), ObjSize_(0) {
+    /*
+     * If all data objects have the same size (e.g., dense vectors),
+     * queries of a different size are rejected: methods expect
+     * queries to have the same size as data objects.
+     */
+    if (!data.empty()) {
+      ObjSize_ = data[0]->datalength();
+      for (const Object* obj: data) {
+        if (obj->datalength() != ObjSize_) {
+          ObjSize_ = 0;
+          break;
+        }
+      }
+    }
+  }
+
+  // Returns after the input is closed and all the queries are answered
+  void Serve(QueryStream& stream, WorkStealingPool& pool) const {
+    mutex               Guard; // protects the output stream and the variables below
+    condition_variable  AllAnswered;
+    size_t              PendingQty = 0;
+    TimeHistogram       Latencies, SearchTimes;
+
+    WallClockTimer      TotalTime;
+    string              line;
+    size_t              QueryNum = 0;
+
+    while (stream.ReadLine(line)) {
+      if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+      if (line.empty()) continue;
+
+      // The latency clock starts ticking when the query is read
+      WallClockTimer  QueryTime;
+      size_t          qn = QueryNum++;
+
+      {
+        unique_lock<mutex> lock(Guard);
+        ++PendingQty;
+      }
+
+      pool.Submit([&, qn, line, QueryTime]() mutable {
+        uint64_t  SearchTime = 0;
+        string    answer;
+        try {
+          answer = Answer(qn, line, SearchTime);
+        } catch (const std::exception& e) {
+          stringstream str;
+          str << qn << "\terror: " << e.what();
+          answer = str.str();
+        }
+
+        unique_lock<mutex> lock(Guard);
+        stream.WriteLine(answer);
+        Latencies.Add(QueryTime.split());
+        SearchTimes.Add(SearchTime);
+        if (--PendingQty == 0) AllAnswered.notify_all();
+      });
+    }
+
+    unique_lock<mutex> lock(Guard);
+    AllAnswered.wait(lock, [&]() { return PendingQty == 0; });
+    TotalTime.split();
+
+    if (!Latencies.GetQty()) return;
+
+    LOG(LIB_INFO) << "Answered " << Latencies.GetQty() << " queries in " << TotalTime.elapsed() / 1e6
+                  << " sec using " << pool.GetThreadQty() << " threads, throughput: "
+                  << Latencies.GetQty() / (TotalTime.elapsed() / 1e6) << " queries/sec";
+    LogTimes("Latency",     Latencies);
+    LogTimes("Search time", SearchTimes);
+  }
+
+private:
+  // SearchTime is in microseconds
+  string Answer(size_t QueryNum, const string& line, uint64_t& SearchTime) const {
+    unique_ptr<Object> QueryObj(space_->CreateObjFromStr(QueryNum, line));
+
+    if (ObjSize_ && QueryObj->datalength() != ObjSize_) {
+      stringstream err;
+      err << "The query size (" << QueryObj->datalength() << " bytes) "
+          << "doesn't match the size of data objects (" << ObjSize_ << " bytes)";
+      throw runtime_error(err.str());
+    }
+
+    stringstream  out;
+    WallClockTimer  wtm;
+
+    out << QueryNum;
+    if (range_.empty()) {
+      KNNQuery<dist_t> query(space_, QueryObj.get(), K_, eps_);
+
+      wtm.reset();
+      index_.Search(&query);
+      query.Rerank();
+      SearchTime = wtm.split();
+
+      vector<typename KNNQueue<dist_t>::QueueElement> res;
+      query.Result()->GetSortedElements(res);
+      for (const auto& elem: res) {
+        out << "\t" << elem.second->id() << ":" << elem.first;
+      }
+    } else {
+      RangeQuery<dist_t> query(space_, QueryObj.get(), range_[0]);
+
+      wtm.reset();
+      index_.Search(&query);
+      SearchTime = wtm.split();
+
+      vector<std::pair<dist_t, IdType>> res;
+      for (size_t i = 0; i < query.ResultSize(); ++i) {
+        res.push_back(std::make_pair((*query.ResultDists())[i], (*query.Result())[i]->id()));
+      }
+      std::sort(res.begin(), res.end());
+      for (const auto& elem: res) {
+        out << "\t" << elem.second << ":" << elem.first;
+      }
+    }
+    return out.str();
+  }
+
+  const Space<dist_t>*  space_;
+  Index<dist_t>&        index_;
+  unsigned              K_;
+  float                 eps_;
+  const vector<dist_t>& range_;
+  size_t                ObjSize_;
+
+  DISABLE_COPY_AND_ASSIGN(QueryServer);
+};
+
+#ifndef _WIN32
+// Connections are served concurrently, the server never exits
+template <typename dist_t>
+void ServeSocket(const QueryServer<dist_t>& server, WorkStealingPool& pool, const string& SocketPath) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    LOG(LIB_FATAL) << "Cannot create a socket, errno: " << errno;
+  }
+
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  if (SocketPath.size() >= sizeof addr.sun_path) {
+    LOG(LIB_FATAL) << "The socket path is too long: " << SocketPath;
+  }
+  strcpy(addr.sun_path, SocketPath.c_str());
+  unlink(SocketPath.c_str());
+
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0 || listen(fd, SOMAXCONN) < 0) {
+    LOG(LIB_FATAL) << "Cannot listen on the socket: " << SocketPath << " errno: " << errno;
+  }
+  LOG(LIB_INFO) << "Listening on the socket: " << SocketPath;
+
+  while (true) {
+    int conn = accept(fd, NULL, NULL);
+    if (conn < 0) {
+      if (errno != EINTR) LOG(LIB_ERROR) << "Cannot accept a connection, errno: " << errno;
+      continue;
+    }
+    LOG(LIB_INFO) << "Accepted a new connection";
+    thread([&server, &pool, conn]() {
+      SocketQueryStream stream(conn);
+      server.Serve(stream, pool);
+      LOG(LIB_INFO) << "The connection is closed";
+    }).detach();
+  }
+}
+#endif
+
+template <typename dist_t>
+void RunServer(const string& SpaceType, const AnyParams& SpaceParams,
+               const string& DataFile, unsigned MaxNumData,
+               const MethodWithParams& Method,
+               const string& SaveIndexFile, const string& LoadIndexFile,
+               unsigned K, float eps, const string& RangeArg,
+               unsigned ThreadQty, const string& SocketPath) {
+  vector<unsigned>  knn;
+  vector<dist_t>    range;
+
+  if (!RangeArg.empty()) {
+    if (!SplitStr(RangeArg, range, ',') || range.size() != 1) {
+      LOG(LIB_FATAL) << "Wrong format of the range argument: '" << RangeArg << "' (expecting a single value)";
+    }
+  } else {
+    knn.push_back(K);
+  }
+
+  /*
+   * There's no query file and only one test set with zero queries.
+   * Thus, all the points are data points.
+   */
+  ExperimentConfig<dist_t> config(SpaceFactoryRegistry<dist_t>::
+                                  Instance().CreateSpace(SpaceType, SpaceParams),
+                                  DataFile, "", 1 /* test set qty */,
+                                  MaxNumData, 0 /* query qty */,
+                                  0 /* dimension */, knn, eps, range);
+  config.ReadDataset();
+  config.SelectTestSet(0);
+
+  unique_ptr<Index<dist_t>> index;
+
+  WallClockTimer wtm;
+
+  if (!LoadIndexFile.empty()) {
+    LOG(LIB_INFO) << "Loading the index from: " << LoadIndexFile;
+    index.reset(MethodFactoryRegistry<dist_t>::Instance().
+                LoadMethod(LoadIndexFile, Method.methName_, SpaceType,
+                           config.GetSpace(), config.GetDataObjects(), Method.methPars_));
+  } else {
+    LOG(LIB_INFO) << "Creating a new index";
+    index.reset(MethodFactoryRegistry<dist_t>::Instance().
+                CreateMethod(true /* print progress */, Method.methName_, SpaceType,
+                             config.GetSpace(), config.GetDataObjects(), Method.methPars_));
+    if (!SaveIndexFile.empty()) {
+      LOG(LIB_INFO) << "Saving the index to: " << SaveIndexFile;
+      index->SaveIndex(SaveIndexFile);
+    }
+  }
+  index->SetQueryTimeParams(Method.methPars_);
+
+  wtm.split();
+  LOG(LIB_INFO) << "The index " << index->ToString() << " is ready, time elapsed: "
+                << wtm.elapsed() / 1e6 << " sec";
+
+  QueryServer<dist_t> server(config.GetSpace(), config.GetDataObjects(), *index, K, eps, range);
+  WorkStealingPool    pool(ThreadQty);
+
+  LOG(LIB_INFO) << "# of search threads: " << pool.GetThreadQty();
+
+  if (SocketPath.empty()) {
+    StdQueryStream stream;
+    server.Serve(stream, pool);
+  } else {
+#ifndef _WIN32
+    ServeSocket(server, pool, SocketPath);
+#else
+    LOG(LIB_FATAL) << "Unix domain sockets are not supported on this platform";
+#endif
+  }
+}
+
+int main(int argc, char* argv[]) {
+  string    SpaceArg, DistType, DataFile, LogFile, MethodArg, RangeArg;
+  string    SaveIndexFile, LoadIndexFile, SocketPath;
+  unsigned  MaxNumData, K, ThreadQty;
+  double    eps;
+
+  po::options_description ProgOptDesc("Allowed options");
+  ProgOptDesc.add_options()
+    ("help,h", "produce help message")
+    ("spaceType,s",     po::value<string>(&SpaceArg)->required(),
+                        "space type, e.g., l1, l2, lp:p=0.25")
+    ("distType",        po::value<string>(&DistType)->default_value("float"),
+                        "distance value type: int, float, double")
+    ("dataFile,i",      po::value<string>(&DataFile)->required(),
+                        "input data file")
+    ("maxNumData",      po::value<unsigned>(&MaxNumData)->default_value(0),
+                        "if non-zero, only the first maxNumData elements are used")
+    ("method,m",        po::value<string>(&MethodArg)->required(),
+                        "a method with comma-separated parameters in the format:\n"
+                        "<method name>:<param1>,<param2>,...,<paramK>")
+    ("knn,k",           po::value<unsigned>(&K)->default_value(10),
+                        "the number of neighbors K for the k-NN search")
+    ("range,r",         po::value<string>(&RangeArg)->default_value(""),
+                        "if specified, the range search with this radius is carried out instead of the k-NN search")
+    ("eps",             po::value<double>(&eps)->default_value(0.0),
+                        "the parameter for the eps-approximate k-NN search.")
+    ("threadQty",       po::value<unsigned>(&ThreadQty)->default_value(0),
+                        "# of search threads (0 means the # of cores)")
+    ("saveIndex",       po::value<string>(&SaveIndexFile)->default_value(""),
+                        "if specified, the index is saved to this file")
+    ("loadIndex",       po::value<string>(&LoadIndexFile)->default_value(""),
+                        "if specified, the index is loaded from this file (rather than being created)")
+    ("socket",          po::value<string>(&SocketPath)->default_value(""),
+                        "if specified, queries are read from connections to this Unix domain socket"
+                        " (rather than from the standard input)")
+    ("logFile,l",       po::value<string>(&LogFile)->default_value(""),
+                        "log file")
+    ;
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, ProgOptDesc), vm);
+    if (vm.count("help")) {
+      std::cout << argv[0] << std::endl << ProgOptDesc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (const std::exception& e) {
+    std::cout << argv[0] << std::endl << ProgOptDesc << std::endl;
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  initLibrary(LogFile.empty() ? LIB_LOGSTDERR:LIB_LOGFILE, LogFile.c_str());
+
+  ToLower(DistType);
+  ToLower(SpaceArg);
+
+  vector<string> tmp;
+  if (!SplitStr(SpaceArg, tmp, ':') || tmp.size() > 2  || !tmp.size()) {
+    LOG(LIB_FATAL) << "Wrong format of the space argument: '" << SpaceArg;
+  }
+  vector<string> SpaceDesc;
+  if (tmp.size() == 2) {
+    if (!SplitStr(tmp[1], SpaceDesc, ',')) {
+      LOG(LIB_FATAL) << "Cannot split space arguments in: " << tmp[1];
+    }
+  }
+  AnyParams SpaceParams(SpaceDesc);
+
+  vector<string> MethTmp;
+  if (!SplitStr(MethodArg, MethTmp, ':') || MethTmp.size() > 2  || !MethTmp.size()) {
+    LOG(LIB_FATAL) << "Wrong format of the method argument: '" << MethodArg;
+  }
+  vector<string> MethodDesc;
+  if (MethTmp.size() == 2) {
+    if (!SplitStr(MethTmp[1], MethodDesc, ',')) {
+      LOG(LIB_FATAL) << "Cannot split method arguments in: " << MethTmp[1];
+    }
+  }
+  MethodWithParams Method(MethTmp[0], MethodDesc);
+
+  try {
+    if ("int" == DistType) {
+      RunServer<int>(tmp[0], SpaceParams, DataFile, MaxNumData, Method,
+                     SaveIndexFile, LoadIndexFile, K, eps, RangeArg, ThreadQty, SocketPath);
+    } else if ("float" == DistType) {
+      RunServer<float>(tmp[0], SpaceParams, DataFile, MaxNumData, Method,
+                       SaveIndexFile, LoadIndexFile, K, eps, RangeArg, ThreadQty, SocketPath);
+    } else if ("double" == DistType) {
+      RunServer<double>(tmp[0], SpaceParams, DataFile, MaxNumData, Method,
+                        SaveIndexFile, LoadIndexFile, K, eps, RangeArg, ThreadQty, SocketPath);
+    } else {
+      LOG(LIB_FATAL) << "Unknown distance value type: " << DistType;
+    }
+  } catch (const std::exception& e) {
+    LOG(LIB_FATAL) << "Exception: " << e.what();
+  }
+
+  return 0;
+}
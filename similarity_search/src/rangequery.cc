@@ -82,15 +82,29 @@ bool RangeQuery<dist_t>::CheckAndAddToResult(const Object* object) {
 
 template <typename dist_t>
 size_t RangeQuery<dist_t>::CheckAndAddToResult(const ObjectVector& bucket) {
+  return CheckAndAddToResult(bucket.data(), bucket.size());
+}
+
+template <typename dist_t>
+size_t RangeQuery<dist_t>::CheckAndAddToResult(const Object* const* objs, size_t qty) {
+  batchDists_.resize(qty);
+  this->DistanceObjLeftBlock(objs, qty, batchDists_.data());
   size_t res = 0;
-  for (size_t i = 0; i < bucket.size(); ++i) {
-    if (CheckAndAddToResult(bucket[i])) {
+  for (size_t i = 0; i < qty; ++i) {
+    if (CheckAndAddToResult(batchDists_[i], objs[i])) {
       ++res;
     }
   }
   return res;
 }
 
+template <typename dist_t>
+void RangeQuery<dist_t>::Merge(const RangeQuery<dist_t>& other) {
+  result_.insert(result_.end(), other.result_.begin(), other.result_.end());
+  resultDists_.insert(resultDists_.end(), other.resultDists_.begin(), other.resultDists_.end());
+  this->distance_computations_ += other.distance_computations_;
+}
+
 template <typename dist_t>
 bool RangeQuery<dist_t>::Equals(const RangeQuery<dist_t>* query) const {
   std::set<const Object*> res1, res2;
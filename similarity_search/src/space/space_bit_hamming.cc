@@ -84,6 +84,8 @@ void SpaceBitHamming::ReadDataset(
   dataset.reserve(MaxNumObjects);
 
   std::vector<uint32_t>    temp;
+  // Objects are placed into the arena provided by the config (if any)
+  ArenaScope arena(*this, config ? config->GetObjectArena() : NULL);
 
   std::ifstream InFile(FileName);
   InFile.exceptions(std::ios::badbit);
@@ -122,7 +124,7 @@ void SpaceBitHamming::ReadDataset(
 }
 
 Object* SpaceBitHamming::CreateObjFromVect(IdType id, LabelType label, const std::vector<uint32_t>& InpVect) const {
-  return new Object(id, label, InpVect.size() * sizeof(uint32_t), &InpVect[0]);
+  return this->CreateObject(id, label, InpVect.size() * sizeof(uint32_t), &InpVect[0]);
 };
 
 }  // namespace similarity
@@ -150,7 +150,7 @@ Object* KLDivGenFast<dist_t>::CreateObjFromVect(IdType id, LabelType label, cons
   temp.resize(2 * InpVect.size());
   // Compute logarithms
   PrecompLogarithms(&temp[0], InpVect.size());
-  return new Object(id, label, temp.size() * sizeof(dist_t), &temp[0]);
+  return this->CreateObject(id, label, temp.size() * sizeof(dist_t), &temp[0]);
 }
 
 
@@ -234,7 +234,7 @@ Object* ItakuraSaitoFast<dist_t>::CreateObjFromVect(IdType id, LabelType label,
   temp.resize(2 * InpVect.size());
   // Compute logarithms
   PrecompLogarithms(&temp[0], InpVect.size());
-  return new Object(id, label, temp.size() * sizeof(dist_t), &temp[0]);
+  return this->CreateObject(id, label, temp.size() * sizeof(dist_t), &temp[0]);
 }
 
 //=============================================================
@@ -253,7 +253,7 @@ dist_t KLDivGenSlow<dist_t>::HiddenDistance(const Object* obj1, const Object* ob
 
 template <typename dist_t>
 Object* KLDivGenSlow<dist_t>::CreateObjFromVect(IdType id, LabelType label, const std::vector<dist_t>& InpVect) const {
-  return new Object(id, label, InpVect.size() * sizeof(dist_t), &InpVect[0]);
+  return this->CreateObject(id, label, InpVect.size() * sizeof(dist_t), &InpVect[0]);
 }
 
 template <typename dist_t>
@@ -276,7 +276,7 @@ Object* KLDivGenFastRightQuery<dist_t>::CreateObjFromVect(IdType id, LabelType l
   temp.resize(2 * InpVect.size());
   // Compute logarithms
   PrecompLogarithms(&temp[0], InpVect.size());
-  return new Object(id, label, temp.size() * sizeof(dist_t), &temp[0]);
+  return this->CreateObject(id, label, temp.size() * sizeof(dist_t), &temp[0]);
 }
 
 //=============================================================
@@ -301,7 +301,7 @@ Object* KLDivFast<dist_t>::CreateObjFromVect(IdType id, LabelType label, const s
   temp.resize(2 * InpVect.size());
   // Compute logarithms
   PrecompLogarithms(&temp[0], InpVect.size());
-  return new Object(id, label, temp.size() * sizeof(dist_t), &temp[0]);
+  return this->CreateObject(id, label, temp.size() * sizeof(dist_t), &temp[0]);
 }
 
 //=============================================================
@@ -326,7 +326,7 @@ Object* KLDivFastRightQuery<dist_t>::CreateObjFromVect(IdType id, LabelType labe
   temp.resize(2 * InpVect.size());
   // Compute logarithms
   PrecompLogarithms(&temp[0], InpVect.size());
-  return new Object(id, label, temp.size() * sizeof(dist_t), &temp[0]);
+  return this->CreateObject(id, label, temp.size() * sizeof(dist_t), &temp[0]);
 }
 
 template class BregmanDiv<float>;
@@ -36,6 +36,19 @@ dist_t SpaceLp<dist_t>::HiddenDistance(const Object* obj1, const Object* obj2) c
   return distObj_(x, y, length);
 }
 
+template <typename dist_t>
+DistKernelDesc SpaceLp<dist_t>::GetDistKernel(const Object* obj) const {
+  if (distObj_.getCustom()) {
+    const size_t ElemQty = obj->datalength() / sizeof(dist_t);
+    switch (static_cast<int>(distObj_.getP())) {
+      case -1: return DistKernelDesc(kDistKernelLInf, ElemQty, obj->datalength());
+      case 1:  return DistKernelDesc(kDistKernelL1, ElemQty, obj->datalength());
+      case 2:  return DistKernelDesc(kDistKernelL2, ElemQty, obj->datalength());
+    }
+  }
+  return DistKernelDesc();
+}
+
 template <typename dist_t>
 std::string SpaceLp<dist_t>::ToString() const {
   std::stringstream stream;
@@ -0,0 +1,374 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "object.h"
+#include "logging.h"
+#include "distcomp.h"
+#include "space/space_quant.h"
+
+namespace similarity {
+
+using namespace std;
+
+OrigVectorStore::OrigVectorStore() : chunks_(MAX_CHUNK_QTY, NULL), chunkQty_(0), size_(0) {
+#ifdef _MSC_VER
+  char dir[MAX_PATH + 1], name[MAX_PATH + 1];
+  if (!GetTempPathA(sizeof dir, dir) || !GetTempFileNameA(dir, "nms", 0, name)) {
+    LOG(LIB_FATAL) << "Cannot create a temporary file to keep original vectors";
+  }
+  hFile_ = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                       FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+  if (hFile_ == INVALID_HANDLE_VALUE) {
+    LOG(LIB_FATAL) << "Cannot create a temporary file: " << name;
+  }
+#else
+  const char* dir = getenv("TMPDIR");
+  string      name = string(dir != NULL && *dir ? dir : "/tmp") + "/nmslib_orig_XXXXXX";
+
+  fd_ = mkstemp(&name[0]);
+  if (fd_ < 0) {
+    LOG(LIB_FATAL) << "Cannot create a temporary file: " << name;
+  }
+  // The file is deleted when it is closed
+  unlink(name.c_str());
+#endif
+}
+
+OrigVectorStore::~OrigVectorStore() {
+  const size_t ChunkSize = CHUNK_ELEM_QTY * sizeof(float);
+#ifdef _MSC_VER
+  for (size_t i = 0; i < chunkQty_; ++i) UnmapViewOfFile(chunks_[i]);
+  for (void* h: hMappings_) CloseHandle(h);
+  CloseHandle(hFile_);
+#else
+  for (size_t i = 0; i < chunkQty_; ++i) munmap(chunks_[i], ChunkSize);
+  close(fd_);
+#endif
+}
+
+void OrigVectorStore::AddChunk() {
+  const uint64_t ChunkSize = CHUNK_ELEM_QTY * sizeof(float);
+  const uint64_t offset    = chunkQty_ * ChunkSize;
+
+  if (chunkQty_ >= MAX_CHUNK_QTY) {
+    LOG(LIB_FATAL) << "Too many original vectors to keep";
+  }
+#ifdef _MSC_VER
+  const uint64_t end = offset + ChunkSize;
+  // The file is extended by the mapping
+  void* h = CreateFileMappingA(hFile_, NULL, PAGE_READWRITE,
+                               static_cast<DWORD>(end >> 32), static_cast<DWORD>(end & 0xFFFFFFFF), NULL);
+  if (h == NULL) {
+    LOG(LIB_FATAL) << "Cannot memory map the file with original vectors";
+  }
+  hMappings_.push_back(h);
+  void* p = MapViewOfFile(h, FILE_MAP_WRITE,
+                          static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset & 0xFFFFFFFF), ChunkSize);
+  if (p == NULL) {
+    LOG(LIB_FATAL) << "Cannot memory map the file with original vectors";
+  }
+#else
+  if (ftruncate(fd_, offset + ChunkSize) != 0) {
+    LOG(LIB_FATAL) << "Cannot extend the file with original vectors";
+  }
+  void* p = mmap(NULL, ChunkSize, PROT_READ, MAP_SHARED, fd_, offset);
+  if (p == MAP_FAILED) {
+    LOG(LIB_FATAL) << "Cannot memory map the file with original vectors";
+  }
+  // Only re-ranked candidates are read
+  madvise(p, ChunkSize, MADV_RANDOM);
+#endif
+  chunks_[chunkQty_++] = reinterpret_cast<float*>(p);
+}
+
+uint64_t OrigVectorStore::Add(const float* pVect, size_t qty) {
+  if (qty > CHUNK_ELEM_QTY) {
+    LOG(LIB_FATAL) << "The vector is too long: " << qty << " elements";
+  }
+  unique_lock<mutex> lock(mutex_);
+
+  uint64_t pos = size_;
+  if (pos + qty > chunkQty_ * CHUNK_ELEM_QTY) {
+    // The vector doesn't fit into the last chunk: it goes to the new one
+    pos = chunkQty_ * CHUNK_ELEM_QTY;
+    AddChunk();
+  }
+#ifdef _MSC_VER
+  if (qty) memcpy(chunks_[pos / CHUNK_ELEM_QTY] + pos % CHUNK_ELEM_QTY, pVect, qty * sizeof(float));
+#else
+  // Writing doesn't touch the mapping: written pages don't stay in the process memory
+  const char* p    = reinterpret_cast<const char*>(pVect);
+  size_t      left = qty * sizeof(float);
+  off_t       offset = pos * sizeof(float);
+  while (left) {
+    ssize_t written = pwrite(fd_, p, left, offset);
+    if (written <= 0) {
+      LOG(LIB_FATAL) << "Cannot write to the file with original vectors";
+    }
+    p += written;
+    offset += written;
+    left -= written;
+  }
+#endif
+  size_ = pos + qty;
+  return pos;
+}
+
+SpaceQuantized::SpaceQuantized(SQDistType distType, SQCodeType codeType, unsigned rerankFactor)
+    : DistType_(distType), CodeType_(codeType), RerankFactor_(rerankFactor),
+      origStore_(rerankFactor ? new OrigVectorStore() : NULL) {
+}
+
+string SpaceQuantized::ToString() const {
+  stringstream str;
+
+  str << (DistType_ == kSQDistL2 ? "L2" : "CosineSimilarity")
+      << " (scalar quantization: " << (CodeType_ == kSQCodeInt8 ? "int8" : "fp16");
+  if (RerankFactor_) str << ", rerank factor: " << RerankFactor_;
+  str << ")";
+
+  return str.str();
+}
+
+size_t SpaceQuantized::GetCodeSize(size_t dim) const {
+  size_t size = CodeType_ == kSQCodeInt8 ? dim : 2 * dim;
+  // Let's keep floats that follow codes aligned
+  return (size + 3) / 4 * 4;
+}
+
+size_t SpaceQuantized::GetElemQty(const Object* obj) const {
+  return GetHeader(obj)->dim_;
+}
+
+const float* SpaceQuantized::GetOrigVector(const Object* obj) const {
+  const Header* h = GetHeader(obj);
+  const char*   p = obj->data() + sizeof(Header);
+
+  if (h->bQuery_) return reinterpret_cast<const float*>(p);
+  if (RerankFactor_) return origStore_->Get(h->origPos_, h->dim_);
+  return NULL;
+}
+
+Object* SpaceQuantized::CreateQueryObjFromVect(IdType id, LabelType label, const vector<float>& InpVect) const {
+  const size_t  dim = InpVect.size();
+  vector<char>  buf(sizeof(Header) + dim * sizeof(float));
+  Header*       h = reinterpret_cast<Header*>(&buf[0]);
+
+  vector<float> temp(InpVect);
+  // Reserve space to store the inverse norm
+  temp.resize(dim + 1);
+  PrecompInvNorm(&temp[0], dim);
+
+  h->bQuery_      = 1;
+  h->dim_         = static_cast<uint32_t>(dim);
+  h->origPos_     = 0;
+  h->min_         = 0;
+  h->scale_       = 0;
+  h->invNorm_     = temp[dim];
+  h->origInvNorm_ = temp[dim];
+
+  if (dim) memcpy(&buf[sizeof(Header)], &InpVect[0], dim * sizeof(float));
+
+  return CreateObject(id, label, buf.size(), &buf[0]);
+}
+
+Object* SpaceQuantized::CreateObjFromVect(IdType id, LabelType label, const vector<float>& InpVect) const {
+  const size_t  dim = InpVect.size();
+  const size_t  codeSize = GetCodeSize(dim);
+  vector<char>  buf(sizeof(Header) + codeSize);
+  Header*       h = reinterpret_cast<Header*>(&buf[0]);
+  char*         pCodes = &buf[sizeof(Header)];
+
+  // The last element is reserved for the inverse norm
+  vector<float> decoded(dim + 1);
+
+  h->bQuery_  = 0;
+  h->dim_     = static_cast<uint32_t>(dim);
+  h->origPos_ = 0;
+  h->min_     = 0;
+  h->scale_   = 0;
+
+  if (CodeType_ == kSQCodeInt8) {
+    if (dim) {
+      h->min_   = *min_element(InpVect.begin(), InpVect.end());
+      h->scale_ = (*max_element(InpVect.begin(), InpVect.end()) - h->min_) / 255;
+    }
+    uint8_t* pSQ8 = reinterpret_cast<uint8_t*>(pCodes);
+    for (size_t i = 0; i < dim; ++i) {
+      long code = h->scale_ > 0 ? lround((InpVect[i] - h->min_) / h->scale_) : 0;
+      pSQ8[i] = static_cast<uint8_t>(max(0L, min(255L, code)));
+    }
+    DecodeSQ8(pSQ8, h->min_, h->scale_, &decoded[0], dim);
+  } else {
+    uint16_t* pFP16 = reinterpret_cast<uint16_t*>(pCodes);
+    for (size_t i = 0; i < dim; ++i) {
+      pFP16[i] = FloatToHalf(InpVect[i]);
+    }
+    DecodeFP16(pFP16, &decoded[0], dim);
+  }
+
+  PrecompInvNorm(&decoded[0], dim);
+  h->invNorm_ = decoded[dim];
+
+  vector<float> temp(InpVect);
+  temp.resize(dim + 1);
+  PrecompInvNorm(&temp[0], dim);
+  h->origInvNorm_ = temp[dim];
+
+  if (RerankFactor_) {
+    h->origPos_ = origStore_->Add(dim ? &InpVect[0] : NULL, dim);
+  }
+
+  return CreateObject(id, label, buf.size(), &buf[0]);
+}
+
+void SpaceQuantized::Decode(const Object* obj, size_t start, size_t qty, float* pVect) const {
+  const Header* h = GetHeader(obj);
+  const char*   pCodes = obj->data() + sizeof(Header);
+
+  if (CodeType_ == kSQCodeInt8) {
+    DecodeSQ8(reinterpret_cast<const uint8_t*>(pCodes) + start, h->min_, h->scale_, pVect, qty);
+  } else {
+    DecodeFP16(reinterpret_cast<const uint16_t*>(pCodes) + start, pVect, qty);
+  }
+}
+
+void SpaceQuantized::GetVector(const Object* obj, vector<float>& v) const {
+  const size_t dim = GetElemQty(obj);
+  const float* pOrig = GetOrigVector(obj);
+
+  v.resize(dim);
+  if (pOrig != NULL) {
+    copy(pOrig, pOrig + dim, v.begin());
+  } else if (dim) {
+    Decode(obj, 0, dim, &v[0]);
+  }
+}
+
+float SpaceQuantized::CodeSum(const float* pVect, const Object* obj, size_t start, size_t qty) const {
+  const Header* h = GetHeader(obj);
+  const char*   pCodes = obj->data() + sizeof(Header);
+
+  if (CodeType_ == kSQCodeInt8) {
+    const uint8_t* pSQ8 = reinterpret_cast<const uint8_t*>(pCodes) + start;
+    return DistType_ == kSQDistL2 ? L2SqrSQ8SIMD(pVect, pSQ8, h->min_, h->scale_, qty) :
+                                    ScalarProductSQ8SIMD(pVect, pSQ8, h->min_, h->scale_, qty);
+  }
+  const uint16_t* pFP16 = reinterpret_cast<const uint16_t*>(pCodes) + start;
+  return DistType_ == kSQDistL2 ? L2SqrFP16SIMD(pVect, pFP16, qty) :
+                                  ScalarProductFP16SIMD(pVect, pFP16, qty);
+}
+
+float SpaceQuantized::FloatSum(const float* pVect1, const float* pVect2, size_t qty) const {
+  return DistType_ == kSQDistL2 ? L2SqrSIMD(pVect1, pVect2, qty) :
+                                  ScalarProductSIMD(pVect1, pVect2, qty);
+}
+
+float SpaceQuantized::Finalize(float sum, float invNorm1, float invNorm2) const {
+  if (DistType_ == kSQDistL2) return sqrt(max(0.0f, sum));
+
+  // Zero vectors are treated the same way as in NormScalarProductPrecompSIMD
+  float cosine;
+  if (invNorm1 == 0 || invNorm2 == 0) {
+    cosine = invNorm1 == invNorm2 ? 1 : 0;
+  } else {
+    cosine = max(-1.0f, min(1.0f, sum * invNorm1 * invNorm2));
+  }
+  return max(0.0f, 1 - cosine);
+}
+
+float SpaceQuantized::ProxyDistance(const Object* obj1, const Object* obj2) const {
+  const Header* h1 = GetHeader(obj1);
+  const Header* h2 = GetHeader(obj2);
+  DCHECK(h1->dim_ == h2->dim_);
+  const size_t  dim = h1->dim_;
+
+  float sum = 0;
+
+  if (h1->bQuery_ && h2->bQuery_) {
+    sum = FloatSum(GetOrigVector(obj1), GetOrigVector(obj2), dim);
+  } else if (h2->bQuery_) {
+    sum = CodeSum(GetOrigVector(obj2), obj1, 0, dim);
+  } else if (h1->bQuery_) {
+    // Both distances are symmetric
+    sum = CodeSum(GetOrigVector(obj1), obj2, 0, dim);
+  } else {
+    // Both objects are compressed: the second one is decoded chunk by chunk
+    const size_t kChunkSize = 256;
+    float buf[kChunkSize];
+    for (size_t start = 0; start < dim; start += kChunkSize) {
+      size_t qty = min(kChunkSize, dim - start);
+      Decode(obj2, start, qty, buf);
+      sum += CodeSum(buf, obj1, start, qty);
+    }
+  }
+
+  return Finalize(sum, h1->invNorm_, h2->invNorm_);
+}
+
+float SpaceQuantized::HiddenDistance(const Object* obj1, const Object* obj2) const {
+  if (!RerankFactor_) return ProxyDistance(obj1, obj2);
+
+  const Header* h1 = GetHeader(obj1);
+  const Header* h2 = GetHeader(obj2);
+  DCHECK(h1->dim_ == h2->dim_);
+
+  return Finalize(FloatSum(GetOrigVector(obj1), GetOrigVector(obj2), h1->dim_),
+                  h1->origInvNorm_, h2->origInvNorm_);
+}
+
+void SpaceQuantized::WriteDataset(const ObjectVector& dataset,
+                                  const char* outputfile) const {
+  ofstream outFile(outputfile, ostream::out | ostream::trunc);
+
+  if (!outFile) {
+    LOG(LIB_FATAL) << "Cannot open: '" << outputfile << "' for writing!";
+  }
+
+  outFile.exceptions(ios::badbit | ios::failbit);
+
+  vector<float> v;
+
+  for (const Object* obj: dataset) {
+    GetVector(obj, v);
+
+    if (obj->label()>=0) outFile << LABEL_PREFIX << obj->label() << " ";
+
+    for (size_t i = 0; i < v.size(); ++i) {
+      outFile << v[i];
+      if (i + 1 == v.size()) outFile << endl; else outFile << "  ";
+    }
+  }
+  outFile.close();
+}
+
+}  // namespace similarity
@@ -39,6 +39,17 @@ dist_t SpaceCosineSimilarity<dist_t>::HiddenDistance(const Object* obj1, const O
   return val;
 }
 
+template <typename dist_t>
+void SpaceCosineSimilarity<dist_t>::HiddenDistanceBlock(const Object* const* objs, size_t qty,
+                                                         const Object* obj2, dist_t* dists) const {
+  CHECK(obj2->datalength() > 0);
+  this->ComputeDistanceBlock([](const dist_t* x, const dist_t* y, size_t length) {
+    dist_t val = CosineSimilarity(x, y, length);
+    if (std::isnan(val)) LOG(LIB_FATAL) << "Bug: NAN dist!!!!";
+    return val;
+  }, obj2->datalength() / sizeof(dist_t), objs, qty, obj2, dists);
+}
+
 template class SpaceCosineSimilarity<float>;
 template class SpaceCosineSimilarity<double>;
 
@@ -56,7 +67,84 @@ dist_t SpaceAngularDistance<dist_t>::HiddenDistance(const Object* obj1, const Ob
   return val;
 }
 
+template <typename dist_t>
+void SpaceAngularDistance<dist_t>::HiddenDistanceBlock(const Object* const* objs, size_t qty,
+                                                        const Object* obj2, dist_t* dists) const {
+  CHECK(obj2->datalength() > 0);
+  this->ComputeDistanceBlock([](const dist_t* x, const dist_t* y, size_t length) {
+    dist_t val = AngularDistance(x, y, length);
+    if (std::isnan(val)) LOG(LIB_FATAL) << "Bug: NAN dist!!!!";
+    return val;
+  }, obj2->datalength() / sizeof(dist_t), objs, qty, obj2, dists);
+}
+
 template class SpaceAngularDistance<float>;
 template class SpaceAngularDistance<double>;
 
+template <typename dist_t>
+Object* SpaceCosineSimilarityFast<dist_t>::CreateObjFromVect(IdType id, LabelType label, const std::vector<dist_t>& InpVect) const {
+  std::vector<dist_t>   temp(InpVect);
+
+  // Reserve space to store the inverse norm
+  temp.resize(InpVect.size() + 1);
+  PrecompInvNorm(&temp[0], InpVect.size());
+  return this->CreateObject(id, label, temp.size() * sizeof(dist_t), &temp[0]);
+}
+
+template <typename dist_t>
+dist_t SpaceCosineSimilarityFast<dist_t>::HiddenDistance(const Object* obj1, const Object* obj2) const {
+  DCHECK(obj1->datalength() > 0);
+  DCHECK(obj1->datalength() == obj2->datalength());
+  const dist_t* x = reinterpret_cast<const dist_t*>(obj1->data());
+  const dist_t* y = reinterpret_cast<const dist_t*>(obj2->data());
+  const size_t length = GetElemQty(obj1);
+
+  return CosineSimilarityPrecompSIMD(x, y, length);
+}
+
+template <typename dist_t>
+void SpaceCosineSimilarityFast<dist_t>::HiddenDistanceBlock(const Object* const* objs, size_t qty,
+                                                             const Object* obj2, dist_t* dists) const {
+  DCHECK(obj2->datalength() > 0);
+  this->ComputeDistanceBlock([](const dist_t* x, const dist_t* y, size_t length) {
+    return CosineSimilarityPrecompSIMD(x, y, length);
+  }, GetElemQty(obj2), objs, qty, obj2, dists);
+}
+
+template class SpaceCosineSimilarityFast<float>;
+template class SpaceCosineSimilarityFast<double>;
+
+template <typename dist_t>
+Object* SpaceAngularDistanceFast<dist_t>::CreateObjFromVect(IdType id, LabelType label, const std::vector<dist_t>& InpVect) const {
+  std::vector<dist_t>   temp(InpVect);
+
+  // Reserve space to store the inverse norm
+  temp.resize(InpVect.size() + 1);
+  PrecompInvNorm(&temp[0], InpVect.size());
+  return this->CreateObject(id, label, temp.size() * sizeof(dist_t), &temp[0]);
+}
+
+template <typename dist_t>
+dist_t SpaceAngularDistanceFast<dist_t>::HiddenDistance(const Object* obj1, const Object* obj2) const {
+  DCHECK(obj1->datalength() > 0);
+  DCHECK(obj1->datalength() == obj2->datalength());
+  const dist_t* x = reinterpret_cast<const dist_t*>(obj1->data());
+  const dist_t* y = reinterpret_cast<const dist_t*>(obj2->data());
+  const size_t length = GetElemQty(obj1);
+
+  return AngularDistancePrecompSIMD(x, y, length);
+}
+
+template <typename dist_t>
+void SpaceAngularDistanceFast<dist_t>::HiddenDistanceBlock(const Object* const* objs, size_t qty,
+                                                            const Object* obj2, dist_t* dists) const {
+  DCHECK(obj2->datalength() > 0);
+  this->ComputeDistanceBlock([](const dist_t* x, const dist_t* y, size_t length) {
+    return AngularDistancePrecompSIMD(x, y, length);
+  }, GetElemQty(obj2), objs, qty, obj2, dists);
+}
+
+template class SpaceAngularDistanceFast<float>;
+template class SpaceAngularDistanceFast<double>;
+
 }  // namespace similarity
@@ -0,0 +1,100 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "space/space_sparse_scalar.h"
+#include "logging.h"
+#include "distcomp.h"
+
+namespace similarity {
+
+using namespace std;
+
+template <typename dist_t>
+Object* SpaceSparseVectorNorm<dist_t>::CreateObjFromVect(IdType id, LabelType label, const vector<ElemType>& InpVect) const {
+  vector<ElemType> temp(InpVect.size() + 1);
+
+  dist_t norm = 0;
+  for (size_t i = 0; i < InpVect.size(); ++i) {
+    norm += InpVect[i].val_ * InpVect[i].val_;
+    temp[i + 1] = InpVect[i];
+  }
+  // See the comment in NormScalarProduct
+  temp[0].val_ = norm < numeric_limits<dist_t>::min() * 2 ? dist_t(0) : dist_t(1) / sqrt(norm);
+
+  return this->CreateObject(id, label, temp.size() * sizeof(ElemType), &temp[0]);
+}
+
+template <typename dist_t>
+dist_t SpaceSparseVectorNorm<dist_t>::ScalarProduct(const Object* obj1, const Object* obj2) const {
+  CHECK(obj1->datalength() >= sizeof(ElemType));
+  CHECK(obj2->datalength() >= sizeof(ElemType));
+
+  const ElemType* beg1 = reinterpret_cast<const ElemType*>(obj1->data());
+  const ElemType* beg2 = reinterpret_cast<const ElemType*>(obj2->data());
+  const ElemType* end1 = reinterpret_cast<const ElemType*>(obj1->data() + obj1->datalength());
+  const ElemType* end2 = reinterpret_cast<const ElemType*>(obj2->data() + obj2->datalength());
+
+  const dist_t invNorm1 = (beg1++)->val_;
+  const dist_t invNorm2 = (beg2++)->val_;
+
+  // Zero vectors are handled in the same way as in NormScalarProduct
+  if (invNorm1 == 0 || invNorm2 == 0) return invNorm1 == invNorm2 ? 1 : 0;
+
+  // Let the first list be the shorter one
+  if (end1 - beg1 > end2 - beg2) {
+    swap(beg1, beg2);
+    swap(end1, end2);
+  }
+
+  dist_t sum = 0;
+
+  if (size_t(end2 - beg2) >= SPARSE_GALLOP_RATIO * size_t(end1 - beg1)) {
+    for (const ElemType* it1 = beg1; it1 < end1 && beg2 < end2; ++it1) {
+      beg2 = GallopLowerBound(beg2, end2, *it1);
+      if (beg2 < end2 && beg2->id_ == it1->id_) {
+        sum += it1->val_ * beg2->val_;
+        ++beg2;
+      }
+    }
+  } else {
+    while (beg1 < end1 && beg2 < end2) {
+      if (beg1->id_ == beg2->id_) {
+        sum += beg1->val_ * beg2->val_;
+        ++beg1;
+        ++beg2;
+      } else if (beg1->id_ < beg2->id_) {
+        ++beg1;
+      } else {
+        ++beg2;
+      }
+    }
+  }
+
+  /*
+   * Sometimes due to rounding errors, we get values > 1 or < -1.
+   * This throws off other functions that use scalar product, e.g., acos
+   */
+  return max(dist_t(-1), min(dist_t(1), sum * invNorm1 * invNorm2));
+}
+
+template class SpaceSparseVectorNorm<float>;
+template class SpaceSparseVectorNorm<double>;
+
+}  // namespace similarity
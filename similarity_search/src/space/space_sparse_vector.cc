@@ -66,8 +66,8 @@ void SpaceSparseVector<dist_t>::ReadSparseVec(std::string line, LabelType& label
       }
     }
   } catch (const std::exception &e) {
-    LOG(LIB_ERROR) << "Exception: " << e.what() << std::endl;
-    LOG(LIB_FATAL) << "Failed to parse the line: '" << line << "'" << std::endl;
+    // ReadDataset treats this error as fatal, but a query server doesn't
+    throw std::runtime_error(string("Failed to parse the line: '") + line + "' " + e.what());
   }
 }
 
@@ -75,7 +75,7 @@ void SpaceSparseVector<dist_t>::ReadSparseVec(std::string line, LabelType& label
 template <typename dist_t>
 void SpaceSparseVector<dist_t>::ReadDataset(
     ObjectVector& dataset,
-    const ExperimentConfig<dist_t>* /* ignoring it here */,
+    const ExperimentConfig<dist_t>* config,
     const char* FileName,
     const int MaxNumObjects) const {
 
@@ -83,6 +83,8 @@ void SpaceSparseVector<dist_t>::ReadDataset(
   dataset.reserve(MaxNumObjects);
 
   vector<ElemType>    temp;
+  // Objects are placed into the arena provided by the config (if any)
+  typename Space<dist_t>::ArenaScope arena(*this, config ? config->GetObjectArena() : NULL);
 
   std::ifstream InFile(FileName);
 
@@ -115,9 +117,21 @@ void SpaceSparseVector<dist_t>::ReadDataset(
 
 template <typename dist_t>
 Object* SpaceSparseVector<dist_t>::CreateObjFromVect(IdType id, LabelType label, const vector<ElemType>& InpVect) const {
-  return new Object(id, label, InpVect.size() * sizeof(ElemType), &InpVect[0]);
+  return this->CreateObject(id, label, InpVect.size() * sizeof(ElemType), &InpVect[0]);
 };
 
+template <typename dist_t>
+Object* SpaceSparseVector<dist_t>::CreateObjFromStr(IdType id, const std::string& s) const {
+  vector<ElemType>  temp;
+  LabelType         label = -1;
+
+  ReadSparseVec(s, label, temp);
+  if (temp.empty()) {
+    throw std::runtime_error("No vector elements in the string: '" + s + "'");
+  }
+  return CreateObjFromVect(id, label, temp);
+}
+
 template <typename dist_t>
 void SpaceSparseVector<dist_t>::GenRandProjPivots(ObjectVector& vDst, size_t Qty, size_t MaxElem) const {
   // Static is thread-safe in C++-11
@@ -34,13 +34,19 @@ Object* SpaceSparseVectorInter<dist_t>::CreateObjFromVect(IdType id, LabelType l
 
   try {
     PackSparseElements(InpVect, pData, dataLen);
-    return new Object(id, label, dataLen, pData);
+    return this->CreateObject(id, label, dataLen, pData);
   } catch (...) {
     delete [] pData;
     throw;
   }
 }
 
+template <typename dist_t>
+void SpaceSparseVectorInter<dist_t>::GetVector(const Object* obj, vector<ElemType>& v) const {
+  v.clear();
+  UnpackSparseElements(obj->data(), obj->datalength(), v);
+}
+
 template class SpaceSparseVectorInter<float>;
 template class SpaceSparseVectorInter<double>;
 
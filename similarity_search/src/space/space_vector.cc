@@ -66,7 +66,8 @@ void VectorSpace<dist_t>::WriteDataset(const ObjectVector& dataset,
   for (const Object* obj: dataset) {
     CHECK(obj->datalength() > 0);
     const dist_t* x = reinterpret_cast<const dist_t*>(obj->data());
-    const size_t length = obj->datalength() / sizeof(dist_t);
+    // Precomputed values (e.g., logarithms) are not written
+    const size_t length = GetElemQty(obj);
 
     if (obj->label()>=0) outFile << LABEL_PREFIX << obj->label() << " ";
 
@@ -86,11 +87,32 @@ void VectorSpace<dist_t>::ReadDataset(
     const ExperimentConfig<dist_t>* config,
     const char* FileName,
     const int MaxNumObjects) const {
+  ReadVectors(dataset, config, FileName, MaxNumObjects, false);
+}
+
+template <typename dist_t>
+void VectorSpace<dist_t>::ReadQuerySet(
+    ObjectVector& queryset,
+    const ExperimentConfig<dist_t>* config,
+    const char* FileName,
+    const int MaxNumObjects) const {
+  ReadVectors(queryset, config, FileName, MaxNumObjects, true);
+}
+
+template <typename dist_t>
+void VectorSpace<dist_t>::ReadVectors(
+    ObjectVector& dataset,
+    const ExperimentConfig<dist_t>* config,
+    const char* FileName,
+    const int MaxNumObjects,
+    bool bQueries) const {
 
   dataset.clear();
   dataset.reserve(MaxNumObjects);
 
   std::vector<dist_t>    temp;
+  // Objects are placed into the arena provided by the config (if any)
+  typename Space<dist_t>::ArenaScope arena(*this, config ? config->GetObjectArena() : NULL);
 
   std::ifstream InFile(FileName);
 
@@ -137,7 +159,8 @@ void VectorSpace<dist_t>::ReadDataset(
       temp.resize(actualDim);
       id = linenum;
       ++linenum;
-      dataset.push_back(CreateObjFromVect(id, label, temp));
+      dataset.push_back(bQueries ? CreateQueryObjFromVect(id, label, temp) :
+                                   CreateObjFromVect(id, label, temp));
     }
     LOG(LIB_INFO) << "Actual dimensionality: " << actualDim;
   } catch (const std::exception &e) {
@@ -148,9 +171,21 @@ void VectorSpace<dist_t>::ReadDataset(
 
 template <typename dist_t>
 Object* VectorSpace<dist_t>::CreateObjFromVect(IdType id, LabelType label, const std::vector<dist_t>& InpVect) const {
-  return new Object(id, label, InpVect.size() * sizeof(dist_t), &InpVect[0]);
+  return this->CreateObject(id, label, InpVect.size() * sizeof(dist_t), &InpVect[0]);
 };
 
+template <typename dist_t>
+Object* VectorSpace<dist_t>::CreateObjFromStr(IdType id, const std::string& s) const {
+  std::vector<dist_t> temp;
+  LabelType           label = -1;
+
+  ReadVec(s, label, temp);
+  if (temp.empty()) {
+    throw runtime_error("No vector elements in the string: '" + s + "'");
+  }
+  return CreateQueryObjFromVect(id, label, temp);
+}
+
 /* 
  * Note that we don't instantiate vector spaces for types other than float & double
  * The only exception is the VectorSpace<PivotIdType>
@@ -0,0 +1,641 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#include <cmath>
+#include <memory>
+#include <limits>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "init.h"
+#include "global.h"
+#include "utils.h"
+#include "ztimer.h"
+#include "experiments.h"
+#include "experimentconf.h"
+#include "space.h"
+#include "index.h"
+#include "logging.h"
+#include "spacefactory.h"
+#include "methodfactory.h"
+
+#include "meta_analysis.h"
+#include "params.h"
+
+using namespace similarity;
+
+using std::vector;
+using std::map;
+using std::string;
+using std::stringstream;
+
+/*
+ * A generic tuner of query-time parameters (see Index::GetQueryTimeParamNames).
+ * The index is created (or loaded, see --loadIndex) only once for each test set 
+ * and the gold standard is computed only once as well (or it is read from the cache).
+ * Both are shared by all ranges and all values of K, which are tuned separately.
+ * Then, we carry out an adaptive pattern search, which 
+ * minimizes the query time subject to the constraint recall >= desiredRecall:
+ *
+ * 1) In each iteration, each tuned parameter is multiplied and divided by 
+ *    the step factor (other parameters retain their values). All such neighbors
+ *    of the current point are evaluated at once: queries are answered in threadTestQty threads.
+ * 2) If the best neighbor is better than the current point, we move there.
+ *    Otherwise, the step factor is decreased.
+ *
+ * A point that reaches the desired recall is better than a point that doesn't.
+ * Points that reach the desired recall are compared using the query time.
+ * Other points are compared using recall. Thus, if the desired recall is 
+ * not reached at the start point, the search first moves towards higher recall values.
+ *
+ * Tuning parameters are specified together with method parameters:
+ *
+ *   desiredRecall    the desired recall (mandatory);
+ *   tuneParams       a colon-separated list of tuned parameters. By default, 
+ *                    all query-time parameters specified for the method are tuned;
+ *   <name>Min,       optional bounds for the tuned parameter <name>
+ *   <name>Max        (by default, parameters are positive and unbounded).
+ *
+ * Initial values of tuned parameters must be specified and positive. A parameter 
+ * is integer-valued if its initial value is an integer number (e.g., use 2.0 rather than 2
+ * for a real-valued parameter). For example:
+ *
+ *   -m small_world_rand:NN=10,initSearchAttempts=1,desiredRecall=0.9
+ *   -m pivot_neighb_invindx:numPivot=512,numPrefix=32,dbScanFrac=0.01,dbScanFracMax=1,minTimes=2,desiredRecall=0.9
+ */
+
+const unsigned MaxIter          = 100;
+const double   InitStepFactor   = 2.0;
+const double   MinStepFactor    = 1.05;
+
+struct TunedParam {
+  string  name_;
+  bool    isInt_;
+  double  min_;
+  double  max_;
+};
+
+struct TuneResult {
+  TuneResult() : recall_(0), time_(std::numeric_limits<double>::max()), imprDistComp_(0) {}
+  double recall_;
+  double time_;
+  double imprDistComp_;
+};
+
+inline bool IsBetter(const TuneResult& a, const TuneResult& b, double DesiredRecall) {
+  const bool aOK = a.recall_ >= DesiredRecall;
+  const bool bOK = b.recall_ >= DesiredRecall;
+  if (aOK != bOK) return aOK;
+  return aOK ? a.time_ < b.time_ : a.recall_ > b.recall_;
+}
+
+inline bool IsIntStr(const string& s) {
+  return !s.empty() && s.find_first_not_of("0123456789+-") == string::npos;
+}
+
+template <typename dist_t>
+class QueryTimeTuner {
+ public:
+  QueryTimeTuner(ExperimentConfig<dist_t>& config,
+                 const string& MethodName,
+                 const string& SpaceType,
+                 const AnyParams& MethPars,
+                 unsigned ThreadTestQty,
+                 unsigned ThreadGSQty,
+                 const string& CachePrefixGS,
+                 const string& SaveIndexPrefix,
+                 const string& LoadIndexPrefix) :
+                 config_(config), MethodName_(MethodName), ThreadTestQty_(ThreadTestQty), QueryTypeId_(0) {
+    for (int TestSetId = 0; TestSetId < config.GetTestSetQty(); ++TestSetId) {
+      config.SelectTestSet(TestSetId);
+      // The config contains all ranges and all values of K: one gold standard serves all of them
+      GSManagers_.push_back(unique_ptr<GoldStandardManager<dist_t>>(new GoldStandardManager<dist_t>(config)));
+      GSManagers_.back()->Compute(ThreadGSQty, 
+                                  CachePrefixGS.empty() ? string("") : GetGSCacheFileName(CachePrefixGS, TestSetId));
+      /*
+       * Indices of different test sets coexist: search methods keep pointers 
+       * to data objects, which are owned by the config.
+       */
+      if (!LoadIndexPrefix.empty()) {
+        const string IndexFile = GetIndexFileName(LoadIndexPrefix);
+        LOG(LIB_INFO) << ">>>> Loading the index for the test set id: " << TestSetId << " from: " << IndexFile;
+        Indices_.push_back(shared_ptr<Index<dist_t>>(MethodFactoryRegistry<dist_t>::Instance().
+                                                     LoadMethod(IndexFile,
+                                                                MethodName, 
+                                                                SpaceType, config.GetSpace(), 
+                                                                config.GetDataObjects(), 
+                                                                MethPars)));
+      } else {
+        LOG(LIB_INFO) << ">>>> Creating the index for the test set id: " << TestSetId;
+        Indices_.push_back(shared_ptr<Index<dist_t>>(MethodFactoryRegistry<dist_t>::Instance().
+                                                     CreateMethod(false, 
+                                                                  MethodName, 
+                                                                  SpaceType, config.GetSpace(), 
+                                                                  config.GetDataObjects(), 
+                                                                  MethPars)));
+        if (!SaveIndexPrefix.empty()) {
+          const string IndexFile = GetIndexFileName(SaveIndexPrefix);
+          LOG(LIB_INFO) << "Saving the index to: " << IndexFile;
+          Indices_.back()->SaveIndex(IndexFile);
+        }
+      }
+    }
+  }
+
+  vector<string> GetQueryTimeParamNames() const { return Indices_[0]->GetQueryTimeParamNames(); }
+
+  size_t GetQueryTypeQty() const { return config_.GetRange().size() + config_.GetKNN().size(); }
+
+  // Query types are numbered as follows: ranges first, then values of K
+  string GetQueryTypeDesc() const {
+    stringstream res;
+    if (QueryTypeId_ < config_.GetRange().size()) {
+      res << "Range: " << config_.GetRange()[QueryTypeId_];
+    } else {
+      res << "K: " << config_.GetKNN()[QueryTypeId_ - config_.GetRange().size()];
+    }
+    return res.str();
+  }
+
+  // Subsequent evaluations use only queries of the given type
+  void SelectQueryType(size_t QueryTypeId) {
+    CHECK(QueryTypeId < GetQueryTypeQty());
+    QueryTypeId_ = QueryTypeId;
+    cache_.clear();
+  }
+
+  // Evaluates points that weren't evaluated before
+  void Evaluate(const vector<AnyParams>& points, vector<TuneResult>& res) {
+    vector<shared_ptr<MethodWithParams>>  MethodsDesc;
+    vector<unique_ptr<MetaAnalysis>>      Stat;
+
+    for (const AnyParams& pars : points) {
+      if (cache_.count(pars.ToString())) continue;
+      MethodsDesc.push_back(shared_ptr<MethodWithParams>(new MethodWithParams(MethodName_, pars)));
+      Stat.push_back(unique_ptr<MetaAnalysis>(new MetaAnalysis(config_.GetTestSetQty())));
+    }
+
+    if (!MethodsDesc.empty()) {
+      const size_t qty = MethodsDesc.size();
+
+      vector<MetaAnalysis*> ExpRes(qty);
+      for (size_t k = 0; k < qty; ++k) ExpRes[k] = Stat[k].get();
+
+      for (int TestSetId = 0; TestSetId < config_.GetTestSetQty(); ++TestSetId) {
+        config_.SelectTestSet(TestSetId);
+        // Each point is a separate "method" that shares the index with other points 
+        vector<shared_ptr<Index<dist_t>>> IndexPtrs(qty, Indices_[TestSetId]);
+
+        if (QueryTypeId_ < config_.GetRange().size()) {
+          typename Experiments<dist_t>::RangeCreator cr(config_.GetRange()[QueryTypeId_]);
+          Experiments<dist_t>::template Execute<RangeQuery<dist_t>, typename Experiments<dist_t>::RangeCreator>
+                                              (false /* don't print info */, ThreadTestQty_, TestSetId,
+                                               ExpRes, config_, *GSManagers_[TestSetId], cr,
+                                               IndexPtrs, MethodsDesc);
+        } else {
+          typename Experiments<dist_t>::KNNCreator cr(config_.GetKNN()[QueryTypeId_ - config_.GetRange().size()],
+                                                      config_.GetEPS());
+          Experiments<dist_t>::template Execute<KNNQuery<dist_t>, typename Experiments<dist_t>::KNNCreator>
+                                              (false /* don't print info */, ThreadTestQty_, TestSetId,
+                                               ExpRes, config_, *GSManagers_[TestSetId], cr,
+                                               IndexPtrs, MethodsDesc);
+        }
+      }
+
+      for (size_t k = 0; k < qty; ++k) {
+        Stat[k]->ComputeAll();
+        TuneResult r;
+        r.recall_       = Stat[k]->GetRecallAvg();
+        r.time_         = Stat[k]->GetQueryTimeAvg();
+        r.imprDistComp_ = Stat[k]->GetImprDistCompAvg();
+        LOG(LIB_INFO) << MethodsDesc[k]->methPars_.ToString() 
+                      << " Recall: " << r.recall_ << " Query time: " << r.time_ 
+                      << " ImprDistComp: " << r.imprDistComp_;
+        cache_[MethodsDesc[k]->methPars_.ToString()] = r;
+      }
+    }
+
+    res.clear();
+    for (const AnyParams& pars : points) res.push_back(cache_[pars.ToString()]);
+  }
+ private:
+  /*
+   * The file name is the same as the one used by the utility experiment,
+   * i.e., <prefix>_0_<method name>. Saving and loading requires a query file,
+   * so there is only one test set.
+   */
+  string GetIndexFileName(const string& prefix) const {
+    return prefix + "_0_" + MethodName_;
+  }
+
+  ExperimentConfig<dist_t>&                         config_;
+  string                                            MethodName_;
+  unsigned                                          ThreadTestQty_;
+  size_t                                            QueryTypeId_;
+  vector<unique_ptr<GoldStandardManager<dist_t>>>   GSManagers_;
+  vector<shared_ptr<Index<dist_t>>>                 Indices_;
+  // Results for points evaluated previously (for the current query type)
+  map<string, TuneResult>                           cache_;
+};
+
+/*
+ * Moves the parameter by the step factor up (if bUp is true) or down.
+ * Returns false if the value cannot be changed.
+ */
+bool MoveParam(const TunedParam& par, double StepFactor, bool bUp, double& val) {
+  double newVal = bUp ? val * StepFactor : val / StepFactor;
+  if (par.isInt_) {
+    newVal = bUp ? std::max(val + 1, std::round(newVal)) : std::min(val - 1, std::round(newVal));
+  }
+  newVal = std::min(par.max_, std::max(par.min_, newVal));
+  if (newVal == val) return false;
+  val = newVal;
+  return true;
+}
+
+void SetParamValues(const vector<TunedParam>& TunedPars, const vector<double>& vals, AnyParams& pars) {
+  for (size_t i = 0; i < TunedPars.size(); ++i) {
+    if (TunedPars[i].isInt_) {
+      pars.ChangeParam(TunedPars[i].name_, static_cast<long long>(vals[i]));
+    } else {
+      pars.ChangeParam(TunedPars[i].name_, vals[i]);
+    }
+  }
+}
+
+/*
+ * Separates tuning parameters (desiredRecall, tuneParams, and bounds)
+ * from parameters of the method.
+ */
+void SplitTuneParams(const AnyParams& AllParams, 
+                     AnyParams& MethPars, double& DesiredRecall,
+                     vector<string>& TuneParamNames, AnyParams& Bounds) {
+  string TuneParamList;
+
+  DesiredRecall = 0;
+  TuneParamNames.clear();
+  {
+    AnyParamManager pmgr(AllParams);
+    pmgr.GetParamRequired("desiredRecall", DesiredRecall);
+    pmgr.GetParamOptional("tuneParams", TuneParamList);
+    if (!TuneParamList.empty() && !SplitStr(TuneParamList, TuneParamNames, ':')) {
+      LOG(LIB_FATAL) << "Wrong format of the parameter tuneParams: '" << TuneParamList << "'";
+    }
+    // Remaining parameters, including bounds, are processed below
+    MethPars = pmgr.ExtractParametersExcept({"desiredRecall", "tuneParams"});
+  }
+
+  /* 
+   * Bounds need to be separated from method parameters, 
+   * but first we need to know the names of tuned parameters.
+   * If the list isn't given explicitly, we need to create the index.
+   */
+  vector<string> BoundNames;
+  for (const string& name : MethPars.ParamNames) {
+    const size_t len = name.size();
+    // A bound can be specified only for a parameter that has an initial value
+    if (len > 3 && (name.compare(len - 3, 3, "Min") == 0 || name.compare(len - 3, 3, "Max") == 0) &&
+        find(MethPars.ParamNames.begin(), MethPars.ParamNames.end(), name.substr(0, len - 3)) != MethPars.ParamNames.end()) {
+      BoundNames.push_back(name);
+    }
+  }
+  Bounds = AnyParams();
+  {
+    AnyParamManager pmgr(MethPars);
+    AnyParams tmp = pmgr.ExtractParametersExcept(BoundNames);
+    for (const string& name : BoundNames) {
+      string val;
+      pmgr.GetParamRequired(name, val);
+      Bounds.ParamNames.push_back(name);
+      Bounds.ParamValues.push_back(val);
+    }
+    MethPars = tmp;
+  }
+}
+
+// Tunes parameters for the query type selected in the tuner
+template <typename dist_t>
+void TuneQueryTimeParams(QueryTimeTuner<dist_t>& tuner,
+                         const string& MethodName,
+                         const AnyParams& MethPars,
+                         double DesiredRecall,
+                         vector<string> TuneParamNames,
+                         const AnyParams& Bounds,
+                         AnyParams& BestPars, TuneResult& BestRes) {
+  const vector<string> QueryTimeNames = tuner.GetQueryTimeParamNames();
+  if (TuneParamNames.empty()) {
+    for (const string& name : MethPars.ParamNames) {
+      if (find(QueryTimeNames.begin(), QueryTimeNames.end(), name) != QueryTimeNames.end()) {
+        TuneParamNames.push_back(name);
+      }
+    }
+  }
+  if (TuneParamNames.empty()) {
+    stringstream err;
+    for (const string& name : QueryTimeNames) err << " " << name;
+    LOG(LIB_FATAL) << "No query-time parameters to tune, specify initial values of some of the following"
+                   << " query-time parameters of the method " << MethodName << ":" << err.str();
+  }
+
+  vector<TunedParam>  TunedPars;
+  vector<double>      CurrVals;
+  {
+    AnyParamManager pmgr(MethPars);
+    AnyParamManager bmgr(Bounds);
+    for (const string& name : TuneParamNames) {
+      if (find(QueryTimeNames.begin(), QueryTimeNames.end(), name) == QueryTimeNames.end()) {
+        LOG(LIB_FATAL) << "Parameter " << name << " is not a query-time parameter of the method " << MethodName;
+      }
+      string sVal;
+      pmgr.GetParamRequired(name, sVal);
+      TunedParam par;
+      par.name_  = name;
+      par.isInt_ = IsIntStr(sVal);
+      par.min_   = par.isInt_ ? 1 : std::numeric_limits<double>::min();
+      par.max_   = std::numeric_limits<double>::max();
+      bmgr.GetParamOptional(name + "Min", par.min_);
+      bmgr.GetParamOptional(name + "Max", par.max_);
+      double val = 0;
+      pmgr.GetParamRequired(name, val);
+      if (!(val > 0)) {
+        LOG(LIB_FATAL) << "The initial value of the tuned parameter " << name << " should be positive";
+      }
+      TunedPars.push_back(par);
+      CurrVals.push_back(std::min(par.max_, std::max(par.min_, val)));
+      LOG(LIB_INFO) << "Tuning parameter: " << name << (par.isInt_ ? " (integer)" : " (real)")
+                    << " range: [" << par.min_ << "," << par.max_ << "]";
+    }
+    pmgr.ExtractParametersExcept(vector<string>());
+  }
+
+  BestPars = MethPars;
+  SetParamValues(TunedPars, CurrVals, BestPars);
+  {
+    vector<TuneResult> res;
+    tuner.Evaluate(vector<AnyParams>(1, BestPars), res);
+    BestRes = res[0];
+  }
+
+  double StepFactor = InitStepFactor;
+
+  for (unsigned iter = 0; iter < MaxIter && StepFactor >= MinStepFactor; ++iter) {
+    LOG(LIB_INFO) << "Iteration: " << iter << " StepFactor: " << StepFactor 
+                  << " current point: " << BestPars.ToString()
+                  << " Recall: " << BestRes.recall_ << " Query time: " << BestRes.time_;
+
+    vector<AnyParams>       points;
+    vector<vector<double>>  pointVals;
+    for (size_t i = 0; i < TunedPars.size(); ++i) {
+      for (bool bUp : {true, false}) {
+        vector<double> vals = CurrVals;
+        if (MoveParam(TunedPars[i], StepFactor, bUp, vals[i])) {
+          points.push_back(MethPars);
+          SetParamValues(TunedPars, vals, points.back());
+          pointVals.push_back(vals);
+        }
+      }
+    }
+
+    vector<TuneResult> res;
+    tuner.Evaluate(points, res);
+
+    int best = -1;
+    for (size_t k = 0; k < res.size(); ++k) {
+      if (IsBetter(res[k], best < 0 ? BestRes : res[best], DesiredRecall)) best = k;
+    }
+    if (best >= 0) {
+      CurrVals = pointVals[best];
+      BestPars = points[best];
+      BestRes  = res[best];
+    } else {
+      StepFactor = sqrt(StepFactor);
+    }
+  }
+
+  if (BestRes.recall_ < DesiredRecall) {
+    LOG(LIB_FATAL) << "Failed to get the desired recall, the best recall: " << BestRes.recall_ 
+                   << " try to choose different initial values (or bounds) of parameters";
+  }
+}
+
+template <typename dist_t>
+void RunExper(const vector<shared_ptr<MethodWithParams>>& Methods,
+             const string&                  SpaceType,
+             const shared_ptr<AnyParams>&   SpaceParams,
+             unsigned                       dimension,
+             unsigned                       TestSetQty,
+             const string&                  DataFile,
+             const string&                  QueryFile,
+             unsigned                       MaxNumData,
+             unsigned                       MaxNumQuery,
+             vector<unsigned>               knnAll,
+             float                          eps,
+             const string&                  RangeArg,
+             unsigned                       ThreadTestQty,
+             unsigned                       ThreadGSQty,
+             const string&                  CachePrefixGS,
+             const string&                  SaveIndexPrefix,
+             const string&                  LoadIndexPrefix
+)
+{
+  vector<dist_t> rangeAll;
+
+  if (!RangeArg.empty()) {
+    if (!SplitStr(RangeArg, rangeAll, ',')) {
+      LOG(LIB_FATAL) << "Wrong format of the range argument: '" << RangeArg << "' Should be a list of coma-separated values.";
+    }
+  }
+
+  if (Methods.size() != 1) {
+    LOG(LIB_FATAL) << "Should specify only a single method";
+  }
+
+  const string&    MethodName = Methods[0]->methName_;
+  const AnyParams& MethPars   = Methods[0]->methPars_;
+
+  AnyParams       TunePars;
+  double          DesiredRecall;
+  vector<string>  TuneParamNames;
+  AnyParams       Bounds;
+
+  SplitTuneParams(MethPars, TunePars, DesiredRecall, TuneParamNames, Bounds);
+
+  try {
+    // Note that space will be deleted by the destructor of ExperimentConfig
+    ExperimentConfig<dist_t> config(SpaceFactoryRegistry<dist_t>::
+                                    Instance().CreateSpace(SpaceType, *SpaceParams),
+                                    DataFile, QueryFile, TestSetQty,
+                                    MaxNumData, MaxNumQuery,
+                                    dimension, knnAll, eps, rangeAll);
+
+    config.ReadDataset();
+
+    /*
+     * Indices and gold standards are created only once,
+     * but each range and each value of K is tuned separately.
+     */
+    QueryTimeTuner<dist_t> tuner(config, MethodName, SpaceType, TunePars, 
+                                 ThreadTestQty, ThreadGSQty, CachePrefixGS,
+                                 SaveIndexPrefix, LoadIndexPrefix);
+
+    for (size_t i = 0; i < tuner.GetQueryTypeQty(); ++i) {
+      tuner.SelectQueryType(i);
+      LOG(LIB_INFO) << ">>>> Tuning for the query type: " << tuner.GetQueryTypeDesc();
+
+      AnyParams   BestPars;
+      TuneResult  BestRes;
+      TuneQueryTimeParams(tuner, MethodName, TunePars, 
+                          DesiredRecall, TuneParamNames, Bounds,
+                          BestPars, BestRes);
+
+      LOG(LIB_INFO) << "Optimization results";
+      LOG(LIB_INFO) << tuner.GetQueryTypeDesc();
+      LOG(LIB_INFO) << "Recall: " << BestRes.recall_;
+      LOG(LIB_INFO) << "Best time: " << BestRes.time_;
+      LOG(LIB_INFO) << "ImprDistComp: " << BestRes.imprDistComp_;
+      LOG(LIB_INFO) << "Best parameters: " << MethodName << ":" << BestPars.ToString();
+    }
+  } catch (const std::exception& e) {
+    LOG(LIB_FATAL) << "Exception: " << e.what();
+  } catch (...) {
+    LOG(LIB_FATAL) << "Unknown exception";
+  }
+}
+
+int main(int ac, char* av[]) {
+  WallClockTimer timer;
+  timer.reset();
+
+  string                  LogFile;
+  string                  DistType;
+  string                  SpaceType;
+  shared_ptr<AnyParams>   SpaceParams;
+  bool                    DoAppend;
+  string                  ResFilePrefix;
+  unsigned                TestSetQty;
+  string                  DataFile;
+  string                  QueryFile;
+  unsigned                MaxNumData;
+  unsigned                MaxNumQuery;
+  vector<unsigned>        knn;
+  string                  RangeArg;
+  unsigned                dimension;
+  unsigned                ThreadTestQty;
+  float                   eps;
+  string                  SaveIndexPrefix;
+  string                  LoadIndexPrefix;
+  unsigned                ThreadGSQty;
+  string                  CachePrefixGS;
+  vector<shared_ptr<MethodWithParams>> Methods;
+
+
+
+  ParseCommandLine(ac, av, LogFile,
+                       DistType,
+                       SpaceType,
+                       SpaceParams,
+                       dimension,
+                       ThreadTestQty,
+                       DoAppend, 
+                       ResFilePrefix,
+                       TestSetQty,
+                       DataFile,
+                       QueryFile,
+                       MaxNumData,
+                       MaxNumQuery,
+                       knn,
+                       eps,
+                       RangeArg,
+                       SaveIndexPrefix,
+                       LoadIndexPrefix,
+                       ThreadGSQty,
+                       CachePrefixGS,
+                       Methods);
+
+  initLibrary(LogFile.empty() ? LIB_LOGSTDERR:LIB_LOGFILE, LogFile.c_str());
+
+  ToLower(DistType);
+
+  if ("int" == DistType) {
+    RunExper<int>(Methods,
+                  SpaceType,
+                  SpaceParams,
+                  dimension,
+                  TestSetQty,
+                  DataFile,
+                  QueryFile,
+                  MaxNumData,
+                  MaxNumQuery,
+                  knn,
+                  eps,
+                  RangeArg,
+                  ThreadTestQty,
+                  ThreadGSQty,
+                  CachePrefixGS,
+                  SaveIndexPrefix,
+                  LoadIndexPrefix
+                 );
+  } else if ("float" == DistType) {
+    RunExper<float>(Methods,
+                  SpaceType,
+                  SpaceParams,
+                  dimension,
+                  TestSetQty,
+                  DataFile,
+                  QueryFile,
+                  MaxNumData,
+                  MaxNumQuery,
+                  knn,
+                  eps,
+                  RangeArg,
+                  ThreadTestQty,
+                  ThreadGSQty,
+                  CachePrefixGS,
+                  SaveIndexPrefix,
+                  LoadIndexPrefix
+                 );
+  } else if ("double" == DistType) {
+    RunExper<double>(Methods,
+                  SpaceType,
+                  SpaceParams,
+                  dimension,
+                  TestSetQty,
+                  DataFile,
+                  QueryFile,
+                  MaxNumData,
+                  MaxNumQuery,
+                  knn,
+                  eps,
+                  RangeArg,
+                  ThreadTestQty,
+                  ThreadGSQty,
+                  CachePrefixGS,
+                  SaveIndexPrefix,
+                  LoadIndexPrefix
+                 );
+  } else {
+    LOG(LIB_FATAL) << "Unknown distance value type: " << DistType;
+  }
+
+  timer.split();
+  LOG(LIB_INFO) << "Time elapsed = " << timer.elapsed() / 1e6;
+  LOG(LIB_INFO) << "Finished at " << LibGetCurrentTime();
+
+  return 0;
+}
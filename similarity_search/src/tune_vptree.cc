@@ -62,6 +62,9 @@ template <typename dist_t>
 void GetOptimalAlphas(ExperimentConfig<dist_t>& config, 
                       const string& SpaceType,
                       AnyParams AllParams, 
+                      unsigned ThreadTestQty,
+                      unsigned ThreadGSQty,
+                      const string& CachePrefixGS,
                       float& recall, float& time_best, float& alpha_left_best, float& alpha_right_best) {
   time_best = std::numeric_limits<float>::max();
   alpha_left_best = 0;
@@ -84,77 +87,109 @@ void GetOptimalAlphas(ExperimentConfig<dist_t>& config,
 
   AnyParams  MethPars = pmgr.ExtractParametersExcept({"desiredRecall"});
 
+  /*
+   * The gold standard doesn't depend on method parameters,
+   * so it is computed only once for each test set.
+   * Likewise, alphas are query-time parameters of the VP-tree:
+   * the tree is built only once for each test set.
+   * Trees of different test sets coexist: they keep pointers
+   * to data objects, which are owned by the config.
+   */
+  vector<unique_ptr<GoldStandardManager<dist_t>>> GSManagers;
+  vector<shared_ptr<Index<dist_t>>>               Indices;
+
+  for (int TestSetId = 0; TestSetId < config.GetTestSetQty(); ++TestSetId) {
+    config.SelectTestSet(TestSetId);
+    GSManagers.push_back(unique_ptr<GoldStandardManager<dist_t>>(new GoldStandardManager<dist_t>(config)));
+    GSManagers.back()->Compute(ThreadGSQty, 
+                               CachePrefixGS.empty() ? string("") : GetGSCacheFileName(CachePrefixGS, TestSetId));
+    LOG(LIB_INFO) << ">>>> Creating the index for the test set id: " << TestSetId;
+    Indices.push_back(shared_ptr<Index<dist_t>>(MethodFactoryRegistry<dist_t>::Instance().
+                                                CreateMethod(false, 
+                                                             METH_VPTREE, 
+                                                             SpaceType, config.GetSpace(), 
+                                                             config.GetDataObjects(), 
+                                                             MethPars)));
+  }
+
+  const size_t GridQty = StepN * StepN;
+
   for (unsigned iter = 0; iter < MaxIter; ++iter) {
     LOG(LIB_INFO) << "Iteration: " << iter << " StepFactor: " << StepFactor;
     double MinRecall = 1.0;
     double MaxRecall = 0;
-      
+
+    /*
+     * All grid points are evaluated by a single call to RunAll:
+     * each grid point is a separate "method" that shares the index
+     * with other grid points. Before queries are run, RunAll sets
+     * query-time parameters (i.e., alphas) of the method.
+     * Queries are answered by ThreadTestQty threads.
+     */
+    vector<shared_ptr<MethodWithParams>>  MethodsDesc;
+    vector<unique_ptr<MetaAnalysis>>      GridStat;
+
     for (int left = 0; left < StepN; ++left) {
       for (int right = 0; right < StepN; ++right) {
         MethPars.ChangeParam("alphaLeft", alpha_left_base * pow(StepFactor, left - StepN/2));
         MethPars.ChangeParam("alphaRight", alpha_right_base * pow(StepFactor, right - StepN/2));
+        MethodsDesc.push_back(shared_ptr<MethodWithParams>(new MethodWithParams(METH_VPTREE, MethPars)));
+        GridStat.push_back(unique_ptr<MetaAnalysis>(new MetaAnalysis(config.GetTestSetQty())));
+      }
+    }
+
+    // Stat is used exactly only once: for one GetRange() or one GetKNN() (but not both)
+    vector<vector<MetaAnalysis*>> ExpResRange(config.GetRange().size(),
+                                            vector<MetaAnalysis*>(GridQty));
+    vector<vector<MetaAnalysis*>> ExpResKNN(config.GetKNN().size(),
+                                          vector<MetaAnalysis*>(GridQty));
+    for (size_t k = 0; k < GridQty; ++k) {
+      for (size_t i = 0; i < config.GetRange().size(); ++i) {
+        ExpResRange[i][k] = GridStat[k].get();
+      }
+      for (size_t i = 0; i < config.GetKNN().size(); ++i) {
+        ExpResKNN[i][k] = GridStat[k].get();
+      }
+    }
+
+    for (int TestSetId = 0; TestSetId < config.GetTestSetQty(); ++TestSetId) {
+      config.SelectTestSet(TestSetId);
+      LOG(LIB_INFO) << ">>>> Test set id: " << TestSetId << " (set qty: " << config.GetTestSetQty() << ")";
+
+      vector<shared_ptr<Index<dist_t>>> IndexPtrs(GridQty, Indices[TestSetId]);
+
+      Experiments<dist_t>::RunAll(false /* don't print info */, ThreadTestQty,
+                                  TestSetId,
+                                  ExpResRange, ExpResKNN,
+                                  config, *GSManagers[TestSetId],
+                                  IndexPtrs,
+                                  MethodsDesc);
+    }
+
+    for (size_t k = 0; k < GridQty; ++k) {
+      MetaAnalysis& Stat = *GridStat[k];
+
+      Stat.ComputeAll();
+      if (Stat.GetRecallAvg() >= DesiredRecall &&
+          Stat.GetQueryTimeAvg() < time_best) {
+          recall =    Stat.GetRecallAvg();
+          time_best = Stat.GetQueryTimeAvg();
+
+          AnyParamManager pmgr(MethodsDesc[k]->methPars_);
+
+          /* 
+           * We need delete other parameters, otherwise the destructor would
+           * complain about unused ones.
+           */
+          AnyParams  MethPars = pmgr.ExtractParametersExcept({"alphaLeft", "alphaRight"});
 
-        LOG(LIB_INFO) << "left: " << (left - StepN/2) << " right: " << (right - StepN/2);
-
-        vector<vector<MetaAnalysis*>> ExpResRange(config.GetRange().size(),
-                                                vector<MetaAnalysis*>(1));
-        vector<vector<MetaAnalysis*>> ExpResKNN(config.GetKNN().size(),
-                                              vector<MetaAnalysis*>(1));
-
-        MetaAnalysis    Stat(config.GetTestSetQty());
-
-        // Stat is used exactly only once: for one GetRange() or one GetKNN() (but not both)
-        for (size_t i = 0; i < config.GetRange().size(); ++i) {
-          ExpResRange[i][0] = &Stat;
-        }
-        for (size_t i = 0; i < config.GetKNN().size(); ++i) {
-          ExpResKNN[i][0] = &Stat;
-        }
-        for (int TestSetId = 0; TestSetId < config.GetTestSetQty(); ++TestSetId) {
-          config.SelectTestSet(TestSetId);
-          LOG(LIB_INFO) << ">>>> Test set id: " << TestSetId << " (set qty: " << config.GetTestSetQty() << ")";
-          std::shared_ptr<Index<dist_t>> MethodPtr( MethodFactoryRegistry<dist_t>::Instance().
-                                           CreateMethod(false, 
-                                                        METH_VPTREE, 
-                                                        SpaceType, config.GetSpace(), 
-                                                        config.GetDataObjects(), 
-                                                        MethPars) );
-
-          vector<shared_ptr<Index<dist_t>>>          IndexPtrs;
-          vector<shared_ptr<MethodWithParams>>       MethodsDesc;
-          
-          IndexPtrs.push_back(MethodPtr);
-          MethodsDesc.push_back(shared_ptr<MethodWithParams>(new MethodWithParams(METH_VPTREE, MethPars)));
-
-          Experiments<dist_t>::RunAll(false /* don't print info */, 1 /* thread */,
-                                      TestSetId,
-                                      ExpResRange, ExpResKNN,
-                                      config, 
-                                      IndexPtrs,
-                                      MethodsDesc);
-
-        }
-        Stat.ComputeAll();
-        if (Stat.GetRecallAvg() >= DesiredRecall &&
-            Stat.GetQueryTimeAvg() < time_best) {
-            recall =    Stat.GetRecallAvg();
-            time_best = Stat.GetQueryTimeAvg();
-
-            AnyParamManager pmgr(MethPars);
-
-            /* 
-             * We need delete other parameters, otherwise the destructor would
-             * complain about unused ones.
-             */
-            AnyParams  MethPars = pmgr.ExtractParametersExcept({"alphaLeft", "alphaRight"});
-
-            pmgr.GetParamRequired("alphaLeft", alpha_left_best);
-            pmgr.GetParamRequired("alphaRight", alpha_right_best);
-        }
-        LOG(LIB_INFO) << "Recall: " << Stat.GetRecallAvg() << " Query time: " << Stat.GetQueryTimeAvg();
-        MinRecall = std::min(MinRecall, Stat.GetRecallAvg());
-        MaxRecall = std::max(MaxRecall, Stat.GetRecallAvg());
+          pmgr.GetParamRequired("alphaLeft", alpha_left_best);
+          pmgr.GetParamRequired("alphaRight", alpha_right_best);
       }
+      LOG(LIB_INFO) << MethodsDesc[k]->methPars_.ToString() 
+                    << " Recall: " << Stat.GetRecallAvg() << " Query time: " << Stat.GetQueryTimeAvg();
+      MinRecall = std::min(MinRecall, Stat.GetRecallAvg());
+      MaxRecall = std::max(MaxRecall, Stat.GetRecallAvg());
     }
     LOG(LIB_INFO) << " MinRecall: " << MinRecall << " MaxRecall: " << MaxRecall << " BestTime: "<< time_best;;
     // Now let's see, if we need to increase/decrease base alpha levels
@@ -204,7 +239,10 @@ void RunExper(const vector<shared_ptr<MethodWithParams>>& Methods,
              unsigned                       MaxNumQuery,
              vector<unsigned>               knnAll,
              float                          eps,
-             const string&                  RangeArg
+             const string&                  RangeArg,
+             unsigned                       ThreadTestQty,
+             unsigned                       ThreadGSQty,
+             const string&                  CachePrefixGS
 )
 {
   vector<dist_t> rangeAll;
@@ -240,7 +278,8 @@ void RunExper(const vector<shared_ptr<MethodWithParams>>& Methods,
       config.ReadDataset();
 
       float recall, time_best, alpha_left, alpha_right;
-      GetOptimalAlphas(config, SpaceType, MethPars, recall, time_best, alpha_left, alpha_right);
+      GetOptimalAlphas(config, SpaceType, MethPars, ThreadTestQty, ThreadGSQty, CachePrefixGS, 
+                       recall, time_best, alpha_left, alpha_right);
 
       LOG(LIB_INFO) << "Optimization results";
       LOG(LIB_INFO) << "Range: "  << rangeAll[i];
@@ -267,7 +306,8 @@ void RunExper(const vector<shared_ptr<MethodWithParams>>& Methods,
       config.ReadDataset();
 
       float recall, time_best, alpha_left, alpha_right;
-      GetOptimalAlphas(config, SpaceType, MethPars, recall, time_best, alpha_left, alpha_right);
+      GetOptimalAlphas(config, SpaceType, MethPars, ThreadTestQty, ThreadGSQty, CachePrefixGS, 
+                       recall, time_best, alpha_left, alpha_right);
 
       LOG(LIB_INFO) << "Optimization results";
       LOG(LIB_INFO) << "K: "  << knnAll[i];
@@ -304,6 +344,10 @@ int main(int ac, char* av[]) {
   unsigned                dimension;
   unsigned                ThreadTestQty;
   float                   eps;
+  string                  SaveIndexPrefix;
+  string                  LoadIndexPrefix;
+  unsigned                ThreadGSQty;
+  string                  CachePrefixGS;
   vector<shared_ptr<MethodWithParams>> Methods;
 
 
@@ -324,6 +368,10 @@ int main(int ac, char* av[]) {
                        knn,
                        eps,
                        RangeArg,
+                       SaveIndexPrefix,
+                       LoadIndexPrefix,
+                       ThreadGSQty,
+                       CachePrefixGS,
                        Methods);
 
   initLibrary(LogFile.empty() ? LIB_LOGSTDERR:LIB_LOGFILE, LogFile.c_str());
@@ -342,7 +390,10 @@ int main(int ac, char* av[]) {
                   MaxNumQuery,
                   knn,
                   eps,
-                  RangeArg
+                  RangeArg,
+                  ThreadTestQty,
+                  ThreadGSQty,
+                  CachePrefixGS
                  );
   } else if ("float" == DistType) {
     RunExper<float>(Methods,
@@ -356,7 +407,10 @@ int main(int ac, char* av[]) {
                   MaxNumQuery,
                   knn,
                   eps,
-                  RangeArg
+                  RangeArg,
+                  ThreadTestQty,
+                  ThreadGSQty,
+                  CachePrefixGS
                  );
   } else if ("double" == DistType) {
     RunExper<double>(Methods,
@@ -370,7 +424,10 @@ int main(int ac, char* av[]) {
                   MaxNumQuery,
                   knn,
                   eps,
-                  RangeArg
+                  RangeArg,
+                  ThreadTestQty,
+                  ThreadGSQty,
+                  CachePrefixGS
                  );
   } else {
     LOG(LIB_FATAL) << "Unknown distance value type: " << DistType;
@@ -27,6 +27,8 @@
 #include <direct.h>       // for mkdir
 #define mkdir(name, mode) mkdir(name)
 #endif
+#include <sys/types.h>
+#include <sys/stat.h>
 #else
 #include <unistd.h>
 #include <sys/time.h>
@@ -58,6 +60,19 @@ bool IsFileExists(const char* filename) {
 #endif
 }
 
+bool GetFileSizeAndTime(const string& filename, uint64_t& size, int64_t& mtime) {
+#ifdef _MSC_VER
+  struct _stat64 st;
+  if (_stat64(filename.c_str(), &st) != 0) return false;
+#else
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) return false;
+#endif
+  size  = static_cast<uint64_t>(st.st_size);
+  mtime = static_cast<int64_t>(st.st_mtime);
+  return true;
+}
+
 void RStrip(char* str) {
   int i = strlen(str) - 1;
   while ((i >= 0) &&
@@ -25,6 +25,7 @@
 #include "space/space_sparse_vector.h"
 #include "space/space_scalar.h"
 #include "distcomp.h"
+#include "distcomp_dispatch.h"
 #include "permutation_utils.h"
 #include "ztimer.h"
 #include "pow.h"
@@ -222,7 +223,7 @@ void TestLInfNormSIMD(size_t N, size_t dim, size_t Rep) {
     uint64_t tDiff = t.split();
 
     LOG(LIB_INFO) << "Ignore: " << DiffSum;
-    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of SIMD LInfs per second: " << (1e6/tDiff) * N * Rep ;
+    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of SIMD (" << SIMDTierName(GetSIMDTier()) << ") LInfs per second: " << (1e6/tDiff) * N * Rep ;
 
     delete [] pArr;
 
@@ -334,7 +335,7 @@ void TestL1NormSIMD(size_t N, size_t dim, size_t Rep) {
     uint64_t tDiff = t.split();
 
     LOG(LIB_INFO) << "Ignore: " << DiffSum;
-    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of SIMD L1s per second: " << (1e6/tDiff) * N * Rep ;
+    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of SIMD (" << SIMDTierName(GetSIMDTier()) << ") L1s per second: " << (1e6/tDiff) * N * Rep ;
 
     delete [] pArr;
 
@@ -445,7 +446,7 @@ void TestL2NormSIMD(size_t N, size_t dim, size_t Rep) {
     uint64_t tDiff = t.split();
  
     LOG(LIB_INFO) << "Ignore: " << DiffSum;
-    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of SIMD L2s per second: " << (1e6/tDiff) * N * Rep ;
+    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of SIMD (" << SIMDTierName(GetSIMDTier()) << ") L2s per second: " << (1e6/tDiff) * N * Rep ;
  
     delete [] pArr;
  
@@ -600,7 +601,7 @@ void TestItakuraSaitoPrecompSIMD(size_t N, size_t dim, size_t Rep) {
     uint64_t tDiff = t.split();
 
     LOG(LIB_INFO) << "Ignore: " << DiffSum;
-    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of SIMD precomp. ItakuraSaito per second: " << (1e6/tDiff) * N * Rep ;
+    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of SIMD (" << SIMDTierName(GetSIMDTier()) << ") precomp. ItakuraSaito per second: " << (1e6/tDiff) * N * Rep ;
 
     delete [] pArr;
 
@@ -717,7 +718,7 @@ void TestKLPrecompSIMD(size_t N, size_t dim, size_t Rep) {
     uint64_t tDiff = t.split();
 
     LOG(LIB_INFO) << "Ignore: " << DiffSum;
-    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of SIMD precomp. KLs per second: " << (1e6/tDiff) * N * Rep ;
+    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of SIMD (" << SIMDTierName(GetSIMDTier()) << ") precomp. KLs per second: " << (1e6/tDiff) * N * Rep ;
 
     delete [] pArr;
 
@@ -1032,7 +1033,7 @@ void TestJSPrecompSIMDApproxLog(size_t N, size_t dim, size_t Rep, float pZero) {
     uint64_t tDiff = t.split();
 
     LOG(LIB_INFO) << "Ignore: " << DiffSum;
-    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of JSs (precomp, one log approx, SIMD) (sparsity:" << pZero << ") per second: " << (1e6/tDiff) * N * Rep ;
+    LOG(LIB_INFO) << typeid(T).name() << " " << "Elapsed: " << tDiff / 1e3 << " ms " << " # of JSs (precomp, one log approx, SIMD " << SIMDTierName(GetSIMDTier()) << ") (sparsity:" << pZero << ") per second: " << (1e6/tDiff) * N * Rep ;
 
     delete [] pArr;
 
@@ -1631,20 +1632,6 @@ int main(int argc, char* argv[]) {
     TestJSPrecompApproxLog<double>(1024, dim, 1000, pZero3);
 #endif
 
-    nTest++;
-    TestJSPrecompSIMDApproxLog<float>(1024, dim, 2000, pZero1);
-    nTest++;
-    TestJSPrecompSIMDApproxLog<float>(1024, dim, 2000, pZero2);
-    nTest++;
-    TestJSPrecompSIMDApproxLog<float>(1024, dim, 2000, pZero3);
-#if TEST_SPEED_DOUBLE
-    nTest++;
-    TestJSPrecompSIMDApproxLog<double>(1024, dim, 2000, pZero1);
-    nTest++;
-    TestJSPrecompSIMDApproxLog<double>(1024, dim, 2000, pZero2);
-    nTest++;
-    TestJSPrecompSIMDApproxLog<double>(1024, dim, 2000, pZero3);
-#endif
 
     nTest++;
     TestL1Norm<float>(1024, dim, 10000);
@@ -1660,12 +1647,6 @@ int main(int argc, char* argv[]) {
     TestL1NormStandard<double>(1024, dim, 10000);
 #endif
 
-    nTest++;
-    TestL1NormSIMD<float>(1024, dim, 10000);
-#if TEST_SPEED_DOUBLE
-    nTest++;
-    TestL1NormSIMD<double>(1024, dim, 10000);
-#endif
 
 
     nTest++;
@@ -1682,12 +1663,6 @@ int main(int argc, char* argv[]) {
     TestLInfNormStandard<double>(1024, dim, 10000);
 #endif
 
-    nTest++;
-    TestLInfNormSIMD<float>(1024, dim, 10000);
-#if TEST_SPEED_DOUBLE
-    nTest++;
-    TestLInfNormSIMD<double>(1024, dim, 10000);
-#endif
 
     nTest++;
     TestItakuraSaitoStandard<float>(1024, dim, 1000);
@@ -1704,12 +1679,6 @@ int main(int argc, char* argv[]) {
     TestItakuraSaitoPrecomp<double>(1024, dim, 2000);
 #endif
 
-    nTest++;
-    TestItakuraSaitoPrecompSIMD<float>(1024, dim, 4000);
-#if TEST_SPEED_DOUBLE
-    nTest++;
-    TestItakuraSaitoPrecompSIMD<double>(1024, dim, 4000);
-#endif
 
     nTest++;
     TestL2Norm<float>(1024, dim, 10000);
@@ -1725,12 +1694,6 @@ int main(int argc, char* argv[]) {
     TestL2NormStandard<double>(1024, dim, 10000);
 #endif
 
-    nTest++;
-    TestL2NormSIMD<float>(1024, dim, 10000);
-#if TEST_SPEED_DOUBLE
-    nTest++;
-    TestL2NormSIMD<double>(1024, dim, 10000);
-#endif
 
 
     nTest++;
@@ -1748,12 +1711,6 @@ int main(int argc, char* argv[]) {
     TestKLPrecomp<double>(1024, dim, 2000);
 #endif
 
-    nTest++;
-    TestKLPrecompSIMD<float>(1024, dim, 4000);
-#if TEST_SPEED_DOUBLE
-    nTest++;
-    TestKLPrecompSIMD<double>(1024, dim, 4000);
-#endif
 
     nTest++;
     TestKLGeneralStandard<float>(1024, dim, 1000);
@@ -1776,6 +1733,61 @@ int main(int argc, char* argv[]) {
     TestKLGeneralPrecompSIMD<double>(1024, dim, 2000);
 #endif
 
+    /*
+     * SIMD functions are benchmarked for every SIMD tier
+     * supported by the CPU (see distcomp_dispatch.h).
+     */
+    const SIMDTier BestTier = GetSIMDTier();
+
+    for (int i = kSIMDTierSSE; i <= kSIMDTierMax; ++i) {
+      SIMDTier tier = static_cast<SIMDTier>(i);
+      if (!IsSIMDTierSupported(tier)) {
+        LOG(LIB_INFO) << "SIMD tier " << SIMDTierName(tier) << " is not supported by this CPU or this binary";
+        continue;
+      }
+      SetSIMDTier(tier);
+      LOG(LIB_INFO) << "========================================";
+      LOG(LIB_INFO) << "SIMD tier: " << SIMDTierName(tier);
+
+      nTest++;
+      TestLInfNormSIMD<float>(1024, dim, 10000);
+      nTest++;
+      TestL1NormSIMD<float>(1024, dim, 10000);
+      nTest++;
+      TestL2NormSIMD<float>(1024, dim, 10000);
+      nTest++;
+      TestItakuraSaitoPrecompSIMD<float>(1024, dim, 4000);
+      nTest++;
+      TestKLPrecompSIMD<float>(1024, dim, 4000);
+      nTest++;
+      TestJSPrecompSIMDApproxLog<float>(1024, dim, 2000, pZero1);
+      nTest++;
+      TestJSPrecompSIMDApproxLog<float>(1024, dim, 2000, pZero2);
+      nTest++;
+      TestJSPrecompSIMDApproxLog<float>(1024, dim, 2000, pZero3);
+#if TEST_SPEED_DOUBLE
+      nTest++;
+      TestLInfNormSIMD<double>(1024, dim, 10000);
+      nTest++;
+      TestL1NormSIMD<double>(1024, dim, 10000);
+      nTest++;
+      TestL2NormSIMD<double>(1024, dim, 10000);
+      nTest++;
+      TestItakuraSaitoPrecompSIMD<double>(1024, dim, 4000);
+      nTest++;
+      TestKLPrecompSIMD<double>(1024, dim, 4000);
+      nTest++;
+      TestJSPrecompSIMDApproxLog<double>(1024, dim, 2000, pZero1);
+      nTest++;
+      TestJSPrecompSIMDApproxLog<double>(1024, dim, 2000, pZero2);
+      nTest++;
+      TestJSPrecompSIMDApproxLog<double>(1024, dim, 2000, pZero3);
+#endif
+    }
+    LOG(LIB_INFO) << "========================================";
+
+    SetSIMDTier(BestTier);
+
 #if TEST_SPEED_LP
     float delta = 0.125/2.0;
 
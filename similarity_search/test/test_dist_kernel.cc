@@ -0,0 +1,138 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#include <vector>
+#include <memory>
+#include <random>
+
+#include "object.h"
+#include "space.h"
+#include "space/space_lp.h"
+#include "space/space_scalar.h"
+#include "knnquery.h"
+#include "dist_kernel.h"
+#include "bunit.h"
+
+using namespace std;
+
+namespace similarity {
+
+template <typename dist_t>
+struct KernelDistCollector {
+  KernelDistCollector(KNNQuery<dist_t>* query, const ObjectVector& data) : query_(query), data_(data) {}
+  template <typename Kernel>
+  void operator()(const Kernel& kernel) {
+    for (const Object* obj : data_) dists_.push_back(kernel.DistanceObjLeft(query_, obj));
+  }
+  KNNQuery<dist_t>*     query_;
+  const ObjectVector&   data_;
+  vector<dist_t>        dists_;
+};
+
+/*
+ * The kernel of the space should compute exactly the same distances
+ * as the space itself and it should count distance computations.
+ */
+template <typename dist_t>
+bool CheckDistKernel(const VectorSpace<dist_t>& space, DistKernelType expType, size_t dim) {
+  mt19937                             gen(0);
+  uniform_real_distribution<dist_t>   distr(-1, 1);
+  ObjectVector                        data;
+
+  for (size_t i = 0; i < 100; ++i) {
+    vector<dist_t> vect(dim);
+    for (size_t k = 0; k < dim; ++k) vect[k] = distr(gen);
+    data.push_back(space.CreateObjFromVect(i, -1, vect));
+  }
+  unique_ptr<const Object> query(data.back());
+  data.pop_back();
+
+  bool res = true;
+  const DistKernelDesc desc = GetDataDistKernel<dist_t>(&space, data);
+
+  if (desc.Type_ != expType) res = false;
+  // Virtual kernels don't fit any query
+  if (desc.Fits(query.get()) != (expType != kDistKernelVirtual)) res = false;
+
+  KNNQuery<dist_t> kernelQuery(&space, query.get(), 10), virtQuery(&space, query.get(), 10);
+  KernelDistCollector<dist_t> kernelDists(&kernelQuery, data), virtDists(&virtQuery, data);
+
+  DispatchDistKernel<dist_t>(desc, kernelDists);
+  virtDists(VirtualDistKernel<dist_t>());
+
+  if (kernelDists.dists_ != virtDists.dists_) res = false;
+  if (kernelQuery.DistanceComputations() != data.size()) res = false;
+
+  for (const Object* obj : data) delete obj;
+  return res;
+}
+
+TEST(DistKernelLp) {
+  for (size_t dim : {1, 7, 16, 33, 128}) {
+    EXPECT_TRUE(CheckDistKernel<float>(SpaceLp<float>(1), kDistKernelL1, dim));
+    EXPECT_TRUE(CheckDistKernel<float>(SpaceLp<float>(2), kDistKernelL2, dim));
+    EXPECT_TRUE(CheckDistKernel<float>(SpaceLp<float>(-1), kDistKernelLInf, dim));
+    EXPECT_TRUE(CheckDistKernel<double>(SpaceLp<double>(2), kDistKernelL2, dim));
+    // There are no kernels for generic Lp distances
+    EXPECT_TRUE(CheckDistKernel<float>(SpaceLp<float>(3), kDistKernelVirtual, dim));
+  }
+}
+
+// Lp kernels are specialized for the current SIMD tier
+TEST(DistKernelLpSIMDTiers) {
+  const SIMDTier CurrTier = GetSIMDTier();
+
+  for (int i = kSIMDTierSSE; i <= kSIMDTierMax; ++i) {
+    SIMDTier tier = static_cast<SIMDTier>(i);
+    if (!IsSIMDTierSupported(tier)) continue;
+    SetSIMDTier(tier);
+    for (size_t dim : {1, 7, 16, 33, 128}) {
+      EXPECT_TRUE(CheckDistKernel<float>(SpaceLp<float>(1), kDistKernelL1, dim));
+      EXPECT_TRUE(CheckDistKernel<float>(SpaceLp<float>(2), kDistKernelL2, dim));
+      EXPECT_TRUE(CheckDistKernel<double>(SpaceLp<double>(-1), kDistKernelLInf, dim));
+    }
+  }
+
+  SetSIMDTier(CurrTier);
+}
+
+TEST(DistKernelCosine) {
+  for (size_t dim : {1, 7, 16, 33, 128}) {
+    EXPECT_TRUE(CheckDistKernel<float>(SpaceCosineSimilarityFast<float>(), kDistKernelCosinePrecomp, dim));
+    EXPECT_TRUE(CheckDistKernel<float>(SpaceAngularDistanceFast<float>(), kDistKernelAngularPrecomp, dim));
+    EXPECT_TRUE(CheckDistKernel<double>(SpaceAngularDistanceFast<double>(), kDistKernelAngularPrecomp, dim));
+  }
+}
+
+TEST(DistKernelDataLength) {
+  SpaceLp<float>  space(2);
+  ObjectVector    data;
+  data.push_back(space.CreateObjFromVect(0, -1, vector<float>(8, 1)));
+  data.push_back(space.CreateObjFromVect(1, -1, vector<float>(9, 1)));
+
+  // Objects have different lengths: the virtual kernel is used
+  EXPECT_EQ(kDistKernelVirtual, GetDataDistKernel<float>(&space, data).Type_);
+  data.pop_back();
+  const DistKernelDesc desc = GetDataDistKernel<float>(&space, data);
+  EXPECT_EQ(kDistKernelL2, desc.Type_);
+  EXPECT_TRUE(desc.Fits(data[0]));
+  unique_ptr<Object> query(space.CreateObjFromVect(2, -1, vector<float>(9, 1)));
+  EXPECT_FALSE(desc.Fits(query.get()));
+
+  for (const Object* obj : data) delete obj;
+}
+
+}  // namespace similarity
@@ -19,7 +19,13 @@
 
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <cmath>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 #include "bunit.h"
 #include "space.h"
@@ -29,8 +35,13 @@
 #include "space/space_sparse_scalar_fast.h"
 #include "space/space_sparse_vector.h"
 #include "space/space_scalar.h"
+#include "space/space_quant.h"
+#include "space/space_lp.h"
+#include "space/space_bregman.h"
+#include "space/space_js.h"
 #include "testdataset.h"
 #include "distcomp.h"
+#include "distcomp_dispatch.h"
 #include "permutation_utils.h"
 #include "ztimer.h"
 #include "pow.h"
@@ -311,6 +322,50 @@ bool TestL2Agree(size_t N, size_t dim, size_t Rep) {
     return true;
 }
 
+template <class T>
+bool TestCosineSimilarityPrecompAgree(size_t N, size_t dim, size_t Rep) {
+    // The last element keeps the inverse norm
+    T* pVect1 = new T[dim + 1];
+    T* pVect2 = new T[dim + 1];
+
+    bool bug = false;
+
+    for (size_t i = 0; i < Rep && !bug; ++i) {
+        for (size_t j = 1; j < N; ++j) {
+            GenRandVect(pVect1, dim, -T(RANGE), T(RANGE));
+            GenRandVect(pVect2, dim, -T(RANGE), T(RANGE));
+
+            PrecompInvNorm(pVect1, dim);
+            PrecompInvNorm(pVect2, dim);
+
+            T val1 = CosineSimilarity(pVect1, pVect2, dim);
+            T val2 = CosineSimilarityPrecompSIMD(pVect1, pVect2, dim);
+
+            T val3 = AngularDistance(pVect1, pVect2, dim);
+            T val4 = AngularDistancePrecompSIMD(pVect1, pVect2, dim);
+
+            if (fabs(val1 - val2) > 1e-5) {
+                cerr << "Bug CosineSimilarityPrecomp !!! Dim = " << dim << " val1 = " << val1 << " val2 = " << val2 << endl;
+                bug = true;
+            }
+            /*
+             * Angular distance is computed using acos, which is very sensitive
+             * to small errors when the argument is close to 1. 
+             */
+            if (fabs(val3 - val4) > 1e-2) {
+                cerr << "Bug AngularDistancePrecomp !!! Dim = " << dim << " val3 = " << val3 << " val4 = " << val4 << endl;
+                bug = true;
+            }
+            if (bug) break;
+        }
+    }
+
+    delete [] pVect1;
+    delete [] pVect2;
+
+    return !bug;
+}
+
 template <class T>
 bool TestItakuraSaitoAgree(size_t N, size_t dim, size_t Rep) {
     T* pVect1 = new T[dim];
@@ -886,6 +941,11 @@ TEST(TestAgree) {
         nTest++;
         nFail += !TestL2Agree<double>(1024, dim, 10);
 
+        nTest++;
+        nFail += !TestCosineSimilarityPrecompAgree<float>(1024, dim, 10);
+        nTest++;
+        nFail += !TestCosineSimilarityPrecompAgree<double>(1024, dim, 10);
+
         nTest++;
         nFail += !TestKLAgree<float>(1024, dim, 10);
         nTest++;
@@ -902,5 +962,418 @@ TEST(TestAgree) {
     EXPECT_EQ(0, nFail);
 }
 
-}  // namespace similarity
+/*
+ * A short and a long sparse vector, whose intersection is computed
+ * using galloping (see SPARSE_GALLOP_RATIO). The short vector shares 
+ * about half of its ids with the long one. 
+ */
+template <class SpaceType>
+bool TestSparseGallop(const SpaceType& space, size_t N, size_t shortQty, size_t longQty) {
+    typedef typename SpaceType::ElemType ElemType;
+
+    bool ok = true;
+
+    for (size_t j = 0; j < N && ok; ++j) {
+        vector<ElemType> longVect, shortVect;
+        map<uint32_t, float> shortMap;
+
+        for (size_t i = 0; i < longQty; ++i) {
+            longVect.push_back(ElemType(static_cast<uint32_t>(i * 100 + RandomInt() % 100), 
+                                        RandomReal<float>() * 2 - 1));
+        }
+        for (size_t i = 0; i < shortQty; ++i) {
+            uint32_t id = RandomInt() % 2 ? longVect[RandomInt() % longQty].id_ : RandomInt() % (longQty * 100);
+            shortMap[id] = RandomReal<float>() * 2 - 1;
+        }
+        for (const auto& e : shortMap) shortVect.push_back(ElemType(e.first, e.second));
+
+        double sum = 0, norm1 = 0, norm2 = 0;
+        for (const ElemType& e : longVect) {
+            norm1 += e.val_ * e.val_;
+            auto it = shortMap.find(e.id_);
+            if (it != shortMap.end()) sum += e.val_ * it->second;
+        }
+        for (const ElemType& e : shortVect) norm2 += e.val_ * e.val_;
+        float expDist = max(0.0, 1 - sum / sqrt(norm1) / sqrt(norm2));
+
+        unique_ptr<Object> longObj(space.CreateObjFromVect(0, -1, longVect));
+        unique_ptr<Object> shortObj(space.CreateObjFromVect(1, -1, shortVect));
+
+        ok = ok && SIMDTierValuesAgree(space.ToString().c_str(), GetSIMDTier(), shortQty, expDist, 
+                                       float(space.IndexTimeDistance(shortObj.get(), longObj.get())));
+        ok = ok && SIMDTierValuesAgree(space.ToString().c_str(), GetSIMDTier(), shortQty, expDist, 
+                                       float(space.IndexTimeDistance(longObj.get(), shortObj.get())));
+    }
+
+    return ok;
+}
+
+TEST(TestSparseGallop) {
+    int nTest = 0;
+    int nFail = 0;
+
+    SpaceSparseCosineSimilarity<float>    spaceFloat;
+    SpaceSparseCosineSimilarity<double>   spaceDouble;
+    SpaceSparseCosineSimilarityFast       spaceFast;
+
+    for (size_t shortQty : { 1, 2, 5, 10, 30 }) {
+        nTest++;
+        nFail += !TestSparseGallop(spaceFloat, 50, shortQty, 2000);
+        nTest++;
+        nFail += !TestSparseGallop(spaceDouble, 50, shortQty, 2000);
+        nTest++;
+        nFail += !TestSparseGallop(spaceFast, 50, shortQty, 2000);
+    }
+
+    LOG(LIB_INFO) << nTest << " (sub) tests performed " << nFail << " failed";
+
+    EXPECT_EQ(0, nFail);
+}
+
+template <class T>
+bool SIMDTierValuesAgree(const char* pName, SIMDTier tier, size_t dim, T valSSE, T valTier) {
+    T AbsDiff = fabs(valSSE - valTier);
+    T RelDiff = AbsDiff/max(max(fabs(valSSE),fabs(valTier)),T(1e-18));
+    if (RelDiff > 1e-5 && AbsDiff > 1e-5) {
+        cerr << "Bug " << pName << " " << typeid(T).name() << " tier: " << SIMDTierName(tier) << " !!! Dim = " << dim 
+             << " SSE = " << valSSE << " " << SIMDTierName(tier) << " = " << valTier << endl;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Functions of the currently selected SIMD tier should
+ * produce the same results as SSE functions.
+ */
+template <class T>
+bool TestSIMDTierAgree(SIMDTier tier, size_t N, size_t dim) {
+    vector<T> vect1(dim), vect2(dim);
+    // These vectors keep logarithms after vector elements
+    vector<T> precompVect1(2 * dim), precompVect2(2 * dim);
+    vector<T> precompZeroVect1(2 * dim), precompZeroVect2(2 * dim);
+
+    bool ok = true;
+
+    for (size_t j = 0; j < N && ok; ++j) {
+        GenRandVect(&vect1[0], dim, -T(RANGE), T(RANGE));
+        GenRandVect(&vect2[0], dim, -T(RANGE), T(RANGE));
+
+        ok = ok && SIMDTierValuesAgree("LInf", tier, dim, 
+                                       LInfNormSSE(&vect1[0], &vect2[0], dim), 
+                                       LInfNormSIMD(&vect1[0], &vect2[0], dim));
+        ok = ok && SIMDTierValuesAgree("L1", tier, dim, 
+                                       L1NormSSE(&vect1[0], &vect2[0], dim), 
+                                       L1NormSIMD(&vect1[0], &vect2[0], dim));
+        ok = ok && SIMDTierValuesAgree("L2", tier, dim, 
+                                       sqrt(L2SqrSSE(&vect1[0], &vect2[0], dim)), 
+                                       L2NormSIMD(&vect1[0], &vect2[0], dim));
+
+        GenRandVect(&precompVect1[0], dim, T(RANGE_SMALL), T(1.0), true);
+        GenRandVect(&precompVect2[0], dim, T(RANGE_SMALL), T(1.0), true);
+        PrecompLogarithms(&precompVect1[0], dim);
+        PrecompLogarithms(&precompVect2[0], dim);
+
+        ok = ok && SIMDTierValuesAgree("KL", tier, dim, 
+                                       KLPrecompSSE(&precompVect1[0], &precompVect2[0], dim), 
+                                       KLPrecompSIMD(&precompVect1[0], &precompVect2[0], dim));
+        ok = ok && SIMDTierValuesAgree("ItakuraSaito", tier, dim, 
+                                       ItakuraSaitoPrecompSSE(&precompVect1[0], &precompVect2[0], dim), 
+                                       ItakuraSaitoPrecompSIMD(&precompVect1[0], &precompVect2[0], dim));
+
+        // JS should work correctly when vectors have zeros
+        copy(precompVect1.begin(), precompVect1.begin() + dim, precompZeroVect1.begin());
+        copy(precompVect2.begin(), precompVect2.begin() + dim, precompZeroVect2.begin());
+        SetRandZeros(&precompZeroVect1[0], dim, 0.25);
+        SetRandZeros(&precompZeroVect2[0], dim, 0.25);
+        Normalize(&precompZeroVect1[0], dim);
+        Normalize(&precompZeroVect2[0], dim);
+        PrecompLogarithms(&precompZeroVect1[0], dim);
+        PrecompLogarithms(&precompZeroVect2[0], dim);
+
+        ok = ok && SIMDTierValuesAgree("JS", tier, dim, 
+                                       JSPrecompSSEApproxLog(&precompZeroVect1[0], &precompZeroVect2[0], dim), 
+                                       JSPrecompSIMDApproxLog(&precompZeroVect1[0], &precompZeroVect2[0], dim));
+    }
+
+    return ok;
+}
+
+/*
+ * Scalar products are compared after dividing them by the product of vector norms:
+ * a sum of many products can be close to zero, but its rounding error is not.
+ */
+bool TestSIMDTierQuantAgree(SIMDTier tier, size_t N, size_t dim) {
+    vector<float>     vect(dim), codeVect(dim), decodedSQ8(dim), decodedFP16(dim);
+    vector<uint8_t>   codesSQ8(dim);
+    vector<uint16_t>  codesFP16(dim);
+
+    const float min = -RANGE, scale = 2 * RANGE / 255;
+
+    bool ok = true;
+
+    for (size_t j = 0; j < N && ok; ++j) {
+        GenRandVect(&vect[0], dim, -RANGE, RANGE);
+        GenRandVect(&codeVect[0], dim, -RANGE, RANGE);
+        for (size_t i = 0; i < dim; ++i) {
+            codesSQ8[i]  = static_cast<uint8_t>(RandomInt() % 256);
+            codesFP16[i] = FloatToHalf(codeVect[i]);
+        }
+        DecodeSQ8(&codesSQ8[0], min, scale, &decodedSQ8[0], dim);
+        DecodeFP16(&codesFP16[0], &decodedFP16[0], dim);
+
+        const float norm     = sqrt(ScalarProductSIMD(&vect[0], &vect[0], dim));
+        const float normSQ8  = norm * sqrt(ScalarProductSIMD(&decodedSQ8[0], &decodedSQ8[0], dim)) + 1;
+        const float normFP16 = norm * sqrt(ScalarProductSIMD(&decodedFP16[0], &decodedFP16[0], dim)) + 1;
+
+        ok = ok && SIMDTierValuesAgree("L2SqrSQ8", tier, dim,
+                                       L2SqrSQ8SSE(&vect[0], &codesSQ8[0], min, scale, dim),
+                                       L2SqrSQ8SIMD(&vect[0], &codesSQ8[0], min, scale, dim));
+        ok = ok && SIMDTierValuesAgree("ScalarProductSQ8", tier, dim,
+                                       ScalarProductSQ8SSE(&vect[0], &codesSQ8[0], min, scale, dim) / normSQ8,
+                                       ScalarProductSQ8SIMD(&vect[0], &codesSQ8[0], min, scale, dim) / normSQ8);
+        ok = ok && SIMDTierValuesAgree("L2SqrFP16", tier, dim,
+                                       L2SqrFP16SSE(&vect[0], &codesFP16[0], dim),
+                                       L2SqrFP16SIMD(&vect[0], &codesFP16[0], dim));
+        ok = ok && SIMDTierValuesAgree("ScalarProductFP16", tier, dim,
+                                       ScalarProductFP16SSE(&vect[0], &codesFP16[0], dim) / normFP16,
+                                       ScalarProductFP16SIMD(&vect[0], &codesFP16[0], dim) / normFP16);
+    }
+
+    return ok;
+}
+
+// Generates qty random unique ids from [1, maxId] (sorted) and respective values
+void GenSparseBlock(size_t qty, size_t maxId, vector<uint16_t>& ids, vector<float>& vals) {
+    CHECK(qty <= maxId);
+    vector<uint16_t> allIds(maxId);
+    for (size_t i = 0; i < maxId; ++i) allIds[i] = static_cast<uint16_t>(i + 1);
+    shuffle(allIds.begin(), allIds.end(), mt19937(RandomInt()));
+    ids.assign(allIds.begin(), allIds.begin() + qty);
+    sort(ids.begin(), ids.end());
+    vals.resize(qty);
+    GenRandVect(&vals[0], qty, -RANGE, RANGE);
+}
+
+/*
+ * As in TestSIMDTierQuantAgree, scalar products are divided by the product of norms.
+ */
+bool TestSIMDTierSparseAgree(SIMDTier tier, size_t N, size_t qty1, size_t qty2) {
+    vector<uint16_t>  ids1, ids2;
+    vector<float>     vals1, vals2;
+
+    bool ok = true;
+
+    for (size_t j = 0; j < N && ok; ++j) {
+        // A small range of ids ensures that blocks have many common ids
+        GenSparseBlock(qty1, qty1 + qty2, ids1, vals1);
+        GenSparseBlock(qty2, qty1 + qty2, ids2, vals2);
+
+        const float norm = sqrt(ScalarProductSIMD(&vals1[0], &vals1[0], qty1)) * 
+                           sqrt(ScalarProductSIMD(&vals2[0], &vals2[0], qty2)) + 1;
+
+        ok = ok && SIMDTierValuesAgree("SparseBlockScalarProduct", tier, qty1,
+                                       SparseBlockScalarProductSSE(&ids1[0], &vals1[0], qty1, 
+                                                                   &ids2[0], &vals2[0], qty2) / norm,
+                                       SparseBlockScalarProductSIMD(&ids1[0], &vals1[0], qty1, 
+                                                                    &ids2[0], &vals2[0], qty2) / norm);
+    }
+
+    return ok;
+}
+
+TEST(TestSIMDTiersAgree) {
+    int nTest = 0;
+    int nFail = 0;
+
+    const SIMDTier CurrTier = GetSIMDTier();
 
+    for (int i = kSIMDTierSSE; i <= kSIMDTierMax; ++i) {
+        SIMDTier tier = static_cast<SIMDTier>(i);
+        if (!IsSIMDTierSupported(tier)) {
+            LOG(LIB_INFO) << "SIMD tier " << SIMDTierName(tier) << " is not supported, skipping";
+            continue;
+        }
+        SetSIMDTier(tier);
+        // 70 is larger than the largest unrolled loop (32 elements) times two
+        for (size_t dim = 1; dim <= 70; ++dim) {
+            nTest++;
+            nFail += !TestSIMDTierAgree<float>(tier, 100, dim);
+            nTest++;
+            nFail += !TestSIMDTierAgree<double>(tier, 100, dim);
+            nTest++;
+            nFail += !TestSIMDTierQuantAgree(tier, 100, dim);
+            nTest++;
+            nFail += !TestSIMDTierSparseAgree(tier, 100, dim, dim);
+            nTest++;
+            nFail += !TestSIMDTierSparseAgree(tier, 100, dim, 3 * dim + 5);
+        }
+    }
+
+    SetSIMDTier(CurrTier);
+
+    LOG(LIB_INFO) << nTest << " (sub) tests performed " << nFail << " failed";
+
+    EXPECT_EQ(0, nFail);
+}
+
+TEST(TestHalfPrecisionConversion) {
+    EXPECT_EQ(uint16_t(0x3c00), FloatToHalf(1.0f));
+    EXPECT_EQ(uint16_t(0xc000), FloatToHalf(-2.0f));
+    EXPECT_EQ(uint16_t(0x3555), FloatToHalf(1.0f/3));
+    EXPECT_EQ(uint16_t(0x7bff), FloatToHalf(65504.0f));
+    // Too large numbers become infinite
+    EXPECT_EQ(uint16_t(0x7c00), FloatToHalf(65520.0f));
+    // The smallest subnormal number, 2^-24, and numbers that round to it or to zero
+    EXPECT_EQ(uint16_t(0x0001), FloatToHalf(5.9604644775390625e-8f));
+    EXPECT_EQ(uint16_t(0x0001), FloatToHalf(4.0e-8f));
+    EXPECT_EQ(uint16_t(0x0000), FloatToHalf(2.0e-8f));
+
+    // All numbers except NaNs should be converted back exactly
+    for (unsigned h = 0; h < 65536; ++h) {
+        if ((h & 0x7c00) == 0x7c00 && (h & 0x3ff)) continue;
+        EXPECT_EQ(uint16_t(h), FloatToHalf(HalfToFloat(uint16_t(h))));
+    }
+}
+
+string VectToString(const vector<float>& v) {
+    stringstream str;
+    str.precision(9);
+    for (float e : v) str << e << " ";
+    return str.str();
+}
+
+/*
+ * Distances between quantized data objects and queries should be
+ * equal to distances between decoded vectors and queries. With re-ranking,
+ * the distance is computed using the original vectors.
+ */
+bool TestQuantizedSpace(SQDistType distType, SQCodeType codeType, size_t N, size_t dim) {
+    SpaceQuantized  space(distType, codeType, 0);
+    SpaceQuantized  spaceRerank(distType, codeType, 2);
+
+    vector<float>   vect1(dim + 1), vect2(dim + 1), decoded(dim + 1);
+
+    bool ok = true;
+
+    for (size_t j = 0; j < N && ok; ++j) {
+        GenRandVect(&vect1[0], dim, -RANGE, RANGE);
+        GenRandVect(&vect2[0], dim, -RANGE, RANGE);
+        vector<float> data(vect1.begin(), vect1.begin() + dim);
+        vector<float> query(vect2.begin(), vect2.begin() + dim);
+
+        unique_ptr<Object> dataObj(space.CreateObjFromVect(0, -1, data));
+        unique_ptr<Object> queryObj(space.CreateObjFromStr(1, VectToString(query)));
+        unique_ptr<Object> dataObjRerank(spaceRerank.CreateObjFromVect(0, -1, data));
+        unique_ptr<Object> queryObjRerank(spaceRerank.CreateObjFromStr(1, VectToString(query)));
+
+        space.GetVector(dataObj.get(), decoded);
+        decoded.resize(dim + 1);
+
+        float expDecoded, expOrig;
+        if (distType == kSQDistL2) {
+            expDecoded = L2NormStandard(&decoded[0], &vect2[0], dim);
+            expOrig    = L2NormStandard(&vect1[0], &vect2[0], dim);
+        } else {
+            PrecompInvNorm(&decoded[0], dim);
+            PrecompInvNorm(&vect1[0], dim);
+            PrecompInvNorm(&vect2[0], dim);
+            expDecoded = CosineSimilarityPrecompSIMD(&decoded[0], &vect2[0], dim);
+            expOrig    = CosineSimilarityPrecompSIMD(&vect1[0], &vect2[0], dim);
+        }
+
+        // Two compressed objects: the distance is the same as between decoded vectors
+        unique_ptr<Object> dataObj2(space.CreateObjFromVect(2, -1, query));
+        vector<float>      decoded2;
+        space.GetVector(dataObj2.get(), decoded2);
+        unique_ptr<Object> queryObj2(space.CreateObjFromStr(3, VectToString(decoded2)));
+
+        ok = ok && SIMDTierValuesAgree("SpaceQuantized", GetSIMDTier(), dim,
+                                       expDecoded, space.IndexTimeDistance(dataObj.get(), queryObj.get()));
+        ok = ok && SIMDTierValuesAgree("SpaceQuantized (left query)", GetSIMDTier(), dim,
+                                       expDecoded, space.IndexTimeDistance(queryObj.get(), dataObj.get()));
+        ok = ok && SIMDTierValuesAgree("SpaceQuantized (compressed)", GetSIMDTier(), dim,
+                                       space.IndexTimeDistance(dataObj.get(), queryObj2.get()),
+                                       space.IndexTimeDistance(dataObj.get(), dataObj2.get()));
+        ok = ok && SIMDTierValuesAgree("SpaceQuantized (rerank)", GetSIMDTier(), dim,
+                                       expOrig, spaceRerank.IndexTimeDistance(dataObjRerank.get(), queryObjRerank.get()));
+    }
+
+    return ok;
+}
+
+TEST(TestQuantizedSpaceAgree) {
+    int nTest = 0;
+    int nFail = 0;
+
+    for (size_t dim = 1; dim <= 300; dim += 7) {
+        for (SQDistType distType : { kSQDistL2, kSQDistCosine }) {
+            for (SQCodeType codeType : { kSQCodeInt8, kSQCodeFP16 }) {
+                nTest++;
+                nFail += !TestQuantizedSpace(distType, codeType, 20, dim);
+            }
+        }
+    }
+
+    LOG(LIB_INFO) << nTest << " (sub) tests performed " << nFail << " failed";
+
+    EXPECT_EQ(0, nFail);
+}
+
+/*
+ * A data set written by WriteDataset should be read back as the same objects:
+ * only vector elements are written, and precomputed values
+ * (logarithms or inverse norms) are recomputed by ReadDataset.
+ */
+bool TestWriteReadDataset(const VectorSpace<float>& space, size_t dim) {
+    const string    location = "write_dataset_test.tmp";
+    ObjectVector    data, readData;
+
+    for (size_t i = 0; i < 10; ++i) {
+        vector<float> vect(dim);
+        // These values are printed and parsed without rounding errors
+        for (size_t k = 0; k < dim; ++k) vect[k] = (1 + (i + k) % 7) / 4.0f;
+        data.push_back(space.CreateObjFromVect(i, -1, vect));
+    }
+
+    space.WriteDataset(data, location.c_str());
+    space.ReadDataset(readData, NULL, location.c_str(), 0);
+    remove(location.c_str());
+
+    bool ok = readData.size() == data.size();
+    for (size_t i = 0; ok && i < data.size(); ++i) {
+        ok = space.GetElemQty(readData[i]) == dim &&
+             readData[i]->datalength() == data[i]->datalength() &&
+             memcmp(readData[i]->data(), data[i]->data(), data[i]->datalength()) == 0;
+    }
+    if (!ok) LOG(LIB_ERROR) << "WriteDataset/ReadDataset mismatch, space: " << space.ToString() << " dim: " << dim;
+
+    for (const Object* obj: data) delete obj;
+    for (const Object* obj: readData) delete obj;
+    return ok;
+}
+
+TEST(TestWriteReadDataset) {
+    int nTest = 0;
+    int nFail = 0;
+
+    SpaceLp<float>                      spaceL2(2);
+    SpaceCosineSimilarityFast<float>    spaceCosine;
+    SpaceAngularDistanceFast<float>     spaceAngular;
+    KLDivGenFast<float>                 spaceKLGen;
+    SpaceJSDiv<float>                   spaceJS(SpaceJSBase<float>::kJSFastPrecomp);
+
+    for (size_t dim : {1, 7, 32}) {
+        for (const VectorSpace<float>* space : 
+                std::initializer_list<const VectorSpace<float>*>{&spaceL2, &spaceCosine, &spaceAngular, &spaceKLGen, &spaceJS}) {
+            nTest++;
+            nFail += !TestWriteReadDataset(*space, dim);
+        }
+    }
+
+    LOG(LIB_INFO) << nTest << " (sub) tests performed " << nFail << " failed";
+
+    EXPECT_EQ(0, nFail);
+}
+
+}  // namespace similarity
@@ -19,8 +19,14 @@
 #include "bunit.h"
 
 #include <limits>
+#include <random>
+#include <memory>
 
 #include <eval_metrics.h>
+#include <eval_results.h>
+#include <space/space_lp.h>
+#include <knnquery.h>
+#include <rangequery.h>
 
 using namespace std;
 
@@ -326,4 +332,117 @@ TEST(TestPrecisionOfApproxInt) {
   }
 }
 
+
+/*
+ * GoldStandard sorts only the closest entries: the sorted part
+ * should always coincide with the beginning of the fully sorted list.
+ */
+void checkSortedPart(const GoldStandard<float>& gs, const vector<RESF>& allSorted, float MaxDist) {
+  const vector<RESF>& entries = gs.GetSortedEntries();
+
+  EXPECT_EQ(allSorted.size(), entries.size());
+  EXPECT_TRUE(gs.GetSortedQty() == allSorted.size() || entries[gs.GetSortedQty() - 1].mDist > MaxDist);
+
+  for (size_t i = 0; i < gs.GetSortedQty(); ++i) {
+    EXPECT_EQ(allSorted[i].mId, entries[i].mId);
+  }
+}
+
+TEST(TestGoldStandardPartialSort) {
+  // 1-d integer values produce a lot of ties
+  SpaceLp<float>                  space(2);
+  mt19937                         gen(0);
+  uniform_int_distribution<int>   distr(0, 50);
+  ObjectVector                    data;
+
+  for (size_t i = 0; i < 1000; ++i) {
+    data.push_back(space.CreateObjFromVect(i, -1, vector<float>(1, distr(gen))));
+  }
+  unique_ptr<Object> queryObj(space.CreateObjFromVect(data.size(), -1, vector<float>(1, 25)));
+
+  vector<RESF> allSorted;
+  for (const Object* obj: data) {
+    allSorted.push_back(RESF(obj->id(), obj->label(), space.IndexTimeDistance(obj, queryObj.get())));
+  }
+  sort(allSorted.begin(), allSorted.end());
+
+  for (unsigned K: {1, 10, 100, 2000}) {
+    KNNQuery<float>     query(&space, queryObj.get(), K);
+    GoldStandard<float> gs(&space, data, &query);
+
+    const size_t qty = min<size_t>(K, data.size());
+    EXPECT_TRUE(gs.GetSortedQty() >= qty);
+    // Entries tied with the K-th one are sorted too
+    checkSortedPart(gs, allSorted, allSorted[qty - 1].mDist);
+
+    for (float MaxDist: {0.0f, 3.0f, 10.0f, 24.0f, 100.0f}) {
+      gs.ExtendSorted(MaxDist);
+      checkSortedPart(gs, allSorted, MaxDist);
+    }
+  }
+  for (float radius: {0.0f, 3.0f, 10.0f, 24.0f, 100.0f}) {
+    RangeQuery<float>   query(&space, queryObj.get(), radius);
+    GoldStandard<float> gs(&space, data, &query);
+
+    checkSortedPart(gs, allSorted, radius);
+  }
+
+  for (const Object* obj: data) delete obj;
+}
+
+/*
+ * GoldStandardManager keeps only the closest entries: GoldStandard
+ * should compute all the distances again only if these entries are not enough.
+ */
+TEST(TestGoldStandardClosestEntries) {
+  SpaceLp<float>                  space(2);
+  mt19937                         gen(0);
+  uniform_int_distribution<int>   distr(0, 50);
+  ObjectVector                    data;
+
+  for (size_t i = 0; i < 1000; ++i) {
+    data.push_back(space.CreateObjFromVect(i, -1, vector<float>(1, distr(gen))));
+  }
+  unique_ptr<Object> queryObj(space.CreateObjFromVect(data.size(), -1, vector<float>(1, 25)));
+
+  vector<float> dists;
+  vector<RESF>  allSorted;
+  for (const Object* obj: data) {
+    dists.push_back(space.IndexTimeDistance(obj, queryObj.get()));
+    allSorted.push_back(RESF(obj->id(), obj->label(), dists.back()));
+  }
+  sort(allSorted.begin(), allSorted.end());
+
+  vector<RESF>  closest;
+  bool          complete = true;
+  {
+    GoldStandard<float> gs(data, dists);
+    gs.SortClosest(50);
+    gs.GetClosestEntries(closest, complete);
+  }
+  EXPECT_FALSE(complete);
+  EXPECT_TRUE(!closest.empty() && closest.size() <= allSorted.size());
+  // All other entries are farther than the kept ones
+  EXPECT_TRUE(closest.back().mDist < allSorted[closest.size()].mDist);
+  for (size_t i = 0; i < closest.size(); ++i) {
+    EXPECT_EQ(allSorted[i].mId, closest[i].mId);
+  }
+
+  for (float MaxDist: {0.0f, 3.0f, 10.0f, 24.0f, 100.0f}) {
+    KNNQuery<float>     query(&space, queryObj.get(), 10);
+    GoldStandard<float> gs(&space, data, closest, complete, 123, &query);
+
+    gs.ExtendSorted(MaxDist);
+    EXPECT_EQ(static_cast<uint64_t>(123), gs.GetSeqSearchTime());
+
+    const vector<RESF>& entries = gs.GetSortedEntries();
+    EXPECT_TRUE(gs.GetSortedQty() == allSorted.size() || entries[gs.GetSortedQty() - 1].mDist > MaxDist);
+    for (size_t i = 0; i < gs.GetSortedQty(); ++i) {
+      EXPECT_EQ(allSorted[i].mId, entries[i].mId);
+    }
+  }
+
+  for (const Object* obj: data) delete obj;
+}
+
 }
@@ -72,6 +72,10 @@ vector<MethodTestCase>    vTestCaseDesc = {
                 1 /* KNN-1 */, 0 /* no range search */ , 0.98, 1.0, 0.0, 0.02, 2.8, 3.4),  
   MethodTestCase("float", "l2", "final8_10K.txt", "vptree:chunkBucket=1,bucketSize=10", 
                 10 /* KNN-10 */, 0 /* no range search */ , 1.0, 1.0, 0.0, 0.0, 20, 24),  
+  MethodTestCase("float", "l2", "final8_10K.txt", "vptree:chunkBucket=1,bucketSize=10,indexThreadQty=4", 
+                10 /* KNN-10 */, 0 /* no range search */ , 1.0, 1.0, 0.0, 0.0, 20, 24),  
+  MethodTestCase("float", "l2", "final8_10K.txt", "vptree:chunkBucket=1,bucketSize=10,flatten=1", 
+                10 /* KNN-10 */, 0 /* no range search */ , 1.0, 1.0, 0.0, 0.0, 20, 24),  
   MethodTestCase("float", "l2", "final8_10K.txt", "vptree:chunkBucket=1,bucketSize=10,alphaLeft=2,alphaRight=2", 
                 10 /* KNN-10 */, 0 /* no range search */ , 0.93, 0.96, 0.0, 0.02, 56, 63),  
   MethodTestCase("float", "l2", "final128_10K.txt", "vptree:chunkBucket=1,bucketSize=10", 
@@ -90,6 +94,8 @@ vector<MethodTestCase>    vTestCaseDesc = {
                 1 /* KNN-1 */, 0 /* no range search */ , 1.0, 1.0, 0.0, 0.0, 120, 140),  
   MethodTestCase("float", "l2", "final8_10K.txt", "mvptree:maxPathLen=4,bucketSize=10", 
                 10 /* KNN-10 */, 0 /* no range search */ , 1.0, 1.0, 0.0, 0.0, 40, 50),  
+  MethodTestCase("float", "l2", "final8_10K.txt", "mvptree:maxPathLen=4,bucketSize=10,indexThreadQty=4", 
+                10 /* KNN-10 */, 0 /* no range search */ , 1.0, 1.0, 0.0, 0.0, 40, 50),  
   MethodTestCase("float", "l2", "final8_10K.txt", "mvptree:maxPathLen=4,bucketSize=10,maxLeavesToVisit=10", 
                 1 /* KNN-1 */, 0 /* no range search */ , 0.82, 0.9, 0.2, 3, 230, 250),  
   MethodTestCase("float", "l2", "final8_10K.txt", "mvptree:maxPathLen=4,bucketSize=10,maxLeavesToVisit=20", 
@@ -175,6 +181,9 @@ vector<MethodTestCase>    vTestCaseDesc = {
                 1 /* KNN-1 */, 0 /* no range search */ , 0.45, 0.6, 55, 75, 90, 130),  
   MethodTestCase("float", "l2", "final8_10K.txt", "lsh_multiprobe:desiredRecall=0.5,tuneK=10,T=5,L=25,H=16535",
                 10 /* KNN-10 */, 0 /* no range search */ , 0.45, 0.6, 10, 40, 80, 120),  
+  // range
+  MethodTestCase("float", "l2", "final8_10K.txt", "lsh_multiprobe:desiredRecall=0.5,tuneK=1,T=5,L=25,H=16535,rangeT=20",
+                0 /* no KNN */, 0.1 /* range search radius 0.1 */ , 0.2, 0.3, 1, 2, 25, 40),  
   // *************** Guassian LSH tests ******************** //
   MethodTestCase("float", "l2", "final8_10K.txt", "lsh_gaussian:W=2,L=5,M=40,H=16535",
 
@@ -233,6 +242,30 @@ vector<MethodTestCase>    vTestCaseDesc = {
   MethodTestCase("float", "l2", "final8_10K.txt", "perm_bin_vptree:numPivot=32,alphaLeft=2,alphaRight=2,dbScanFrac=0.1",
                 1 /* KNN-1 */, 0 /* no range search */ , 0.9, 1.0, 0.01, 0.5, 8, 12),  
 
+  // *************** sequential search tests ******************** //
+  MethodTestCase("float", "l2", "final8_10K.txt", "seq_search:threadQty=4",
+                10 /* KNN-10 */, 0 /* no range search */ , 1.0, 1.0, 0.0, 0.0, 0.99, 1.01),  
+
+  // *************** product quantization tests ******************** //
+  MethodTestCase("float", "l2", "final8_10K.txt", "pq:subVectQty=4,shortListQty=100",
+                1 /* KNN-1 */, 0 /* no range search */ , 0.999, 1.0, 0, 0.01, 90, 110),  
+  MethodTestCase("float", "l2", "final8_10K.txt", "pq:subVectQty=4,shortListQty=10",
+                1 /* KNN-1 */, 0 /* no range search */ , 0.95, 1.0, 0, 0.2, 900, 1100),  
+
+  // *************** HNSW tests ******************** //
+  MethodTestCase("float", "l2", "final8_10K.txt", "hnsw:M=16,efConstruction=100,efSearch=10",
+                1 /* KNN-1 */, 0 /* no range search */ , 0.98, 1.0, 0, 0.05, 70, 120),  
+  MethodTestCase("float", "l2", "final8_10K.txt", "hnsw:M=16,efConstruction=100,efSearch=10",
+                10 /* KNN-10 */, 0 /* no range search */ , 0.97, 1.0, 0, 0.05, 70, 120),  
+  MethodTestCase("float", "l2", "final8_10K.txt", "hnsw:M=16,efConstruction=100,efSearch=50,indexThreadQty=4",
+                10 /* KNN-10 */, 0 /* no range search */ , 0.99, 1.0, 0, 0.01, 35, 55),  
+
+  // *************** sparse inverted index tests ******************** //
+  MethodTestCase("float", "cosinesimil_sparse_fast", "sparse_wiki_5K.txt", "sparse_inv_index",
+                1 /* KNN-1 */, 0 /* no range search */ , 0.999, 1.0, 0, 0.01, 1800, 2800),  
+  MethodTestCase("float", "cosinesimil_sparse_fast", "sparse_wiki_5K.txt", "sparse_inv_index:taatRatio=1000000",
+                10 /* KNN-10 */, 0 /* no range search */ , 0.999, 1.0, 0, 0.01, 75, 115),  
+
 
 
 };
@@ -321,11 +321,15 @@ size_t RunTestExper(const vector<MethodTestCase>& vTestCases,
         }
       }
 
+      GoldStandardManager<dist_t> GSManager(config);
+
+      GSManager.Compute(0 /* use all cores */, "" /* no caching */);
+
       Experiments<dist_t>::RunAll(true /* print info */, 
                                       ThreadTestQty, 
                                       TestSetId,
                                       ExpResRange, ExpResKNN,
-                                      config, 
+                                      config, GSManager,
                                       IndexPtrs, MethodsDesc);
 
 
@@ -419,6 +423,10 @@ bool RunOneTest(const vector<MethodTestCase>& vTestCases,
   unsigned              tmp2;
   unsigned              dimension = 0;
   float                 eps = 0.0;
+  string                SaveIndexPrefix;
+  string                LoadIndexPrefix;
+  unsigned              ThreadGSQty = 0;
+  string                CachePrefixGS;
 
 
   vector<shared_ptr<MethodWithParams>>        MethodsDesc;
@@ -440,6 +448,10 @@ bool RunOneTest(const vector<MethodTestCase>& vTestCases,
                        knn,
                        eps,
                        RangeArg,
+                       SaveIndexPrefix,
+                       LoadIndexPrefix,
+                       ThreadGSQty,
+                       CachePrefixGS,
                        MethodsDesc);
 
 
@@ -0,0 +1,105 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#include <string.h>
+
+#include <vector>
+#include <queue>
+#include <random>
+#include <utility>
+
+#include "object.h"
+#include "knnqueue.h"
+#include "bunit.h"
+
+using namespace std;
+
+namespace similarity {
+
+typedef KNNQueue<float>::QueueElement QueueElement;
+
+/*
+ * The queue should keep the same K closest elements
+ * as the priority_queue-based reference implementation.
+ */
+bool CheckKNNQueue(unsigned K, size_t qty, size_t batchSize, unsigned seed) {
+  mt19937                           gen(seed);
+  uniform_int_distribution<int>     distr(0, 100); // many ties
+  vector<Object*>                   objs;
+  vector<QueueElement>              elems;
+
+  for (size_t i = 0; i < qty; ++i) {
+    objs.push_back(new Object(i, -1, 0, NULL));
+    elems.push_back(QueueElement(static_cast<float>(distr(gen)), objs.back()));
+  }
+
+  priority_queue<QueueElement>  ref;
+  KNNQueue<float>               single(K), batch(K);
+
+  for (size_t i = 0; i < qty; ++i) {
+    if (ref.size() < K) {
+      ref.push(elems[i]);
+    } else if (K && elems[i].first < ref.top().first) {
+      ref.pop();
+      ref.push(elems[i]);
+    }
+    single.Push(elems[i].first, elems[i].second);
+  }
+
+  size_t added = 0;
+  for (size_t i = 0; i < qty; i += batchSize) {
+    added += batch.PushBatch(&elems[i], min(batchSize, qty - i));
+  }
+
+  vector<QueueElement> refElems;
+  while (!ref.empty()) {
+    refElems.push_back(ref.top());
+    ref.pop();
+  }
+  reverse(refElems.begin(), refElems.end());
+
+  vector<QueueElement> singleElems, batchElems;
+  single.GetSortedElements(singleElems);
+  batch.GetSortedElements(batchElems);
+
+  bool res = added >= batch.Size() &&
+             refElems == singleElems && refElems == batchElems &&
+             // Getting sorted elements doesn't change the queue
+             batch.Size() == batchElems.size() &&
+             batch.TopDistance() == (batchElems.empty() ?
+                                     numeric_limits<float>::max() : batchElems.back().first);
+
+  // Popping returns the farthest elements first
+  for (auto it = singleElems.rbegin(); res && it != singleElems.rend(); ++it) {
+    res = single.TopDistance() == it->first && single.Pop() == it->second;
+  }
+  res = res && single.Empty();
+
+  for (Object* obj: objs) delete obj;
+  return res;
+}
+
+TEST(KNNQueue) {
+  for (unsigned seed = 0; seed < 5; ++seed) {
+    EXPECT_TRUE(CheckKNNQueue(0,   100,  10, seed));
+    EXPECT_TRUE(CheckKNNQueue(1,   100,  1,  seed));
+    EXPECT_TRUE(CheckKNNQueue(10,  5,    3,  seed));
+    EXPECT_TRUE(CheckKNNQueue(10,  1000, 1,  seed));
+    EXPECT_TRUE(CheckKNNQueue(10,  1000, 50, seed));
+    EXPECT_TRUE(CheckKNNQueue(100, 1000, 7,  seed));
+  }
+}
+
+}  // namespace similarity
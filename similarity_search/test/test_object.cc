@@ -15,10 +15,14 @@
 
 #include <string.h>
 #include "object.h"
+#include "object_arena.h"
+#include "space/space_lp.h"
 #include "bunit.h"
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <thread>
 
 using namespace std;
 
@@ -79,4 +83,55 @@ TEST(AddLabel) {
 }
 
 
+// Exposes the arena scope of the space
+class ArenaTestSpace : public SpaceLp<float> {
+ public:
+  ArenaTestSpace() : SpaceLp<float>(2) {}
+  using SpaceLp<float>::ArenaScope;
+};
+
+/*
+ * The arena is used only by the thread that created the scope
+ * and only for objects of the space it was created for.
+ */
+TEST(ArenaScopeThread) {
+  ArenaTestSpace  space, otherSpace;
+  // Each object gets its own slab, so the arena grows with every object
+  ObjectArena     arena(1);
+  const vector<float> vect(8, 1);
+  vector<unique_ptr<Object>> objs;
+
+  {
+    ArenaTestSpace::ArenaScope scope(space, &arena);
+
+    objs.emplace_back(space.CreateObjFromVect(0, -1, vect));
+    const size_t size = arena.GetTotalSize();
+    EXPECT_TRUE(size > 0);
+
+    std::thread thread([&space, &vect, &objs]() { objs.emplace_back(space.CreateObjFromVect(1, -1, vect)); });
+    thread.join();
+    EXPECT_EQ(size, arena.GetTotalSize());
+
+    objs.emplace_back(otherSpace.CreateObjFromVect(2, -1, vect));
+    EXPECT_EQ(size, arena.GetTotalSize());
+
+    {
+      // Scopes can be nested
+      ArenaTestSpace::ArenaScope innerScope(space, NULL);
+      objs.emplace_back(space.CreateObjFromVect(3, -1, vect));
+      EXPECT_EQ(size, arena.GetTotalSize());
+    }
+    objs.emplace_back(space.CreateObjFromVect(4, -1, vect));
+    EXPECT_TRUE(arena.GetTotalSize() > size);
+  }
+
+  const size_t size = arena.GetTotalSize();
+  objs.emplace_back(space.CreateObjFromVect(5, -1, vect));
+  EXPECT_EQ(size, arena.GetTotalSize());
+
+  for (size_t i = 0; i < objs.size(); ++i) {
+    EXPECT_EQ(static_cast<IdType>(i), objs[i]->id());
+  }
+}
+
 }  // namespace similarity
@@ -0,0 +1,425 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib
+ *
+ * Copyright (c) 2014
+ *
+ * This code is released under the
+ * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <fstream>
+#include <set>
+#include <iomanip>
+#include <stdexcept>
+#include <cstdio>
+
+#include "object.h"
+#include "space.h"
+#include "space/space_lp.h"
+#include "space/space_quant.h"
+#include "space/space_sparse_scalar_fast.h"
+#include "knnquery.h"
+#include "knnqueue.h"
+#include "rangequery.h"
+#include "searchoracle.h"
+#include "method/seqsearch.h"
+#include "method/list_clusters.h"
+#include "method/vptree.h"
+#include "method/sparse_inv_index.h"
+#include "factory/method/permutation_index.h"
+#include "factory/method/vptree.h"
+#include "factory/method/ghtree.h"
+#include "factory/method/small_world_rand.h"
+#include "factory/method/hnsw.h"
+#include "bunit.h"
+
+using namespace std;
+
+namespace similarity {
+
+/*
+ * Batch search should produce exactly the same results
+ * (and the same number of distance computations) as
+ * answering queries one by one.
+ */
+template <typename QueryType, typename QueryCreator>
+bool CheckBatch(Index<float>& index, const ObjectVector& queryObjs, const QueryCreator& create) {
+  vector<unique_ptr<QueryType>> single, batch;
+  vector<QueryType*>            batchPtrs;
+
+  for (const Object* obj: queryObjs) {
+    single.push_back(unique_ptr<QueryType>(create(obj)));
+    index.Search(single.back().get());
+    batch.push_back(unique_ptr<QueryType>(create(obj)));
+    batchPtrs.push_back(batch.back().get());
+  }
+  index.SearchBatch(batchPtrs);
+
+  for (size_t i = 0; i < single.size(); ++i) {
+    if (!single[i]->Equals(batch[i].get())) return false;
+    if (single[i]->DistanceComputations() != batch[i]->DistanceComputations()) return false;
+  }
+  return true;
+}
+
+class TestBatchData {
+ public:
+  explicit TestBatchData(size_t dataQty = 2000) : space_(2) {
+    mt19937                         gen(0);
+    uniform_real_distribution<float> distr(0, 1);
+    const size_t dim = 8;
+
+    for (size_t i = 0; i < dataQty + 100; ++i) {
+      vector<float> vect(dim);
+      for (size_t k = 0; k < dim; ++k) vect[k] = distr(gen);
+      (i < dataQty ? data_ : queries_).push_back(space_.CreateObjFromVect(i, -1, vect));
+    }
+  }
+  ~TestBatchData() {
+    for (const Object* obj: data_) delete obj;
+    for (const Object* obj: queries_) delete obj;
+  }
+
+  void CheckIndex(Index<float>& index) {
+    EXPECT_TRUE(CheckBatch<KNNQuery<float>>(index, queries_,
+                  [this](const Object* obj) { return new KNNQuery<float>(&space_, obj, 10); }));
+    EXPECT_TRUE(CheckBatch<RangeQuery<float>>(index, queries_,
+                  [this](const Object* obj) { return new RangeQuery<float>(&space_, obj, 0.3); }));
+  }
+
+  SpaceLp<float>  space_;
+  ObjectVector    data_;
+  ObjectVector    queries_;
+};
+
+TEST(SearchBatchSeqSearch) {
+  TestBatchData test;
+  SeqSearch<float> index(&test.space_, test.data_, AnyParams(vector<string>()));
+  test.CheckIndex(index);
+}
+
+/*
+ * The parallel scan should give the same results
+ * (and the same number of distance computations) as the sequential one.
+ */
+TEST(SeqSearchThreads) {
+  // The data set should be large enough to be split into several parts
+  TestBatchData test(20000);
+  SeqSearch<float> seqIndex(&test.space_, test.data_, AnyParams(vector<string>()));
+  SeqSearch<float> parIndex(&test.space_, test.data_, AnyParams({"threadQty=4"}));
+
+  for (const Object* obj: test.queries_) {
+    KNNQuery<float>   seqKNN(&test.space_, obj, 10), parKNN(&test.space_, obj, 10);
+    RangeQuery<float> seqRange(&test.space_, obj, 0.3), parRange(&test.space_, obj, 0.3);
+
+    seqIndex.Search(&seqKNN);
+    parIndex.Search(&parKNN);
+    seqIndex.Search(&seqRange);
+    parIndex.Search(&parRange);
+
+    EXPECT_TRUE(seqKNN.Equals(&parKNN));
+    EXPECT_TRUE(seqRange.Equals(&parRange));
+    EXPECT_EQ(seqKNN.DistanceComputations(), parKNN.DistanceComputations());
+    EXPECT_EQ(seqRange.DistanceComputations(), parRange.DistanceComputations());
+  }
+  test.CheckIndex(parIndex);
+}
+
+TEST(SearchBatchListClusters) {
+  TestBatchData test;
+  ListClusters<float> index(&test.space_, test.data_, AnyParams({"bucketSize=50"}));
+  test.CheckIndex(index);
+}
+
+TEST(SearchBatchVPTree) {
+  TestBatchData test;
+  VPTree<float, TriangIneq<float>, TriangIneqCreator<float>>
+              index(false, TriangIneqCreator<float>(1, 1), &test.space_, test.data_, AnyParams({"bucketSize=10"}));
+  test.CheckIndex(index);
+}
+
+TEST(SearchBatchVPTreeEarlyTerm) {
+  TestBatchData test;
+  VPTree<float, TriangIneq<float>, TriangIneqCreator<float>>
+              index(false, TriangIneqCreator<float>(1, 1), &test.space_, test.data_,
+                    AnyParams({"bucketSize=10", "maxLeavesToVisit=5"}));
+  test.CheckIndex(index);
+}
+
+/*
+ * Stretching coefficients of the oracle are query-time parameters:
+ * changing them affects the search, but not the tree.
+ */
+TEST(VPTreeQueryTimeParams) {
+  TestBatchData test;
+  for (const char* flatten : {"flatten=0", "flatten=1"}) {
+    VPTree<float, TriangIneq<float>, TriangIneqCreator<float>>
+                index(false, TriangIneqCreator<float>(1, 1), &test.space_, test.data_,
+                      AnyParams({"bucketSize=10", flatten}));
+
+    uint64_t exactDistQty = 0, approxDistQty = 0;
+    for (const Object* obj: test.queries_) {
+      KNNQuery<float> exactKNN(&test.space_, obj, 10), approxKNN(&test.space_, obj, 10), againKNN(&test.space_, obj, 10);
+
+      index.SetQueryTimeParams(AnyParams({"alphaLeft=1", "alphaRight=1"}));
+      index.Search(&exactKNN);
+      index.SetQueryTimeParams(AnyParams({"alphaLeft=4", "alphaRight=4"}));
+      index.Search(&approxKNN);
+      index.SetQueryTimeParams(AnyParams({"alphaLeft=1", "alphaRight=1"}));
+      index.Search(&againKNN);
+
+      EXPECT_TRUE(exactKNN.Equals(&againKNN));
+      EXPECT_EQ(exactKNN.DistanceComputations(), againKNN.DistanceComputations());
+      exactDistQty  += exactKNN.DistanceComputations();
+      approxDistQty += approxKNN.DistanceComputations();
+    }
+    EXPECT_TRUE(approxDistQty < exactDistQty);
+  }
+}
+
+/*
+ * The inverted index is an exact method: both MaxScore (a large taatRatio)
+ * and term-at-a-time evaluation (taatRatio=0) should find the same
+ * data points as the sequential search.
+ */
+template <typename SpaceType>
+void CheckSparseInvIndex() {
+  SpaceType                         space;
+  mt19937                           gen(0);
+  // Elements with smaller ids are more frequent
+  geometric_distribution<uint32_t>  idDistr(0.02);
+  uniform_int_distribution<size_t>  qtyDistr(1, 20);
+  uniform_real_distribution<float>  valDistr(-0.2f, 1);
+  ObjectVector                      data, queries;
+
+  for (size_t i = 0; i < 2000 + 100; ++i) {
+    vector<SparseVectElem<float>> elems;
+    const size_t qty = qtyDistr(gen);
+    for (size_t k = 0; k < qty; ++k) elems.push_back(SparseVectElem<float>(idDistr(gen), valDistr(gen)));
+    sort(elems.begin(), elems.end());
+    elems.erase(unique(elems.begin(), elems.end(), 
+                       [](const SparseVectElem<float>& e1, const SparseVectElem<float>& e2) { return e1.id_ == e2.id_; }),
+                elems.end());
+    (i < 2000 ? data : queries).push_back(space.CreateObjFromVect(i, -1, elems));
+  }
+
+  SeqSearch<float>      seqIndex(&space, data, AnyParams(vector<string>()));
+  SparseInvIndex<float> index(&space, data, AnyParams(vector<string>()));
+  // The largest radius keeps all data points
+  const float           radii[] = {0.2f, 0.5f, 0.9f, 4.0f};
+
+  for (const char* taatRatio : {"taatRatio=0", "taatRatio=1", "taatRatio=1000000"}) {
+    index.SetQueryTimeParams(AnyParams({taatRatio}));
+    uint64_t distQty = 0;
+    for (const Object* obj: queries) {
+      for (float radius: radii) {
+        RangeQuery<float> seqRange(&space, obj, radius), range(&space, obj, radius);
+        seqIndex.Search(&seqRange);
+        index.Search(&range);
+        EXPECT_TRUE(seqRange.Equals(&range));
+        if (radius < 1) distQty += range.DistanceComputations();
+      }
+      KNNQuery<float> seqKNN(&space, obj, 10), knn(&space, obj, 10);
+      seqIndex.Search(&seqKNN);
+      index.Search(&knn);
+      EXPECT_TRUE(seqKNN.Equals(&knn));
+    }
+    // Only candidates are compared with queries
+    EXPECT_TRUE(distQty < queries.size() * 3 * data.size());
+  }
+
+  for (const Object* obj: data) delete obj;
+  for (const Object* obj: queries) delete obj;
+}
+
+TEST(SparseInvIndexCosine) {
+  CheckSparseInvIndex<SpaceSparseCosineSimilarityFast>();
+}
+
+TEST(SparseInvIndexAngular) {
+  CheckSparseInvIndex<SpaceSparseAngularDistanceFast>();
+}
+
+string ReadFileContent(const string& location) {
+  ifstream in(location.c_str(), ios::binary);
+  stringstream res;
+  res << in.rdbuf();
+  return res.str();
+}
+
+/*
+ * Tree buckets may keep copies of data objects (see CreateCacheOptimizedBucket),
+ * so answers of range queries are compared using object ids.
+ */
+bool EqualRangeResults(const RangeQuery<float>& a, const RangeQuery<float>& b) {
+  set<IdType> ids1, ids2;
+  for (const Object* obj: *a.Result()) ids1.insert(obj->id());
+  for (const Object* obj: *b.Result()) ids2.insert(obj->id());
+  return ids1 == ids2;
+}
+
+/*
+ * An index loaded from a file should answer queries exactly
+ * as the index that was saved. Saving the loaded index should 
+ * produce exactly the same file. Methods that choose entry points randomly
+ * during the search (bDeterministic is false) may carry out a different
+ * number of distance computations: only their results are compared.
+ */
+template <typename CreateFunc, typename LoadFunc>
+void CheckSaveLoad(const string& location, CreateFunc create, LoadFunc load, 
+                   const AnyParams& params, bool bRange, bool bDeterministic,
+                   size_t dataQty = 2000) {
+  TestBatchData     test(dataQty);
+  const string      reSaved = location + ".resaved";
+
+  unique_ptr<Index<float>> index(create(false, "l2", &test.space_, test.data_, params));
+  index->SaveIndex(location);
+  unique_ptr<Index<float>> loaded(load(location, "l2", &test.space_, test.data_, params));
+  loaded->SaveIndex(reSaved);
+
+  const string content = ReadFileContent(location);
+  EXPECT_FALSE(content.empty());
+  EXPECT_TRUE(content == ReadFileContent(reSaved));
+  remove(location.c_str());
+  remove(reSaved.c_str());
+
+  for (const Object* obj: test.queries_) {
+    KNNQuery<float>   knn(&test.space_, obj, 10), loadedKNN(&test.space_, obj, 10);
+
+    index->Search(&knn);
+    loaded->Search(&loadedKNN);
+
+    EXPECT_TRUE(knn.Equals(&loadedKNN));
+    if (bDeterministic) EXPECT_EQ(knn.DistanceComputations(), loadedKNN.DistanceComputations());
+
+    if (bRange) {
+      RangeQuery<float> range(&test.space_, obj, 0.3), loadedRange(&test.space_, obj, 0.3);
+
+      index->Search(&range);
+      loaded->Search(&loadedRange);
+
+      EXPECT_TRUE(EqualRangeResults(range, loadedRange));
+      if (bDeterministic) EXPECT_EQ(range.DistanceComputations(), loadedRange.DistanceComputations());
+    }
+  }
+}
+
+TEST(PermutationIndexSaveLoad) {
+  CheckSaveLoad("permutation_index_test.tmp", CreatePermutationIndex<float>, LoadPermutationIndex<float>,
+                AnyParams({"numPivot=8", "dbScanFrac=0.1"}), true, true);
+}
+
+TEST(VPTreeSaveLoad) {
+  CheckSaveLoad("vptree_test.tmp", CreateVPTreeTriang<float>, LoadVPTreeTriang<float>,
+                AnyParams({"bucketSize=10", "alphaLeft=2", "alphaRight=2"}), true, true);
+}
+
+TEST(GHTreeSaveLoad) {
+  CheckSaveLoad("ghtree_test.tmp", CreateGHTree<float>, LoadGHTree<float>,
+                AnyParams({"bucketSize=10"}), true, true);
+}
+
+TEST(HnswSaveLoad) {
+  CheckSaveLoad("hnsw_test.tmp", CreateHnsw<float>, LoadHnsw<float>,
+                AnyParams({"M=8", "efConstruction=50", "efSearch=20"}), false, true);
+}
+
+/*
+ * The search starts from a random entry point. Yet, if NN
+ * is as large as the data set, the whole graph is explored.
+ */
+TEST(SmallWorldRandSaveLoad) {
+  CheckSaveLoad("small_world_rand_test.tmp", CreateSmallWorldRand<float>, LoadSmallWorldRand<float>,
+                AnyParams({"NN=300", "initSearchAttempts=1"}), false, false, 300);
+}
+
+/*
+ * If the space re-ranks k-NN candidates, a search method collects 
+ * K * <re-ranking factor> candidates using codes. Result() keeps K closest 
+ * of them, and their distances are computed using original vectors. 
+ * Methods that compute distances themselves (e.g., the VP-tree) work the same way.
+ */
+TEST(KNNQueryRerank) {
+  const unsigned    K = 10, RerankFactor = 4;
+  const size_t      dim = 16, dataQty = 1000;
+  SpaceQuantized    space(kSQDistL2, kSQCodeInt8, RerankFactor);
+  SpaceLp<float>    spaceExact(2);
+  mt19937                           gen(0);
+  uniform_real_distribution<float>  distr(0, 1);
+  ObjectVector                      data, dataExact;
+  vector<unique_ptr<Object>>        queries, queriesExact;
+
+  for (size_t i = 0; i < dataQty + 20; ++i) {
+    vector<float> vect(dim);
+    for (size_t k = 0; k < dim; ++k) vect[k] = distr(gen);
+    if (i < dataQty) {
+      data.push_back(space.CreateObjFromVect(i, -1, vect));
+      dataExact.push_back(spaceExact.CreateObjFromVect(i, -1, vect));
+    } else {
+      // Query objects are not compressed
+      stringstream str;
+      str << setprecision(9);
+      for (float v: vect) str << v << " ";
+      queries.push_back(unique_ptr<Object>(space.CreateObjFromStr(i, str.str())));
+      queriesExact.push_back(unique_ptr<Object>(spaceExact.CreateObjFromVect(i, -1, vect)));
+    }
+  }
+
+  SeqSearch<float>  index(&space, data, AnyParams(vector<string>()));
+  SeqSearch<float>  indexExact(&spaceExact, dataExact, AnyParams(vector<string>()));
+
+  for (size_t q = 0; q < queries.size(); ++q) {
+    KNNQuery<float> query(&space, queries[q].get(), K);
+    KNNQuery<float> queryExact(&spaceExact, queriesExact[q].get(), K);
+
+    index.Search(&query);
+    indexExact.Search(&queryExact);
+
+    // Candidates are re-ranked only once
+    EXPECT_EQ(K, query.ResultSize());
+    query.Rerank();
+    EXPECT_EQ(K, query.ResultSize());
+    // A distance to every data point using codes and to every candidate using original vectors
+    EXPECT_EQ(dataQty + K * RerankFactor, query.DistanceComputations());
+
+    vector<KNNQueue<float>::QueueElement> res, resExact;
+    query.Result()->GetSortedElements(res);
+    queryExact.Result()->GetSortedElements(resExact);
+    for (size_t i = 0; i < res.size(); ++i) {
+      const Object* obj = dataExact[res[i].second->id()];
+      EXPECT_EQ_EPS(spaceExact.IndexTimeDistance(obj, queriesExact[q].get()), res[i].first, 1e-5f);
+    }
+    // 40 candidates selected using 8-bit codes should include 10 nearest neighbors
+    EXPECT_TRUE(query.Equals(&queryExact));
+  }
+
+  VPTree<float, TriangIneq<float>, TriangIneqCreator<float>>
+              vptree(false, TriangIneqCreator<float>(1, 1), &space, data, AnyParams({"bucketSize=10"}));
+  for (size_t q = 0; q < queries.size(); ++q) {
+    KNNQuery<float> query(&space, queries[q].get(), K);
+    KNNQuery<float> queryExact(&spaceExact, queriesExact[q].get(), K);
+
+    vptree.Search(&query);
+    indexExact.Search(&queryExact);
+
+    EXPECT_EQ(K, query.ResultSize());
+    EXPECT_TRUE(query.Equals(&queryExact));
+  }
+
+  for (const Object* obj: data) delete obj;
+  for (const Object* obj: dataExact) delete obj;
+}
+
+}  // namespace similarity
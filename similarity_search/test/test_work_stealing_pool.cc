@@ -0,0 +1,156 @@
+/**
+ * Non-metric Space Library
+ *
+ * Authors: Bilegsaikhan Naidan (https://github.com/bileg), Leonid Boytsov (http://boytsov.info).
+ * With contributions from Lawrence Cayton (http://lcayton.com/) and others.
+ *
+ * For the complete list of contributors and further details see:
+ * https://github.com/searchivarius/NonMetricSpaceLib 
+ * 
+ * Copyright (c) 2014
+ *
+ * This code is released under the * Apache License Version 2.0 http://www.apache.org/licenses/.
+ *
+ */
+
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+
+#include "work_stealing_pool.h"
+#include "method/parallel_tree_builder.h"
+#include "bunit.h"
+
+using namespace std;
+
+namespace similarity {
+
+TEST(WorkStealingPoolRunsEachTaskOnce) {
+  const size_t      qty = 10000;
+  vector<atomic<int>> counts(qty);
+  for (auto& c: counts) c = 0;
+
+  {
+    WorkStealingPool pool(4);
+    EXPECT_EQ(4U, pool.GetThreadQty());
+    for (size_t i = 0; i < qty; ++i) {
+      pool.Submit([&counts, i]() { ++counts[i]; });
+    }
+    pool.WaitAll();
+
+    bool bOnce = true;
+    for (auto& c: counts) bOnce = bOnce && c == 1;
+    EXPECT_TRUE(bOnce);
+
+    // The pool can be reused after WaitAll
+    for (size_t i = 0; i < qty; ++i) {
+      pool.Submit([&counts, i]() { ++counts[i]; });
+    }
+    // The destructor waits for all the tasks
+  }
+  bool bTwice = true;
+  for (auto& c: counts) bTwice = bTwice && c == 2;
+  EXPECT_TRUE(bTwice);
+}
+
+/*
+ * A long task doesn't block tasks in the queue of its worker:
+ * they are stolen by other workers.
+ */
+TEST(WorkStealingPoolSteals) {
+  WorkStealingPool  pool(2);
+  atomic<bool>      bRelease(false);
+  atomic<int>       doneQty(0);
+
+  // Tasks are distributed round-robin: both workers' queues get a blocked task
+  pool.Submit([&bRelease]() { while (!bRelease) this_thread::yield(); });
+  for (int i = 0; i < 100; ++i) {
+    pool.Submit([&doneQty]() { ++doneQty; });
+  }
+
+  auto start = chrono::steady_clock::now();
+  while (doneQty < 100 && chrono::steady_clock::now() - start < chrono::seconds(10)) {
+    this_thread::yield();
+  }
+  EXPECT_EQ(100, doneQty.load());
+
+  bRelease = true;
+  pool.WaitAll();
+}
+
+/*
+ * Workers fall asleep when there are no tasks: 
+ * a task submitted after that should wake one of them up.
+ */
+TEST(WorkStealingPoolWakesIdleWorkers) {
+  WorkStealingPool  pool(3);
+  atomic<int>       doneQty(0);
+
+  for (int i = 0; i < 2000; ++i) {
+    pool.Submit([&doneQty]() { ++doneQty; });
+    pool.WaitAll();
+    if (i % 100 == 0) this_thread::sleep_for(chrono::milliseconds(1));
+  }
+  EXPECT_EQ(2000, doneQty.load());
+}
+
+/*
+ * An exception thrown by a task is rethrown by WaitAll
+ * after all the tasks are finished. The pool remains usable.
+ */
+TEST(WorkStealingPoolRethrows) {
+  WorkStealingPool  pool(4);
+  atomic<int>       doneQty(0);
+
+  for (int i = 0; i < 100; ++i) {
+    pool.Submit([&doneQty, i]() {
+      if (i % 10 == 0) throw runtime_error("task failure");
+      ++doneQty;
+    });
+  }
+  bool bThrown = false;
+  try {
+    pool.WaitAll();
+  } catch (const runtime_error&) {
+    bThrown = true;
+  }
+  EXPECT_TRUE(bThrown);
+  EXPECT_EQ(90, doneQty.load());
+
+  pool.Submit([&doneQty]() { ++doneQty; });
+  pool.WaitAll();
+  EXPECT_EQ(91, doneQty.load());
+}
+
+TEST(ParallelTreeBuilderRethrows) {
+  ParallelTreeBuilder builder(4, 100000);
+
+  bool bThrown = false;
+  try {
+    builder.ParallelFor(100000, [](size_t i) { if (i == 77777) throw runtime_error("ParallelFor failure"); });
+  } catch (const runtime_error&) {
+    bThrown = true;
+  }
+  EXPECT_TRUE(bThrown);
+
+  atomic<int> doneQty(0);
+  for (int i = 0; i < 10; ++i) {
+    builder.AddSubtreeTask([&doneQty, i]() {
+      if (i == 5) throw runtime_error("subtree failure");
+      ++doneQty;
+    });
+  }
+  bThrown = false;
+  try {
+    builder.Finish();
+  } catch (const runtime_error&) {
+    bThrown = true;
+  }
+  EXPECT_TRUE(bThrown);
+  EXPECT_EQ(9, doneQty.load());
+}
+
+}  // namespace similarity